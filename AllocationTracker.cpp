@@ -0,0 +1,204 @@
+#include "pch.h"
+#include "AllocationTracker.h"
+
+#include <new>
+#include <cstdlib>
+
+using namespace std;
+
+namespace
+{
+
+const char* TAG_NAMES[ALLOCATION_TAGS_COUNT] =
+{
+	"untagged",
+	"update",
+	"shapes",
+	"stack",
+	"draw",
+	"renderer",
+	"hud",
+};
+
+struct TagCounters
+{
+	atomic<uint64_t> AllocationsCount;
+	atomic<uint64_t> BytesCount;
+};
+
+// zero before any constructor runs, operator new may come first
+TagCounters s_Counters[ALLOCATION_TAGS_COUNT];
+
+thread_local AllocationTag s_CurrentTag = ALLOCATION_TAG_UNTAGGED;
+thread_local bool s_AreAllocationsForbidden = false;
+
+}
+
+// AllocationTracker
+
+bool AllocationTracker::IsEnabled()
+{
+#ifdef BLOCKOUT_TRACK_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+AllocationCounts AllocationTracker::GetCounts(AllocationTag tag)
+{
+	assert(tag < ALLOCATION_TAGS_COUNT);
+
+	AllocationCounts counts;
+	counts.AllocationsCount = s_Counters[tag].AllocationsCount.load(memory_order_relaxed);
+	counts.BytesCount = s_Counters[tag].BytesCount.load(memory_order_relaxed);
+	return counts;
+}
+
+AllocationCounts AllocationTracker::GetTotalCounts()
+{
+	AllocationCounts total = {};
+
+	for (unsigned tag = 0; tag < ALLOCATION_TAGS_COUNT; ++tag)
+	{
+		const AllocationCounts counts = GetCounts(AllocationTag(tag));
+		total.AllocationsCount += counts.AllocationsCount;
+		total.BytesCount += counts.BytesCount;
+	}
+
+	return total;
+}
+
+const char* AllocationTracker::GetTagName(AllocationTag tag)
+{
+	assert(tag < ALLOCATION_TAGS_COUNT);
+	return TAG_NAMES[tag];
+}
+
+void AllocationTracker::SetAllocationsForbidden(bool isForbidden)
+{
+	s_AreAllocationsForbidden = isForbidden;
+}
+
+void AllocationTracker::Record(size_t size)
+{
+	// look one frame up for the call site
+	assert(!s_AreAllocationsForbidden);
+
+	s_Counters[s_CurrentTag].AllocationsCount.fetch_add(1, memory_order_relaxed);
+	s_Counters[s_CurrentTag].BytesCount.fetch_add(size, memory_order_relaxed);
+}
+
+// AllocationScope
+
+AllocationScope::AllocationScope(AllocationTag tag)
+	: m_PreviousTag(s_CurrentTag)
+{
+#ifdef BLOCKOUT_TRACK_ALLOCATIONS
+	s_CurrentTag = tag;
+#else
+	(void)tag;
+#endif
+}
+
+AllocationScope::~AllocationScope()
+{
+	s_CurrentTag = m_PreviousTag;
+}
+
+#ifdef BLOCKOUT_TRACK_ALLOCATIONS
+
+// The nothrow forms of the standard library call these, the array and sized
+// forms are replaced too since a runtime may not forward them.
+
+void* operator new(size_t size)
+{
+	AllocationTracker::Record(size);
+
+	void* pMemory = malloc(size > 0 ? size : 1);
+
+	if (!pMemory)
+	{
+		throw bad_alloc();
+	}
+
+	return pMemory;
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	free(pMemory);
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete[](void* pMemory) noexcept
+{
+	operator delete(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+	operator delete(pMemory);
+}
+
+void operator delete[](void* pMemory, size_t) noexcept
+{
+	operator delete(pMemory);
+}
+
+void* operator new(size_t size, align_val_t alignment)
+{
+	AllocationTracker::Record(size);
+
+	const size_t alignmentSize = size_t(alignment);
+	// aligned_alloc takes only whole multiples of the alignment
+	const size_t alignedSize = (max(size, size_t(1)) + alignmentSize - 1) / alignmentSize * alignmentSize;
+
+#ifdef _MSC_VER
+	void* pMemory = _aligned_malloc(alignedSize, alignmentSize);
+#else
+	void* pMemory = aligned_alloc(alignmentSize, alignedSize);
+#endif
+
+	if (!pMemory)
+	{
+		throw bad_alloc();
+	}
+
+	return pMemory;
+}
+
+void operator delete(void* pMemory, align_val_t) noexcept
+{
+#ifdef _MSC_VER
+	_aligned_free(pMemory);
+#else
+	free(pMemory);
+#endif
+}
+
+void* operator new[](size_t size, align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete[](void* pMemory, align_val_t alignment) noexcept
+{
+	operator delete(pMemory, alignment);
+}
+
+void operator delete(void* pMemory, size_t, align_val_t alignment) noexcept
+{
+	operator delete(pMemory, alignment);
+}
+
+void operator delete[](void* pMemory, size_t, align_val_t alignment) noexcept
+{
+	operator delete(pMemory, alignment);
+}
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+// subsystems heap allocations are counted for, see AllocationScope
+enum AllocationTag
+{
+	ALLOCATION_TAG_UNTAGGED,	// outside of every scope
+	ALLOCATION_TAG_UPDATE,		// game rules, Game::Update
+	ALLOCATION_TAG_SHAPES,		// shape creation and moves
+	ALLOCATION_TAG_STACK,		// settled cubes and their meshes
+	ALLOCATION_TAG_DRAW,		// snapshot and draw submission
+	ALLOCATION_TAG_RENDERER,	// buffers created by the renderer
+	ALLOCATION_TAG_HUD,			// text
+
+	ALLOCATION_TAGS_COUNT
+};
+
+struct AllocationCounts
+{
+	uint64_t AllocationsCount;
+	uint64_t BytesCount;
+};
+
+// Counts the heap allocations of the whole process per AllocationTag. The
+// global operator new and delete are replaced only when
+// BLOCKOUT_TRACK_ALLOCATIONS is defined, as in the Debug build of the game
+// and in every build of the benchmarks; otherwise nothing is counted and
+// the scopes do nothing. Counting takes no lock, any thread may allocate
+// and read meanwhile.
+class AllocationTracker
+{
+public:
+	// whether allocations are counted in this build
+	static bool IsEnabled();
+
+	// since the start of the process
+	static AllocationCounts GetCounts(AllocationTag tag);
+	static AllocationCounts GetTotalCounts();
+
+	static const char* GetTagName(AllocationTag tag);
+
+	// A thread that forbids allocations fails an assertion on its next
+	// one, so the debugger stops right at the call site.
+	static void SetAllocationsForbidden(bool isForbidden);
+
+	// by the replaced operator new
+	static void Record(size_t size);
+};
+
+// Tags the allocations of the thread while in scope; scopes nest and the
+// innermost one wins.
+class AllocationScope
+{
+public:
+	explicit AllocationScope(AllocationTag tag);
+	~AllocationScope();
+
+private:
+	AllocationScope(const AllocationScope&);
+	AllocationScope& operator = (const AllocationScope&);
+
+	AllocationTag m_PreviousTag;
+};
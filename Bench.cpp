@@ -0,0 +1,2456 @@
+#include "pch.h"
+#include "PerfCounters.h"
+#include "Random.h"
+#include "Game.h"
+#include "Grid.h"
+#include "Shape.h"
+#include "ShapeFactory.h"
+#include "ShapeLibrary.h"
+#include "ShapeGeometry.h"
+#include "ShapeOrientation.h"
+#include "NullRenderer.h"
+#include "SoftwareRenderer.h"
+#include "RenderQueue.h"
+#include "Perft.h"
+#include "PositionNotation.h"
+#include "Clock.h"
+#include "GameSnapshot.h"
+#include "HudLayer.h"
+#include "GameLanes.h"
+#include "AllocationTracker.h"
+#include "ShapeSetImage.h"
+#include "ShapeSetParser.h"
+#include "PolycubeEnumerator.h"
+#include "StackFaceMasks.h"
+#include "StackMeshBuilder.h"
+
+// Headless rules engine benchmarks:
+//
+//   BlockOutBench.exe [-runs <count>] [-filter <text>] [-json <file>]
+//                     [-baseline <file>] [-threshold <percent>]
+//   BlockOutBench.exe -perft <position or all> [-threads <count>]
+//   BlockOutBench.exe -allocations <pieces>
+//   BlockOutBench.exe -lanes <games>
+//   BlockOutBench.exe -parse-errors
+//   BlockOutBench.exe -polycubes
+//   BlockOutBench.exe -math
+//   BlockOutBench.exe -stack-meshes
+//   BlockOutBench.exe -render-queue
+//   BlockOutBench.exe -software-hud
+//   BlockOutBench.exe -render-frames <frames> [-threads <count>]
+//
+// Micro benchmarks run over a fixed corpus of pit states from empty to
+// almost full, generated from a fixed seed, so every machine and every
+// build measures the same work. Every benchmark reports per operation
+// numbers of its fastest run: wall clock time and, where perf_event_open is
+// available, hardware counters, see PerfCounters. -json writes the results
+// for later comparison; -baseline compares them with such a file and fails
+// when a benchmark got slower by more than the threshold, 10% by default.
+//
+// -perft counts the placement sequences of the standard positions, see
+// Perft, to every published depth, checks the counts and reports nodes per
+// second; a single position also prints the counts under every root
+// placement of the deepest ply.
+//
+// -allocations plays the given number of pieces after a warm-up and fails
+// when any of them allocates, in builds with BLOCKOUT_TRACK_ALLOCATIONS.
+//
+// -lanes plays the given number of games to their end in GameLanes and
+// fails when a step of any of them differs from the same step of Game.
+//
+// -parse-errors converts malformed text shape sets and fails when an error
+// message, its line or its column differs from the expected one.
+//
+// -polycubes enumerates the polycubes of up to 9 cubes and fails when their
+// counts differ from the published ones.
+//
+// -math compares the SimdMath functions with reference values and fails when
+// one differs; a build with MATH_NO_SIMD checks the scalar code.
+//
+// -stack-meshes builds the stack mesh of fixed pits and fails when its
+// counts differ from the expected ones or exceed the stack buffers.
+//
+// -render-queue flushes draws into a NullRenderer and fails when it is asked
+// to set a state more often than the draws need.
+//
+// -software-hud draws a game frame and the HUD over it with the
+// SoftwareRenderer and fails when the HUD panel is missing or the scene
+// around it is.
+//
+// -render-frames draws the given number of 1920x1080 frames of the game and
+// the HUD with the SoftwareRenderer, over the corpus stacks, and reports
+// frames per second. A Game keeps its buffers for one renderer at a time,
+// so this isn't one of the benchmarks, which draw with a NullRenderer.
+//
+// Besides the BlockOutBench project it builds on Linux with the portable
+// sources of the game, every source but main, BlockOut, D3DApplication and
+// D3D10Renderer:
+//   g++ -O2 -std=c++17 -pthread -DBLOCKOUT_TRACK_ALLOCATIONS -include pch.h
+//     -o bench $(ls *.cpp | grep -v -E
+//     '^(main|BlockOut|D3DApplication|D3D10Renderer)\.cpp$')
+
+using namespace std;
+
+namespace
+{
+
+const int64_t TICK_TIME = NANOSECONDS_PER_SECOND / 120;
+
+const uint64_t CORPUS_SEED = 0x426C6F636B4F7574ull;
+const size_t CORPUS_SIZE = 16;
+
+// the corpus stacks leave these levels free, so up to four levels can be
+// filled and cleared on top of them
+const size_t CORPUS_FREE_LEVELS_COUNT = 4;
+
+const size_t MAX_CLEARED_LEVELS_COUNT = 4;
+
+const size_t SEEDED_GAMES_COUNT = 16;
+
+// games stepped in lockstep, and steps of every game per run
+const size_t LOCKSTEP_LANES_COUNT = 1024;
+const size_t LOCKSTEP_STEPS_COUNT = 64;
+
+// shapes of the generated text shape set the parser loads
+const size_t PARSED_SHAPES_COUNT = 10000;
+
+// results are summed here and printed, so the compiler can't drop the work
+uint64_t s_Checksum = 0;
+
+#pragma region harness
+
+// A benchmark runs once per state, its corpus state or its game seed;
+// SetUp prepares the state and isn't measured, Run is and returns the
+// number of operations it did.
+struct Benchmark
+{
+	string Name;
+	size_t StatesCount;
+
+	function<void (size_t state)> SetUp;
+	function<uint64_t (size_t state)> Run;
+};
+
+struct BenchmarkResult
+{
+	string Name;
+	uint64_t OperationsCount;
+	PerfSample Sample;
+
+	double GetNanosecondsPerOperation() const
+	{
+		return OperationsCount > 0 ? double(Sample.Nanoseconds) / OperationsCount : 0.0;
+	}
+
+	double GetOperationsPerSecond() const
+	{
+		return Sample.Nanoseconds > 0 ? OperationsCount * 1.0e9 / Sample.Nanoseconds : 0.0;
+	}
+};
+
+PerfSample MeasureRun(PerfCounters& counters, const Benchmark& benchmark, uint64_t& operationsCount)
+{
+	PerfSample total;
+	operationsCount = 0;
+
+	for (size_t state = 0; state < benchmark.StatesCount; ++state)
+	{
+		benchmark.SetUp(state);
+
+		counters.Start();
+		operationsCount += benchmark.Run(state);
+		PerfSample sample = counters.Stop();
+
+		if (state == 0)
+		{
+			total = sample;
+		}
+		else
+		{
+			total.Add(sample);
+		}
+	}
+
+	return total;
+}
+
+BenchmarkResult Measure(PerfCounters& counters, const Benchmark& benchmark, unsigned runsCount)
+{
+	BenchmarkResult result;
+	result.Name = benchmark.Name;
+
+	// warms the caches and the branch predictors
+	MeasureRun(counters, benchmark, result.OperationsCount);
+
+	for (unsigned run = 0; run < runsCount; ++run)
+	{
+		// every run does the same operations
+		PerfSample sample = MeasureRun(counters, benchmark, result.OperationsCount);
+
+		if (run == 0 || sample.Nanoseconds < result.Sample.Nanoseconds)
+		{
+			result.Sample = sample;
+		}
+	}
+
+	return result;
+}
+
+#pragma endregion
+
+#pragma region reports
+
+const char* JSON_COUNTER_KEYS[PERF_COUNTERS_COUNT] =
+{
+	"cycles_per_op",
+	"instructions_per_op",
+	"l1d_misses_per_op",
+	"llc_misses_per_op",
+	"branch_misses_per_op",
+};
+
+void PrintHeader(const PerfCounters& counters)
+{
+	if (!counters.IsAvailable())
+	{
+		cout << "hardware counters unavailable, wall clock only: " << counters.GetUnavailabilityReason() << "\n\n";
+	}
+
+	cout << left << setw(28) << "benchmark" << right << setw(12) << "ns/op" << setw(14) << "ops/s";
+
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		cout << setw(15) << PerfCounters::GetCounterName(PerfCounter(i));
+	}
+
+	cout << setw(7) << "IPC" << '\n';
+}
+
+void PrintResult(const BenchmarkResult& result)
+{
+	const PerfSample& sample = result.Sample;
+
+	cout << left << setw(28) << result.Name << right << fixed << setprecision(1)
+		<< setw(12) << result.GetNanosecondsPerOperation()
+		<< setw(14) << setprecision(0) << result.GetOperationsPerSecond() << setprecision(1);
+
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		if (sample.IsCounted[i])
+		{
+			cout << setw(15) << double(sample.Counts[i]) / result.OperationsCount;
+		}
+		else
+		{
+			cout << setw(15) << "-";
+		}
+	}
+
+	if (sample.IsCounted[PERF_CYCLES] && sample.IsCounted[PERF_INSTRUCTIONS] && sample.Counts[PERF_CYCLES] > 0)
+	{
+		cout << setw(7) << setprecision(2) << double(sample.Counts[PERF_INSTRUCTIONS]) / sample.Counts[PERF_CYCLES];
+	}
+	else
+	{
+		cout << setw(7) << "-";
+	}
+
+	cout << endl;
+}
+
+// one benchmark per line, which is what ReadBaseline expects
+bool WriteJson(const string& fileName, const vector<BenchmarkResult>& results)
+{
+	ofstream file(fileName.c_str());
+
+	file << "{\n\t\"benchmarks\": [\n";
+	file << setprecision(3) << fixed;
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchmarkResult& result = results[i];
+
+		file << "\t\t{\"name\": \"" << result.Name << "\", \"operations\": " << result.OperationsCount
+			<< ", \"ns_per_op\": " << result.GetNanosecondsPerOperation()
+			<< ", \"ops_per_sec\": " << result.GetOperationsPerSecond();
+
+		for (unsigned counter = 0; counter < PERF_COUNTERS_COUNT; ++counter)
+		{
+			if (result.Sample.IsCounted[counter])
+			{
+				file << ", \"" << JSON_COUNTER_KEYS[counter] << "\": " << double(result.Sample.Counts[counter]) / result.OperationsCount;
+			}
+		}
+
+		file << (i + 1 < results.size() ? "},\n" : "}\n");
+	}
+
+	file << "\t]\n}\n";
+
+	return bool(file);
+}
+
+// the string or number after "key": on the line, empty when there is none
+string FindJsonValue(const string& line, const string& key)
+{
+	const string quotedKey = '"' + key + "\":";
+	size_t position = line.find(quotedKey);
+
+	if (position == string::npos)
+	{
+		return string();
+	}
+
+	position = line.find_first_not_of(' ', position + quotedKey.size());
+
+	if (position == string::npos)
+	{
+		return string();
+	}
+
+	if (line[position] == '"')
+	{
+		const size_t end = line.find('"', position + 1);
+		return end == string::npos ? string() : line.substr(position + 1, end - position - 1);
+	}
+
+	return line.substr(position, line.find_first_of(",}", position) - position);
+}
+
+// ns/op by benchmark name from a file written by WriteJson
+bool ReadBaseline(const string& fileName, map<string, double>& nanosecondsPerOperation)
+{
+	ifstream file(fileName.c_str());
+
+	if (!file)
+	{
+		return false;
+	}
+
+	string line;
+
+	while (getline(file, line))
+	{
+		const string name = FindJsonValue(line, "name");
+		const string value = FindJsonValue(line, "ns_per_op");
+
+		if (!name.empty() && !value.empty())
+		{
+			nanosecondsPerOperation[name] = atof(value.c_str());
+		}
+	}
+
+	return true;
+}
+
+// returns the number of benchmarks slower than the threshold allows
+size_t CompareWithBaseline(const vector<BenchmarkResult>& results, const map<string, double>& baseline, double thresholdPercent)
+{
+	size_t regressionsCount = 0;
+
+	cout << '\n' << left << setw(28) << "benchmark" << right << setw(12) << "baseline" << setw(12) << "ns/op" << setw(10) << "change" << '\n';
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		map<string, double>::const_iterator it = baseline.find(results[i].Name);
+
+		if (it == baseline.end() || it->second <= 0.0)
+		{
+			cout << left << setw(28) << results[i].Name << right << setw(12) << "-" << '\n';
+			continue;
+		}
+
+		const double current = results[i].GetNanosecondsPerOperation();
+		const double change = (current / it->second - 1.0) * 100.0;
+		const bool isRegression = change > thresholdPercent;
+
+		cout << left << setw(28) << results[i].Name << right << fixed << setprecision(1)
+			<< setw(12) << it->second << setw(12) << current
+			<< setw(9) << showpos << change << noshowpos << '%'
+			<< (isRegression ? "  SLOWER" : "") << '\n';
+
+		if (isRegression)
+		{
+			++regressionsCount;
+		}
+	}
+
+	return regressionsCount;
+}
+
+#pragma endregion
+
+#pragma region corpus
+
+// Stacks from empty to almost full in the lower levels, each level with at
+// least one hole, so no level is ever full.
+vector<Pit> BuildCorpus()
+{
+	Random random(CORPUS_SEED);
+	vector<Pit> corpus;
+
+	for (size_t i = 0; i < CORPUS_SIZE; ++i)
+	{
+		Pit pit;
+
+		// in 1/256 of a cell
+		const unsigned fill = unsigned(i * 256 / CORPUS_SIZE);
+
+		for (size_t z = CORPUS_FREE_LEVELS_COUNT; z < PIT_Z_SIZE; ++z)
+		{
+			const unsigned hole = random.Next(unsigned(Pit::CELLS_PER_LEVEL));
+
+			for (unsigned cell = 0; cell < Pit::CELLS_PER_LEVEL; ++cell)
+			{
+				if (cell != hole && random.Next(256) < fill)
+				{
+					pit.Occupy(cell % PIT_X_SIZE, cell / PIT_X_SIZE, z);
+				}
+			}
+		}
+
+		corpus.push_back(pit);
+	}
+
+	return corpus;
+}
+
+#pragma endregion
+
+#pragma region rules
+
+bool Collides(const Pit& pit, const ShapeOrientation& orientation, size_t cornerX, size_t cornerY, size_t z)
+{
+	const size_t depth = size_t(orientation.Maximum[2] - orientation.Minimum[2]) + 1;
+
+	if (z + depth > PIT_Z_SIZE)
+	{
+		return true;
+	}
+
+	const size_t shift = cornerY * PIT_X_SIZE + cornerX;
+
+	for (size_t layer = 0; layer < depth; ++layer)
+	{
+		if ((orientation.LayerMasks[layer] << shift) & pit.GetLevelMask(z + layer))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// every orientation dropped straight down from the top at every position
+// its footprint fits, returns the number of resting places
+size_t CountPlacements(const Pit& pit, const ShapeOrientationTable& table)
+{
+	size_t placementsCount = 0;
+
+	for (size_t i = 0; i < table.Count; ++i)
+	{
+		const ShapeOrientation& orientation = table.Orientations[i];
+
+		if (!orientation.HasLayerMasks)
+		{
+			continue;
+		}
+
+		const size_t width = size_t(orientation.Maximum[0] - orientation.Minimum[0]) + 1;
+		const size_t height = size_t(orientation.Maximum[1] - orientation.Minimum[1]) + 1;
+
+		for (size_t y = 0; y + height <= PIT_Y_SIZE; ++y)
+		{
+			for (size_t x = 0; x + width <= PIT_X_SIZE; ++x)
+			{
+				if (Collides(pit, orientation, x, y, 0))
+				{
+					continue;
+				}
+
+				size_t z = 0;
+
+				while (!Collides(pit, orientation, x, y, z + 1))
+				{
+					++z;
+				}
+
+				++placementsCount;
+			}
+		}
+	}
+
+	return placementsCount;
+}
+
+// Moves every piece to the next spot of a fixed sweep over the pit, turns
+// it by the piece number and drops it. A key every 16 ticks lets the 0.1
+// second move animations end, so no key is lost and a seed always plays
+// the same game.
+class FixedPolicy
+{
+public:
+	FixedPolicy()
+		: m_PiecesCount(0)
+		, m_KeysCount(0)
+		, m_PlayedCubesCount(0)
+	{
+	}
+
+	GameKey GetKey(const Game& game, uint64_t tick)
+	{
+		if (game.GetPlayedCubesCount() != m_PlayedCubesCount)
+		{
+			m_PlayedCubesCount = game.GetPlayedCubesCount();
+			++m_PiecesCount;
+			m_KeysCount = 0;
+		}
+
+		if (tick % 16 != 0)
+		{
+			return GAME_KEY_NONE;
+		}
+
+		const int dx = int(m_PiecesCount % 5) - 2;
+		const int dy = int(m_PiecesCount / 5 % 5) - 2;
+
+		size_t key = m_KeysCount++;
+
+		if (key < size_t(abs(dx)))
+		{
+			return dx < 0 ? GAME_KEY_LEFT : GAME_KEY_RIGHT;
+		}
+
+		key -= abs(dx);
+
+		if (key < size_t(abs(dy)))
+		{
+			return dy < 0 ? GAME_KEY_DOWN : GAME_KEY_UP;
+		}
+
+		key -= abs(dy);
+
+		if (key == 0)
+		{
+			return GameKey(GAME_KEY_ROTATE_X_NEGATIVE + m_PiecesCount % 6);
+		}
+
+		// the drop goes on by itself until the piece lands
+		return key == 1 ? GAME_KEY_DROP : GAME_KEY_NONE;
+	}
+
+private:
+	size_t m_PiecesCount;
+	size_t m_KeysCount;
+	unsigned m_PlayedCubesCount;
+};
+
+// returns the ticks the game lasted
+uint64_t PlaySeededGame(Game& game, unsigned seed)
+{
+	game.SetRandomSeed(seed);
+	game.NewGame();
+
+	FixedPolicy policy;
+	uint64_t ticksCount = 0;
+
+	while (!game.IsOver())
+	{
+		const GameKey key = policy.GetKey(game, ticksCount);
+
+		if (key != GAME_KEY_NONE)
+		{
+			game.OnKeyPressed(key);
+		}
+
+		game.Update(TICK_TIME);
+		++ticksCount;
+	}
+
+	return ticksCount;
+}
+
+// The key of a game at a step for the lockstep benchmarks: mostly falling,
+// with moves, turns and a drop in between; games start at different
+// points of the pattern.
+GameKey GetStepKey(size_t game, size_t step)
+{
+	static const GameKey PATTERN[] =
+	{
+		GAME_KEY_LEFT, GAME_KEY_NONE, GAME_KEY_ROTATE_X_NEGATIVE, GAME_KEY_NONE,
+		GAME_KEY_UP, GAME_KEY_NONE, GAME_KEY_NONE, GAME_KEY_ROTATE_Z_POSITIVE,
+		GAME_KEY_RIGHT, GAME_KEY_NONE, GAME_KEY_DOWN, GAME_KEY_NONE,
+		GAME_KEY_ROTATE_Y_NEGATIVE, GAME_KEY_NONE, GAME_KEY_NONE, GAME_KEY_DROP,
+	};
+
+	const size_t patternSize = sizeof(PATTERN) / sizeof(PATTERN[0]);
+	return PATTERN[(step + game * 5) % patternSize];
+}
+
+// one step like GameLanes::Step, the falling time passes when there is no
+// key; returns the score, a game that ends starts again
+unsigned StepGame(Game& game, GameKey key)
+{
+	if (game.IsOver())
+	{
+		game.NewGame();
+	}
+
+	if (key != GAME_KEY_NONE)
+	{
+		game.OnKeyPressed(key);
+	}
+
+	// longer than the falling time and the move animations
+	game.Update(NANOSECONDS_PER_SECOND);
+
+	return game.GetScore();
+}
+
+#pragma endregion
+
+#pragma region perft
+
+// returns false when a count differs from the published one
+bool CheckPerft(const PerftPosition& position, unsigned threadsCount, bool isDivided)
+{
+	Pit pit;
+	vector<const ShapeOrientationTable*> pieces;
+
+	if (!Perft::SetUp(position, pit, pieces))
+	{
+		cout << position.Name << ": unknown shape set or piece" << endl;
+		return false;
+	}
+
+	bool isCorrect = true;
+	Perft::Result deepest;
+
+	for (size_t depth = 1; depth <= PerftPosition::MAX_DEPTH && position.NodesCounts[depth - 1] > 0; ++depth)
+	{
+		Perft::Options options;
+		options.Depth = depth;
+		options.ThreadsCount = threadsCount;
+
+		const int64_t start = Clock::GetSteadyClock().GetNanoseconds();
+		deepest = Perft::Run(pit, pieces, options);
+		const double seconds = (Clock::GetSteadyClock().GetNanoseconds() - start) * 1.0e-9;
+
+		const bool isExpected = deepest.NodesCount == position.NodesCounts[depth - 1];
+		isCorrect = isCorrect && isExpected;
+
+		cout << left << setw(14) << position.Name << right << setw(6) << depth << setw(14) << deepest.NodesCount
+			<< fixed << setprecision(3) << setw(10) << seconds
+			<< setprecision(0) << setw(14) << (seconds > 0.0 ? deepest.NodesCount / seconds : 0.0)
+			<< (isExpected ? "  ok" : "  WRONG, expected " + nsc::NumberToString(position.NodesCounts[depth - 1])) << endl;
+	}
+
+	if (isDivided)
+	{
+		cout << "\norientation     x     y     z         nodes\n";
+
+		for (size_t i = 0; i < deepest.RootPlacements.size(); ++i)
+		{
+			const Perft::Placement& placement = deepest.RootPlacements[i];
+
+			cout << setw(11) << int(placement.Orientation) << setw(6) << int(placement.X) << setw(6) << int(placement.Y)
+				<< setw(6) << int(placement.Z) << setw(14) << deepest.DividedCounts[i] << '\n';
+		}
+	}
+
+	return isCorrect;
+}
+
+int RunPerft(const string& positionName, unsigned threadsCount)
+{
+	cout << left << setw(14) << "position" << right << setw(6) << "depth" << setw(14) << "nodes"
+		<< setw(10) << "seconds" << setw(14) << "nodes/s" << '\n';
+
+	if (positionName != "all")
+	{
+		const PerftPosition* pPosition = Perft::FindStandardPosition(positionName);
+
+		if (!pPosition)
+		{
+			cerr << "unknown position " << positionName << endl;
+			return 1;
+		}
+
+		return CheckPerft(*pPosition, threadsCount, true) ? 0 : 2;
+	}
+
+	bool isCorrect = true;
+
+	for (size_t i = 0; i < Perft::GetStandardPositionsCount(); ++i)
+	{
+		isCorrect = CheckPerft(Perft::GetStandardPosition(i), threadsCount, false) && isCorrect;
+	}
+
+	return isCorrect ? 0 : 2;
+}
+
+#pragma endregion
+
+#pragma region allocations
+
+// Drops every piece where it clears the most levels, else where its cubes
+// land deepest, trying every column in the orientations one rotation key
+// away. Plans once per piece from Game::GetPosition and then sends its keys
+// like FixedPolicy, so pieces are turned, moved and dropped by the game and
+// levels get cleared. Plans nothing for shapes without an orientation table.
+class GreedyPolicy
+{
+public:
+	GreedyPolicy()
+		: m_PlayedCubesCount(UINT_MAX)
+		, m_KeysCount(0)
+		, m_SentKeysCount(0)
+	{
+	}
+
+	GameKey GetKey(const Game& game, uint64_t tick)
+	{
+		if (game.GetPlayedCubesCount() != m_PlayedCubesCount)
+		{
+			m_PlayedCubesCount = game.GetPlayedCubesCount();
+			Plan(game);
+		}
+
+		if (tick % 16 != 0 || m_SentKeysCount == m_KeysCount)
+		{
+			return GAME_KEY_NONE;
+		}
+
+		return m_Keys[m_SentKeysCount++];
+	}
+
+private:
+	void Plan(const Game& game)
+	{
+		m_KeysCount = 0;
+		m_SentKeysCount = 0;
+
+		game.GetPosition(m_Position);
+
+		const ShapeOrientationTable* pTable = m_Position.ShapeKind >= 0
+			? ShapeFactory::GetShapeSet()->GetShape(unsigned(m_Position.ShapeKind))->GetOrientations()
+			: nullptr;
+
+		if (!pTable)
+		{
+			m_Keys[m_KeysCount++] = GAME_KEY_DROP;
+			return;
+		}
+
+		const Pit& pit = m_Position.Stack;
+		const int x = m_Position.ShapeX, y = m_Position.ShapeY, z = m_Position.ShapeZ;
+
+		int bestScore = INT_MIN, bestRotation = -1, bestX = x, bestY = y;
+
+		for (int rotation = -1; rotation < SHAPE_ROTATIONS_COUNT; ++rotation)
+		{
+			const ShapeOrientation& orientation = pTable->Orientations[rotation < 0
+				? m_Position.Orientation
+				: pTable->Orientations[m_Position.Orientation].Rotations[rotation]];
+
+			if (!Fits(pit, orientation, x, y, z))
+			{
+				continue;
+			}
+
+			for (int targetY = 0; targetY < int(PIT_Y_SIZE); ++targetY)
+			{
+				for (int targetX = 0; targetX < int(PIT_X_SIZE); ++targetX)
+				{
+					// moved along x, then along y, then dropped
+					bool canMove = true;
+
+					for (int stepX = x; stepX != targetX && canMove; )
+					{
+						stepX += targetX > stepX ? 1 : -1;
+						canMove = Fits(pit, orientation, stepX, y, z);
+					}
+
+					for (int stepY = y; stepY != targetY && canMove; )
+					{
+						stepY += targetY > stepY ? 1 : -1;
+						canMove = Fits(pit, orientation, targetX, stepY, z);
+					}
+
+					if (!canMove)
+					{
+						continue;
+					}
+
+					int landingZ = z;
+
+					while (Fits(pit, orientation, targetX, targetY, landingZ + 1))
+					{
+						++landingZ;
+					}
+
+					const int score = Score(pit, orientation, targetX, targetY, landingZ);
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestRotation = rotation;
+						bestX = targetX;
+						bestY = targetY;
+					}
+				}
+			}
+		}
+
+		if (bestRotation >= 0)
+		{
+			m_Keys[m_KeysCount++] = GameKey(GAME_KEY_ROTATE_X_NEGATIVE + bestRotation);
+		}
+
+		for (int i = 0; i < abs(bestX - x); ++i)
+		{
+			m_Keys[m_KeysCount++] = bestX < x ? GAME_KEY_LEFT : GAME_KEY_RIGHT;
+		}
+
+		for (int i = 0; i < abs(bestY - y); ++i)
+		{
+			m_Keys[m_KeysCount++] = bestY < y ? GAME_KEY_DOWN : GAME_KEY_UP;
+		}
+
+		m_Keys[m_KeysCount++] = GAME_KEY_DROP;
+	}
+
+	// like Shape::IsMovePosible, cubes above the pit fit anywhere over it
+	static bool Fits(const Pit& pit, const ShapeOrientation& orientation, int x, int y, int z)
+	{
+		for (size_t i = 0; i < orientation.CubesCount; ++i)
+		{
+			const int cubeX = x + orientation.Cubes[i][0], cubeY = y + orientation.Cubes[i][1], cubeZ = z + orientation.Cubes[i][2];
+
+			if (cubeX < 0 || cubeX >= int(PIT_X_SIZE) || cubeY < 0 || cubeY >= int(PIT_Y_SIZE) || cubeZ >= int(PIT_Z_SIZE) ||
+				pit.IsOccupied(cubeX, cubeY, cubeZ))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// cleared levels first, then the depth of the cubes
+	static int Score(const Pit& pit, const ShapeOrientation& orientation, int x, int y, int z)
+	{
+		Pit placed = pit;
+		int depth = 0;
+
+		for (size_t i = 0; i < orientation.CubesCount; ++i)
+		{
+			const int cubeZ = z + orientation.Cubes[i][2];
+
+			if (cubeZ >= 0)
+			{
+				placed.Occupy(x + orientation.Cubes[i][0], y + orientation.Cubes[i][1], cubeZ);
+			}
+
+			depth += cubeZ;
+		}
+
+		int clearedLevelsCount = 0;
+
+		for (size_t level = 0; level < PIT_Z_SIZE; ++level)
+		{
+			clearedLevelsCount += placed.IsLevelFull(level);
+		}
+
+		return clearedLevelsCount * 1000 + depth;
+	}
+
+	unsigned m_PlayedCubesCount;
+	GamePosition m_Position;
+
+	// a rotation, the moves along x and y and the drop
+	GameKey m_Keys[1 + PIT_X_SIZE + PIT_Y_SIZE + 1];
+	size_t m_KeysCount;
+	size_t m_SentKeysCount;
+};
+
+// boxes instead of a font, the layout costs the same
+GlyphAtlas BuildBoxGlyphAtlas()
+{
+	GlyphAtlas atlas(256, 256, 24);
+	atlas.AddBoxGlyphs(10, 16, 12);
+	return atlas;
+}
+
+// Plays seeded games with the greedy policy every tick the way the game
+// runs: update, snapshot, scene and HUD. The warm-up pieces grow every
+// container to the size it needs; the pieces after them, from spawn to lock
+// and clear, must not allocate at all. A Debug build stops at the first
+// allocation instead, see AllocationTracker::SetAllocationsForbidden.
+int CheckAllocations(size_t piecesCount)
+{
+	if (!AllocationTracker::IsEnabled())
+	{
+		cerr << "allocations are not tracked in this build, define BLOCKOUT_TRACK_ALLOCATIONS" << endl;
+		return 1;
+	}
+
+	const size_t WARM_UP_PIECES_COUNT = 1000;
+
+	NullRenderer renderer;
+	Game game(renderer, "", CORPUS_SEED);
+	GameSnapshot snapshot;
+	GreedyPolicy policy;
+	HudLayer hudLayer(renderer, BuildBoxGlyphAtlas());
+
+	AllocationCounts counts[ALLOCATION_TAGS_COUNT] = {};
+	size_t playedPiecesCount = 0, clearingPiecesCount = 0;
+	unsigned playedCubesCount = 0, score = 0;
+
+	for (uint64_t tick = 0; playedPiecesCount < WARM_UP_PIECES_COUNT + piecesCount; ++tick)
+	{
+		if (game.GetPlayedCubesCount() != playedCubesCount)
+		{
+			playedCubesCount = game.GetPlayedCubesCount();
+			++playedPiecesCount;
+
+			if (game.GetScore() > score)
+			{
+				++clearingPiecesCount;
+			}
+
+			score = game.GetScore();
+
+			if (playedPiecesCount == WARM_UP_PIECES_COUNT)
+			{
+				clearingPiecesCount = 0;
+
+				for (unsigned tag = 0; tag < ALLOCATION_TAGS_COUNT; ++tag)
+				{
+					counts[tag] = AllocationTracker::GetCounts(AllocationTag(tag));
+				}
+
+#ifdef _DEBUG
+				AllocationTracker::SetAllocationsForbidden(true);
+#endif
+			}
+		}
+
+		if (game.IsOver())
+		{
+			game.NewGame();
+			playedCubesCount = 0;
+			score = 0;
+		}
+
+		const GameKey key = policy.GetKey(game, tick);
+
+		if (key != GAME_KEY_NONE)
+		{
+			game.OnKeyPressed(key);
+		}
+
+		game.Update(TICK_TIME);
+		game.Publish(snapshot);
+		game.Draw(snapshot);
+		hudLayer.Update(snapshot, 800, 600);
+		hudLayer.Draw();
+	}
+
+	AllocationTracker::SetAllocationsForbidden(false);
+
+	cout << piecesCount << " pieces after " << WARM_UP_PIECES_COUNT << " warm-up pieces, "
+		<< clearingPiecesCount << " of them clearing levels, " << hudLayer.GetUploadsCount() << " HUD uploads\n";
+
+	uint64_t allocationsCount = 0;
+
+	for (unsigned tag = 0; tag < ALLOCATION_TAGS_COUNT; ++tag)
+	{
+		const AllocationCounts now = AllocationTracker::GetCounts(AllocationTag(tag));
+		const uint64_t tagAllocationsCount = now.AllocationsCount - counts[tag].AllocationsCount;
+
+		if (tagAllocationsCount > 0)
+		{
+			cout << left << setw(12) << AllocationTracker::GetTagName(AllocationTag(tag)) << right
+				<< setw(10) << tagAllocationsCount << " allocations" << setw(12) << now.BytesCount - counts[tag].BytesCount << " bytes\n";
+		}
+
+		allocationsCount += tagAllocationsCount;
+	}
+
+	cout << (allocationsCount == 0 ? "no allocations" : "FAILED, the steady state allocates") << endl;
+	return allocationsCount == 0 ? 0 : 2;
+}
+
+#pragma endregion
+
+#pragma region lanes
+
+// A key for a lane of the lanes check: mostly falling, then moves, turns and
+// drops; pause is left out, GameLanes ignores it and Game would stop.
+GameKey GetRandomStepKey(Random& random)
+{
+	const unsigned draw = random.Next(32);
+
+	if (draw < 14)
+	{
+		return GAME_KEY_NONE;
+	}
+
+	if (draw < 22)
+	{
+		return GameKey(GAME_KEY_LEFT + (draw - 14) % 4);
+	}
+
+	return draw < 30 ? GameKey(GAME_KEY_ROTATE_X_NEGATIVE + (draw - 22) % 6) : GAME_KEY_DROP;
+}
+
+// returns the first field where the positions differ, nullptr when they don't
+const char* FindPositionDifference(const GamePosition& expected, const GamePosition& actual)
+{
+	for (size_t z = 0; z < PIT_Z_SIZE; ++z)
+	{
+		if (expected.Stack.GetLevelMask(z) != actual.Stack.GetLevelMask(z))
+		{
+			return "stack";
+		}
+	}
+
+	if (expected.ShapeKind != actual.ShapeKind || expected.NextShapeKind != actual.NextShapeKind)
+	{
+		return "shape kinds";
+	}
+
+	if (expected.Orientation != actual.Orientation)
+	{
+		return "orientation";
+	}
+
+	if (expected.ShapeX != actual.ShapeX || expected.ShapeY != actual.ShapeY || expected.ShapeZ != actual.ShapeZ)
+	{
+		return "pivot";
+	}
+
+	if (expected.Score != actual.Score)
+	{
+		return "score";
+	}
+
+	return expected.RandomState != actual.RandomState ? "random state" : nullptr;
+}
+
+// Plays the given number of seeded games to their end in GameLanes and
+// checks every step of every lane against Game: the game is set to the
+// position of the lane, gets the same key and must reach the same position,
+// played cubes and end. A lane keeps the level it starts with, so the game
+// is set again before every step and never plays long enough to rise.
+int CheckLanes(size_t gamesCount)
+{
+	NullRenderer renderer;
+	Game game(renderer);
+
+	GameLanes lanes(*ShapeFactory::GetShapeSet(), gamesCount);
+	const vector<Pit> corpus = BuildCorpus();
+
+	// games start on the corpus stacks, where pieces fill levels and clear them
+	for (size_t lane = 0; lane < gamesCount; ++lane)
+	{
+		lanes.NewGame(lane, CORPUS_SEED + lane, unsigned(lane % 10));
+
+		GamePosition position;
+		lanes.GetPosition(lane, position);
+		position.Stack = corpus[lane % CORPUS_SIZE];
+
+		if (!lanes.SetPosition(lane, position))
+		{
+			lanes.NewGame(lane, CORPUS_SEED + lane, unsigned(lane % 10));
+		}
+	}
+
+	// every other game is played by the greedy policy, which clears levels,
+	// the others by random keys, which try every key anywhere
+	Random keysRandom(CORPUS_SEED);
+	vector<GreedyPolicy> policies(gamesCount);
+
+	vector<GameKey> keys(gamesCount);
+	vector<GamePosition> positions(gamesCount);
+	vector<unsigned> playedCubesCounts(gamesCount, 0);
+	vector<bool> wereRunning(gamesCount);
+
+	uint64_t stepsCount = 0, comparedCount = 0, clearsCount = 0, divergencesCount = 0;
+
+	while (lanes.GetRunningLanesCount() > 0)
+	{
+		for (size_t lane = 0; lane < gamesCount; ++lane)
+		{
+			lanes.GetPosition(lane, positions[lane]);
+			wereRunning[lane] = !lanes.IsOver(lane);
+
+			if (lanes.GetPlayedCubesCount(lane) != playedCubesCounts[lane])
+			{
+				// plans the new piece
+				playedCubesCounts[lane] = lanes.GetPlayedCubesCount(lane);
+				policies[lane] = GreedyPolicy();
+			}
+
+			if (lane % 2 != 0)
+			{
+				keys[lane] = GetRandomStepKey(keysRandom);
+			}
+			else if (wereRunning[lane] && game.SetPosition(positions[lane]))
+			{
+				// a key every step, the policy waits 16 ticks between keys
+				keys[lane] = policies[lane].GetKey(game, stepsCount * 16);
+			}
+			else
+			{
+				keys[lane] = GAME_KEY_NONE;
+			}
+		}
+
+		lanes.Step(&keys.front());
+		++stepsCount;
+
+		for (size_t lane = 0; lane < gamesCount; ++lane)
+		{
+			if (!wereRunning[lane])
+			{
+				continue;
+			}
+
+			if (!game.SetPosition(positions[lane]))
+			{
+				cout << "game " << lane << ", step " << stepsCount << ": Game rejects the position of the lane\n";
+				++divergencesCount;
+				continue;
+			}
+
+			const GameKey key = keys[lane];
+
+			if (key != GAME_KEY_NONE)
+			{
+				game.OnKeyPressed(key);
+			}
+
+			// longer than the falling time and the move animations, a drop
+			// falls one level per update until the shape locks
+			do
+			{
+				game.Update(NANOSECONDS_PER_SECOND);
+			}
+			while (key == GAME_KEY_DROP && game.GetPlayedCubesCount() == 0);
+
+			GamePosition expected, actual;
+			game.GetPosition(expected);
+			lanes.GetPosition(lane, actual);
+
+			const char* pDifference = FindPositionDifference(expected, actual);
+
+			if (!pDifference && game.GetPlayedCubesCount() != lanes.GetPlayedCubesCount(lane) - playedCubesCounts[lane])
+			{
+				pDifference = "played cubes";
+			}
+
+			if (!pDifference && game.IsOver() != lanes.IsOver(lane))
+			{
+				pDifference = "game over";
+			}
+
+			if (pDifference)
+			{
+				// the first ones are enough to find the rule
+				if (divergencesCount < 10)
+				{
+					cout << "game " << lane << ", step " << stepsCount << ", key " << int(key) << ": " << pDifference << " differs\n";
+				}
+
+				++divergencesCount;
+			}
+
+			clearsCount += game.GetScore() > positions[lane].Score;
+			++comparedCount;
+		}
+	}
+
+	cout << gamesCount << " games over after " << stepsCount << " steps, " << comparedCount << " steps compared, "
+		<< clearsCount << " of them clearing levels\n";
+	cout << (divergencesCount == 0 ? "lanes play like Game" : "FAILED, " + nsc::NumberToString(divergencesCount) + " steps diverge") << endl;
+	return divergencesCount == 0 ? 0 : 2;
+}
+
+#pragma endregion
+
+#pragma region parse errors
+
+struct ParseErrorCase
+{
+	const char* Text;
+	const char* Message;
+};
+
+// malformed text shape sets and the errors they must report, with the line
+// and the column of the offending number after any whitespace before it
+const ParseErrorCase PARSE_ERROR_CASES[] =
+{
+	{ "5000000", "check(1:1): shapes count is too large" },
+	{ "1\n5000000\n", "check(2:1): vertices count is too large" },
+	{ "1\n  \n   5000000\n", "check(3:4): vertices count is too large" },
+	{ "1\n3\n0 0 0\n1 0 0\n0 1 0\n1\n0 1\n  7\n", "check(8:3): triangle index 7 is out of range" },
+	{ "1\n3\n0 0 0\n1 0 0\n0 1 0\n1\n0 1 2\n1\n0\n9\n", "check(10:1): line index 9 is out of range" },
+	{ "1\n0\n0\n0\nx\n", "check(5:1): invalid cubes count" },
+	{ "1\n0\n0\n0\n2\n  0 0 0\n0 0 0\n", "check(6:3): cube positions must be distinct integers to generate the mesh" },
+	{ "1\n0\n0\n0\n1\n\n0.5 0 0\n", "check(7:1): cube positions must be distinct integers to generate the mesh" },
+};
+
+// Converts every case and fails when an error differs from the expected one.
+int CheckParseErrors()
+{
+	bool isCorrect = true;
+
+	for (size_t i = 0; i < sizeof(PARSE_ERROR_CASES) / sizeof(PARSE_ERROR_CASES[0]); ++i)
+	{
+		const ParseErrorCase& errorCase = PARSE_ERROR_CASES[i];
+		string message = "no error";
+
+		try
+		{
+			vector<char> image;
+			ShapeSetImage::BuildFromText(errorCase.Text, strlen(errorCase.Text), "check", image);
+		}
+		catch (const ShapeSetError& error)
+		{
+			message = error.what();
+		}
+
+		const bool isExpected = message == errorCase.Message;
+		isCorrect = isCorrect && isExpected;
+
+		cout << message << (isExpected ? "  ok" : "  WRONG, expected " + string(errorCase.Message)) << '\n';
+	}
+
+	cout << (isCorrect ? "all errors as expected" : "FAILED, an error differs") << endl;
+	return isCorrect ? 0 : 2;
+}
+
+#pragma endregion
+
+#pragma region math
+
+// the reference values are rounded to 7 digits
+const float MATH_TOLERANCE = 1.0e-5f;
+
+// prints the case and returns false when a value is off by more than the tolerance
+bool CheckValues(const char* name, const float* pActual, const float* pExpected, size_t count)
+{
+	float largestError = 0.0f;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		largestError = max(largestError, fabsf(pActual[i] - pExpected[i]));
+	}
+
+	const bool isExpected = largestError <= MATH_TOLERANCE;
+
+	cout << left << setw(44) << name << right
+		<< (isExpected ? "  ok" : "  WRONG, off by " + nsc::NumberToString(largestError)) << '\n';
+
+	return isExpected;
+}
+
+bool CheckMatrix(const char* name, const Matrix& actual, const Matrix& expected)
+{
+	return CheckValues(name, actual, expected, 16);
+}
+
+// Compares the math functions the game uses with the values D3DX gives:
+// rotations around one axis, a rotation by known angles, exact products and
+// a transformed point. The reference rotations are computed apart from
+// SimdMath in double precision. Runs the SSE code, or the scalar code in
+// builds with MATH_NO_SIMD.
+int CheckMath()
+{
+#ifdef MATH_USE_SSE
+	cout << "SSE math\n";
+#else
+	cout << "scalar math\n";
+#endif
+
+	bool isCorrect = true;
+	Matrix matrix;
+
+	// D3DXMatrixRotationY, X and Z of a quarter turn
+	const Matrix rotationY(
+		0.0f, 0.0f, -1.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+	const Matrix rotationX(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, -1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+	const Matrix rotationZ(
+		0.0f, 1.0f, 0.0f, 0.0f,
+		-1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+
+	MatrixRotationYawPitchRoll(&matrix, PI_HALF, 0.0f, 0.0f);
+	isCorrect = CheckMatrix("MatrixRotationYawPitchRoll yaw", matrix, rotationY) && isCorrect;
+	MatrixRotationYawPitchRoll(&matrix, 0.0f, PI_HALF, 0.0f);
+	isCorrect = CheckMatrix("MatrixRotationYawPitchRoll pitch", matrix, rotationX) && isCorrect;
+	MatrixRotationYawPitchRoll(&matrix, 0.0f, 0.0f, PI_HALF);
+	isCorrect = CheckMatrix("MatrixRotationYawPitchRoll roll", matrix, rotationZ) && isCorrect;
+
+	// roll 0.7 around z, then pitch 0.5 around x, then yaw 0.3 around y
+	const Matrix yawPitchRoll(
+		0.8219544f, 0.5653542f, 0.0690336f, 0.0f,
+		-0.5070819f, 0.6712122f, 0.5406868f, 0.0f,
+		0.2593434f, -0.4794255f, 0.8383866f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+
+	MatrixRotationYawPitchRoll(&matrix, 0.3f, 0.5f, 0.7f);
+	isCorrect = CheckMatrix("MatrixRotationYawPitchRoll", matrix, yawPitchRoll) && isCorrect;
+
+	const Matrix first(
+		1.0f, 2.0f, 3.0f, 4.0f,
+		5.0f, 6.0f, 7.0f, 8.0f,
+		9.0f, 10.0f, 11.0f, 12.0f,
+		13.0f, 14.0f, 15.0f, 16.0f);
+	const Matrix second(
+		2.0f, 0.0f, 1.0f, -1.0f,
+		0.0f, 3.0f, -2.0f, 1.0f,
+		1.0f, -1.0f, 0.0f, 2.0f,
+		-3.0f, 1.0f, 2.0f, 0.0f);
+	const Matrix product(
+		-7.0f, 7.0f, 5.0f, 7.0f,
+		-7.0f, 19.0f, 9.0f, 15.0f,
+		-7.0f, 31.0f, 13.0f, 23.0f,
+		-7.0f, 43.0f, 17.0f, 31.0f);
+
+	MatrixMultiply(&matrix, &first, &second);
+	isCorrect = CheckMatrix("MatrixMultiply", matrix, product) && isCorrect;
+
+	matrix = first;
+	MatrixMultiply(&matrix, &matrix, &second);
+	isCorrect = CheckMatrix("MatrixMultiply into its first argument", matrix, product) && isCorrect;
+
+	// D3DXMatrixRotationAxis of 0.9 around (1, 2, 3)
+	const Matrix rotationAxis(
+		0.6486378f, 0.6821145f, -0.3376223f, 0.0f,
+		-0.5740030f, 0.7297214f, 0.3715201f, 0.0f,
+		0.4997894f, -0.0471858f, 0.8648607f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+
+	Quaternion quaternion;
+	const Vector3 axis(1.0f, 2.0f, 3.0f);
+	QuaternionRotationAxis(&quaternion, &axis, 0.9f);
+	MatrixRotationQuaternion(&matrix, &quaternion);
+	isCorrect = CheckMatrix("MatrixRotationQuaternion", matrix, rotationAxis) && isCorrect;
+
+	QuaternionRotationYawPitchRoll(&quaternion, 0.3f, 0.5f, 0.7f);
+	MatrixRotationQuaternion(&matrix, &quaternion);
+	isCorrect = CheckMatrix("MatrixRotationQuaternion of yaw pitch roll", matrix, yawPitchRoll) && isCorrect;
+
+	// the product rotates by the left quaternion first
+	Quaternion roll, pitch, yaw;
+	QuaternionRotationYawPitchRoll(&roll, 0.0f, 0.0f, 0.7f);
+	QuaternionRotationYawPitchRoll(&pitch, 0.0f, 0.5f, 0.0f);
+	QuaternionRotationYawPitchRoll(&yaw, 0.3f, 0.0f, 0.0f);
+	quaternion = roll * pitch * yaw;
+	MatrixRotationQuaternion(&matrix, &quaternion);
+	isCorrect = CheckMatrix("QuaternionMultiply", matrix, yawPitchRoll) && isCorrect;
+
+	const Matrix projection(
+		2.0f, 0.0f, 0.0f, 1.0f,
+		0.0f, 2.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 2.0f, 1.0f,
+		1.0f, 1.0f, 1.0f, 2.0f);
+	const Vector3 point(1.0f, 2.0f, 3.0f);
+	const Vector3 projected(0.5f, 0.8333333f, 1.1666667f);
+
+	Vector3 transformed;
+	Vec3TransformCoord(&transformed, &point, &projection);
+	isCorrect = CheckValues("Vec3TransformCoord", transformed, projected, 3) && isCorrect;
+
+	cout << (isCorrect ? "all values as expected" : "FAILED, a value differs") << endl;
+	return isCorrect ? 0 : 2;
+}
+
+#pragma endregion
+
+#pragma region render queue
+
+struct StatisticCheck
+{
+	const char* Name;
+	size_t Count;
+	size_t Expected;
+	// the expected count is the most there may be
+	bool IsBound;
+};
+
+// prints the counts and returns false when one differs from the expected one
+bool CheckStatistics(const StatisticCheck* pChecks, size_t checksCount)
+{
+	bool isCorrect = true;
+
+	for (size_t i = 0; i < checksCount; ++i)
+	{
+		const StatisticCheck& check = pChecks[i];
+		const bool isExpected = check.IsBound ? check.Count <= check.Expected : check.Count == check.Expected;
+		isCorrect = isCorrect && isExpected;
+
+		cout << left << setw(28) << check.Name << right << setw(8) << check.Count
+			<< (isExpected ? "  ok" : string("  WRONG, expected ") + (check.IsBound ? "at most " : "") + nsc::NumberToString(check.Expected)) << '\n';
+	}
+
+	return isCorrect;
+}
+
+// Flushes draws of a known state into a NullRenderer and checks every state
+// is set once per run of draws sharing it, then checks a Game::Draw frame
+// sets no state more often than it draws and shares worlds between draws.
+int CheckRenderQueue()
+{
+	NullRenderer renderer;
+
+	RenderBuffer* pSolidVertexBuffer = renderer.CreateDynamicVertexBuffer(sizeof(Vertex));
+	RenderBuffer* pOtherVertexBuffer = renderer.CreateDynamicVertexBuffer(sizeof(Vertex));
+	RenderBuffer* pSolidIndexBuffer = renderer.CreateDynamicIndexBuffer(1);
+	RenderBuffer* pOtherIndexBuffer = renderer.CreateDynamicIndexBuffer(1);
+	RenderBuffer* pOutlineIndexBuffer = renderer.CreateDynamicIndexBuffer(1);
+
+	DrawItem solid;
+	solid.pVertexBuffer = pSolidVertexBuffer;
+	solid.pIndexBuffer = pSolidIndexBuffer;
+	solid.IndicesCount = 1;
+
+	DrawItem other = solid;
+	other.pVertexBuffer = pOtherVertexBuffer;
+	other.pIndexBuffer = pOtherIndexBuffer;
+	other.DrawColor = BLUE;
+
+	DrawItem outline = solid;
+	outline.Pass = RENDER_PASS_COLORED_OUTLINES;
+	outline.Layer = RENDER_LAYER_OUTLINES;
+	outline.pIndexBuffer = pOutlineIndexBuffer;
+	outline.Topology = TOPOLOGY_LINE_LIST;
+
+	// Interleaved runs: three red and two green solid draws on one pair of
+	// buffers, two blue ones on another and an outline of the first vertex
+	// buffer in another format. Every draw has the same world. Whichever
+	// buffer sorts first, the states change as counted below.
+	RenderQueue queue;
+	const Color SOLID_COLORS[] = { RED, GREEN, RED, GREEN, RED };
+
+	for (size_t i = 0; i < sizeof(SOLID_COLORS) / sizeof(SOLID_COLORS[0]); ++i)
+	{
+		solid.DrawColor = SOLID_COLORS[i];
+		queue.Submit(solid);
+
+		if (i == 1)
+		{
+			queue.Submit(outline);
+		}
+
+		if (i % 2 == 0 && i < 4)
+		{
+			queue.Submit(other);
+		}
+	}
+
+	queue.Flush(renderer);
+
+	const RenderStatistics& statistics = renderer.GetStatistics();
+
+	const StatisticCheck QUEUE_CHECKS[] =
+	{
+		{ "draws", statistics.DrawsCount, 8, false },
+		{ "vertex buffer binds", statistics.VertexBufferBindsCount, 3, false },
+		{ "index buffer binds", statistics.IndexBufferBindsCount, 3, false },
+		{ "topology changes", statistics.TopologyChangesCount, 2, false },
+		{ "texture binds", statistics.TextureBindsCount, 0, false },
+		{ "world uploads", statistics.WorldUploadsCount, 1, false },
+		// green, red and blue solid runs and the black outline
+		{ "color uploads", statistics.ColorUploadsCount, 4, false },
+		{ "pass applies", statistics.PassAppliesCount, 4, false },
+	};
+
+	cout << "known draws\n";
+	bool isCorrect = CheckStatistics(QUEUE_CHECKS, sizeof(QUEUE_CHECKS) / sizeof(QUEUE_CHECKS[0]));
+
+	renderer.ReleaseBuffer(pSolidVertexBuffer);
+	renderer.ReleaseBuffer(pOtherVertexBuffer);
+	renderer.ReleaseBuffer(pSolidIndexBuffer);
+	renderer.ReleaseBuffer(pOtherIndexBuffer);
+	renderer.ReleaseBuffer(pOutlineIndexBuffer);
+
+	{
+		// a game with a stack, a falling shape and the next one
+		Game game(renderer, "", CORPUS_SEED);
+		FixedPolicy policy;
+
+		for (uint64_t tick = 0; tick < 4096 && !game.IsOver(); ++tick)
+		{
+			const GameKey key = policy.GetKey(game, tick);
+
+			if (key != GAME_KEY_NONE)
+			{
+				game.OnKeyPressed(key);
+			}
+
+			game.Update(TICK_TIME);
+		}
+
+		game.Draw();
+
+		const RenderStatistics& frame = renderer.GetStatistics();
+		const size_t drawsCount = frame.DrawsCount;
+
+		// every object draws its faces and its outline with one world, so
+		// there are half as many worlds as draws at most
+		const StatisticCheck FRAME_CHECKS[] =
+		{
+			{ "vertex buffer binds", frame.VertexBufferBindsCount, drawsCount, true },
+			{ "index buffer binds", frame.IndexBufferBindsCount, drawsCount, true },
+			{ "topology changes", frame.TopologyChangesCount, drawsCount, true },
+			{ "world uploads", frame.WorldUploadsCount, drawsCount / 2, true },
+			{ "color uploads", frame.ColorUploadsCount, drawsCount, true },
+			{ "pass applies", frame.PassAppliesCount, drawsCount, true },
+		};
+
+		cout << "game frame, " << drawsCount << " draws\n";
+		isCorrect = CheckStatistics(FRAME_CHECKS, sizeof(FRAME_CHECKS) / sizeof(FRAME_CHECKS[0])) && drawsCount > 0 && isCorrect;
+	}
+
+	cout << (isCorrect ? "all states set as expected" : "FAILED, a state is set more often than expected") << endl;
+	return isCorrect ? 0 : 2;
+}
+
+#pragma endregion
+
+#pragma region software renderer
+
+// the left edge of the HUD panel at a width of 800 pixels, see HudLayer
+const unsigned HUD_PANEL_X = 705;
+
+vector<uint32_t> GetFramePixels(const SoftwareRenderer& renderer)
+{
+	const uint32_t* pPixels = renderer.GetPixels();
+	return vector<uint32_t>(pPixels, pPixels + renderer.GetWidth() * renderer.GetHeight());
+}
+
+// Draws a game frame, the HUD alone and both in one frame, the way the game
+// flushes them, and checks the HUD covers its panel, lands on the scene
+// where it covers it and leaves the rest of the scene as it was.
+int CheckSoftwareHud()
+{
+	const unsigned WIDTH = 800, HEIGHT = 600;
+
+	SoftwareRenderer renderer(WIDTH, HEIGHT);
+	Game game(renderer, "", CORPUS_SEED);
+	GameSnapshot snapshot;
+	HudLayer hudLayer(renderer, BuildBoxGlyphAtlas());
+
+	game.Update(TICK_TIME);
+	game.Publish(snapshot);
+	hudLayer.Update(snapshot, WIDTH, HEIGHT);
+
+	renderer.Rasterize();
+	const vector<uint32_t> empty = GetFramePixels(renderer);
+
+	game.Draw(snapshot);
+	renderer.Rasterize();
+	const vector<uint32_t> scene = GetFramePixels(renderer);
+
+	// the camera of the game is still set, the text must not go through it
+	hudLayer.Draw();
+	renderer.Rasterize();
+	const vector<uint32_t> hud = GetFramePixels(renderer);
+
+	game.Draw(snapshot);
+	hudLayer.Draw();
+	renderer.Rasterize();
+	const vector<uint32_t> frame = GetFramePixels(renderer);
+
+	size_t scenePixelsCount = 0, panelPixelsCount = 0, hudPixelsCount = 0;
+	size_t wrongScenePixelsCount = 0, wrongHudPixelsCount = 0;
+
+	for (size_t i = 0; i < frame.size(); ++i)
+	{
+		scenePixelsCount += scene[i] != empty[i];
+
+		if (hud[i] == empty[i])
+		{
+			wrongScenePixelsCount += frame[i] != scene[i];
+			continue;
+		}
+
+		++hudPixelsCount;
+		panelPixelsCount += i % WIDTH >= HUD_PANEL_X;
+		wrongHudPixelsCount += frame[i] != hud[i];
+	}
+
+	cout << "scene pixels            " << setw(8) << scenePixelsCount << (scenePixelsCount > 0 ? "  ok\n" : "  WRONG, expected some\n");
+	cout << "HUD panel pixels        " << setw(8) << panelPixelsCount << (panelPixelsCount > 0 ? "  ok\n" : "  WRONG, expected some\n");
+	cout << "HUD pixels over scene   " << setw(8) << hudPixelsCount - wrongHudPixelsCount
+		<< (wrongHudPixelsCount == 0 ? "  ok\n" : "  WRONG, expected " + to_string(hudPixelsCount) + "\n");
+	cout << "changed scene pixels    " << setw(8) << wrongScenePixelsCount << (wrongScenePixelsCount == 0 ? "  ok\n" : "  WRONG, expected 0\n");
+
+	const bool isCorrect = scenePixelsCount > 0 && panelPixelsCount > 0 && wrongHudPixelsCount == 0 && wrongScenePixelsCount == 0;
+	cout << (isCorrect ? "all pixels as expected" : "FAILED, the HUD or the scene is missing from the frame") << endl;
+	return isCorrect ? 0 : 2;
+}
+
+// Draws whole frames the way the game does, the scene and the HUD submitted
+// and then rasterized, over every corpus stack in turn. The stack mesh is
+// rebuilt once per stack, like when a shape locks.
+int RunRenderFrames(size_t framesCount, unsigned threadsCount)
+{
+	const unsigned WIDTH = 1920, HEIGHT = 1080;
+
+	SoftwareRenderer renderer(WIDTH, HEIGHT, threadsCount);
+	Game game(renderer, "", CORPUS_SEED);
+	game.SetAspectRatio(float(WIDTH) / HEIGHT);
+	HudLayer hudLayer(renderer, BuildBoxGlyphAtlas());
+
+	const vector<Pit> corpus = BuildCorpus();
+	vector<GameSnapshot> snapshots(CORPUS_SIZE);
+
+	for (size_t state = 0; state < CORPUS_SIZE; ++state)
+	{
+		GamePosition position;
+		game.GetPosition(position);
+		position.Stack = corpus[state];
+
+		if (!game.SetPosition(position))
+		{
+			cerr << "the shape doesn't fit over corpus stack " << state << endl;
+			return 1;
+		}
+
+		game.Publish(snapshots[state]);
+	}
+
+	const int64_t start = Clock::GetSteadyClock().GetNanoseconds();
+
+	for (size_t frame = 0; frame < framesCount; ++frame)
+	{
+		const GameSnapshot& snapshot = snapshots[frame * CORPUS_SIZE / framesCount];
+
+		game.Draw(snapshot);
+		hudLayer.Update(snapshot, WIDTH, HEIGHT);
+		hudLayer.Draw();
+		renderer.Rasterize();
+
+		s_Checksum += renderer.GetPixels()[(HEIGHT / 2) * WIDTH + WIDTH / 2];
+	}
+
+	const double seconds = (Clock::GetSteadyClock().GetNanoseconds() - start) * 1.0e-9;
+
+	cout << right << setw(10) << "frames" << setw(10) << "seconds" << setw(12) << "frames/s" << '\n'
+		<< setw(10) << framesCount << fixed << setprecision(3) << setw(10) << seconds
+		<< setprecision(1) << setw(12) << (seconds > 0.0 ? framesCount / seconds : 0.0) << '\n'
+		<< "checksum " << s_Checksum << endl;
+	return 0;
+}
+
+#pragma endregion
+
+#pragma region stack mesh
+
+const Color STACK_CHECK_COLORS[] = { RED, GREEN, BLUE };
+
+// builds the mesh of the stack, prints its counts and returns false when
+// they exceed the buffers made for any stack or, unless expected is null,
+// differ from the expected vertices, triangles and lines
+bool CheckStackMesh(const string& name, const Pit& pit, const size_t* pExpected)
+{
+	StackFaceMasks faceMasks;
+	faceMasks.Rebuild(pit);
+
+	vector<ColoredVertex> vertices;
+	vector<unsigned> triangleIndices, lineIndices;
+	StackMeshBuilder::Build(faceMasks, STACK_CHECK_COLORS, sizeof(STACK_CHECK_COLORS) / sizeof(STACK_CHECK_COLORS[0]),
+		vertices, triangleIndices, lineIndices);
+
+	const size_t counts[3] = { vertices.size(), triangleIndices.size() / 3, lineIndices.size() / 2 };
+
+	const bool isInBuffers = vertices.size() <= StackMeshBuilder::GetMaxVerticesCount()
+		&& triangleIndices.size() <= StackMeshBuilder::GetMaxTriangleIndicesCount()
+		&& lineIndices.size() <= StackMeshBuilder::GetMaxLineIndicesCount();
+	const bool isExpected = !pExpected || equal(counts, counts + 3, pExpected);
+
+	cout << left << setw(16) << name << right << setw(10) << counts[0] << setw(12) << counts[1] << setw(12) << counts[2];
+
+	if (!isInBuffers)
+	{
+		cout << "  WRONG, larger than the buffers\n";
+	}
+	else if (!isExpected)
+	{
+		cout << "  WRONG, expected " << pExpected[0] << " " << pExpected[1] << " " << pExpected[2] << '\n';
+	}
+	else
+	{
+		cout << "  ok\n";
+	}
+
+	return isInBuffers && isExpected;
+}
+
+// Builds the stack mesh of fixed pits and checks the counts worked out by
+// hand, then checks that the corpus stacks and a checkerboard of cubes, which
+// shows the most faces, fit in the buffers sized by StackMeshBuilder.
+int CheckStackMeshes()
+{
+	cout << left << setw(16) << "stack" << right << setw(10) << "vertices" << setw(12) << "triangles" << setw(12) << "lines" << '\n';
+
+	bool isCorrect = true;
+
+	Pit pit;
+	const size_t EMPTY_COUNTS[3] = { 0, 0, 0 };
+	isCorrect = CheckStackMesh("empty", pit, EMPTY_COUNTS) && isCorrect;
+
+	// the top, +x and +y faces show, 3 quads with 9 unit edges between them
+	pit.Occupy(0, 0, PIT_Z_SIZE - 1);
+	const size_t CUBE_COUNTS[3] = { 3 * 4 + 9 * 2, 3 * 2, 9 };
+	isCorrect = CheckStackMesh("corner cube", pit, CUBE_COUNTS) && isCorrect;
+
+	// the top faces merge into one quad, their edges into 6 lines along x
+	// and 6 along y
+	pit.Clear();
+	pit.OccupyCells(PIT_Z_SIZE - 1, Pit::FULL_LEVEL_MASK);
+	const size_t LEVEL_COUNTS[3] = { 4 + 12 * 2, 2, 12 };
+	isCorrect = CheckStackMesh("full level", pit, LEVEL_COUNTS) && isCorrect;
+
+	const vector<Pit> corpus = BuildCorpus();
+
+	for (size_t i = 0; i < corpus.size(); ++i)
+	{
+		isCorrect = CheckStackMesh("corpus " + nsc::NumberToString(i), corpus[i], nullptr) && isCorrect;
+	}
+
+	pit.Clear();
+
+	for (size_t z = 0; z < PIT_Z_SIZE; ++z)
+	{
+		for (size_t y = 0; y < PIT_Y_SIZE; ++y)
+		{
+			for (size_t x = 0; x < PIT_X_SIZE; ++x)
+			{
+				if ((x + y + z) % 2 == 0)
+				{
+					pit.Occupy(x, y, z);
+				}
+			}
+		}
+	}
+
+	isCorrect = CheckStackMesh("checkerboard", pit, nullptr) && isCorrect;
+
+	cout << (isCorrect ? "all meshes as expected" : "FAILED, a mesh differs") << endl;
+	return isCorrect ? 0 : 2;
+}
+
+#pragma endregion
+
+#pragma region polycube counts
+
+// published counts of polycubes by number of cubes, up to rotation and up
+// to rotation and reflection
+const size_t COUNTED_CUBES_COUNT = 9;
+const size_t POLYCUBES_COUNTS[COUNTED_CUBES_COUNT] = { 1, 1, 2, 8, 29, 166, 1023, 6922, 48311 };
+const size_t REFLECTED_POLYCUBES_COUNTS[COUNTED_CUBES_COUNT] = { 1, 1, 2, 7, 23, 112, 607, 3811, 25413 };
+
+// returns false when a count differs from the published one
+bool CheckPolycubeCounts(bool isReflectionIdentified, const size_t* pExpectedCounts)
+{
+	PolycubeEnumerator::Options options;
+	options.MaxCubesCount = COUNTED_CUBES_COUNT;
+	options.IsReflectionIdentified = isReflectionIdentified;
+
+	const vector<PolycubeEnumerator::Polycube> polycubes = PolycubeEnumerator::Enumerate(options);
+
+	size_t counts[COUNTED_CUBES_COUNT] = {};
+
+	for (size_t i = 0; i < polycubes.size(); ++i)
+	{
+		++counts[polycubes[i].size() - 1];
+	}
+
+	bool isCorrect = true;
+
+	for (size_t cubes = 1; cubes <= COUNTED_CUBES_COUNT; ++cubes)
+	{
+		const bool isExpected = counts[cubes - 1] == pExpectedCounts[cubes - 1];
+		isCorrect = isCorrect && isExpected;
+
+		cout << left << setw(12) << (isReflectionIdentified ? "reflected" : "rotated") << right << setw(6) << cubes
+			<< setw(10) << counts[cubes - 1]
+			<< (isExpected ? "  ok" : "  WRONG, expected " + nsc::NumberToString(pExpectedCounts[cubes - 1])) << '\n';
+	}
+
+	return isCorrect;
+}
+
+// Enumerates the polycubes of up to COUNTED_CUBES_COUNT cubes, with mirror
+// images apart and identified, and fails when a count differs from the
+// published one.
+int CheckPolycubes()
+{
+	cout << left << setw(12) << "polycubes" << right << setw(6) << "cubes" << setw(10) << "count" << '\n';
+
+	bool isCorrect = CheckPolycubeCounts(false, POLYCUBES_COUNTS);
+	isCorrect = CheckPolycubeCounts(true, REFLECTED_POLYCUBES_COUNTS) && isCorrect;
+
+	cout << (isCorrect ? "all counts as published" : "FAILED, a count differs") << endl;
+	return isCorrect ? 0 : 2;
+}
+
+#pragma endregion
+
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned runsCount = 5;
+	string filter, jsonFileName, baselineFileName, perftPositionName;
+	double thresholdPercent = 10.0;
+	unsigned threadsCount = 0;
+	size_t allocationsPiecesCount = 0;
+	size_t lanesGamesCount = 0;
+	size_t renderFramesCount = 0;
+	bool isCheckingParseErrors = false;
+	bool isCheckingPolycubes = false;
+	bool isCheckingMath = false;
+	bool isCheckingStackMeshes = false;
+	bool isCheckingRenderQueue = false;
+	bool isCheckingSoftwareHud = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const string option = argv[i];
+
+		if (option == "-parse-errors")
+		{
+			isCheckingParseErrors = true;
+			continue;
+		}
+
+		if (option == "-polycubes")
+		{
+			isCheckingPolycubes = true;
+			continue;
+		}
+
+		if (option == "-math")
+		{
+			isCheckingMath = true;
+			continue;
+		}
+
+		if (option == "-stack-meshes")
+		{
+			isCheckingStackMeshes = true;
+			continue;
+		}
+
+		if (option == "-render-queue")
+		{
+			isCheckingRenderQueue = true;
+			continue;
+		}
+
+		if (option == "-software-hud")
+		{
+			isCheckingSoftwareHud = true;
+			continue;
+		}
+
+		if (i + 1 == argc)
+		{
+			break;
+		}
+
+		const char* value = argv[++i];
+
+		if (option == "-runs")
+		{
+			runsCount = max(atoi(value), 1);
+		}
+		else if (option == "-filter")
+		{
+			filter = value;
+		}
+		else if (option == "-json")
+		{
+			jsonFileName = value;
+		}
+		else if (option == "-baseline")
+		{
+			baselineFileName = value;
+		}
+		else if (option == "-threshold")
+		{
+			thresholdPercent = atof(value);
+		}
+		else if (option == "-perft")
+		{
+			perftPositionName = value;
+		}
+		else if (option == "-threads")
+		{
+			threadsCount = unsigned(max(atoi(value), 0));
+		}
+		else if (option == "-allocations")
+		{
+			allocationsPiecesCount = size_t(max(atoi(value), 1));
+		}
+		else if (option == "-lanes")
+		{
+			lanesGamesCount = size_t(max(atoi(value), 1));
+		}
+		else if (option == "-render-frames")
+		{
+			renderFramesCount = size_t(max(atoi(value), 1));
+		}
+	}
+
+	if (isCheckingParseErrors)
+	{
+		return CheckParseErrors();
+	}
+
+	if (isCheckingPolycubes)
+	{
+		return CheckPolycubes();
+	}
+
+	if (isCheckingMath)
+	{
+		return CheckMath();
+	}
+
+	if (isCheckingStackMeshes)
+	{
+		return CheckStackMeshes();
+	}
+
+	if (isCheckingRenderQueue)
+	{
+		return CheckRenderQueue();
+	}
+
+	if (isCheckingSoftwareHud)
+	{
+		return CheckSoftwareHud();
+	}
+
+	if (allocationsPiecesCount > 0)
+	{
+		return CheckAllocations(allocationsPiecesCount);
+	}
+
+	if (lanesGamesCount > 0)
+	{
+		return CheckLanes(lanesGamesCount);
+	}
+
+	if (renderFramesCount > 0)
+	{
+		return RunRenderFrames(renderFramesCount, threadsCount);
+	}
+
+	if (!perftPositionName.empty())
+	{
+		return RunPerft(perftPositionName, threadsCount);
+	}
+
+	NullRenderer renderer;
+	Game game(renderer);
+	Grid& grid = *Grid::GetInstance();
+
+	const ShapeSet& shapeSet = *ShapeFactory::GetShapeSet();
+	const unsigned shapesCount = unsigned(shapeSet.GetShapesCount());
+
+	const vector<Pit> corpus = BuildCorpus();
+
+	// one shape of every kind at the spawn point, above every corpus stack,
+	// made again for every state so every run moves them the same way
+	vector<Shape*> shapes(shapesCount, nullptr);
+
+	// shapes apart from each other above the stack; Destroy deletes them
+	vector<Shape*> stagedShapes;
+
+	function<void (size_t)> setCorpusState = [&](size_t state)
+	{
+		grid.SetPit(corpus[state]);
+
+		for (unsigned kind = 0; kind < shapesCount; ++kind)
+		{
+			SafeDelete(shapes[kind]);
+			shapes[kind] = ShapeFactory::CreateShape(kind);
+		}
+	};
+
+	vector<Benchmark> benchmarks;
+
+	{
+		Benchmark benchmark = { "Grid::HasBoxOn", CORPUS_SIZE, setCorpusState,
+			[&](size_t) -> uint64_t
+			{
+				for (size_t i = 0; i < 64; ++i)
+				{
+					for (size_t z = 0; z < Grid::Z_SIZE; ++z)
+					{
+						for (size_t y = 0; y < Grid::Y_SIZE; ++y)
+						{
+							for (size_t x = 0; x < Grid::X_SIZE; ++x)
+							{
+								s_Checksum += grid.HasBoxOn(x, y, z);
+							}
+						}
+					}
+				}
+
+				return 64 * Grid::X_SIZE * Grid::Y_SIZE * Grid::Z_SIZE;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	{
+		Benchmark benchmark = { "Pit::IsLevelFull", CORPUS_SIZE, setCorpusState,
+			[&](size_t) -> uint64_t
+			{
+				const Pit& pit = grid.GetPit();
+
+				for (size_t i = 0; i < 1024; ++i)
+				{
+					for (size_t z = 0; z < PIT_Z_SIZE; ++z)
+					{
+						s_Checksum += pit.IsLevelFull(z);
+					}
+				}
+
+				return 1024 * PIT_Z_SIZE;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	// The levels right above the stack are filled and cleared, so the stack
+	// is the same after every operation; the fill is part of it, like a
+	// landing piece is part of every clear in a game.
+	for (size_t cleared = 0; cleared <= MAX_CLEARED_LEVELS_COUNT; ++cleared)
+	{
+		Benchmark benchmark = { "Grid::UpdateLevels " + nsc::NumberToString(cleared), CORPUS_SIZE, setCorpusState,
+			[&, cleared](size_t) -> uint64_t
+			{
+				const size_t top = grid.GetHighestLevelWithBox();
+
+				for (size_t i = 0; i < 512; ++i)
+				{
+					for (size_t z = top - cleared; z < top; ++z)
+					{
+						for (size_t y = 0; y < Grid::Y_SIZE; ++y)
+						{
+							for (size_t x = 0; x < Grid::X_SIZE; ++x)
+							{
+								grid.SetBoxOn(x, y, z);
+							}
+						}
+					}
+
+					s_Checksum += grid.UpdateLevels();
+				}
+
+				return 512;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	{
+		Benchmark benchmark = { "Shape::TryToTranslate", CORPUS_SIZE, setCorpusState,
+			[&](size_t) -> uint64_t
+			{
+				static const float TRANSLATIONS[6][3] =
+				{
+					{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+				};
+
+				for (size_t i = 0; i < 6 * 256; ++i)
+				{
+					const float* translation = TRANSLATIONS[i % 6];
+					s_Checksum += shapes[i / 6 % shapesCount]->TryToTranslate(translation[0], translation[1], translation[2]);
+				}
+
+				return 6 * 256;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	{
+		Benchmark benchmark = { "Shape::TryToRotate", CORPUS_SIZE, setCorpusState,
+			[&](size_t) -> uint64_t
+			{
+				for (size_t i = 0; i < 12 * 64; ++i)
+				{
+					// four quarter turns around x, then y, then z
+					const size_t axis = i / 4 % 3;
+					Shape* pShape = shapes[i / 12 % shapesCount];
+					s_Checksum += pShape->TryToRotate(axis == 0 ? PI_HALF : 0.0f, axis == 1 ? PI_HALF : 0.0f, axis == 2 ? PI_HALF : 0.0f);
+				}
+
+				return 12 * 64;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	{
+		Benchmark benchmark = { "Shape::IsMovePosible", CORPUS_SIZE, setCorpusState,
+			[&](size_t) -> uint64_t
+			{
+				for (size_t i = 0; i < 4096; ++i)
+				{
+					s_Checksum += shapes[i % shapesCount]->IsMovePosible();
+				}
+
+				return 4096;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	{
+		Benchmark benchmark = { "Shape::Destroy", CORPUS_SIZE,
+			[&](size_t state)
+			{
+				grid.SetPit(corpus[state]);
+
+				// cells of the stack and of the shapes staged so far
+				Pit claimed = corpus[state];
+				stagedShapes.clear();
+
+				for (size_t z = 0; z < CORPUS_FREE_LEVELS_COUNT; ++z)
+				{
+					for (unsigned kind = 0; kind < shapesCount; ++kind)
+					{
+						Shape* pShape = ShapeFactory::CreateShape(kind);
+						const ShapeGeometry::CubesContainer& cubes = shapeSet.GetShape(kind)->GetCubesRelativePositions();
+
+						for (int y = 0; y < int(Grid::Y_SIZE) && pShape; ++y)
+						{
+							for (int x = 0; x < int(Grid::X_SIZE) && pShape; ++x)
+							{
+								bool isFree = true;
+
+								for (size_t i = 0; i < cubes.size() && isFree; ++i)
+								{
+									const int cubeX = x + Round(cubes[i].x), cubeY = y + Round(cubes[i].y), cubeZ = int(z) + Round(cubes[i].z);
+
+									isFree = cubeX >= 0 && cubeX < int(PIT_X_SIZE) && cubeY >= 0 && cubeY < int(PIT_Y_SIZE) &&
+										cubeZ >= 0 && cubeZ < int(PIT_Z_SIZE) && !claimed.IsOccupied(cubeX, cubeY, cubeZ);
+								}
+
+								// shapes spawn at the center of the top level
+								if (isFree && pShape->TryToTranslate(float(x - int(Grid::X_SIZE / 2)), float(y - int(Grid::Y_SIZE / 2)), float(z)))
+								{
+									for (size_t i = 0; i < cubes.size(); ++i)
+									{
+										claimed.Occupy(x + Round(cubes[i].x), y + Round(cubes[i].y), z + Round(cubes[i].z));
+									}
+
+									stagedShapes.push_back(pShape);
+									pShape = nullptr;
+								}
+							}
+						}
+
+						SafeDelete(pShape);
+					}
+				}
+			},
+			[&](size_t) -> uint64_t
+			{
+				for (size_t i = 0; i < stagedShapes.size(); ++i)
+				{
+					stagedShapes[i]->Destroy();
+				}
+
+				s_Checksum += grid.GetStackVersion();
+				return stagedShapes.size();
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	{
+		// the corpus stacks with a shape in the pit, written down once
+		vector<string> notations;
+
+		for (size_t i = 0; i < CORPUS_SIZE; ++i)
+		{
+			GamePosition position;
+			position.Stack = corpus[i];
+			position.ShapeKind = int(i % shapesCount);
+			position.NextShapeKind = int((i + 1) % shapesCount);
+			position.Score = unsigned(i * 37);
+			position.Level = unsigned(i % 10);
+			position.RandomState = CORPUS_SEED + i;
+
+			notations.push_back(PositionNotation::Print(position));
+		}
+
+		Benchmark parse = { "PositionNotation::Parse", CORPUS_SIZE, [](size_t) {},
+			[=](size_t state) -> uint64_t
+			{
+				for (size_t i = 0; i < 256; ++i)
+				{
+					s_Checksum += PositionNotation::Parse(notations[state]).Stack.GetHighestOccupiedLevel();
+				}
+
+				return 256;
+			} };
+		benchmarks.push_back(parse);
+
+		vector<GamePosition> positions;
+
+		for (size_t i = 0; i < CORPUS_SIZE; ++i)
+		{
+			positions.push_back(PositionNotation::Parse(notations[i]));
+		}
+
+		string text;
+
+		Benchmark print = { "PositionNotation::Print", CORPUS_SIZE, [](size_t) {},
+			[=](size_t state) mutable -> uint64_t
+			{
+				for (size_t i = 0; i < 256; ++i)
+				{
+					text.clear();
+					PositionNotation::Print(positions[state], text);
+					s_Checksum += text.size();
+				}
+
+				return 256;
+			} };
+		benchmarks.push_back(print);
+	}
+
+	{
+		// the polycubes of up to 8 cubes, 8152 of them, over again up to the
+		// count; given by their cubes, so every mesh is generated as well
+		PolycubeEnumerator::Options options;
+		options.MaxCubesCount = 8;
+
+		const vector<PolycubeEnumerator::Polycube> polycubes = PolycubeEnumerator::Enumerate(options);
+		vector<PolycubeEnumerator::Polycube> parsedPolycubes;
+
+		for (size_t i = 0; i < PARSED_SHAPES_COUNT; ++i)
+		{
+			parsedPolycubes.push_back(polycubes[i % polycubes.size()]);
+		}
+
+		ostringstream stream;
+		PolycubeEnumerator::WriteShapeSet(stream, parsedPolycubes);
+		const string text = stream.str();
+
+		vector<char> image;
+
+		// one operation is the whole file, like loading it
+		Benchmark benchmark = { "ShapeSet parse 10k", 1, [](size_t) {},
+			[=](size_t) mutable -> uint64_t
+			{
+				ShapeSetImage::BuildFromText(text.data(), text.size(), "generated", image);
+				s_Checksum += image.size();
+				return 1;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	{
+		Benchmark benchmark = { "placement enumeration", CORPUS_SIZE, setCorpusState,
+			[&](size_t) -> uint64_t
+			{
+				for (size_t i = 0; i < 64 * shapesCount; ++i)
+				{
+					const ShapeOrientationTable* pOrientations = shapeSet.GetShape(unsigned(i % shapesCount))->GetOrientations();
+
+					if (pOrientations)
+					{
+						s_Checksum += CountPlacements(grid.GetPit(), *pOrientations);
+					}
+				}
+
+				return 64 * shapesCount;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	{
+		Benchmark benchmark = { "seeded game", SEEDED_GAMES_COUNT,
+			[](size_t) {},
+			[&](size_t seed) -> uint64_t
+			{
+				s_Checksum += PlaySeededGame(game, unsigned(seed + 1));
+				return 1;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	{
+		// the baseline of the lockstep games, the same keys one game at a time
+		Benchmark benchmark = { "Game step", SEEDED_GAMES_COUNT,
+			[&](size_t seed)
+			{
+				game.SetRandomSeed(seed + 1);
+				game.NewGame();
+			},
+			[&](size_t seed) -> uint64_t
+			{
+				for (size_t step = 0; step < LOCKSTEP_STEPS_COUNT; ++step)
+				{
+					s_Checksum += StepGame(game, GetStepKey(seed, step));
+				}
+
+				return LOCKSTEP_STEPS_COUNT;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	GameLanes lanes(shapeSet, LOCKSTEP_LANES_COUNT);
+	vector<GameKey> laneKeys(LOCKSTEP_LANES_COUNT * LOCKSTEP_STEPS_COUNT);
+
+	for (size_t step = 0; step < LOCKSTEP_STEPS_COUNT; ++step)
+	{
+		for (size_t lane = 0; lane < LOCKSTEP_LANES_COUNT; ++lane)
+		{
+			laneKeys[step * LOCKSTEP_LANES_COUNT + lane] = GetStepKey(lane, step);
+		}
+	}
+
+	{
+		// one operation per game and step, as in "Game step"
+		Benchmark benchmark = { "GameLanes step " + nsc::NumberToString(LOCKSTEP_LANES_COUNT), SEEDED_GAMES_COUNT,
+			[&](size_t seed)
+			{
+				for (size_t lane = 0; lane < LOCKSTEP_LANES_COUNT; ++lane)
+				{
+					lanes.NewGame(lane, seed * LOCKSTEP_LANES_COUNT + lane + 1);
+				}
+			},
+			[&](size_t seed) -> uint64_t
+			{
+				for (size_t step = 0; step < LOCKSTEP_STEPS_COUNT; ++step)
+				{
+					lanes.Step(&laneKeys[step * LOCKSTEP_LANES_COUNT]);
+
+					// ended games start again, like in StepGame
+					if (lanes.GetRunningLanesCount() < LOCKSTEP_LANES_COUNT)
+					{
+						for (size_t lane = 0; lane < LOCKSTEP_LANES_COUNT; ++lane)
+						{
+							if (lanes.IsOver(lane))
+							{
+								s_Checksum += lanes.GetScore(lane);
+								lanes.NewGame(lane, seed + step * LOCKSTEP_LANES_COUNT + lane + 1);
+							}
+						}
+					}
+				}
+
+				return LOCKSTEP_STEPS_COUNT * LOCKSTEP_LANES_COUNT;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	HudLayer hudLayer(renderer, BuildBoxGlyphAtlas());
+	GameSnapshot hudSnapshot;
+
+	{
+		// the score changes every 64 frames, about a placed shape a second
+		Benchmark benchmark = { "HudLayer frame", CORPUS_SIZE, [](size_t) {},
+			[&](size_t state) -> uint64_t
+			{
+				for (unsigned frame = 0; frame < 4096; ++frame)
+				{
+					hudSnapshot.Score = unsigned(state * 4096 + frame) / 64;
+					hudLayer.Update(hudSnapshot, 800, 600);
+					hudLayer.Draw();
+				}
+
+				s_Checksum += hudLayer.GetUploadsCount();
+				return 4096;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	{
+		// on one thread, so the numbers don't depend on the core count
+		const PerftPosition& position = *Perft::FindStandardPosition("start");
+
+		Pit pit;
+		vector<const ShapeOrientationTable*> pieces;
+		Perft::SetUp(position, pit, pieces);
+
+		Benchmark benchmark = { "perft start 3", 1,
+			[](size_t) {},
+			[=](size_t) -> uint64_t
+			{
+				Perft::Options options;
+				options.Depth = 3;
+				options.ThreadsCount = 1;
+
+				const uint64_t nodesCount = Perft::Run(pit, pieces, options).NodesCount;
+				s_Checksum += nodesCount;
+				return nodesCount;
+			} };
+		benchmarks.push_back(benchmark);
+	}
+
+	PerfCounters counters;
+	PrintHeader(counters);
+
+	vector<BenchmarkResult> results;
+
+	for (size_t i = 0; i < benchmarks.size(); ++i)
+	{
+		if (benchmarks[i].Name.find(filter) == string::npos)
+		{
+			continue;
+		}
+
+		results.push_back(Measure(counters, benchmarks[i], runsCount));
+		PrintResult(results.back());
+	}
+
+	cout << "\nchecksum " << s_Checksum << endl;
+
+	for (unsigned kind = 0; kind < shapesCount; ++kind)
+	{
+		SafeDelete(shapes[kind]);
+	}
+
+	if (!jsonFileName.empty() && !WriteJson(jsonFileName, results))
+	{
+		cerr << "cannot write " << jsonFileName << endl;
+		return 1;
+	}
+
+	if (!baselineFileName.empty())
+	{
+		map<string, double> baseline;
+
+		if (!ReadBaseline(baselineFileName, baseline))
+		{
+			cerr << "cannot read " << baselineFileName << endl;
+			return 1;
+		}
+
+		if (CompareWithBaseline(results, baseline, thresholdPercent) > 0)
+		{
+			return 2;
+		}
+	}
+
+	return 0;
+}
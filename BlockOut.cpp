@@ -1,116 +1,146 @@
 #include "pch.h"
 #include "BlockOut.h"
 
-#include "Box.h"
-#include "Grid.h"
-#include "LevelPole.h"
-#include "ShapeFactory.h"
-#include "Shape.h"
+#include "D3D10Renderer.h"
+#include "Game.h"
+#include "Simulation.h"
+#include "HudLayer.h"
+#include "ShapeSetParser.h"
+#include "AllocationTracker.h"
 
 using namespace std;
 using namespace nsc;
 
-const Vector3 SHAPE_INITIAL_POSITION_IN_GRID(0.0f, 0.0f, 6.6f);
 const char* HIGH_SCORE_FILE_NAME = "score.txt";
-const int LAST_LEVEL = 9;
-const float LEVEL_TIME_INTERVAL = 60.0f;
+const char* PROFILE_FILE_NAME = "profile.csv";
 
-void DrawText(int x, int y, const string& text, ID3DX10Font* pFont, const Color& color = WHITE)
+const double PROFILE_OVERLAY_UPDATE_INTERVAL = 0.5;	// in seconds
+
+// the font of BuildFont
+const int FONT_HEIGHT = 24;
+const char* FONT_FACE_NAME = "Times New Roman";
+
+const unsigned GLYPH_ATLAS_SIZE = 256;
+
+void DrawText(int x, int y, const char* text, ID3DX10Font* pFont, const Color& color = WHITE)
 {
 	RECT rect = {x, y, 0, 0};
-	pFont->DrawText(0, text.c_str(), -1, &rect, DT_NOCLIP, color);
+	pFont->DrawText(0, text, -1, &rect, DT_NOCLIP, D3DXCOLOR(color));
+}
+
+// the overlay is drawn every frame, so no strings
+const char* ToMilliseconds(int64_t nanoseconds, char (&text)[16])
+{
+	snprintf(text, sizeof(text), "%.2f", nanoseconds / 1.0e6);
+	return text;
 }
 
-float ComputeFallingTimeForLevel(int level)
+GameKey ToGameKey(unsigned key)
 {
-	assert(level <= LAST_LEVEL);
-	return (LAST_LEVEL - level) * 0.1f;
+	switch (key)
+	{
+	case VK_RETURN:	return GAME_KEY_NEW_GAME;
+	case 'P':
+	case VK_PAUSE:	return GAME_KEY_PAUSE;
+	case 'M':		return GAME_KEY_TOGGLE_STACK_RENDER_MODE;
+	case VK_LEFT:	return GAME_KEY_LEFT;
+	case VK_RIGHT:	return GAME_KEY_RIGHT;
+	case VK_UP:		return GAME_KEY_UP;
+	case VK_DOWN:	return GAME_KEY_DOWN;
+	case VK_SPACE:	return GAME_KEY_DROP;
+	case 'A':		return GAME_KEY_ROTATE_X_NEGATIVE;
+	case 'Q':		return GAME_KEY_ROTATE_X_POSITIVE;
+	case 'S':		return GAME_KEY_ROTATE_Y_NEGATIVE;
+	case 'W':		return GAME_KEY_ROTATE_Y_POSITIVE;
+	case 'D':		return GAME_KEY_ROTATE_Z_NEGATIVE;
+	case 'E':		return GAME_KEY_ROTATE_Z_POSITIVE;
+	default:		return GAME_KEY_NONE;
+	}
 }
 
-BlockOut::BlockOut(HINSTANCE hInstance)
+BlockOut::BlockOut(HINSTANCE hInstance, const string& shapeSetFileName)
 	: D3DApplication(hInstance)
+	, m_ShapeSetFileName(shapeSetFileName)
 	, m_pEffect(nullptr)
-	, m_pEffectViewProjection(nullptr)
 	, m_pVertexLayout(nullptr)
+	, m_pInstancedVertexLayout(nullptr)
+	, m_pColoredVertexLayout(nullptr)
+	, m_pTextVertexLayout(nullptr)
 	, m_pTransparentBS(nullptr)
+	, m_pDepthStencilState(nullptr)
 	, m_pFont(nullptr)
-	, m_pGrid(nullptr)
-	, m_pLevelPole(nullptr)
-	, m_pCurrentShape(nullptr)
-	, m_pNextShape(nullptr)
-	, m_Level(0)
-	, m_PlayedCubesCount(0)
-	, m_Score(0)
-	, m_HighScore(0)
-	, m_LastKeyPressed(0) 
-	, m_NextLevelStartTime(LEVEL_TIME_INTERVAL)
-	, m_ShapeFallingTime(ComputeFallingTimeForLevel(0))
-	, m_CurrentTimeAfterLastFall(0.0f)
-	, m_IsGamePaused(false)
-	, m_IsGameOver(false)
+	, m_pRenderer(nullptr)
+	, m_pGame(nullptr)
+	, m_pSimulation(nullptr)
+	, m_pHudLayer(nullptr)
+	, m_IsProfileOverlayVisible(false)
+	, m_ProfileOverlayUpdateTime(0.0)
 {
-	D3DXMatrixIdentity(&m_View);
-	D3DXMatrixIdentity(&m_Projection);
+	memset(m_ProfileOverlayStatistics, 0, sizeof(m_ProfileOverlayStatistics));
 }
 
 BlockOut::~BlockOut()
 {
-	WriteHighScore();
+	// the game belongs to this thread again once the simulation stopped
+	SafeDelete(m_pSimulation);
+
+	if (m_pGame)
+	{
+		WriteHighScore();
+		FrameProfiler::WriteCsv(PROFILE_FILE_NAME);
+	}
 
 	if (m_pDevice)
 	{
 		m_pDevice->ClearState();
 	}
 
-	Box::ReleaseBuffers();
-	ShapeFactory::ReleaseBuffers();
+	// the game and the HUD release their buffers through the renderer
+	SafeDelete(m_pGame);
+	SafeDelete(m_pHudLayer);
+	SafeDelete(m_pRenderer);
 
 	SafeRelease(m_pEffect);
 	SafeRelease(m_pVertexLayout);
+	SafeRelease(m_pInstancedVertexLayout);
+	SafeRelease(m_pColoredVertexLayout);
+	SafeRelease(m_pTextVertexLayout);
 	SafeRelease(m_pTransparentBS);
+	SafeRelease(m_pDepthStencilState);
 	SafeRelease(m_pFont);
-
-	SafeDelete(m_pGrid);
-	SafeDelete(m_pLevelPole);
-	SafeDelete(m_pCurrentShape);
-	SafeDelete(m_pNextShape);
 }
 
 void BlockOut::InitApplication()
 {
 	__super::InitApplication();
 
-	srand((unsigned)time(nullptr));
-
 	BuildEffect();
 	BuildVertexLayout();
 	BuildBlendStates();
 	BuildDepthStencilState();
 	BuildFont();
 
-	ReadHighScore();
-
-	GameObject::InitializeRenderingParameters(m_pDevice, m_pEffect);
-	Box::Initialize();
+	ID3D10InputLayout* vertexLayouts[VERTEX_FORMATS_COUNT] = { m_pVertexLayout, m_pInstancedVertexLayout, m_pColoredVertexLayout, m_pTextVertexLayout };
+	m_pRenderer = new D3D10Renderer(m_pDevice, m_pEffect, vertexLayouts);
 
-	// set scene
-	m_pGrid = Grid::Create();
-	m_pGrid->SetPosition(-2.5f, -2.5f, 6.1f);
+	BuildHudLayer();
 
-	m_pLevelPole = LevelPole::Create();
-	m_pLevelPole->SetScale(0.4f, 0.4f, 0.4f);
-	m_pLevelPole->SetPosition(-3.15f, -2.35f, 6.1f);
+	try
+	{
+		m_pGame = new Game(*m_pRenderer, m_ShapeSetFileName, uint64_t(time(nullptr)));
+	}
+	catch (const ShapeSetError& error)
+	{
+		::MessageBox(0, error.what(), "Error", MB_ICONERROR);
+		exit(1);
+	}
 
-	SetCurrentAndNextShapes();
+	m_pGame->SetAspectRatio(float(m_ClientWidth) / m_ClientHeight);
 
-	// Build the view matrix.
-	Vector3 position(0.0f, 0.0f, 0.0f);
-	Vector3 target(0.0f, 0.0f, 1.0f);
-	Vector3 up(0.0f, 1.0f, 0.0f);
-	D3DXMatrixLookAtLH(&m_View, &position, &target, &up);
+	ReadHighScore();
 
-	Matrix VP = m_View * m_Projection;
-	m_pEffectViewProjection->SetMatrix((float*)&VP);
+	m_pSimulation = new Simulation(*m_pGame);
+	m_pSimulation->Start();
 }
 
 void BlockOut::OnResize()
@@ -118,140 +148,48 @@ void BlockOut::OnResize()
 	__super::OnResize();
 
 	// Recalculate the projection matrix
-	float aspectRatio = float(m_ClientWidth) / m_ClientHeight;
-	D3DXMatrixPerspectiveFovLH(&m_Projection, 0.25f * PI, aspectRatio, 1.0f, 1000.0f);
+	if (m_pGame)
+	{
+		m_pGame->SetAspectRatio(float(m_ClientWidth) / m_ClientHeight);
+	}
 }
 
 void BlockOut::UpdateScene( float deltaTime )
 {
+	// the game is updated by the simulation thread
 	__super::UpdateScene(deltaTime);
-
-	switch (m_LastKeyPressed)
-	{
-	case VK_RETURN:
-		if (m_IsGameOver)
-		{
-			NewGame();
-		}
-		break;
-	case VK_ESCAPE:
-		::PostQuitMessage(0);
-		break;
-	case 'P':
-	case VK_PAUSE:
-		m_IsGamePaused = !m_IsGamePaused;
-		m_IsGamePaused ? m_GameTimer.Stop() : m_GameTimer.Start();
-		m_LastKeyPressed = 0;
-		break;
-	}
-
-	if (m_IsGameOver || m_IsGamePaused)
-	{
-		return;
-	}
-
-	m_CurrentTimeAfterLastFall += deltaTime;
-
-	if (!m_pCurrentShape->IsAnimationStarted())
-	{
-		if (m_LastKeyPressed != 0)
-		{
-			switch (m_LastKeyPressed)
-			{
-			case VK_LEFT:
-				m_pCurrentShape->TryToTranslate(-1, 0, 0);
-				break;
-			case VK_RIGHT:
-				m_pCurrentShape->TryToTranslate(1, 0, 0);
-				break;
-			case VK_UP:
-				m_pCurrentShape->TryToTranslate(0, 1, 0);
-				break;
-			case VK_DOWN:
-				m_pCurrentShape->TryToTranslate(0, -1, 0);
-				break;
-			case VK_SPACE:
-				MoveDownCurrentShape();
-				break;
-			case 'A':
-				m_pCurrentShape->TryToRotate(-PI_HALF, 0, 0);
-				break;
-			case 'Q':
-				m_pCurrentShape->TryToRotate(PI_HALF, 0, 0);
-				break;
-			case 'S':
-				m_pCurrentShape->TryToRotate(0, -PI_HALF, 0);
-				break;
-			case 'W':
-				m_pCurrentShape->TryToRotate(0, PI_HALF, 0);
-				break;
-			case 'D':
-				m_pCurrentShape->TryToRotate(0, 0, -PI_HALF);
-				break;
-			case 'E':
-				m_pCurrentShape->TryToRotate(0, 0, PI_HALF);
-				break;
-			}
-
-			if (m_LastKeyPressed != VK_SPACE)
-			{
-				m_LastKeyPressed = 0;
-			}
-		}
-		else if (m_ShapeFallingTime <= m_CurrentTimeAfterLastFall)
-		{
-			m_CurrentTimeAfterLastFall = 0.0f;
-			MoveDownCurrentShape();
-		}
-	}
-
-	if (m_GameTimer.GetGameTime() > m_NextLevelStartTime && m_Level < LAST_LEVEL)
-	{
-		++m_Level;
-		m_NextLevelStartTime += LEVEL_TIME_INTERVAL;
-		m_ShapeFallingTime = ComputeFallingTimeForLevel(m_Level);
-	}
-
-	m_pCurrentShape->Update(deltaTime);
-	m_pNextShape->RotateY(deltaTime);
-	m_pLevelPole->Update(m_pCurrentShape->GetShapeHeightInGrid());
 }
 
 void BlockOut::DrawScene()
 {
 	__super::DrawScene();
 
-	// Restore default states and vertex layout
+	// Restore default states, the vertex layout is bound by the renderer
 	m_pDevice->OMSetDepthStencilState(m_pDepthStencilState, 0);
 	float blendFactors[] = {0.0f, 0.0f, 0.0f, 0.0f};
 	m_pDevice->OMSetBlendState(m_pTransparentBS, blendFactors, 0xffffffff);
-	m_pDevice->IASetInputLayout(m_pVertexLayout);
 
-	m_pGrid->Draw();
-	m_pLevelPole->Draw();
-	
-	if (!m_IsGamePaused && !m_IsGameOver)
-	{
-		m_pGrid->DrawBoxes();
-		m_pCurrentShape->Draw();
-		m_pNextShape->Draw();
-	}
-	else if (m_IsGamePaused)
-	{
-		m_pNextShape->Draw();
+	// an inactive window holds the game like it did when it was updated here
+	m_pSimulation->SetSuspended(m_IsPaused);
 
-		DrawText(m_ClientWidth / 2 - 30, m_ClientHeight / 2 - 10, "PAUSE", m_pFont, RED);
-	}
-	else if (m_IsGameOver)
+	const GameSnapshot& snapshot = m_pSimulation->GetLatestSnapshot();
+	m_pGame->Draw(snapshot);
+
+	// text goes over the scene
 	{
-		m_pGrid->DrawBoxes();
+		ScopedPhaseTimer timer(PHASE_DRAW_HUD);
+		AllocationScope allocationScope(ALLOCATION_TAG_HUD);
 
-		DrawText(m_ClientWidth / 2 - 60, m_ClientHeight / 2 - 20, "GAME OVER", m_pFont, WHITE);
-		DrawText(m_ClientWidth / 2 - 130, m_ClientHeight / 2, "Press ENTER to start new game", m_pFont, WHITE);
+		m_pHudLayer->Update(snapshot, m_ClientWidth, m_ClientHeight);
+		m_pHudLayer->Draw();
+
+		if (m_IsProfileOverlayVisible)
+		{
+			DrawProfileOverlay();
+		}
 	}
-	
-	DrawGameInfo();
 
+	ScopedPhaseTimer timer(PHASE_PRESENT);
 	m_pSwapChain->Present(0, 0);
 }
 
@@ -277,8 +215,6 @@ void BlockOut::BuildEffect()
 		DXTrace(__FILE__, (DWORD)__LINE__, hr, "D3DX10CreateEffectFromFile", true);
 #endif
 	}
-
-	m_pEffectViewProjection = m_pEffect->GetVariableByName("g_ViewProjection")->AsMatrix();
 }
 
 void BlockOut::BuildVertexLayout()
@@ -294,6 +230,41 @@ void BlockOut::BuildVertexLayout()
 	m_pEffect->GetTechniqueByName("BlockOutTechnique")->GetPassByIndex(0)->GetDesc(&passDescription);
 	HR(m_pDevice->CreateInputLayout(vertexDescription, 1, passDescription.pIAInputSignature,
 		passDescription.IAInputSignatureSize, &m_pVertexLayout));
+
+	// Create the instanced input layout, see StackInstance.
+	D3D10_INPUT_ELEMENT_DESC instancedVertexDescription[] =
+	{
+		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D10_INPUT_PER_VERTEX_DATA, 0},
+		{"CELL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D10_INPUT_PER_INSTANCE_DATA, 1},
+		{"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 12, D3D10_INPUT_PER_INSTANCE_DATA, 1},
+	};
+
+	m_pEffect->GetTechniqueByName("InstancedTechnique")->GetPassByIndex(0)->GetDesc(&passDescription);
+	HR(m_pDevice->CreateInputLayout(instancedVertexDescription, 3, passDescription.pIAInputSignature,
+		passDescription.IAInputSignatureSize, &m_pInstancedVertexLayout));
+
+	// Create the colored vertex input layout, see ColoredVertex.
+	D3D10_INPUT_ELEMENT_DESC coloredVertexDescription[] =
+	{
+		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D10_INPUT_PER_VERTEX_DATA, 0},
+		{"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D10_INPUT_PER_VERTEX_DATA, 0},
+	};
+
+	m_pEffect->GetTechniqueByName("ColoredTechnique")->GetPassByIndex(0)->GetDesc(&passDescription);
+	HR(m_pDevice->CreateInputLayout(coloredVertexDescription, 2, passDescription.pIAInputSignature,
+		passDescription.IAInputSignatureSize, &m_pColoredVertexLayout));
+
+	// Create the text vertex input layout, see TextVertex.
+	D3D10_INPUT_ELEMENT_DESC textVertexDescription[] =
+	{
+		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D10_INPUT_PER_VERTEX_DATA, 0},
+		{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D10_INPUT_PER_VERTEX_DATA, 0},
+		{"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 20, D3D10_INPUT_PER_VERTEX_DATA, 0},
+	};
+
+	m_pEffect->GetTechniqueByName("TextTechnique")->GetPassByIndex(0)->GetDesc(&passDescription);
+	HR(m_pDevice->CreateInputLayout(textVertexDescription, 3, passDescription.pIAInputSignature,
+		passDescription.IAInputSignatureSize, &m_pTextVertexLayout));
 }
 
 void BlockOut::BuildBlendStates()
@@ -329,7 +300,7 @@ void BlockOut::BuildDepthStencilState()
 void BlockOut::BuildFont()
 {
 	D3DX10_FONT_DESC fontDescription;
-	fontDescription.Height			 = 24;
+	fontDescription.Height			= FONT_HEIGHT;
 	fontDescription.Width			= 0;
 	fontDescription.Weight			= 0;
 	fontDescription.MipLevels		= 1;
@@ -338,118 +309,150 @@ void BlockOut::BuildFont()
 	fontDescription.OutputPrecision	= OUT_DEFAULT_PRECIS;
 	fontDescription.Quality			= DEFAULT_QUALITY;
 	fontDescription.PitchAndFamily	= DEFAULT_PITCH | FF_DONTCARE;
-	strcpy(fontDescription.FaceName, "Times New Roman");
+	strcpy(fontDescription.FaceName, FONT_FACE_NAME);
 
 	D3DX10CreateFontIndirect(m_pDevice, &fontDescription, &m_pFont);
 }
 
-void BlockOut::NewGame()
+void BlockOut::BuildHudLayer()
 {
-	m_Level = 0;
-	m_PlayedCubesCount = 0;
-	m_Score = 0;
-	m_CurrentTimeAfterLastFall = 0.0f;
-	m_NextLevelStartTime = LEVEL_TIME_INTERVAL;
-	m_ShapeFallingTime = ComputeFallingTimeForLevel(0);
-	m_LastKeyPressed = 0;
-	m_IsGameOver = false;
-	m_pGrid->DeleteBoxes();
-	SetCurrentAndNextShapes();
-	m_GameTimer.Reset();
+	m_pHudLayer = new HudLayer(*m_pRenderer, BuildGlyphAtlas());
 }
 
-void BlockOut::GameOver()
+GlyphAtlas BlockOut::BuildGlyphAtlas()
 {
-	m_GameTimer.Stop();
-	m_IsGameOver = true;
+	// GDI rasterizes the glyphs of the same font the profile overlay uses
+	HDC hdc = ::CreateCompatibleDC(nullptr);
+	HFONT hFont = ::CreateFont(FONT_HEIGHT, 0, 0, 0, FW_DONTCARE, FALSE, FALSE, FALSE, DEFAULT_CHARSET,
+		OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, FONT_FACE_NAME);
+	HGDIOBJ hPreviousFont = ::SelectObject(hdc, hFont);
+
+	TEXTMETRIC textMetrics;
+	::GetTextMetrics(hdc, &textMetrics);
+
+	GlyphAtlas atlas(GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE, textMetrics.tmHeight);
+
+	const MAT2 identity = { {0, 1}, {0, 0}, {0, 0}, {0, 1} };
+	vector<uint8_t> bitmap, coverage;
+
+	for (char character = GlyphAtlas::FIRST_CHARACTER; character <= GlyphAtlas::LAST_CHARACTER; ++character)
+	{
+		GLYPHMETRICS metrics;
+		DWORD size = ::GetGlyphOutline(hdc, character, GGO_GRAY8_BITMAP, &metrics, 0, nullptr, &identity);
+
+		if (size == GDI_ERROR)
+		{
+			continue;
+		}
+
+		// blanks have no bitmap, only an advance
+		unsigned width = 0, height = 0;
+
+		if (size > 0)
+		{
+			bitmap.resize(size);
+			::GetGlyphOutline(hdc, character, GGO_GRAY8_BITMAP, &metrics, size, &bitmap.front(), &identity);
+
+			// rows are DWORD aligned and the levels go from 0 to 64
+			width = metrics.gmBlackBoxX;
+			height = metrics.gmBlackBoxY;
+			const unsigned pitch = (width + 3) & ~3u;
+
+			coverage.resize(width * height);
+
+			for (unsigned y = 0; y < height; ++y)
+			{
+				for (unsigned x = 0; x < width; ++x)
+				{
+					coverage[y * width + x] = uint8_t(min(bitmap[y * pitch + x] * 4u, 255u));
+				}
+			}
+		}
+
+		atlas.AddGlyph(character, width, height, metrics.gmptGlyphOrigin.x, textMetrics.tmAscent - metrics.gmptGlyphOrigin.y,
+			metrics.gmCellIncX, width > 0 ? &coverage.front() : nullptr);
+	}
+
+	::SelectObject(hdc, hPreviousFont);
+	::DeleteObject(hFont);
+	::DeleteDC(hdc);
+
+	return atlas;
 }
 
 void BlockOut::ReadHighScore()
 {
 	ifstream file(HIGH_SCORE_FILE_NAME);
 
-	if (!file.fail())
+	unsigned highScore = 0;
+
+	if (file >> highScore)
 	{
-		file >> m_HighScore;
+		m_pGame->SetHighScore(highScore);
 	}
 }
 
 void BlockOut::WriteHighScore() const
 {
 	ofstream file(HIGH_SCORE_FILE_NAME);
-	file << m_HighScore;
+	file << m_pGame->GetHighScore();
 }
 
-void BlockOut::SetCurrentAndNextShapes()
+void BlockOut::DrawProfileOverlay()
 {
-	ShapeFactory::LoadShapeSetFromFile("FlatFun.txt");
-	m_pCurrentShape = ShapeFactory::CreateRandomShape();
-	m_pCurrentShape->SetPosition(SHAPE_INITIAL_POSITION_IN_GRID);
-	SetNextShapePreview();
-}
+	if (m_GameTimer.GetGameTime() >= m_ProfileOverlayUpdateTime)
+	{
+		for (unsigned phase = 0; phase < PROFILE_PHASES_COUNT; ++phase)
+		{
+			m_ProfileOverlayStatistics[phase] = FrameProfiler::GetStatistics(ProfilePhase(phase));
+		}
 
-void BlockOut::SetNextShapePreview()
-{
-	m_pNextShape = ShapeFactory::CreateRandomShape();
-	
-	m_pNextShape->SetScale(0.20f, 0.20f, 0.20f);
-	m_pNextShape->RotateZ(PI / 2);
-	m_pNextShape->SetPosition(2.9f, 0.9f, 6.0f);
-}
+		m_ProfileOverlayUpdateTime = m_GameTimer.GetGameTime() + PROFILE_OVERLAY_UPDATE_INTERVAL;
+	}
 
-void BlockOut::DrawGameInfo() const
-{
-	// current level
-	DrawText(705, 20, "LEVEL: " + NumberToString(m_Level), m_pFont);
-
-	// next shape
-	DrawText(705, 80, "NEXT", m_pFont);
-	DrawText(705, 100, "SHAPE:", m_pFont);
-
-	// cubes played
-	DrawText(705, 250, "CUBES", m_pFont);
-	DrawText(705, 270, "PLAYED:", m_pFont);
-	DrawText(705, 300, NumberToString(m_PlayedCubesCount), m_pFont);
-
-	// score
-	DrawText(705, 350, "SCORE:", m_pFont);
-	DrawText(705, 380, NumberToString(m_Score), m_pFont);
-
-	// high score
-	DrawText(705, 430, "HIGH", m_pFont);
-	DrawText(705, 450, "SCORE:", m_pFont);
-	DrawText(705, 480, NumberToString(m_HighScore), m_pFont);
-}
+	const int columns[] = {10, 170, 240, 310, 380};
 
-void BlockOut::MoveDownCurrentShape()
-{
-	if (!m_pCurrentShape->TryToTranslate(0, 0, 1))
-	{
-		m_PlayedCubesCount += m_pCurrentShape->GetCompoundedBlocksCount();
-		m_pCurrentShape->Destroy();
-		m_Score += m_pGrid->UpdateLevels() * (m_Level + 1);
+	DrawText(columns[0], 10, "ms", m_pFont, YELLOW);
+	DrawText(columns[1], 10, "p50", m_pFont, YELLOW);
+	DrawText(columns[2], 10, "p99", m_pFont, YELLOW);
+	DrawText(columns[3], 10, "p99.9", m_pFont, YELLOW);
+	DrawText(columns[4], 10, "max", m_pFont, YELLOW);
 
-		if (m_Score > m_HighScore)
-		{
-			m_HighScore = m_Score;
-		}
+	int y = 34;
 
-		if (m_pGrid->HasBoxOnHighestLevel())
+	for (unsigned phase = 0; phase < PROFILE_PHASES_COUNT; ++phase)
+	{
+		const PhaseStatistics& statistics = m_ProfileOverlayStatistics[phase];
+
+		if (statistics.Count == 0)
 		{
-			GameOver();
+			continue;
 		}
 
-		m_pNextShape->SetWorldTransformationToIdentity();
-		m_pCurrentShape = m_pNextShape;
-		m_pCurrentShape->SetPosition(SHAPE_INITIAL_POSITION_IN_GRID);
-		SetNextShapePreview();
+		char text[16];
 
-		m_LastKeyPressed = 0;
-		m_CurrentTimeAfterLastFall = 0.0f;
+		DrawText(columns[0], y, FrameProfiler::GetPhaseName(ProfilePhase(phase)), m_pFont, YELLOW);
+		DrawText(columns[1], y, ToMilliseconds(statistics.P50, text), m_pFont, YELLOW);
+		DrawText(columns[2], y, ToMilliseconds(statistics.P99, text), m_pFont, YELLOW);
+		DrawText(columns[3], y, ToMilliseconds(statistics.P999, text), m_pFont, YELLOW);
+		DrawText(columns[4], y, ToMilliseconds(statistics.Max, text), m_pFont, YELLOW);
+		y += 24;
 	}
 }
 
 void BlockOut::OnKeyPressed(unsigned key)
 {
-	m_LastKeyPressed = key;
+	if (key == VK_ESCAPE)
+	{
+		::PostQuitMessage(0);
+		return;
+	}
+
+	if (key == VK_F3)
+	{
+		m_IsProfileOverlayVisible = !m_IsProfileOverlayVisible;
+		return;
+	}
+
+	m_pSimulation->PostKey(ToGameKey(key));
 }
@@ -20,6 +20,31 @@ float4 PS(float4 iPositionH : SV_POSITION) : SV_Target
 	return g_Color;
 }
 
+struct InstancedVertexOut
+{
+	float4 PositionH	: SV_POSITION;
+	float4 Color		: COLOR;
+};
+
+// one unit cube per instance, moved to its cell in the grid
+InstancedVertexOut InstancedVS(float3 iPositionL : POSITION, float3 iCell : CELL, float4 iColor : COLOR)
+{
+	InstancedVertexOut output;
+	output.PositionH = mul(float4(iPositionL + iCell, 1.0f), mul(g_World, g_ViewProjection));
+	output.Color = iColor;
+	return output;
+}
+
+float4 InstanceColorPS(InstancedVertexOut input) : SV_Target
+{
+	return input.Color;
+}
+
+float4 OutlinePS(InstancedVertexOut input) : SV_Target
+{
+	return g_Color;
+}
+
 technique10 BlockOutTechnique
 {
 	pass P0
@@ -29,3 +54,109 @@ technique10 BlockOutTechnique
 		SetPixelShader(CompileShader(ps_4_0, PS()));
 	}
 }
+
+struct ColoredVertexOut
+{
+	float4 PositionH	: SV_POSITION;
+	float4 Color		: COLOR;
+};
+
+ColoredVertexOut ColoredVS(float3 iPositionL : POSITION, float4 iColor : COLOR)
+{
+	ColoredVertexOut output;
+	output.PositionH = mul(float4(iPositionL, 1.0f), mul(g_World, g_ViewProjection));
+	output.Color = iColor;
+	return output;
+}
+
+float4 VertexColorPS(ColoredVertexOut input) : SV_Target
+{
+	return input.Color;
+}
+
+float4 ColoredOutlinePS(ColoredVertexOut input) : SV_Target
+{
+	return g_Color;
+}
+
+technique10 InstancedTechnique
+{
+	// faces
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, InstancedVS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, InstanceColorPS()));
+	}
+
+	// outlines
+	pass P1
+	{
+		SetVertexShader(CompileShader(vs_4_0, InstancedVS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, OutlinePS()));
+	}
+}
+
+technique10 ColoredTechnique
+{
+	// faces
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, ColoredVS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, VertexColorPS()));
+	}
+
+	// outlines
+	pass P1
+	{
+		SetVertexShader(CompileShader(vs_4_0, ColoredVS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, ColoredOutlinePS()));
+	}
+}
+
+Texture2D g_Atlas;
+
+SamplerState g_AtlasSampler
+{
+	Filter = MIN_MAG_MIP_POINT;
+	AddressU = CLAMP;
+	AddressV = CLAMP;
+};
+
+struct TextVertexOut
+{
+	float4 PositionH	: SV_POSITION;
+	float2 TexCoord		: TEXCOORD;
+	float4 Color		: COLOR;
+};
+
+// text is placed in pixels, g_World maps them to clip space
+TextVertexOut TextVS(float3 iPositionL : POSITION, float2 iTexCoord : TEXCOORD, float4 iColor : COLOR)
+{
+	TextVertexOut output;
+	output.PositionH = mul(float4(iPositionL, 1.0f), g_World);
+	output.TexCoord = iTexCoord;
+	output.Color = iColor;
+	return output;
+}
+
+// the atlas holds the coverage of the glyphs
+float4 TextPS(TextVertexOut input) : SV_Target
+{
+	float4 color = input.Color;
+	color.a *= g_Atlas.Sample(g_AtlasSampler, input.TexCoord).r;
+	return color;
+}
+
+technique10 TextTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, TextVS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, TextPS()));
+	}
+}
@@ -1,15 +1,22 @@
 #pragma once
 
 #include "D3DApplication.h"
+#include "FrameProfiler.h"
 
-class Grid;
-class Shape;
-class LevelPole;
+class Game;
+class GlyphAtlas;
+class HudLayer;
+class Renderer;
+class Simulation;
+struct GameSnapshot;
 
+// Window, Direct3D device and text around the portable Game. The game runs
+// on the simulation thread, the window thread draws its latest snapshot.
 class BlockOut : public D3DApplication
 {
 public:
-	BlockOut(HINSTANCE hInstance);
+	// an empty shapeSetFileName selects the embedded default shape set
+	BlockOut(HINSTANCE hInstance, const std::string& shapeSetFileName = "");
 	virtual ~BlockOut();
 
 	virtual void InitApplication();
@@ -17,55 +24,42 @@ public:
 	virtual void UpdateScene(float deltaTime);
 	virtual void DrawScene();
 
+	// the glyphs of the HUD font, rasterized by GDI
+	static GlyphAtlas BuildGlyphAtlas();
+
 private:
 	void BuildEffect();
 	void BuildVertexLayout();
 	void BuildBlendStates();
 	void BuildDepthStencilState();
 	void BuildFont();
-
-	void NewGame();
-	void GameOver();
+	void BuildHudLayer();
 
 	void ReadHighScore();
 	void WriteHighScore() const;
 
-	void SetCurrentAndNextShapes();
-	void SetNextShapePreview();
-
-	void DrawGameInfo() const;
-
-	void MoveDownCurrentShape();
+	void DrawProfileOverlay();
 
 	virtual void OnKeyPressed(unsigned key);
 
-	Matrix m_View;
-	Matrix m_Projection;
+	std::string m_ShapeSetFileName;
 
 	ID3D10Effect*				m_pEffect;
 	ID3D10InputLayout*			m_pVertexLayout;
-	ID3D10EffectMatrixVariable*	m_pEffectViewProjection;
+	ID3D10InputLayout*			m_pInstancedVertexLayout;
+	ID3D10InputLayout*			m_pColoredVertexLayout;
+	ID3D10InputLayout*			m_pTextVertexLayout;
 	ID3D10BlendState*			m_pTransparentBS;
 	ID3D10DepthStencilState*	m_pDepthStencilState;
 	ID3DX10Font*				m_pFont;
 
-	Grid*		m_pGrid;
-	LevelPole*	m_pLevelPole;
-	Shape*		m_pCurrentShape;
-	Shape*		m_pNextShape;
-
-	unsigned m_PlayedCubesCount;
-	unsigned m_Level;
-	unsigned m_Score;
-	unsigned m_HighScore;
-
-	// all times are in seconds
-	float m_NextLevelStartTime;
-	float m_CurrentTimeAfterLastFall;
-	float m_ShapeFallingTime;
-
-	unsigned m_LastKeyPressed;
+	Renderer*	m_pRenderer;
+	Game*		m_pGame;
+	Simulation*	m_pSimulation;
+	HudLayer*	m_pHudLayer;
 
-	bool m_IsGamePaused;
-	bool m_IsGameOver;
+	// per-phase latencies over the scene, refreshed a few times a second
+	bool			m_IsProfileOverlayVisible;
+	double			m_ProfileOverlayUpdateTime;
+	PhaseStatistics	m_ProfileOverlayStatistics[PROFILE_PHASES_COUNT];
 };
@@ -1,11 +1,6 @@
 #include "pch.h"
 #include "Box.h"
-#include "Grid.h"
-
-Box::Box(const Color& color /* = BLACK */) 
-	: GameObject(color)
-{
-}
+#include "StackInstances.h"
 
 void Box::Initialize()
 {
@@ -68,21 +63,25 @@ void Box::Initialize()
 
 void Box::ReleaseBuffers()
 {
-	SafeRelease(m_pVertexBuffer);
-	SafeRelease(m_pTrianglesIndexBuffer);
-	SafeRelease(m_pLinesIndexBuffer);
+	ReleaseBuffer(m_pVertexBuffer);
+	ReleaseBuffer(m_pTrianglesIndexBuffer);
+	ReleaseBuffer(m_pLinesIndexBuffer);
 }
 
-void Box::Draw() const
+void Box::DrawInstances(RenderBuffer* pInstanceBuffer, size_t instancesCount)
 {
-	SetWorldTransformation();
-	SetVertexBuffer(m_pVertexBuffer);
-	// draw cube
-	DrawTriangles(m_pTrianglesIndexBuffer, TRIANGLES_COUNT, m_Color);
-	// draw border
-	DrawLines(m_pLinesIndexBuffer, LINES_COUNT, BLACK);
+	if (instancesCount == 0)
+	{
+		return;
+	}
+
+	SetInstancedVertexBuffers(m_pVertexBuffer, pInstanceBuffer, sizeof(StackInstance));
+	// draw cubes
+	DrawTrianglesInstanced(m_pTrianglesIndexBuffer, TRIANGLES_COUNT, instancesCount);
+	// draw borders
+	DrawLinesInstanced(m_pLinesIndexBuffer, LINES_COUNT, instancesCount, BLACK);
 }
 
-ID3D10Buffer* Box::m_pVertexBuffer = nullptr;
-ID3D10Buffer* Box::m_pTrianglesIndexBuffer = nullptr;
-ID3D10Buffer* Box::m_pLinesIndexBuffer = nullptr;
+RenderBuffer* Box::m_pVertexBuffer = nullptr;
+RenderBuffer* Box::m_pTrianglesIndexBuffer = nullptr;
+RenderBuffer* Box::m_pLinesIndexBuffer = nullptr;
@@ -2,20 +2,23 @@
 
 #include "GameObject.h"
 
+// Unit cube geometry of the settled stack. Cubes are not objects of their
+// own; the grid draws all of them at once from a buffer of StackInstance.
 class Box : public GameObject
 {
 public:
-	Box(const Color& color = BLACK);
-
 	static void Initialize();
 	static void ReleaseBuffers();
 
-	virtual void Draw() const;
+	// instances are drawn in the world space of the current world matrix
+	static void DrawInstances(RenderBuffer* pInstanceBuffer, size_t instancesCount);
 
 private:
-	static ID3D10Buffer* m_pVertexBuffer;
-	static ID3D10Buffer* m_pTrianglesIndexBuffer;
-	static ID3D10Buffer* m_pLinesIndexBuffer;
+	Box();
+
+	static RenderBuffer* m_pVertexBuffer;
+	static RenderBuffer* m_pTrianglesIndexBuffer;
+	static RenderBuffer* m_pLinesIndexBuffer;
 
 	static const size_t VERTICES_COUNT = 8;
 	static const size_t TRIANGLES_COUNT = 10;
@@ -0,0 +1,76 @@
+#include "pch.h"
+#include "Clock.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+// of real time, a ManualClock that nobody moves is checked this often
+const milliseconds MANUAL_CLOCK_WAIT_TIME(10);
+
+}
+
+// Clock
+
+const Clock& Clock::GetSteadyClock()
+{
+	static const SteadyClock steadyClock;
+	return steadyClock;
+}
+
+// SteadyClock
+
+int64_t SteadyClock::GetNanoseconds() const
+{
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void SteadyClock::WaitUntil(int64_t nanoseconds) const
+{
+	this_thread::sleep_until(steady_clock::time_point(duration_cast<steady_clock::duration>(std::chrono::nanoseconds(nanoseconds))));
+}
+
+// ManualClock
+
+ManualClock::ManualClock(int64_t nanoseconds /*= 0*/)
+	: m_Nanoseconds(nanoseconds)
+{
+}
+
+int64_t ManualClock::GetNanoseconds() const
+{
+	return m_Nanoseconds;
+}
+
+void ManualClock::WaitUntil(int64_t nanoseconds) const
+{
+	unique_lock<mutex> lock(m_Mutex);
+	m_TimeChanged.wait_for(lock, MANUAL_CLOCK_WAIT_TIME, [&] { return m_Nanoseconds >= nanoseconds; });
+}
+
+void ManualClock::SetNanoseconds(int64_t nanoseconds)
+{
+	// monotonic like any other clock
+	assert(nanoseconds >= m_Nanoseconds);
+
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_Nanoseconds = nanoseconds;
+	}
+
+	m_TimeChanged.notify_all();
+}
+
+void ManualClock::Advance(int64_t nanoseconds)
+{
+	assert(nanoseconds >= 0);
+
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_Nanoseconds += nanoseconds;
+	}
+
+	m_TimeChanged.notify_all();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// Source of monotonic time in nanoseconds. Timers read the time through it,
+// so tests and headless runs can drive them with a ManualClock.
+class Clock
+{
+public:
+	virtual ~Clock() {}
+
+	virtual int64_t GetNanoseconds() const = 0;
+
+	// Returns once the time reached the given one, or earlier when it may
+	// never get there on its own, so callers check the time again.
+	virtual void WaitUntil(int64_t nanoseconds) const = 0;
+
+	// std::chrono::steady_clock, shared by every timer that isn't given a clock
+	static const Clock& GetSteadyClock();
+};
+
+class SteadyClock : public Clock
+{
+public:
+	virtual int64_t GetNanoseconds() const;
+	virtual void WaitUntil(int64_t nanoseconds) const;
+};
+
+// Virtual time that only moves when told to. May be advanced from one thread
+// and read from others.
+class ManualClock : public Clock
+{
+public:
+	explicit ManualClock(int64_t nanoseconds = 0);
+
+	virtual int64_t GetNanoseconds() const;
+	// wakes up when the time is moved, or after a few milliseconds of real time
+	virtual void WaitUntil(int64_t nanoseconds) const;
+
+	void SetNanoseconds(int64_t nanoseconds);
+	void Advance(int64_t nanoseconds);
+
+private:
+	std::atomic<int64_t> m_Nanoseconds;
+
+	mutable std::mutex m_Mutex;
+	mutable std::condition_variable m_TimeChanged;
+};
+
+const int64_t NANOSECONDS_PER_SECOND = 1000000000;
+
+inline double NanosecondsToSeconds(int64_t nanoseconds)
+{
+	return double(nanoseconds) / NANOSECONDS_PER_SECOND;
+}
+
+inline int64_t SecondsToNanoseconds(double seconds)
+{
+	return int64_t(floor(seconds * NANOSECONDS_PER_SECOND + 0.5));
+}
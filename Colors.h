@@ -2,11 +2,11 @@
 
 // predefined color constants
 
-const D3DXCOLOR WHITE(1.0f, 1.0f, 1.0f, 1.0f);
-const D3DXCOLOR BLACK(0.0f, 0.0f, 0.0f, 1.0f);
-const D3DXCOLOR RED(1.0f, 0.0f, 0.0f, 1.0f);
-const D3DXCOLOR GREEN(0.0f, 1.0f, 0.0f, 1.0f);
-const D3DXCOLOR BLUE(0.0f, 0.0f, 1.0f, 1.0f);
-const D3DXCOLOR YELLOW(1.0f, 1.0f, 0.0f, 1.0f);
-const D3DXCOLOR CYAN(0.0f, 1.0f, 1.0f, 1.0f);
-const D3DXCOLOR MAGENTA(1.0f, 0.0f, 1.0f, 1.0f);
+const Color WHITE(1.0f, 1.0f, 1.0f, 1.0f);
+const Color BLACK(0.0f, 0.0f, 0.0f, 1.0f);
+const Color RED(1.0f, 0.0f, 0.0f, 1.0f);
+const Color GREEN(0.0f, 1.0f, 0.0f, 1.0f);
+const Color BLUE(0.0f, 0.0f, 1.0f, 1.0f);
+const Color YELLOW(1.0f, 1.0f, 0.0f, 1.0f);
+const Color CYAN(0.0f, 1.0f, 1.0f, 1.0f);
+const Color MAGENTA(1.0f, 0.0f, 1.0f, 1.0f);
@@ -0,0 +1,229 @@
+#include "pch.h"
+#include "D3D10Renderer.h"
+
+namespace
+{
+
+struct PassName
+{
+	const char* Technique;
+	unsigned Index;
+};
+
+const PassName PASS_NAMES[RENDER_PASSES_COUNT] =
+{
+	{ "BlockOutTechnique", 0 },
+	{ "InstancedTechnique", 0 },
+	{ "InstancedTechnique", 1 },
+	{ "ColoredTechnique", 0 },
+	{ "ColoredTechnique", 1 },
+	{ "TextTechnique", 0 },
+};
+
+const D3D10_PRIMITIVE_TOPOLOGY D3D10_TOPOLOGIES[] =
+{
+	D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST,
+	D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP,
+	D3D10_PRIMITIVE_TOPOLOGY_LINELIST,
+};
+
+}
+
+D3D10Renderer::D3D10Renderer(ID3D10Device* pDevice, ID3D10Effect* pEffect, ID3D10InputLayout* const pVertexLayouts[VERTEX_FORMATS_COUNT])
+	: m_pDevice(pDevice)
+	, m_pEffectWorld(pEffect->GetVariableByName("g_World")->AsMatrix())
+	, m_pEffectColor(pEffect->GetVariableByName("g_Color")->AsVector())
+	, m_pEffectViewProjection(pEffect->GetVariableByName("g_ViewProjection")->AsMatrix())
+	, m_pEffectAtlas(pEffect->GetVariableByName("g_Atlas")->AsShaderResource())
+{
+	for (size_t pass = 0; pass < RENDER_PASSES_COUNT; ++pass)
+	{
+		m_pPasses[pass] = pEffect->GetTechniqueByName(PASS_NAMES[pass].Technique)->GetPassByIndex(PASS_NAMES[pass].Index);
+	}
+
+	for (size_t format = 0; format < VERTEX_FORMATS_COUNT; ++format)
+	{
+		m_pVertexLayouts[format] = pVertexLayouts[format];
+	}
+}
+
+// buffers
+
+RenderBuffer* D3D10Renderer::CreateVertexBuffer(const void* pVertices, size_t size)
+{
+	return CreateBuffer(pVertices, size, D3D10_BIND_VERTEX_BUFFER);
+}
+
+RenderBuffer* D3D10Renderer::CreateIndexBuffer(const unsigned* pIndices, size_t count)
+{
+	return CreateBuffer(pIndices, count * sizeof(unsigned), D3D10_BIND_INDEX_BUFFER);
+}
+
+RenderBuffer* D3D10Renderer::CreateDynamicVertexBuffer(size_t size)
+{
+	return CreateDynamicBuffer(size, D3D10_BIND_VERTEX_BUFFER);
+}
+
+RenderBuffer* D3D10Renderer::CreateDynamicIndexBuffer(size_t count)
+{
+	return CreateDynamicBuffer(count * sizeof(unsigned), D3D10_BIND_INDEX_BUFFER);
+}
+
+void D3D10Renderer::UpdateDynamicBuffer(RenderBuffer* pBuffer, const void* pData, size_t size)
+{
+	void* pMappedData = nullptr;
+	HR(ToD3D10Buffer(pBuffer)->Map(D3D10_MAP_WRITE_DISCARD, 0, &pMappedData));
+	memcpy(pMappedData, pData, size);
+	ToD3D10Buffer(pBuffer)->Unmap();
+}
+
+void D3D10Renderer::ReleaseBuffer(RenderBuffer* pBuffer)
+{
+	ID3D10Buffer* pD3D10Buffer = ToD3D10Buffer(pBuffer);
+	SafeRelease(pD3D10Buffer);
+}
+
+// textures
+
+RenderTexture* D3D10Renderer::CreateTexture(size_t width, size_t height, const uint8_t* pCoverage)
+{
+	D3D10_TEXTURE2D_DESC textureDescription;
+	textureDescription.Width = unsigned(width);
+	textureDescription.Height = unsigned(height);
+	textureDescription.MipLevels = 1;
+	textureDescription.ArraySize = 1;
+	textureDescription.Format = DXGI_FORMAT_R8_UNORM;
+	textureDescription.SampleDesc.Count = 1;
+	textureDescription.SampleDesc.Quality = 0;
+	textureDescription.Usage = D3D10_USAGE_IMMUTABLE;
+	textureDescription.BindFlags = D3D10_BIND_SHADER_RESOURCE;
+	textureDescription.CPUAccessFlags = 0;
+	textureDescription.MiscFlags = 0;
+
+	D3D10_SUBRESOURCE_DATA initData;
+	initData.pSysMem = pCoverage;
+	initData.SysMemPitch = unsigned(width);
+	initData.SysMemSlicePitch = 0;
+
+	ID3D10Texture2D* pTexture = nullptr;
+	HR(m_pDevice->CreateTexture2D(&textureDescription, &initData, &pTexture));
+
+	// the view keeps the texture alive
+	ID3D10ShaderResourceView* pView = nullptr;
+	HR(m_pDevice->CreateShaderResourceView(pTexture, nullptr, &pView));
+	SafeRelease(pTexture);
+
+	return reinterpret_cast<RenderTexture*>(pView);
+}
+
+void D3D10Renderer::ReleaseTexture(RenderTexture* pTexture)
+{
+	ID3D10ShaderResourceView* pView = ToD3D10View(pTexture);
+	SafeRelease(pView);
+}
+
+// draw submission
+
+void D3D10Renderer::BeginFrame()
+{
+}
+
+void D3D10Renderer::SetVertexBuffers(VertexFormat format, RenderBuffer* pVertexBuffer, RenderBuffer* pInstanceBuffer, size_t instanceSize)
+{
+	ID3D10Buffer* buffers[] = { ToD3D10Buffer(pVertexBuffer), ToD3D10Buffer(pInstanceBuffer) };
+	unsigned strides[] = { unsigned(GetVertexSize(format)), unsigned(instanceSize) };
+	unsigned offsets[] = { 0, 0 };
+
+	m_pDevice->IASetInputLayout(m_pVertexLayouts[format]);
+	m_pDevice->IASetVertexBuffers(0, pInstanceBuffer ? 2 : 1, buffers, strides, offsets);
+}
+
+void D3D10Renderer::SetIndexBuffer(RenderBuffer* pIndexBuffer)
+{
+	m_pDevice->IASetIndexBuffer(ToD3D10Buffer(pIndexBuffer), DXGI_FORMAT_R32_UINT, 0);
+}
+
+void D3D10Renderer::SetTopology(PrimitiveTopology topology)
+{
+	m_pDevice->IASetPrimitiveTopology(D3D10_TOPOLOGIES[topology]);
+}
+
+void D3D10Renderer::SetTexture(RenderTexture* pTexture)
+{
+	m_pEffectAtlas->SetResource(ToD3D10View(pTexture));
+}
+
+void D3D10Renderer::ApplyPass(RenderPass pass)
+{
+	m_pPasses[pass]->Apply(0);
+}
+
+void D3D10Renderer::DrawIndexed(size_t indicesCount, size_t startIndex, int baseVertex)
+{
+	m_pDevice->DrawIndexed(unsigned(indicesCount), unsigned(startIndex), baseVertex);
+}
+
+void D3D10Renderer::DrawIndexedInstanced(size_t indicesCount, size_t instancesCount, size_t startIndex, int baseVertex)
+{
+	m_pDevice->DrawIndexedInstanced(unsigned(indicesCount), unsigned(instancesCount), unsigned(startIndex), baseVertex, 0);
+}
+
+// constants
+
+void D3D10Renderer::SetColor(const Color& color)
+{
+	m_pEffectColor->SetFloatVector((float*)&color);
+}
+
+void D3D10Renderer::SetWorld(const Matrix& world)
+{
+	m_pEffectWorld->SetMatrix((float*)&world);
+}
+
+void D3D10Renderer::SetViewProjection(const Matrix& viewProjection)
+{
+	m_pEffectViewProjection->SetMatrix((float*)&viewProjection);
+}
+
+RenderBuffer* D3D10Renderer::CreateBuffer(const void* pData, size_t size, D3D10_BIND_FLAG flag)
+{
+	D3D10_BUFFER_DESC bufferDescription;
+	bufferDescription.Usage = D3D10_USAGE_IMMUTABLE;
+	bufferDescription.ByteWidth = size;
+	bufferDescription.BindFlags = flag;
+	bufferDescription.CPUAccessFlags = 0;
+	bufferDescription.MiscFlags = 0;
+
+	D3D10_SUBRESOURCE_DATA initData;
+	initData.pSysMem = pData;
+
+	ID3D10Buffer* pBuffer = nullptr;
+	HR(m_pDevice->CreateBuffer(&bufferDescription, &initData, &pBuffer));
+
+	return reinterpret_cast<RenderBuffer*>(pBuffer);
+}
+
+RenderBuffer* D3D10Renderer::CreateDynamicBuffer(size_t size, D3D10_BIND_FLAG flag)
+{
+	D3D10_BUFFER_DESC bufferDescription;
+	bufferDescription.Usage = D3D10_USAGE_DYNAMIC;
+	bufferDescription.ByteWidth = size;
+	bufferDescription.BindFlags = flag;
+	bufferDescription.CPUAccessFlags = D3D10_CPU_ACCESS_WRITE;
+	bufferDescription.MiscFlags = 0;
+
+	ID3D10Buffer* pBuffer = nullptr;
+	HR(m_pDevice->CreateBuffer(&bufferDescription, nullptr, &pBuffer));
+
+	return reinterpret_cast<RenderBuffer*>(pBuffer);
+}
+
+ID3D10Buffer* D3D10Renderer::ToD3D10Buffer(RenderBuffer* pBuffer)
+{
+	return reinterpret_cast<ID3D10Buffer*>(pBuffer);
+}
+
+ID3D10ShaderResourceView* D3D10Renderer::ToD3D10View(RenderTexture* pTexture)
+{
+	return reinterpret_cast<ID3D10ShaderResourceView*>(pTexture);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Renderer.h"
+
+// Renderer on a Direct3D 10 device with the techniques of BlockOut.fx.
+// Render buffers are the ID3D10Buffer objects themselves, render textures
+// the shader resource views of their ID3D10Texture2D.
+class D3D10Renderer : public Renderer
+{
+public:
+	// layouts are indexed by VertexFormat and stay owned by the caller
+	D3D10Renderer(ID3D10Device* pDevice, ID3D10Effect* pEffect, ID3D10InputLayout* const pVertexLayouts[VERTEX_FORMATS_COUNT]);
+
+	virtual RenderBuffer* CreateVertexBuffer(const void* pVertices, size_t size);
+	virtual RenderBuffer* CreateIndexBuffer(const unsigned* pIndices, size_t count);
+	virtual RenderBuffer* CreateDynamicVertexBuffer(size_t size);
+	virtual RenderBuffer* CreateDynamicIndexBuffer(size_t count);
+	virtual void UpdateDynamicBuffer(RenderBuffer* pBuffer, const void* pData, size_t size);
+	virtual void ReleaseBuffer(RenderBuffer* pBuffer);
+
+	virtual RenderTexture* CreateTexture(size_t width, size_t height, const uint8_t* pCoverage);
+	virtual void ReleaseTexture(RenderTexture* pTexture);
+
+	virtual void BeginFrame();
+
+	virtual void SetVertexBuffers(VertexFormat format, RenderBuffer* pVertexBuffer, RenderBuffer* pInstanceBuffer, size_t instanceSize);
+	virtual void SetIndexBuffer(RenderBuffer* pIndexBuffer);
+	virtual void SetTopology(PrimitiveTopology topology);
+	virtual void SetTexture(RenderTexture* pTexture);
+	virtual void ApplyPass(RenderPass pass);
+
+	virtual void DrawIndexed(size_t indicesCount, size_t startIndex, int baseVertex);
+	virtual void DrawIndexedInstanced(size_t indicesCount, size_t instancesCount, size_t startIndex, int baseVertex);
+
+	virtual void SetColor(const Color& color);
+	virtual void SetWorld(const Matrix& world);
+	virtual void SetViewProjection(const Matrix& viewProjection);
+
+private:
+	RenderBuffer* CreateBuffer(const void* pData, size_t size, D3D10_BIND_FLAG flag);
+	RenderBuffer* CreateDynamicBuffer(size_t size, D3D10_BIND_FLAG flag);
+
+	static ID3D10Buffer* ToD3D10Buffer(RenderBuffer* pBuffer);
+	static ID3D10ShaderResourceView* ToD3D10View(RenderTexture* pTexture);
+
+	ID3D10Device*				m_pDevice;
+	ID3D10EffectPass*			m_pPasses[RENDER_PASSES_COUNT];
+	ID3D10InputLayout*			m_pVertexLayouts[VERTEX_FORMATS_COUNT];
+	ID3D10EffectMatrixVariable*	m_pEffectWorld;
+	ID3D10EffectVectorVariable*	m_pEffectColor;
+	ID3D10EffectMatrixVariable*	m_pEffectViewProjection;
+	ID3D10EffectShaderResourceVariable* m_pEffectAtlas;
+};
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "D3DApplication.h"
+#include "FrameProfiler.h"
 
 const char* APPLICATION_NAME = "Block Out";
 const char* MAIN_WINDOW_CLASS_NAME = "D3DWindowClass";
@@ -78,6 +79,8 @@ int D3DApplication::Run()
 {
 	MSG message = {0};
 
+	FrameProfiler::SetThreadName("main");
+
 	m_GameTimer.Reset();
 
 	while (message.message != WM_QUIT)
@@ -85,6 +88,7 @@ int D3DApplication::Run()
 		// If there are Window messages then process them.
 		if (PeekMessage(&message, nullptr, 0, 0, PM_REMOVE))
 		{
+			ScopedPhaseTimer timer(PHASE_INPUT);
 			TranslateMessage(&message);
 			DispatchMessage(&message);
 		}
@@ -95,7 +99,11 @@ int D3DApplication::Run()
 
 			if(!m_IsPaused)
 			{
-				UpdateScene(m_GameTimer.GetDeltaTime());	
+				// a stopped timer has no frame time to record
+				FrameProfiler::Record(PHASE_FRAME, m_GameTimer.GetDeltaTimeNanoseconds());
+
+				ScopedPhaseTimer timer(PHASE_UPDATE);
+				UpdateScene(float(m_GameTimer.GetDeltaTime()));	
 			}
 			else
 			{
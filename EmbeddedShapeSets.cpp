@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "EmbeddedShapeSets.h"
+
+using namespace std;
+
+namespace
+{
+
+// FLAT FUN, the classic flat pieces
+
+constexpr int FLAT_FUN_0[][3] = { { 0, 0, 0 } };
+constexpr int FLAT_FUN_1[][3] = { { 0, 0, 0 }, { 1, 0, 0 } };
+constexpr int FLAT_FUN_2[][3] = { { 0, 0, 0 }, { -1, 0, 0 }, { 1, 0, 0 } };
+constexpr int FLAT_FUN_3[][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 } };
+constexpr int FLAT_FUN_4[][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 } };
+constexpr int FLAT_FUN_5[][3] = { { 0, 0, 0 }, { -1, 0, 0 }, { 1, 0, 0 }, { -1, 1, 0 } };
+constexpr int FLAT_FUN_6[][3] = { { 0, 0, 0 }, { -1, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 } };
+constexpr int FLAT_FUN_7[][3] = { { 0, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 } };
+
+constexpr ShapeOrientationTable FLAT_FUN_ORIENTATIONS[] =
+{
+	ShapeOrientationBuilder::Build(FLAT_FUN_0),
+	ShapeOrientationBuilder::Build(FLAT_FUN_1),
+	ShapeOrientationBuilder::Build(FLAT_FUN_2),
+	ShapeOrientationBuilder::Build(FLAT_FUN_3),
+	ShapeOrientationBuilder::Build(FLAT_FUN_4),
+	ShapeOrientationBuilder::Build(FLAT_FUN_5),
+	ShapeOrientationBuilder::Build(FLAT_FUN_6),
+	ShapeOrientationBuilder::Build(FLAT_FUN_7),
+};
+
+// turning around the pivot cube a cube keeps one orientation, a domino has
+// six, the small corner twelve and the L every one of the twenty four
+static_assert(FLAT_FUN_ORIENTATIONS[0].Count == 1, "wrong orientation table");
+static_assert(FLAT_FUN_ORIENTATIONS[1].Count == 6, "wrong orientation table");
+static_assert(FLAT_FUN_ORIENTATIONS[4].Count == 12, "wrong orientation table");
+static_assert(FLAT_FUN_ORIENTATIONS[5].Count == 24, "wrong orientation table");
+
+const EmbeddedShape FLAT_FUN[] =
+{
+	{ FLAT_FUN_0, 1, &FLAT_FUN_ORIENTATIONS[0] },
+	{ FLAT_FUN_1, 2, &FLAT_FUN_ORIENTATIONS[1] },
+	{ FLAT_FUN_2, 3, &FLAT_FUN_ORIENTATIONS[2] },
+	{ FLAT_FUN_3, 4, &FLAT_FUN_ORIENTATIONS[3] },
+	{ FLAT_FUN_4, 3, &FLAT_FUN_ORIENTATIONS[4] },
+	{ FLAT_FUN_5, 4, &FLAT_FUN_ORIENTATIONS[5] },
+	{ FLAT_FUN_6, 4, &FLAT_FUN_ORIENTATIONS[6] },
+	{ FLAT_FUN_7, 4, &FLAT_FUN_ORIENTATIONS[7] },
+};
+
+// TETRACUBES, every piece of four cubes, mirror images are distinct
+
+constexpr int TETRACUBE_0[][3] = { { -1, 0, 0 }, { 0, 0, 0 }, { 1, 0, 0 }, { 2, 0, 0 } };
+constexpr int TETRACUBE_1[][3] = { { -1, 0, 0 }, { 0, 0, 0 }, { 1, 0, 0 }, { -1, 1, 0 } };
+constexpr int TETRACUBE_2[][3] = { { -1, 0, 0 }, { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 } };
+constexpr int TETRACUBE_3[][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 } };
+constexpr int TETRACUBE_4[][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+constexpr int TETRACUBE_5[][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 0, 1 } };
+constexpr int TETRACUBE_6[][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, 1, 1 } };
+constexpr int TETRACUBE_7[][3] = { { -1, 0, 0 }, { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 } };
+
+constexpr ShapeOrientationTable TETRACUBES_ORIENTATIONS[] =
+{
+	ShapeOrientationBuilder::Build(TETRACUBE_0),
+	ShapeOrientationBuilder::Build(TETRACUBE_1),
+	ShapeOrientationBuilder::Build(TETRACUBE_2),
+	ShapeOrientationBuilder::Build(TETRACUBE_3),
+	ShapeOrientationBuilder::Build(TETRACUBE_4),
+	ShapeOrientationBuilder::Build(TETRACUBE_5),
+	ShapeOrientationBuilder::Build(TETRACUBE_6),
+	ShapeOrientationBuilder::Build(TETRACUBE_7),
+};
+
+const EmbeddedShape TETRACUBES[] =
+{
+	{ TETRACUBE_0, 4, &TETRACUBES_ORIENTATIONS[0] },
+	{ TETRACUBE_1, 4, &TETRACUBES_ORIENTATIONS[1] },
+	{ TETRACUBE_2, 4, &TETRACUBES_ORIENTATIONS[2] },
+	{ TETRACUBE_3, 4, &TETRACUBES_ORIENTATIONS[3] },
+	{ TETRACUBE_4, 4, &TETRACUBES_ORIENTATIONS[4] },
+	{ TETRACUBE_5, 4, &TETRACUBES_ORIENTATIONS[5] },
+	{ TETRACUBE_6, 4, &TETRACUBES_ORIENTATIONS[6] },
+	{ TETRACUBE_7, 4, &TETRACUBES_ORIENTATIONS[7] },
+};
+
+const EmbeddedShapeSet SETS[] =
+{
+	{ "FlatFun", FLAT_FUN, sizeof(FLAT_FUN) / sizeof(FLAT_FUN[0]) },
+	{ "Tetracubes", TETRACUBES, sizeof(TETRACUBES) / sizeof(TETRACUBES[0]) },
+};
+
+const size_t SETS_COUNT = sizeof(SETS) / sizeof(SETS[0]);
+
+}
+
+const EmbeddedShapeSet* EmbeddedShapeSets::Find(const string& name)
+{
+	for (size_t i = 0; i < SETS_COUNT; ++i)
+	{
+		if (name == SETS[i].Name)
+		{
+			return &SETS[i];
+		}
+	}
+
+	return nullptr;
+}
+
+size_t EmbeddedShapeSets::GetSetsCount()
+{
+	return SETS_COUNT;
+}
+
+const EmbeddedShapeSet& EmbeddedShapeSets::GetSet(size_t index)
+{
+	assert(index < SETS_COUNT);
+	return SETS[index];
+}
+
+const char* const EmbeddedShapeSets::DEFAULT_SET_NAME = "FlatFun";
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "ShapeOrientation.h"
+
+struct EmbeddedShape
+{
+	const int (*pCubes)[3];
+	size_t CubesCount;
+	const ShapeOrientationTable* pOrientations;
+};
+
+struct EmbeddedShapeSet
+{
+	const char* Name;
+	const EmbeddedShape* pShapes;
+	size_t ShapesCount;
+};
+
+// Standard shape sets compiled into the executable together with their
+// orientation tables and collision masks, so the game starts without any
+// asset next to it. Custom sets are still loaded from files.
+class EmbeddedShapeSets
+{
+public:
+	static const char* const DEFAULT_SET_NAME;
+
+	// returns nullptr for unknown names
+	static const EmbeddedShapeSet* Find(const std::string& name);
+
+	static size_t GetSetsCount();
+	static const EmbeddedShapeSet& GetSet(size_t index);
+};
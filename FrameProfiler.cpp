@@ -0,0 +1,359 @@
+#include "pch.h"
+#include "FrameProfiler.h"
+#include "Tracer.h"
+
+using namespace std;
+
+namespace
+{
+
+const char* PHASE_NAMES[PROFILE_PHASES_COUNT] =
+{
+	"frame",
+	"input",
+	"update",
+	"draw grid",
+	"draw stack",
+	"draw shapes",
+	"draw submit",
+	"draw hud",
+	"present",
+	"simulation tick",
+};
+
+unsigned GetHighestBit(uint64_t value)
+{
+	assert(value != 0);
+
+	unsigned bit = 0;
+
+	for (unsigned shift = 32; shift != 0; shift /= 2)
+	{
+		if (value >> shift)
+		{
+			value >>= shift;
+			bit += shift;
+		}
+	}
+
+	return bit;
+}
+
+// a store instead of a locked add, the owning thread is the only writer
+void Increment(atomic<uint64_t>& counter, uint64_t value = 1)
+{
+	counter.store(counter.load(memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+double ToMicroseconds(int64_t nanoseconds)
+{
+	return nanoseconds / 1000.0;
+}
+
+}
+
+#pragma region LatencyHistogram
+
+LatencyHistogram::LatencyHistogram()
+	: m_TotalCount(0)
+	, m_Max(0)
+{
+	for (unsigned i = 0; i < BUCKETS_COUNT; ++i)
+	{
+		m_Counts[i].store(0, memory_order_relaxed);
+	}
+}
+
+void LatencyHistogram::Record(int64_t nanoseconds)
+{
+	const uint64_t value = uint64_t(max<int64_t>(nanoseconds, 0));
+
+	Increment(m_Counts[GetBucketIndex(value)]);
+	Increment(m_TotalCount);
+
+	if (nanoseconds > m_Max.load(memory_order_relaxed))
+	{
+		m_Max.store(nanoseconds, memory_order_relaxed);
+	}
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+	uint64_t totalCount = 0;
+
+	for (unsigned i = 0; i < BUCKETS_COUNT; ++i)
+	{
+		const uint64_t count = other.m_Counts[i].load(memory_order_relaxed);
+		Increment(m_Counts[i], count);
+		totalCount += count;
+	}
+
+	// summed from the buckets, so the percentiles stay consistent while the
+	// other one is being recorded into
+	Increment(m_TotalCount, totalCount);
+	m_Max.store(max(m_Max.load(memory_order_relaxed), other.m_Max.load(memory_order_relaxed)), memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetCount() const
+{
+	return m_TotalCount.load(memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::GetMax() const
+{
+	return m_Max.load(memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::GetPercentile(double percentile) const
+{
+	const uint64_t totalCount = GetCount();
+
+	if (totalCount == 0)
+	{
+		return 0;
+	}
+
+	const uint64_t rank = max<uint64_t>(uint64_t(ceil(percentile / 100.0 * totalCount)), 1);
+	uint64_t count = 0;
+
+	for (unsigned i = 0; i < BUCKETS_COUNT; ++i)
+	{
+		count += m_Counts[i].load(memory_order_relaxed);
+
+		if (count >= rank)
+		{
+			return min(GetBucketHighestValue(i), GetMax());
+		}
+	}
+
+	return GetMax();
+}
+
+unsigned LatencyHistogram::GetBucketIndex(uint64_t value)
+{
+	value = min<uint64_t>(value, (uint64_t(1) << MAX_VALUE_BITS) - 1);
+
+	// values below twice the sub-buckets count are exact, above every power
+	// of two is split into SUB_BUCKETS_COUNT buckets
+	const unsigned shift = value < 2 * SUB_BUCKETS_COUNT ? 0 : GetHighestBit(value) - SUB_BUCKET_BITS;
+	return shift * SUB_BUCKETS_COUNT + unsigned(value >> shift);
+}
+
+int64_t LatencyHistogram::GetBucketHighestValue(unsigned index)
+{
+	if (index < 2 * SUB_BUCKETS_COUNT)
+	{
+		return index;
+	}
+
+	const unsigned shift = index / SUB_BUCKETS_COUNT - 1;
+	const uint64_t mantissa = index - shift * SUB_BUCKETS_COUNT;
+	return int64_t(((mantissa + 1) << shift) - 1);
+}
+
+#pragma endregion
+
+#pragma region FrameProfiler
+
+namespace
+{
+
+const unsigned MAX_THREADS_COUNT = 16;
+
+struct ThreadProfile
+{
+	LatencyHistogram Phases[PROFILE_PHASES_COUNT];
+};
+
+// profiles outlive their threads, so a thread that ended is still dumped
+struct ThreadProfiles
+{
+	ThreadProfiles()
+		: ClaimedCount(0)
+	{
+		for (unsigned i = 0; i < MAX_THREADS_COUNT; ++i)
+		{
+			Profiles[i].store(nullptr, memory_order_relaxed);
+		}
+	}
+
+	~ThreadProfiles()
+	{
+		for (unsigned i = 0; i < MAX_THREADS_COUNT; ++i)
+		{
+			delete Profiles[i].load();
+		}
+	}
+
+	atomic<ThreadProfile*> Profiles[MAX_THREADS_COUNT];
+	atomic<unsigned> ClaimedCount;
+
+	// names are set once per thread, never while recording
+	mutex NamesMutex;
+	string Names[MAX_THREADS_COUNT];
+};
+
+ThreadProfiles s_ThreadProfiles;
+
+thread_local ThreadProfile* s_pThreadProfile = nullptr;
+thread_local unsigned s_ThreadIndex = UINT_MAX;
+
+ThreadProfile* GetThreadProfile()
+{
+	if (s_pThreadProfile || s_ThreadIndex != UINT_MAX)
+	{
+		return s_pThreadProfile;
+	}
+
+	// threads past the limit are not profiled
+	s_ThreadIndex = s_ThreadProfiles.ClaimedCount.fetch_add(1);
+
+	if (s_ThreadIndex < MAX_THREADS_COUNT)
+	{
+		s_pThreadProfile = new ThreadProfile;
+		s_ThreadProfiles.Profiles[s_ThreadIndex].store(s_pThreadProfile, memory_order_release);
+	}
+
+	return s_pThreadProfile;
+}
+
+unsigned GetProfiledThreadsCount()
+{
+	return min(s_ThreadProfiles.ClaimedCount.load(), MAX_THREADS_COUNT);
+}
+
+PhaseStatistics ComputeStatistics(const LatencyHistogram& histogram)
+{
+	PhaseStatistics statistics;
+	statistics.Count = histogram.GetCount();
+	statistics.P50 = histogram.GetPercentile(50.0);
+	statistics.P99 = histogram.GetPercentile(99.0);
+	statistics.P999 = histogram.GetPercentile(99.9);
+	statistics.Max = histogram.GetMax();
+	return statistics;
+}
+
+}
+
+void FrameProfiler::Record(ProfilePhase phase, int64_t nanoseconds)
+{
+	assert(phase < PROFILE_PHASES_COUNT);
+
+	if (ThreadProfile* pProfile = GetThreadProfile())
+	{
+		pProfile->Phases[phase].Record(nanoseconds);
+	}
+}
+
+void FrameProfiler::SetThreadName(const string& name)
+{
+	Tracer::SetThreadName(name);
+
+	if (GetThreadProfile())
+	{
+		lock_guard<mutex> lock(s_ThreadProfiles.NamesMutex);
+		s_ThreadProfiles.Names[s_ThreadIndex] = name;
+	}
+}
+
+PhaseStatistics FrameProfiler::GetStatistics(ProfilePhase phase)
+{
+	assert(phase < PROFILE_PHASES_COUNT);
+
+	LatencyHistogram merged;
+
+	const unsigned threadsCount = GetProfiledThreadsCount();
+
+	for (unsigned i = 0; i < threadsCount; ++i)
+	{
+		// claimed but maybe not stored yet
+		if (const ThreadProfile* pProfile = s_ThreadProfiles.Profiles[i].load(memory_order_acquire))
+		{
+			merged.Merge(pProfile->Phases[phase]);
+		}
+	}
+
+	return ComputeStatistics(merged);
+}
+
+const char* FrameProfiler::GetPhaseName(ProfilePhase phase)
+{
+	assert(phase < PROFILE_PHASES_COUNT);
+	return PHASE_NAMES[phase];
+}
+
+bool FrameProfiler::WriteCsv(const string& fileName)
+{
+	ofstream file(fileName);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	file << "thread,phase,count,p50_us,p99_us,p99.9_us,max_us\n";
+	file.setf(ios::fixed);
+	file.precision(3);
+
+	const unsigned threadsCount = GetProfiledThreadsCount();
+
+	for (unsigned i = 0; i < threadsCount; ++i)
+	{
+		const ThreadProfile* pProfile = s_ThreadProfiles.Profiles[i].load(memory_order_acquire);
+
+		if (!pProfile)
+		{
+			continue;
+		}
+
+		string threadName;
+		{
+			lock_guard<mutex> lock(s_ThreadProfiles.NamesMutex);
+			threadName = s_ThreadProfiles.Names[i];
+		}
+
+		if (threadName.empty())
+		{
+			threadName = "thread " + nsc::NumberToString(i);
+		}
+
+		for (unsigned phase = 0; phase < PROFILE_PHASES_COUNT; ++phase)
+		{
+			const PhaseStatistics statistics = ComputeStatistics(pProfile->Phases[phase]);
+
+			if (statistics.Count == 0)
+			{
+				continue;
+			}
+
+			file << threadName << ',' << PHASE_NAMES[phase] << ',' << statistics.Count
+				<< ',' << ToMicroseconds(statistics.P50)
+				<< ',' << ToMicroseconds(statistics.P99)
+				<< ',' << ToMicroseconds(statistics.P999)
+				<< ',' << ToMicroseconds(statistics.Max) << '\n';
+		}
+	}
+
+	return bool(file);
+}
+
+#pragma endregion
+
+#pragma region ScopedPhaseTimer
+
+ScopedPhaseTimer::ScopedPhaseTimer(ProfilePhase phase, const Clock& clock)
+	: m_Phase(phase)
+	, m_Clock(clock)
+	, m_StartTime(clock.GetNanoseconds())
+{
+}
+
+ScopedPhaseTimer::~ScopedPhaseTimer()
+{
+	const int64_t duration = m_Clock.GetNanoseconds() - m_StartTime;
+
+	FrameProfiler::Record(m_Phase, duration);
+	Tracer::Complete("frame", PHASE_NAMES[m_Phase], m_StartTime, duration);
+}
+
+#pragma endregion
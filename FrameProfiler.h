@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Clock.h"
+
+enum ProfilePhase
+{
+	PHASE_FRAME,			// whole frame, from one timer tick to the next
+	PHASE_INPUT,			// window messages, key presses included
+	PHASE_UPDATE,			// UpdateScene
+	PHASE_DRAW_GRID,		// grid and level pole
+	PHASE_DRAW_STACK,		// settled cubes, mesh rebuilds included
+	PHASE_DRAW_SHAPES,		// falling and next shape
+	PHASE_DRAW_SUBMIT,		// render queue flush, the actual draw calls
+	PHASE_DRAW_HUD,			// text
+	PHASE_PRESENT,
+	PHASE_SIMULATION_TICK,	// one fixed step on the simulation thread
+
+	PROFILE_PHASES_COUNT
+};
+
+// Latency distribution in nanoseconds, bucketed like an HDR histogram: 32
+// linear buckets per power of two, so every value is kept within about 3%
+// whatever its magnitude. Written by one thread without locks, may be read
+// by any other meanwhile.
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+
+	// owning thread only
+	void Record(int64_t nanoseconds);
+
+	// adds the counts of the other one to a histogram nobody records into
+	void Merge(const LatencyHistogram& other);
+
+	uint64_t GetCount() const;
+	int64_t GetMax() const;
+
+	// highest value of the bucket holding the percentile, 0 when empty
+	int64_t GetPercentile(double percentile) const;
+
+private:
+	LatencyHistogram(const LatencyHistogram&);
+	LatencyHistogram& operator = (const LatencyHistogram&);
+
+	static const unsigned SUB_BUCKET_BITS = 5;
+	static const unsigned SUB_BUCKETS_COUNT = 1 << SUB_BUCKET_BITS;
+
+	// longer values are counted as the longest one, 2^44 ns is almost 5 hours
+	static const unsigned MAX_VALUE_BITS = 44;
+	static const unsigned BUCKETS_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS_COUNT;
+
+	static unsigned GetBucketIndex(uint64_t value);
+	static int64_t GetBucketHighestValue(unsigned index);
+
+	std::atomic<uint64_t> m_Counts[BUCKETS_COUNT];
+	std::atomic<uint64_t> m_TotalCount;
+	std::atomic<int64_t> m_Max;
+};
+
+struct PhaseStatistics
+{
+	uint64_t Count;
+	int64_t P50;	// in nanoseconds
+	int64_t P99;
+	int64_t P999;
+	int64_t Max;
+};
+
+// Per-phase latency histograms of every thread that records. Each thread
+// records into histograms of its own, claimed on its first record, so
+// recording takes no lock and threads don't contend; readers merge the
+// threads when asked.
+class FrameProfiler
+{
+public:
+	static void Record(ProfilePhase phase, int64_t nanoseconds);
+
+	// shown in the CSV and the trace, threads without a name are numbered
+	static void SetThreadName(const std::string& name);
+
+	// all threads merged
+	static PhaseStatistics GetStatistics(ProfilePhase phase);
+
+	static const char* GetPhaseName(ProfilePhase phase);
+
+	// one row per thread and phase with a record, times in microseconds;
+	// returns false when the file can't be written
+	static bool WriteCsv(const std::string& fileName);
+};
+
+// Records the lifetime of the scope as the given phase, and traces it as a
+// span while tracing is on.
+class ScopedPhaseTimer
+{
+public:
+	explicit ScopedPhaseTimer(ProfilePhase phase, const Clock& clock = Clock::GetSteadyClock());
+	~ScopedPhaseTimer();
+
+private:
+	ScopedPhaseTimer(const ScopedPhaseTimer&);
+	ScopedPhaseTimer& operator = (const ScopedPhaseTimer&);
+
+	ProfilePhase m_Phase;
+	const Clock& m_Clock;
+	int64_t m_StartTime;
+};
@@ -0,0 +1,520 @@
+#include "pch.h"
+#include "Game.h"
+
+#include "Box.h"
+#include "Grid.h"
+#include "LevelPole.h"
+#include "ShapeFactory.h"
+#include "ShapeLibrary.h"
+#include "ShapeSetParser.h"
+#include "EmbeddedShapeSets.h"
+#include "Shape.h"
+#include "Clock.h"
+#include "AllocationTracker.h"
+#include "FrameProfiler.h"
+#include "Tracer.h"
+#include "PositionNotation.h"
+#include "ShapeGeometry.h"
+#include "ShapeOrientation.h"
+
+using namespace std;
+
+namespace
+{
+
+const Vector3 SHAPE_INITIAL_POSITION_IN_GRID(0.0f, 0.0f, 6.6f);
+const unsigned LAST_LEVEL = 9;
+const int64_t LEVEL_TIME_INTERVAL = 60 * NANOSECONDS_PER_SECOND;
+
+int64_t ComputeFallingTimeForLevel(unsigned level)
+{
+	assert(level <= LAST_LEVEL);
+	return (LAST_LEVEL - level) * NANOSECONDS_PER_SECOND / 10;
+}
+
+}
+
+Game::Game(Renderer& renderer, const string& shapeSetFileName, uint64_t randomSeed)
+	: m_Renderer(renderer)
+	, m_pGrid(nullptr)
+	, m_pLevelPole(nullptr)
+	, m_pCurrentShape(nullptr)
+	, m_pNextShape(nullptr)
+	, m_PlayedCubesCount(0)
+	, m_Level(0)
+	, m_Score(0)
+	, m_HighScore(0)
+	, m_Random(randomSeed)
+	, m_PlayTime(0)
+	, m_NextLevelStartTime(LEVEL_TIME_INTERVAL)
+	, m_CurrentTimeAfterLastFall(0)
+	, m_ShapeFallingTime(ComputeFallingTimeForLevel(0))
+	, m_LastKeyPressed(GAME_KEY_NONE)
+	, m_StackRenderMode(STACK_MERGED_MESH)
+	, m_IsGamePaused(false)
+	, m_IsGameOver(false)
+{
+	GameObject::InitializeRenderingParameters(&m_Renderer, &m_RenderQueue);
+	Box::Initialize();
+
+	ShapeFactory::SetShapeSet(shapeSetFileName.empty()
+		? ShapeLibrary::LoadEmbeddedShapeSet(EmbeddedShapeSets::DEFAULT_SET_NAME)
+		: ShapeLibrary::LoadShapeSetFromFile(shapeSetFileName));
+
+	// set scene
+	m_pGrid = Grid::Create();
+	m_pGrid->SetPosition(-2.5f, -2.5f, 6.1f);
+
+	m_pLevelPole = LevelPole::Create();
+	m_pLevelPole->SetScale(0.4f, 0.4f, 0.4f);
+	m_pLevelPole->SetPosition(-3.15f, -2.35f, 6.1f);
+
+	SetCurrentAndNextShapes();
+
+	// Build the view matrix.
+	Vector3 position(0.0f, 0.0f, 0.0f);
+	Vector3 target(0.0f, 0.0f, 1.0f);
+	Vector3 up(0.0f, 1.0f, 0.0f);
+	MatrixLookAtLH(&m_View, &position, &target, &up);
+
+	SetAspectRatio(4.0f / 3.0f);
+}
+
+Game::~Game()
+{
+	SafeDelete(m_pGrid);
+	SafeDelete(m_pLevelPole);
+	SafeDelete(m_pCurrentShape);
+	SafeDelete(m_pNextShape);
+	ShapeFactory::DeleteRecycledShapes();
+
+	// shape buffers go back to the renderer before it is gone
+	ShapeLibrary::ReleaseShapeSets();
+	Box::ReleaseBuffers();
+}
+
+void Game::Update(int64_t deltaTime)
+{
+	AllocationScope allocationScope(ALLOCATION_TAG_UPDATE);
+
+	switch (m_LastKeyPressed)
+	{
+	case GAME_KEY_NEW_GAME:
+		if (m_IsGameOver)
+		{
+			NewGame();
+		}
+		break;
+	case GAME_KEY_PAUSE:
+		m_IsGamePaused = !m_IsGamePaused;
+		m_LastKeyPressed = GAME_KEY_NONE;
+		Tracer::Instant("game", m_IsGamePaused ? "pause" : "resume");
+		break;
+	case GAME_KEY_TOGGLE_STACK_RENDER_MODE:
+		// switch between the merged stack mesh and instanced cubes
+		m_StackRenderMode = m_StackRenderMode == STACK_MERGED_MESH ? STACK_INSTANCED : STACK_MERGED_MESH;
+		m_LastKeyPressed = GAME_KEY_NONE;
+		break;
+	default:
+		break;
+	}
+
+	if (m_IsGameOver || m_IsGamePaused)
+	{
+		return;
+	}
+
+	m_PlayTime += deltaTime;
+	m_CurrentTimeAfterLastFall += deltaTime;
+
+	if (!m_pCurrentShape->IsAnimationStarted())
+	{
+		if (m_LastKeyPressed != GAME_KEY_NONE)
+		{
+			switch (m_LastKeyPressed)
+			{
+			case GAME_KEY_LEFT:
+				m_pCurrentShape->TryToTranslate(-1, 0, 0);
+				break;
+			case GAME_KEY_RIGHT:
+				m_pCurrentShape->TryToTranslate(1, 0, 0);
+				break;
+			case GAME_KEY_UP:
+				m_pCurrentShape->TryToTranslate(0, 1, 0);
+				break;
+			case GAME_KEY_DOWN:
+				m_pCurrentShape->TryToTranslate(0, -1, 0);
+				break;
+			case GAME_KEY_DROP:
+				MoveDownCurrentShape();
+				break;
+			case GAME_KEY_ROTATE_X_NEGATIVE:
+				m_pCurrentShape->TryToRotate(-PI_HALF, 0, 0);
+				break;
+			case GAME_KEY_ROTATE_X_POSITIVE:
+				m_pCurrentShape->TryToRotate(PI_HALF, 0, 0);
+				break;
+			case GAME_KEY_ROTATE_Y_NEGATIVE:
+				m_pCurrentShape->TryToRotate(0, -PI_HALF, 0);
+				break;
+			case GAME_KEY_ROTATE_Y_POSITIVE:
+				m_pCurrentShape->TryToRotate(0, PI_HALF, 0);
+				break;
+			case GAME_KEY_ROTATE_Z_NEGATIVE:
+				m_pCurrentShape->TryToRotate(0, 0, -PI_HALF);
+				break;
+			case GAME_KEY_ROTATE_Z_POSITIVE:
+				m_pCurrentShape->TryToRotate(0, 0, PI_HALF);
+				break;
+			default:
+				break;
+			}
+
+			// the drop goes on until the shape lands
+			if (m_LastKeyPressed != GAME_KEY_DROP)
+			{
+				m_LastKeyPressed = GAME_KEY_NONE;
+			}
+		}
+		else if (m_ShapeFallingTime <= m_CurrentTimeAfterLastFall)
+		{
+			// the time past the fall counts towards the next one, so the
+			// falls don't drift; whole falling times missed aren't made up
+			m_CurrentTimeAfterLastFall = m_ShapeFallingTime > 0 ? m_CurrentTimeAfterLastFall % m_ShapeFallingTime : 0;
+			MoveDownCurrentShape();
+		}
+	}
+
+	if (m_PlayTime > m_NextLevelStartTime && m_Level < LAST_LEVEL)
+	{
+		++m_Level;
+		m_NextLevelStartTime += LEVEL_TIME_INTERVAL;
+		m_ShapeFallingTime = ComputeFallingTimeForLevel(m_Level);
+		Tracer::Instant("game", "level up", "level", m_Level);
+	}
+
+	const float deltaSeconds = float(NanosecondsToSeconds(deltaTime));
+	m_pCurrentShape->Update(deltaSeconds);
+	m_pNextShape->RotateY(deltaSeconds);
+}
+
+void Game::Publish(GameSnapshot& snapshot)
+{
+	AllocationScope allocationScope(ALLOCATION_TAG_DRAW);
+
+	// world matrices of everything moved since the last snapshot
+	TransformSystem::UpdateWorldMatrices();
+
+	snapshot.GridWorld = m_pGrid->GetWorldMatrix();
+	snapshot.LevelPoleWorld = m_pLevelPole->GetWorldMatrix();
+
+	snapshot.StackPit = m_pGrid->GetPit();
+	snapshot.FaceMasks = m_pGrid->GetFaceMasks();
+	snapshot.StackVersion = m_pGrid->GetStackVersion();
+	snapshot.StackMode = m_StackRenderMode;
+
+	m_pCurrentShape->Publish(snapshot.CurrentShape);
+	m_pNextShape->Publish(snapshot.NextShape);
+	snapshot.ShapeHeight = m_pCurrentShape->GetShapeHeightInGrid();
+
+	snapshot.Level = m_Level;
+	snapshot.PlayedCubesCount = m_PlayedCubesCount;
+	snapshot.Score = m_Score;
+	snapshot.HighScore = m_HighScore;
+	snapshot.IsPaused = m_IsGamePaused;
+	snapshot.IsOver = m_IsGameOver;
+}
+
+void Game::Draw(const GameSnapshot& snapshot)
+{
+	AllocationScope allocationScope(ALLOCATION_TAG_DRAW);
+
+	{
+		ScopedPhaseTimer timer(PHASE_DRAW_GRID);
+		m_pGrid->Draw(snapshot);
+		m_pLevelPole->Draw(snapshot);
+	}
+
+	// the stack is hidden while paused, the falling shape also once the game is over
+	if (!snapshot.IsPaused)
+	{
+		ScopedPhaseTimer timer(PHASE_DRAW_STACK);
+		m_pGrid->DrawBoxes(snapshot);
+	}
+
+	{
+		ScopedPhaseTimer timer(PHASE_DRAW_SHAPES);
+
+		if (!snapshot.IsPaused && !snapshot.IsOver)
+		{
+			Shape::Draw(snapshot.CurrentShape);
+		}
+
+		if (snapshot.IsPaused || !snapshot.IsOver)
+		{
+			Shape::Draw(snapshot.NextShape);
+		}
+	}
+
+	ScopedPhaseTimer timer(PHASE_DRAW_SUBMIT);
+	m_RenderQueue.Flush(m_Renderer);
+}
+
+void Game::Draw()
+{
+	Publish(m_Snapshot);
+	Draw(m_Snapshot);
+}
+
+void Game::OnKeyPressed(GameKey key)
+{
+	m_LastKeyPressed = key;
+}
+
+void Game::SetAspectRatio(float aspectRatio)
+{
+	MatrixPerspectiveFovLH(&m_Projection, 0.25f * PI, aspectRatio, 1.0f, 1000.0f);
+
+	Matrix VP = m_View * m_Projection;
+	m_Renderer.SetViewProjection(VP);
+}
+
+void Game::NewGame()
+{
+	SetLevel(0);
+	m_PlayedCubesCount = 0;
+	m_Score = 0;
+	m_CurrentTimeAfterLastFall = 0;
+	m_LastKeyPressed = GAME_KEY_NONE;
+	m_IsGameOver = false;
+	Tracer::Instant("game", "new game");
+	m_pGrid->DeleteBoxes();
+	RecycleShapes();
+	SetCurrentAndNextShapes();
+}
+
+void Game::SetRandomSeed(uint64_t randomSeed)
+{
+	m_Random.Seed(randomSeed);
+}
+
+void Game::GetPosition(GamePosition& position) const
+{
+	position.Stack = m_pGrid->GetPit();
+
+	position.ShapeKind = ShapeFactory::GetShapeKind(*m_pCurrentShape);
+	position.NextShapeKind = ShapeFactory::GetShapeKind(*m_pNextShape);
+
+	// shapes without an orientation table can't be written down
+	const int orientation = m_pCurrentShape->GetOrientation();
+
+	if (orientation < 0)
+	{
+		position.ShapeKind = -1;
+	}
+
+	const Vector3& positionInGrid = m_pCurrentShape->GetPositionInGrid();
+
+	position.Orientation = unsigned(max(orientation, 0));
+	position.ShapeX = Round(positionInGrid.x);
+	position.ShapeY = Round(positionInGrid.y);
+	position.ShapeZ = Round(positionInGrid.z);
+
+	position.Score = m_Score;
+	position.Level = m_Level;
+	position.RandomState = m_Random.GetState();
+}
+
+bool Game::SetPosition(const GamePosition& position)
+{
+	const ShapeSet* pShapeSet = ShapeFactory::GetShapeSet();
+	const int shapesCount = int(pShapeSet->GetShapesCount());
+
+	if (position.ShapeKind >= shapesCount || position.NextShapeKind >= shapesCount || position.Level > LAST_LEVEL)
+	{
+		return false;
+	}
+
+	if (position.ShapeKind >= 0)
+	{
+		const ShapeOrientationTable* pOrientations = pShapeSet->GetShape(unsigned(position.ShapeKind))->GetOrientations();
+
+		if (!pOrientations || position.Orientation >= pOrientations->Count)
+		{
+			return false;
+		}
+
+		// the cells of Shape::IsMovePosible
+		const ShapeOrientation& orientation = pOrientations->Orientations[position.Orientation];
+
+		for (size_t i = 0; i < orientation.CubesCount; ++i)
+		{
+			const int x = position.ShapeX + orientation.Cubes[i][0];
+			const int y = position.ShapeY + orientation.Cubes[i][1];
+			const int z = position.ShapeZ + orientation.Cubes[i][2];
+
+			if (x < 0 || x >= int(Grid::X_SIZE) || y < 0 || y >= int(Grid::Y_SIZE) || z >= int(Grid::Z_SIZE) ||
+				position.Stack.IsOccupied(x, y, z))
+			{
+				return false;
+			}
+		}
+	}
+
+	m_pGrid->SetPit(position.Stack);
+	m_Random.Seed(position.RandomState);
+
+	RecycleShapes();
+
+	if (position.ShapeKind >= 0)
+	{
+		m_pCurrentShape = ShapeFactory::CreateShape(unsigned(position.ShapeKind));
+		m_pCurrentShape->SetPosition(SHAPE_INITIAL_POSITION_IN_GRID);
+		m_pCurrentShape->Place(position.Orientation, Vector3(float(position.ShapeX), float(position.ShapeY), float(position.ShapeZ)));
+	}
+	else
+	{
+		m_pCurrentShape = ShapeFactory::CreateRandomShape(m_Random);
+		m_pCurrentShape->SetPosition(SHAPE_INITIAL_POSITION_IN_GRID);
+	}
+
+	SetNextShape(position.NextShapeKind >= 0
+		? ShapeFactory::CreateShape(unsigned(position.NextShapeKind))
+		: ShapeFactory::CreateRandomShape(m_Random));
+
+	SetLevel(position.Level);
+	m_Score = position.Score;
+	m_PlayedCubesCount = 0;
+	m_CurrentTimeAfterLastFall = 0;
+	m_LastKeyPressed = GAME_KEY_NONE;
+	m_IsGamePaused = false;
+	m_IsGameOver = m_pGrid->HasBoxOnHighestLevel();
+
+	if (m_Score > m_HighScore)
+	{
+		m_HighScore = m_Score;
+	}
+
+	return true;
+}
+
+unsigned Game::GetLevel() const
+{
+	return m_Level;
+}
+
+unsigned Game::GetPlayedCubesCount() const
+{
+	return m_PlayedCubesCount;
+}
+
+unsigned Game::GetScore() const
+{
+	return m_Score;
+}
+
+unsigned Game::GetHighScore() const
+{
+	return m_HighScore;
+}
+
+void Game::SetHighScore(unsigned highScore)
+{
+	m_HighScore = highScore;
+}
+
+bool Game::IsPaused() const
+{
+	return m_IsGamePaused;
+}
+
+bool Game::IsOver() const
+{
+	return m_IsGameOver;
+}
+
+void Game::GameOver()
+{
+	m_IsGameOver = true;
+	Tracer::Instant("game", "game over", "score", m_Score);
+}
+
+void Game::SetCurrentAndNextShapes()
+{
+	m_pCurrentShape = ShapeFactory::CreateRandomShape(m_Random);
+	m_pCurrentShape->SetPosition(SHAPE_INITIAL_POSITION_IN_GRID);
+	Tracer::Instant("game", "spawn", "cubes", m_pCurrentShape->GetCompoundedBlocksCount());
+	SetNextShape(ShapeFactory::CreateRandomShape(m_Random));
+}
+
+void Game::RecycleShapes()
+{
+	if (m_pCurrentShape)
+	{
+		ShapeFactory::RecycleShape(m_pCurrentShape);
+		m_pCurrentShape = nullptr;
+	}
+
+	if (m_pNextShape)
+	{
+		ShapeFactory::RecycleShape(m_pNextShape);
+		m_pNextShape = nullptr;
+	}
+}
+
+void Game::SetNextShape(Shape* pShape)
+{
+	m_pNextShape = pShape;
+
+	m_pNextShape->SetScale(0.20f, 0.20f, 0.20f);
+	m_pNextShape->RotateZ(PI / 2);
+	m_pNextShape->SetPosition(2.9f, 0.9f, 6.0f);
+}
+
+void Game::SetLevel(unsigned level)
+{
+	assert(level <= LAST_LEVEL);
+
+	// the play time at the start of the level
+	m_Level = level;
+	m_PlayTime = level * LEVEL_TIME_INTERVAL;
+	m_NextLevelStartTime = m_PlayTime + LEVEL_TIME_INTERVAL;
+	m_ShapeFallingTime = ComputeFallingTimeForLevel(level);
+}
+
+void Game::MoveDownCurrentShape()
+{
+	if (!m_pCurrentShape->TryToTranslate(0, 0, 1))
+	{
+		m_PlayedCubesCount += m_pCurrentShape->GetCompoundedBlocksCount();
+		Tracer::Instant("game", "lock", "cubes", m_pCurrentShape->GetCompoundedBlocksCount());
+		m_pCurrentShape->Destroy();
+
+		const unsigned clearedLevelsCount = m_pGrid->UpdateLevels();
+		m_Score += clearedLevelsCount * (m_Level + 1);
+
+		if (clearedLevelsCount > 0)
+		{
+			Tracer::Instant("game", "clear", "levels", clearedLevelsCount);
+		}
+
+		if (m_Score > m_HighScore)
+		{
+			m_HighScore = m_Score;
+		}
+
+		if (m_pGrid->HasBoxOnHighestLevel())
+		{
+			GameOver();
+		}
+
+		m_pNextShape->SetWorldTransformationToIdentity();
+		m_pCurrentShape = m_pNextShape;
+		m_pCurrentShape->SetPosition(SHAPE_INITIAL_POSITION_IN_GRID);
+		Tracer::Instant("game", "spawn", "cubes", m_pCurrentShape->GetCompoundedBlocksCount());
+		SetNextShape(ShapeFactory::CreateRandomShape(m_Random));
+
+		m_LastKeyPressed = GAME_KEY_NONE;
+		m_CurrentTimeAfterLastFall = 0;
+	}
+}
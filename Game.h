@@ -0,0 +1,135 @@
+#pragma once
+
+#include "RenderQueue.h"
+#include "GameSnapshot.h"
+#include "Random.h"
+
+class Grid;
+class Shape;
+class LevelPole;
+class Renderer;
+struct GamePosition;
+
+// player commands, the application maps its keys to them
+enum GameKey
+{
+	GAME_KEY_NONE,
+	GAME_KEY_NEW_GAME,
+	GAME_KEY_PAUSE,
+	GAME_KEY_TOGGLE_STACK_RENDER_MODE,
+	GAME_KEY_LEFT,
+	GAME_KEY_RIGHT,
+	GAME_KEY_UP,
+	GAME_KEY_DOWN,
+	GAME_KEY_DROP,
+	GAME_KEY_ROTATE_X_NEGATIVE,
+	GAME_KEY_ROTATE_X_POSITIVE,
+	GAME_KEY_ROTATE_Y_NEGATIVE,
+	GAME_KEY_ROTATE_Y_POSITIVE,
+	GAME_KEY_ROTATE_Z_NEGATIVE,
+	GAME_KEY_ROTATE_Z_POSITIVE,
+};
+
+// The game and its scene without a window or a graphics API. Everything is
+// drawn through the given renderer, so the whole frame runs the same way
+// with D3D10Renderer and NullRenderer. The scene is drawn from a snapshot
+// of the game, so Update and Draw can run on different threads, see
+// Simulation; the getters and setters belong to the simulation side.
+class Game
+{
+public:
+	// an empty shapeSetFileName selects the embedded default shape set,
+	// throws ShapeSetError; the seed decides the pieces of every game
+	Game(Renderer& renderer, const std::string& shapeSetFileName = "", uint64_t randomSeed = 1);
+	~Game();
+
+	// deltaTime in nanoseconds
+	void Update(int64_t deltaTime);
+	void OnKeyPressed(GameKey key);
+
+	// copies what the scene and the HUD are drawn from
+	void Publish(GameSnapshot& snapshot);
+
+	// submits the scene of the snapshot and flushes it to the renderer
+	void Draw(const GameSnapshot& snapshot);
+	// publishes and draws on the calling thread
+	void Draw();
+
+	// renderer side, like Draw
+	void SetAspectRatio(float aspectRatio);
+
+	void NewGame();
+
+	// the pieces drawn from now on, the next game is decided by the seed
+	void SetRandomSeed(uint64_t randomSeed);
+
+	// see PositionNotation
+	void GetPosition(GamePosition& position) const;
+	// returns false and changes nothing when a shape kind or orientation
+	// doesn't exist in the shape set, the current shape doesn't fit or
+	// the level is too high
+	bool SetPosition(const GamePosition& position);
+
+	unsigned GetLevel() const;
+	unsigned GetPlayedCubesCount() const;
+	unsigned GetScore() const;
+
+	unsigned GetHighScore() const;
+	void SetHighScore(unsigned highScore);
+
+	bool IsPaused() const;
+	bool IsOver() const;
+
+private:
+	Game(const Game&);
+	Game& operator = (const Game&);
+
+	void GameOver();
+
+	void SetCurrentAndNextShapes();
+	// hands both shapes back to the ShapeFactory
+	void RecycleShapes();
+	void SetNextShape(Shape* pShape);
+
+	void SetLevel(unsigned level);
+
+	void MoveDownCurrentShape();
+
+	Renderer& m_Renderer;
+	RenderQueue m_RenderQueue;
+
+	// of the single threaded Draw
+	GameSnapshot m_Snapshot;
+
+	Matrix m_View;
+	Matrix m_Projection;
+
+	Grid*		m_pGrid;
+	LevelPole*	m_pLevelPole;
+	Shape*		m_pCurrentShape;
+	Shape*		m_pNextShape;
+
+	unsigned m_PlayedCubesCount;
+	unsigned m_Level;
+	unsigned m_Score;
+	unsigned m_HighScore;
+
+	// the pieces come from here
+	Random m_Random;
+
+	// the play time stops with the game and is kept in nanoseconds, so the
+	// levels keep their pace however long a game lasts
+	int64_t m_PlayTime;
+	int64_t m_NextLevelStartTime;
+
+	// in nanoseconds as well, so the falls keep their pace
+	int64_t m_CurrentTimeAfterLastFall;
+	int64_t m_ShapeFallingTime;
+
+	GameKey m_LastKeyPressed;
+
+	StackRenderMode m_StackRenderMode;
+
+	bool m_IsGamePaused;
+	bool m_IsGameOver;
+};
@@ -0,0 +1,49 @@
+#include "pch.h"
+#include "GameInfoText.h"
+#include "GameSnapshot.h"
+
+using namespace std;
+
+GameInfoText::GameInfoText()
+{
+	m_Level[0] = m_PlayedCubes[0] = m_Score[0] = m_HighScore[0] = '\0';
+}
+
+void GameInfoText::Format(const GameSnapshot& snapshot)
+{
+	FormatLine(m_Level, "LEVEL: ", snapshot.Level);
+	FormatLine(m_PlayedCubes, "", snapshot.PlayedCubesCount);
+	FormatLine(m_Score, "", snapshot.Score);
+	FormatLine(m_HighScore, "", snapshot.HighScore);
+}
+
+const char* GameInfoText::GetLevel() const
+{
+	return m_Level;
+}
+
+const char* GameInfoText::GetPlayedCubes() const
+{
+	return m_PlayedCubes;
+}
+
+const char* GameInfoText::GetScore() const
+{
+	return m_Score;
+}
+
+const char* GameInfoText::GetHighScore() const
+{
+	return m_HighScore;
+}
+
+void GameInfoText::FormatLine(char (&line)[LINE_SIZE], const char* prefix, unsigned number)
+{
+	const size_t prefixLength = strlen(prefix);
+	assert(prefixLength + numeric_limits<unsigned>::digits10 + 2 <= LINE_SIZE);
+
+	memcpy(line, prefix, prefixLength);
+
+	const to_chars_result result = to_chars(line + prefixLength, line + LINE_SIZE - 1, number);
+	*result.ptr = '\0';
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+struct GameSnapshot;
+
+// The lines of the game info panel that change with the game, formatted
+// into fixed buffers, so the HUD is drawn every frame without allocating.
+class GameInfoText
+{
+public:
+	GameInfoText();
+
+	void Format(const GameSnapshot& snapshot);
+
+	// "LEVEL: n"
+	const char* GetLevel() const;
+	const char* GetPlayedCubes() const;
+	const char* GetScore() const;
+	const char* GetHighScore() const;
+
+private:
+	// room for the prefix and any unsigned
+	static const size_t LINE_SIZE = 32;
+
+	static void FormatLine(char (&line)[LINE_SIZE], const char* prefix, unsigned number);
+
+	char m_Level[LINE_SIZE];
+	char m_PlayedCubes[LINE_SIZE];
+	char m_Score[LINE_SIZE];
+	char m_HighScore[LINE_SIZE];
+};
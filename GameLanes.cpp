@@ -0,0 +1,838 @@
+#include "pch.h"
+#include "GameLanes.h"
+#include "ShapeLibrary.h"
+#include "ShapeGeometry.h"
+#include "PositionNotation.h"
+
+// the lanes take integer SSE2, which comes with every x64 compiler
+#if defined(MATH_USE_SSE) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define GAME_LANES_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+
+// of Game
+const unsigned LAST_LEVEL = 9;
+
+// the pivot cube of a new shape, see Perft
+const int SPAWN_X = int(PIT_X_SIZE / 2);
+const int SPAWN_Y = int(PIT_Y_SIZE / 2);
+
+constexpr Pit::LevelMask GetColumnMask(size_t x)
+{
+	Pit::LevelMask mask = 0;
+
+	for (size_t y = 0; y < PIT_Y_SIZE; ++y)
+	{
+		mask |= Pit::LevelMask(1) << (y * PIT_X_SIZE + x);
+	}
+
+	return mask;
+}
+
+// cells a shape can't leave when it moves towards that side
+const Pit::LevelMask FIRST_COLUMN_MASK = GetColumnMask(0);
+const Pit::LevelMask LAST_COLUMN_MASK = GetColumnMask(PIT_X_SIZE - 1);
+const Pit::LevelMask FIRST_ROW_MASK = (Pit::LevelMask(1) << PIT_X_SIZE) - 1;
+const Pit::LevelMask LAST_ROW_MASK = FIRST_ROW_MASK << ((PIT_Y_SIZE - 1) * PIT_X_SIZE);
+
+static_assert(GAME_KEY_ROTATE_Z_POSITIVE - GAME_KEY_ROTATE_X_NEGATIVE + 1 == SHAPE_ROTATIONS_COUNT, "rotation keys must follow ShapeRotation");
+
+bool GetRotation(GameKey key, ShapeRotation& rotation)
+{
+	if (key < GAME_KEY_ROTATE_X_NEGATIVE || key > GAME_KEY_ROTATE_Z_POSITIVE)
+	{
+		return false;
+	}
+
+	rotation = ShapeRotation(key - GAME_KEY_ROTATE_X_NEGATIVE);
+	return true;
+}
+
+// the cells stay between the walls and above the bottom; cells above the
+// pit are free, see Shape::IsMovePosible
+bool IsInPit(const ShapeOrientation& orientation, int x, int y, int z)
+{
+	return orientation.HasLayerMasks &&
+		x + orientation.Minimum[0] >= 0 && x + orientation.Maximum[0] < int(PIT_X_SIZE) &&
+		y + orientation.Minimum[1] >= 0 && y + orientation.Maximum[1] < int(PIT_Y_SIZE) &&
+		z + orientation.Maximum[2] < int(PIT_Z_SIZE);
+}
+
+// of the layer masks of the orientation to the pivot cube at x, y
+size_t GetLayerShift(const ShapeOrientation& orientation, int x, int y)
+{
+	return size_t(y + orientation.Minimum[1]) * PIT_X_SIZE + size_t(x + orientation.Minimum[0]);
+}
+
+#ifdef GAME_LANES_USE_SSE2
+
+__m128i Load(const void* pValues)
+{
+	return _mm_loadu_si128(static_cast<const __m128i*>(pValues));
+}
+
+void Store(void* pValues, __m128i values)
+{
+	_mm_storeu_si128(static_cast<__m128i*>(pValues), values);
+}
+
+// a where the mask is set, b elsewhere
+__m128i Select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// all bits set in the lanes that aren't zero
+__m128i IsNotZero(__m128i values)
+{
+	return _mm_xor_si128(_mm_cmpeq_epi32(values, _mm_setzero_si128()), _mm_set1_epi32(-1));
+}
+
+bool IsAnySet(__m128i mask)
+{
+	return _mm_movemask_epi8(mask) != 0;
+}
+
+// a level of four lanes whose levels differ, offset from the level of each
+__m128i LoadLevels(const Pit::LevelMask* const* pLevels, size_t offset)
+{
+	return _mm_set_epi32(int(pLevels[3][offset]), int(pLevels[2][offset]), int(pLevels[1][offset]), int(pLevels[0][offset]));
+}
+
+#endif
+
+}
+
+GameLanes::GameLanes(const ShapeSet& shapeSet, size_t lanesCount)
+	: m_LanesCount(lanesCount)
+	, m_Capacity((lanesCount + GROUP_SIZE - 1) / GROUP_SIZE * GROUP_SIZE)
+	, m_RunningLanesCount(0)
+{
+	for (unsigned kind = 0; kind < shapeSet.GetShapesCount(); ++kind)
+	{
+		const ShapeOrientationTable* pOrientations = shapeSet.GetShape(kind)->GetOrientations();
+
+		assert(pOrientations && IsInPit(pOrientations->Orientations[0], SPAWN_X, SPAWN_Y, 0));
+
+		m_Pieces.push_back(pOrientations);
+	}
+
+	assert(!m_Pieces.empty() && m_Pieces.size() <= UINT8_MAX);
+
+	m_StackLevels.assign(STORED_LEVELS_COUNT * m_Capacity, 0);
+	m_ShapeLayers.assign(MAX_SHAPE_CUBES * m_Capacity, 0);
+
+	// the bottom of the pit stops a shape like the stack does
+	for (size_t lane = 0; lane < m_Capacity; ++lane)
+	{
+		for (int z = int(PIT_Z_SIZE); z < int(PIT_Z_SIZE + MAX_SHAPE_CUBES); ++z)
+		{
+			m_StackLevels[GetLevelIndex(lane, z)] = Pit::FULL_LEVEL_MASK;
+		}
+	}
+
+	m_ShapeX.assign(m_Capacity, SPAWN_X);
+	m_ShapeY.assign(m_Capacity, SPAWN_Y);
+	m_ShapeZ.assign(m_Capacity, 0);
+	m_ShapeMinimumZ.assign(m_Capacity, 0);
+	m_ShapeMaximumZ.assign(m_Capacity, 0);
+	m_Orientations.assign(m_Capacity, 0);
+	m_ShapeKinds.assign(m_Capacity, 0);
+	m_NextShapeKinds.assign(m_Capacity, 0);
+
+	m_RandomStates.assign(m_Capacity, Random().GetState());
+
+	m_Levels.assign(m_Capacity, 0);
+	m_Scores.assign(m_Capacity, 0);
+	m_PlayedCubesCounts.assign(m_Capacity, 0);
+
+	// the lanes past the last one never run
+	m_IsRunning.assign(m_Capacity, 0);
+
+	for (size_t lane = 0; lane < m_LanesCount; ++lane)
+	{
+		NewGame(lane, lane + 1);
+	}
+}
+
+size_t GameLanes::GetLanesCount() const
+{
+	return m_LanesCount;
+}
+
+size_t GameLanes::GetRunningLanesCount() const
+{
+	return m_RunningLanesCount;
+}
+
+void GameLanes::NewGame(size_t lane, uint64_t randomSeed, unsigned level)
+{
+	assert(lane < m_LanesCount && level <= LAST_LEVEL);
+
+	for (int z = 0; z < int(PIT_Z_SIZE); ++z)
+	{
+		m_StackLevels[GetLevelIndex(lane, z)] = 0;
+	}
+
+	m_RandomStates[lane] = Random(randomSeed).GetState();
+
+	const unsigned kind = DrawShapeKind(lane);
+	SetShape(lane, kind, 0, SPAWN_X, SPAWN_Y, 0);
+	m_NextShapeKinds[lane] = uint8_t(DrawShapeKind(lane));
+
+	m_Levels[lane] = level;
+	m_Scores[lane] = 0;
+	m_PlayedCubesCounts[lane] = 0;
+
+	if (!m_IsRunning[lane])
+	{
+		m_IsRunning[lane] = ~0u;
+		++m_RunningLanesCount;
+	}
+}
+
+void GameLanes::GetPosition(size_t lane, GamePosition& position) const
+{
+	assert(lane < m_LanesCount);
+
+	position.Stack.Clear();
+
+	for (size_t z = 0; z < PIT_Z_SIZE; ++z)
+	{
+		position.Stack.OccupyCells(z, m_StackLevels[GetLevelIndex(lane, int(z))]);
+	}
+
+	position.ShapeKind = m_ShapeKinds[lane];
+	position.NextShapeKind = m_NextShapeKinds[lane];
+	position.Orientation = m_Orientations[lane];
+	position.ShapeX = m_ShapeX[lane];
+	position.ShapeY = m_ShapeY[lane];
+	position.ShapeZ = m_ShapeZ[lane];
+
+	position.Score = m_Scores[lane];
+	position.Level = m_Levels[lane];
+	position.RandomState = m_RandomStates[lane];
+}
+
+bool GameLanes::SetPosition(size_t lane, const GamePosition& position)
+{
+	assert(lane < m_LanesCount);
+
+	const int shapesCount = int(m_Pieces.size());
+
+	if (position.ShapeKind >= shapesCount || position.NextShapeKind >= shapesCount || position.Level > LAST_LEVEL)
+	{
+		return false;
+	}
+
+	if (position.ShapeKind >= 0)
+	{
+		const ShapeOrientationTable& orientations = *m_Pieces[position.ShapeKind];
+
+		if (position.Orientation >= orientations.Count)
+		{
+			return false;
+		}
+
+		// the levels above the pit are kept for MAX_SHAPE_CUBES - 1 of
+		// them, a pivot cube in the pit keeps every cube there
+		if (position.ShapeZ < 0)
+		{
+			return false;
+		}
+
+		const ShapeOrientation& orientation = orientations.Orientations[position.Orientation];
+
+		for (size_t i = 0; i < orientation.CubesCount; ++i)
+		{
+			const int x = position.ShapeX + orientation.Cubes[i][0];
+			const int y = position.ShapeY + orientation.Cubes[i][1];
+			const int z = position.ShapeZ + orientation.Cubes[i][2];
+
+			if (x < 0 || x >= int(PIT_X_SIZE) || y < 0 || y >= int(PIT_Y_SIZE) || z >= int(PIT_Z_SIZE) ||
+				position.Stack.IsOccupied(x, y, z))
+			{
+				return false;
+			}
+		}
+	}
+
+	for (size_t z = 0; z < PIT_Z_SIZE; ++z)
+	{
+		m_StackLevels[GetLevelIndex(lane, int(z))] = position.Stack.GetLevelMask(z);
+	}
+
+	m_RandomStates[lane] = Random(position.RandomState).GetState();
+
+	if (position.ShapeKind >= 0)
+	{
+		SetShape(lane, unsigned(position.ShapeKind), position.Orientation, position.ShapeX, position.ShapeY, position.ShapeZ);
+	}
+	else
+	{
+		const unsigned kind = DrawShapeKind(lane);
+		SetShape(lane, kind, 0, SPAWN_X, SPAWN_Y, 0);
+	}
+
+	m_NextShapeKinds[lane] = uint8_t(position.NextShapeKind >= 0 ? unsigned(position.NextShapeKind) : DrawShapeKind(lane));
+
+	m_Levels[lane] = position.Level;
+	m_Scores[lane] = position.Score;
+	m_PlayedCubesCounts[lane] = 0;
+
+	const bool isRunning = m_StackLevels[GetLevelIndex(lane, 0)] == 0;
+
+	if (isRunning && !m_IsRunning[lane])
+	{
+		++m_RunningLanesCount;
+	}
+	else if (!isRunning && m_IsRunning[lane])
+	{
+		--m_RunningLanesCount;
+	}
+
+	m_IsRunning[lane] = isRunning ? ~0u : 0;
+
+	return true;
+}
+
+void GameLanes::Step(const GameKey* pKeys)
+{
+	assert(pKeys || m_LanesCount == 0);
+
+	for (size_t first = 0; first < m_LanesCount; first += GROUP_SIZE)
+	{
+		StepGroup(first, pKeys);
+	}
+}
+
+bool GameLanes::IsOver(size_t lane) const
+{
+	assert(lane < m_LanesCount);
+	return m_IsRunning[lane] == 0;
+}
+
+unsigned GameLanes::GetLevel(size_t lane) const
+{
+	assert(lane < m_LanesCount);
+	return m_Levels[lane];
+}
+
+unsigned GameLanes::GetScore(size_t lane) const
+{
+	assert(lane < m_LanesCount);
+	return m_Scores[lane];
+}
+
+unsigned GameLanes::GetPlayedCubesCount(size_t lane) const
+{
+	assert(lane < m_LanesCount);
+	return m_PlayedCubesCounts[lane];
+}
+
+void GameLanes::StepLane(size_t lane, GameKey key)
+{
+	if (!m_IsRunning[lane])
+	{
+		return;
+	}
+
+	ShapeRotation rotation;
+
+	switch (key)
+	{
+	case GAME_KEY_NONE:
+		MoveDown(lane);
+		break;
+	case GAME_KEY_LEFT:
+		TryToTranslate(lane, -1, 0, 0);
+		break;
+	case GAME_KEY_RIGHT:
+		TryToTranslate(lane, 1, 0, 0);
+		break;
+	case GAME_KEY_UP:
+		TryToTranslate(lane, 0, 1, 0);
+		break;
+	case GAME_KEY_DOWN:
+		TryToTranslate(lane, 0, -1, 0);
+		break;
+	case GAME_KEY_DROP:
+		while (MoveDown(lane))
+		{
+		}
+		break;
+	default:
+		if (GetRotation(key, rotation))
+		{
+			TryToRotate(lane, rotation);
+		}
+		break;
+	}
+}
+
+void GameLanes::StepGroup(size_t first, const GameKey* pKeys)
+{
+	// the lanes past the last one have no key
+	GameKey keys[GROUP_SIZE];
+
+	for (size_t slot = 0; slot < GROUP_SIZE; ++slot)
+	{
+		keys[slot] = first + slot < m_LanesCount ? pKeys[first + slot] : GAME_KEY_NONE;
+	}
+
+#ifdef GAME_LANES_USE_SSE2
+	const __m128i isRunning = Load(&m_IsRunning[first]);
+
+	if (!IsAnySet(isRunning))
+	{
+		return;
+	}
+
+	// a group is contiguous, a layer or a level of its four lanes is one load
+	Pit::LevelMask* pLayers = &m_ShapeLayers[GetLayerIndex(first, 0)];
+	Pit::LevelMask* pLevels = &m_StackLevels[GetLevelIndex(first, 0)];
+
+	// the layers of the tallest shape of the group, the others are empty;
+	// the shape of an ended game is taken in too, it costs less than a test
+	size_t layersCount = 0;
+
+	// the level under the first layer of every shape once it moved
+	const Pit::LevelMask* pTopLevels[GROUP_SIZE];
+
+	// A rotated shape takes its cells from the orientation table, one lane
+	// at a time; when they stay in the pit they are tested against the
+	// stack together with the translated and the falling shapes.
+	uint32_t rotatingLanes[GROUP_SIZE] = {};
+	const ShapeOrientation* pRotatedOrientations[GROUP_SIZE] = {};
+	bool isAnyRotating = false;
+
+	for (size_t slot = 0; slot < GROUP_SIZE; ++slot)
+	{
+		const size_t lane = first + slot;
+		int top = m_ShapeZ[lane] + m_ShapeMinimumZ[lane];
+		ShapeRotation rotation;
+
+		layersCount = max(layersCount, GetLayersCount(lane));
+
+		if (keys[slot] == GAME_KEY_NONE || keys[slot] == GAME_KEY_DROP)
+		{
+			++top;
+		}
+		else if (m_IsRunning[lane] && GetRotation(keys[slot], rotation))
+		{
+			const ShapeOrientationTable& orientations = *m_Pieces[m_ShapeKinds[lane]];
+			const ShapeOrientation& orientation = orientations.Orientations[orientations.Orientations[m_Orientations[lane]].Rotations[rotation]];
+
+			if (IsInPit(orientation, m_ShapeX[lane], m_ShapeY[lane], m_ShapeZ[lane]))
+			{
+				rotatingLanes[slot] = ~0u;
+				pRotatedOrientations[slot] = &orientation;
+				isAnyRotating = true;
+
+				layersCount = max(layersCount, size_t(orientation.Maximum[2] - orientation.Minimum[2] + 1));
+				top = m_ShapeZ[lane] + orientation.Minimum[2];
+			}
+		}
+
+		pTopLevels[slot] = pLevels + ptrdiff_t(top) * ptrdiff_t(GROUP_SIZE) + ptrdiff_t(slot);
+	}
+
+	Pit::LevelMask rotatedLayers[MAX_SHAPE_CUBES][GROUP_SIZE];
+
+	if (isAnyRotating)
+	{
+		memset(rotatedLayers, 0, layersCount * sizeof(rotatedLayers[0]));
+
+		for (size_t slot = 0; slot < GROUP_SIZE; ++slot)
+		{
+			const ShapeOrientation* pOrientation = pRotatedOrientations[slot];
+
+			if (!pOrientation)
+			{
+				continue;
+			}
+
+			const size_t lane = first + slot;
+			const size_t shift = GetLayerShift(*pOrientation, m_ShapeX[lane], m_ShapeY[lane]);
+
+			for (size_t layer = 0; layer <= size_t(pOrientation->Maximum[2] - pOrientation->Minimum[2]); ++layer)
+			{
+				rotatedLayers[layer][slot] = pOrientation->LayerMasks[layer] << shift;
+			}
+		}
+	}
+
+	// all bits set in the running lanes that got the key
+	const __m128i keyValues = _mm_set_epi32(keys[3], keys[2], keys[1], keys[0]);
+
+	const __m128i left = _mm_and_si128(isRunning, _mm_cmpeq_epi32(keyValues, _mm_set1_epi32(GAME_KEY_LEFT)));
+	const __m128i right = _mm_and_si128(isRunning, _mm_cmpeq_epi32(keyValues, _mm_set1_epi32(GAME_KEY_RIGHT)));
+	const __m128i up = _mm_and_si128(isRunning, _mm_cmpeq_epi32(keyValues, _mm_set1_epi32(GAME_KEY_UP)));
+	const __m128i down = _mm_and_si128(isRunning, _mm_cmpeq_epi32(keyValues, _mm_set1_epi32(GAME_KEY_DOWN)));
+	const __m128i dropping = _mm_and_si128(isRunning, _mm_cmpeq_epi32(keyValues, _mm_set1_epi32(GAME_KEY_DROP)));
+	const __m128i resting = _mm_and_si128(isRunning, _mm_cmpeq_epi32(keyValues, _mm_set1_epi32(GAME_KEY_NONE)));
+
+	const __m128i rotating = Load(rotatingLanes);
+	const __m128i falling = _mm_or_si128(resting, dropping);
+	const __m128i moving = _mm_or_si128(_mm_or_si128(_mm_or_si128(left, right), _mm_or_si128(up, down)), _mm_or_si128(rotating, falling));
+
+	// cells on the side the shape moves to block it like the stack does
+	const __m128i edge = _mm_or_si128(
+		_mm_or_si128(_mm_and_si128(left, _mm_set1_epi32(FIRST_COLUMN_MASK)), _mm_and_si128(right, _mm_set1_epi32(LAST_COLUMN_MASK))),
+		_mm_or_si128(_mm_and_si128(up, _mm_set1_epi32(LAST_ROW_MASK)), _mm_and_si128(down, _mm_set1_epi32(FIRST_ROW_MASK))));
+
+	__m128i movedLayers[MAX_SHAPE_CUBES];
+	__m128i blocked = _mm_setzero_si128();
+
+	for (size_t layer = 0; layer < layersCount; ++layer)
+	{
+		const __m128i cells = Load(pLayers + layer * GROUP_SIZE);
+
+		// x is bit 1 and y bit PIT_X_SIZE of the level masks, a falling
+		// shape keeps its layers on the levels below
+		__m128i moved = _mm_or_si128(
+			_mm_or_si128(_mm_and_si128(left, _mm_srli_epi32(cells, 1)), _mm_and_si128(right, _mm_slli_epi32(cells, 1))),
+			_mm_or_si128(_mm_and_si128(up, _mm_slli_epi32(cells, PIT_X_SIZE)), _mm_and_si128(down, _mm_srli_epi32(cells, PIT_X_SIZE))));
+		moved = _mm_or_si128(moved, _mm_and_si128(falling, cells));
+
+		if (isAnyRotating)
+		{
+			moved = _mm_or_si128(moved, Load(rotatedLayers[layer]));
+		}
+
+		blocked = _mm_or_si128(blocked, _mm_or_si128(_mm_and_si128(cells, edge), _mm_and_si128(moved, LoadLevels(pTopLevels, layer * GROUP_SIZE))));
+		movedLayers[layer] = moved;
+	}
+
+	blocked = IsNotZero(blocked);
+
+	const __m128i isMoved = _mm_andnot_si128(blocked, moving);
+	__m128i locked = _mm_and_si128(falling, blocked);
+	__m128i shapeZ = Load(&m_ShapeZ[first]);
+
+	if (IsAnySet(isMoved))
+	{
+		for (size_t layer = 0; layer < layersCount; ++layer)
+		{
+			Store(pLayers + layer * GROUP_SIZE, Select(isMoved, movedLayers[layer], Load(pLayers + layer * GROUP_SIZE)));
+		}
+
+		// the masks are -1 where set, so left minus right is the step in x
+		Store(&m_ShapeX[first], _mm_add_epi32(Load(&m_ShapeX[first]), _mm_and_si128(isMoved, _mm_sub_epi32(left, right))));
+		Store(&m_ShapeY[first], _mm_add_epi32(Load(&m_ShapeY[first]), _mm_and_si128(isMoved, _mm_sub_epi32(down, up))));
+		shapeZ = _mm_sub_epi32(shapeZ, _mm_and_si128(isMoved, falling));
+
+		const int rotatedLanes = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(isMoved, rotating)));
+
+		for (size_t slot = 0; slot < GROUP_SIZE; ++slot)
+		{
+			if (rotatedLanes & (1 << slot))
+			{
+				const size_t lane = first + slot;
+				const ShapeOrientation& orientation = *pRotatedOrientations[slot];
+
+				m_Orientations[lane] = uint8_t(&orientation - m_Pieces[m_ShapeKinds[lane]]->Orientations);
+				m_ShapeMinimumZ[lane] = orientation.Minimum[2];
+				m_ShapeMaximumZ[lane] = orientation.Maximum[2];
+			}
+		}
+	}
+
+	// a drop falls on until the shape locks, the layers stay and the
+	// levels under them move up
+	__m128i dropped = _mm_and_si128(isMoved, dropping);
+
+	while (IsAnySet(dropped))
+	{
+		const int droppedLanes = _mm_movemask_ps(_mm_castsi128_ps(dropped));
+
+		for (size_t slot = 0; slot < GROUP_SIZE; ++slot)
+		{
+			if (droppedLanes & (1 << slot))
+			{
+				pTopLevels[slot] += GROUP_SIZE;
+			}
+		}
+
+		blocked = _mm_setzero_si128();
+
+		for (size_t layer = 0; layer < layersCount; ++layer)
+		{
+			blocked = _mm_or_si128(blocked, _mm_and_si128(Load(pLayers + layer * GROUP_SIZE), LoadLevels(pTopLevels, layer * GROUP_SIZE)));
+		}
+
+		blocked = IsNotZero(blocked);
+		locked = _mm_or_si128(locked, _mm_and_si128(dropped, blocked));
+		dropped = _mm_andnot_si128(blocked, dropped);
+		shapeZ = _mm_sub_epi32(shapeZ, dropped);
+	}
+
+	Store(&m_ShapeZ[first], shapeZ);
+
+	if (!IsAnySet(locked))
+	{
+		return;
+	}
+
+	// the shapes go into the stack one lane at a time, their levels differ
+	uint32_t lockedLanes[GROUP_SIZE];
+	uint32_t hasFullLevels[GROUP_SIZE] = {};
+	bool isAnyLevelFull = false;
+
+	Store(lockedLanes, locked);
+
+	for (size_t slot = 0; slot < GROUP_SIZE; ++slot)
+	{
+		if (lockedLanes[slot] && AddShapeToStack(first + slot))
+		{
+			hasFullLevels[slot] = ~0u;
+			isAnyLevelFull = true;
+		}
+	}
+
+	// Grid::UpdateLevels, one full level per lane and pass: the levels from
+	// the lowest full one up move one level down, level 0 takes the empty
+	// one above the pit
+	uint32_t clearedCounts[GROUP_SIZE] = {};
+
+	if (isAnyLevelFull)
+	{
+		const __m128i fullLevel = _mm_set1_epi32(Pit::FULL_LEVEL_MASK);
+		const __m128i clearing = Load(hasFullLevels);
+		__m128i hasFullLevel = clearing;
+		__m128i clearedLevelsCounts = _mm_setzero_si128();
+
+		while (IsAnySet(hasFullLevel))
+		{
+			hasFullLevel = _mm_setzero_si128();
+
+			for (int z = int(PIT_Z_SIZE) - 1; z >= 0; --z)
+			{
+				const __m128i levels = Load(pLevels + z * int(GROUP_SIZE));
+				hasFullLevel = _mm_or_si128(hasFullLevel, _mm_and_si128(clearing, _mm_cmpeq_epi32(levels, fullLevel)));
+
+				Store(pLevels + z * int(GROUP_SIZE), Select(hasFullLevel, Load(pLevels + (z - 1) * int(GROUP_SIZE)), levels));
+			}
+
+			clearedLevelsCounts = _mm_sub_epi32(clearedLevelsCounts, hasFullLevel);
+		}
+
+		Store(clearedCounts, clearedLevelsCounts);
+	}
+
+	for (size_t slot = 0; slot < GROUP_SIZE; ++slot)
+	{
+		if (lockedLanes[slot])
+		{
+			FinishLock(first + slot, clearedCounts[slot]);
+		}
+	}
+#else
+	for (size_t slot = 0; slot < GROUP_SIZE; ++slot)
+	{
+		StepLane(first + slot, keys[slot]);
+	}
+#endif
+}
+
+bool GameLanes::IsMovePosible(size_t lane, unsigned orientationIndex, int x, int y, int z) const
+{
+	const ShapeOrientation& orientation = m_Pieces[m_ShapeKinds[lane]]->Orientations[orientationIndex];
+
+	if (!IsInPit(orientation, x, y, z))
+	{
+		return false;
+	}
+
+	const size_t shift = GetLayerShift(orientation, x, y);
+	const int top = z + orientation.Minimum[2];
+
+	for (size_t layer = 0; layer <= size_t(orientation.Maximum[2] - orientation.Minimum[2]); ++layer)
+	{
+		if ((orientation.LayerMasks[layer] << shift) & m_StackLevels[GetLevelIndex(lane, top + int(layer))])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool GameLanes::TryToTranslate(size_t lane, int x, int y, int z)
+{
+	const int newX = m_ShapeX[lane] + x;
+	const int newY = m_ShapeY[lane] + y;
+	const int newZ = m_ShapeZ[lane] + z;
+
+	if (!IsMovePosible(lane, m_Orientations[lane], newX, newY, newZ))
+	{
+		return false;
+	}
+
+	SetShape(lane, m_ShapeKinds[lane], m_Orientations[lane], newX, newY, newZ);
+	return true;
+}
+
+bool GameLanes::TryToRotate(size_t lane, ShapeRotation rotation)
+{
+	const unsigned orientation = GetOrientation(lane).Rotations[rotation];
+
+	if (!IsMovePosible(lane, orientation, m_ShapeX[lane], m_ShapeY[lane], m_ShapeZ[lane]))
+	{
+		return false;
+	}
+
+	SetShape(lane, m_ShapeKinds[lane], orientation, m_ShapeX[lane], m_ShapeY[lane], m_ShapeZ[lane]);
+	return true;
+}
+
+bool GameLanes::MoveDown(size_t lane)
+{
+	if (TryToTranslate(lane, 0, 0, 1))
+	{
+		return true;
+	}
+
+	Lock(lane);
+	return false;
+}
+
+void GameLanes::Lock(size_t lane)
+{
+	unsigned clearedLevelsCount = 0;
+
+	if (AddShapeToStack(lane))
+	{
+		// from the bottom, a removed level is replaced by the one above
+		for (int z = int(PIT_Z_SIZE) - 1; z >= 0; )
+		{
+			if (m_StackLevels[GetLevelIndex(lane, z)] != Pit::FULL_LEVEL_MASK)
+			{
+				--z;
+				continue;
+			}
+
+			for (int level = z; level >= 0; --level)
+			{
+				m_StackLevels[GetLevelIndex(lane, level)] = m_StackLevels[GetLevelIndex(lane, level - 1)];
+			}
+
+			++clearedLevelsCount;
+		}
+	}
+
+	FinishLock(lane, clearedLevelsCount);
+}
+
+bool GameLanes::AddShapeToStack(size_t lane)
+{
+	const int top = m_ShapeZ[lane] + m_ShapeMinimumZ[lane];
+	bool isAnyLevelFull = false;
+
+	// cubes above the pit are lost, as in Shape::Destroy
+	for (size_t layer = 0; layer < GetLayersCount(lane); ++layer)
+	{
+		const int z = top + int(layer);
+
+		if (z < 0)
+		{
+			continue;
+		}
+
+		Pit::LevelMask& level = m_StackLevels[GetLevelIndex(lane, z)];
+		level |= m_ShapeLayers[GetLayerIndex(lane, layer)];
+
+		if (level == Pit::FULL_LEVEL_MASK)
+		{
+			isAnyLevelFull = true;
+		}
+	}
+
+	return isAnyLevelFull;
+}
+
+void GameLanes::FinishLock(size_t lane, unsigned clearedLevelsCount)
+{
+	m_PlayedCubesCounts[lane] += GetOrientation(lane).CubesCount;
+	m_Scores[lane] += clearedLevelsCount * (m_Levels[lane] + 1);
+
+	// a box on level 0 ends the game
+	if (m_StackLevels[GetLevelIndex(lane, 0)] != 0)
+	{
+		m_IsRunning[lane] = 0;
+		--m_RunningLanesCount;
+	}
+
+	// the next shape comes even when the game is over, as in Game
+	Spawn(lane);
+}
+
+void GameLanes::Spawn(size_t lane)
+{
+	const unsigned kind = m_NextShapeKinds[lane];
+
+	SetShape(lane, kind, 0, SPAWN_X, SPAWN_Y, 0);
+	m_NextShapeKinds[lane] = uint8_t(DrawShapeKind(lane));
+}
+
+void GameLanes::SetShape(size_t lane, unsigned kind, unsigned orientationIndex, int x, int y, int z)
+{
+	// the layers hold nothing but the shape
+	for (size_t layer = 0; layer < GetLayersCount(lane); ++layer)
+	{
+		m_ShapeLayers[GetLayerIndex(lane, layer)] = 0;
+	}
+
+	m_ShapeKinds[lane] = uint8_t(kind);
+	m_Orientations[lane] = uint8_t(orientationIndex);
+	m_ShapeX[lane] = x;
+	m_ShapeY[lane] = y;
+	m_ShapeZ[lane] = z;
+
+	const ShapeOrientation& orientation = GetOrientation(lane);
+	m_ShapeMinimumZ[lane] = orientation.Minimum[2];
+	m_ShapeMaximumZ[lane] = orientation.Maximum[2];
+
+	assert(orientation.HasLayerMasks);
+	const size_t shift = GetLayerShift(orientation, x, y);
+
+	for (size_t layer = 0; layer < GetLayersCount(lane); ++layer)
+	{
+		m_ShapeLayers[GetLayerIndex(lane, layer)] = orientation.LayerMasks[layer] << shift;
+	}
+}
+
+unsigned GameLanes::DrawShapeKind(size_t lane)
+{
+	// like ShapeFactory::CreateRandomShape with the random numbers of the lane
+	Random random(m_RandomStates[lane]);
+	const unsigned kind = random.Next(unsigned(m_Pieces.size()));
+	m_RandomStates[lane] = random.GetState();
+
+	return kind;
+}
+
+const ShapeOrientation& GameLanes::GetOrientation(size_t lane) const
+{
+	return m_Pieces[m_ShapeKinds[lane]]->Orientations[m_Orientations[lane]];
+}
+
+size_t GameLanes::GetLayersCount(size_t lane) const
+{
+	return size_t(m_ShapeMaximumZ[lane] - m_ShapeMinimumZ[lane] + 1);
+}
+
+size_t GameLanes::GetLevelIndex(size_t lane, int z)
+{
+	return (lane - lane % GROUP_SIZE) * STORED_LEVELS_COUNT + size_t(z + int(LEVELS_ABOVE_PIT)) * GROUP_SIZE + lane % GROUP_SIZE;
+}
+
+size_t GameLanes::GetLayerIndex(size_t lane, size_t layer)
+{
+	return (lane - lane % GROUP_SIZE) * MAX_SHAPE_CUBES + layer * GROUP_SIZE + lane % GROUP_SIZE;
+}
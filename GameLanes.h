@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Game.h"
+#include "Pit.h"
+#include "ShapeOrientation.h"
+
+class ShapeSet;
+
+// Many independent games stepped in lockstep, for training and tuning runs
+// that play thousands of them. Nothing is drawn and nothing is timed: a
+// step applies one key to every game, and a game without a key falls one
+// level, with the rules of Game::MoveDownCurrentShape and
+// Grid::UpdateLevels. The games are kept in structure of arrays form, one
+// mask per pit level, one per layer of the falling piece, its pivot cube,
+// its orientation and the random state of every game, so gravity,
+// translations, collisions and clearing levels run over four games at a
+// time; ended games are masked out. Rotations, locking and spawning look up
+// the orientation tables or the levels of one game at a time.
+class GameLanes
+{
+public:
+	// every kind of the set needs an orientation table whose first
+	// orientation fits in the pit, which is true for the embedded sets
+	GameLanes(const ShapeSet& shapeSet, size_t lanesCount);
+
+	size_t GetLanesCount() const;
+	// the lanes whose game isn't over
+	size_t GetRunningLanesCount() const;
+
+	// like Game::NewGame after Game::SetRandomSeed; there is no clock, so the
+	// level doesn't rise and stays the given one for the whole game
+	void NewGame(size_t lane, uint64_t randomSeed, unsigned level = 0);
+
+	// see Game::GetPosition and Game::SetPosition, with the same checks;
+	// the pivot cube must not be above the pit, which play never leads to
+	void GetPosition(size_t lane, GamePosition& position) const;
+	bool SetPosition(size_t lane, const GamePosition& position);
+
+	// One tick of every running game, pKeys holds a key per lane. The keys
+	// act like Game::OnKeyPressed with the shape at rest; GAME_KEY_NONE
+	// makes the shape fall one level, as the falling time of Game::Update
+	// does, and GAME_KEY_DROP lets it fall until it locks. Keys that don't
+	// move the shape are ignored.
+	void Step(const GameKey* pKeys);
+
+	bool IsOver(size_t lane) const;
+	unsigned GetLevel(size_t lane) const;
+	unsigned GetScore(size_t lane) const;
+	unsigned GetPlayedCubesCount(size_t lane) const;
+
+private:
+	GameLanes(const GameLanes&);
+	GameLanes& operator = (const GameLanes&);
+
+	// lanes are added in groups of the SIMD width
+	static const size_t GROUP_SIZE = 4;
+
+	// Empty levels above the pit, where the cubes of a shape resting on
+	// level 0 can reach, and full ones below it, under the layers of the
+	// tallest shape of a group, so a collision is a test against the stack
+	// wherever the shape is.
+	static const size_t LEVELS_ABOVE_PIT = MAX_SHAPE_CUBES - 1;
+	static const size_t STORED_LEVELS_COUNT = LEVELS_ABOVE_PIT + PIT_Z_SIZE + MAX_SHAPE_CUBES;
+
+	void StepLane(size_t lane, GameKey key);
+	void StepGroup(size_t first, const GameKey* pKeys);
+
+	bool IsMovePosible(size_t lane, unsigned orientation, int x, int y, int z) const;
+	bool TryToTranslate(size_t lane, int x, int y, int z);
+	bool TryToRotate(size_t lane, ShapeRotation rotation);
+
+	// returns false when the shape locked instead
+	bool MoveDown(size_t lane);
+	void Lock(size_t lane);
+	// returns true when a level got full
+	bool AddShapeToStack(size_t lane);
+	// scoring and spawning once the shape is part of the stack and full
+	// levels are removed
+	void FinishLock(size_t lane, unsigned clearedLevelsCount);
+	void Spawn(size_t lane);
+
+	void SetShape(size_t lane, unsigned kind, unsigned orientation, int x, int y, int z);
+	unsigned DrawShapeKind(size_t lane);
+
+	const ShapeOrientation& GetOrientation(size_t lane) const;
+	// layers of the current shape, from its highest level down
+	size_t GetLayersCount(size_t lane) const;
+
+	// [group][z][slot], so a level of the four lanes of a group is one
+	// load and a group is contiguous; z goes from -LEVELS_ABOVE_PIT
+	static size_t GetLevelIndex(size_t lane, int z);
+	static size_t GetLayerIndex(size_t lane, size_t layer);
+
+	std::vector<const ShapeOrientationTable*> m_Pieces;
+
+	size_t m_LanesCount;
+	// lanes rounded up to whole groups
+	size_t m_Capacity;
+
+	// see GetLevelIndex
+	std::vector<Pit::LevelMask> m_StackLevels;
+	// cells of the falling shape, layer i on level z + minimum z + i, the
+	// layers below the shape are empty; see GetLayerIndex
+	std::vector<Pit::LevelMask> m_ShapeLayers;
+
+	// of the pivot cube
+	std::vector<int32_t> m_ShapeX, m_ShapeY, m_ShapeZ;
+	// of the orientation, levels of the highest and the lowest cube from the pivot
+	std::vector<int8_t> m_ShapeMinimumZ, m_ShapeMaximumZ;
+	std::vector<uint8_t> m_Orientations;
+	std::vector<uint8_t> m_ShapeKinds;
+	std::vector<uint8_t> m_NextShapeKinds;
+
+	std::vector<uint64_t> m_RandomStates;
+
+	std::vector<unsigned> m_Levels;
+	std::vector<unsigned> m_Scores;
+	std::vector<unsigned> m_PlayedCubesCounts;
+
+	// all bits set while the game goes on, so four lanes are masked with one load
+	std::vector<uint32_t> m_IsRunning;
+	size_t m_RunningLanesCount;
+};
@@ -1,68 +1,59 @@
 #include "pch.h"
 #include "GameObject.h"
+#include "AllocationTracker.h"
 
 GameObject::GameObject(const Color& color /*= BLACK*/)
-	: m_IsWorldMatrixChanged(false)
-	, m_Scale(1.0f, 1.0f, 1.0f)
-	, m_Position(0.0f, 0.0f, 0.0f)
-	, m_Color(color)
+	: m_Color(color)
+	, m_Transform(TransformSystem::Allocate())
 {
-	D3DXQuaternionIdentity(&m_Rotation);
-	D3DXMatrixIdentity(&m_World);
 }
 
-const Matrix& GameObject::GetWorldMatrix() const
+GameObject::~GameObject()
 {
-	if (m_IsWorldMatrixChanged)
-	{
-		Matrix scale, rotation, translation;
-		
-		D3DXMatrixScaling(&scale, m_Scale.x, m_Scale.y, m_Scale.z);
-		D3DXMatrixRotationQuaternion(&rotation, &m_Rotation);
-		D3DXMatrixTranslation(&translation, m_Position.x, m_Position.y, m_Position.z);
-
-		m_World = scale * rotation * translation;
-
-		m_IsWorldMatrixChanged = false;
-	}
+	TransformSystem::Free(m_Transform);
+}
 
-	return m_World;
+const Matrix& GameObject::GetWorldMatrix() const
+{
+	return TransformSystem::GetWorldMatrix(m_Transform);
 }
 
 void GameObject::SetWorldTransformationToIdentity()
 {
-	m_Position = Vector3(0.0f, 0.0f, 0.0f);
-	m_Scale = Vector3(1.0f, 1.0f, 1.0f);
+	Quaternion identity;
+	QuaternionIdentity(&identity);
 
-	D3DXQuaternionIdentity(&m_Rotation);
-	D3DXMatrixIdentity(&m_World);
+	TransformSystem::SetScale(m_Transform, Vector3(1.0f, 1.0f, 1.0f));
+	TransformSystem::SetRotation(m_Transform, identity);
+	TransformSystem::SetPosition(m_Transform, Vector3(0.0f, 0.0f, 0.0f));
+}
 
-	m_IsWorldMatrixChanged = false;
+Vector3 GameObject::GetScale() const
+{
+	return TransformSystem::GetScale(m_Transform);
 }
 
-const Vector3& GameObject::GetScale() const
+Quaternion GameObject::GetRotation() const
 {
-	return m_Scale;
+	return TransformSystem::GetRotation(m_Transform);
 }
 
-const Quaternion& GameObject::GetRotation() const
+Vector3 GameObject::GetPosition() const
 {
-	return m_Rotation;
+	return TransformSystem::GetPosition(m_Transform);
 }
 
-const Vector3& GameObject::GetPosition() const
+TransformSystem::Handle GameObject::GetTransform() const
 {
-	return m_Position;
+	return m_Transform;
 }
 
 // rendering related
 
-void GameObject::InitializeRenderingParameters( ID3D10Device* pDevice, ID3D10Effect* pEffect )
+void GameObject::InitializeRenderingParameters( Renderer* pRenderer, RenderQueue* pRenderQueue )
 {
-	m_pDevice = pDevice;
-	m_pTechnique = pEffect->GetTechniqueByName("BlockOutTechnique");
-	m_pEffectWorld = pEffect->GetVariableByName("g_World")->AsMatrix();
-	m_pEffectColor = pEffect->GetVariableByName("g_Color")->AsVector();
+	m_pRenderer = pRenderer;
+	m_pRenderQueue = pRenderQueue;
 }
 
 void GameObject::SetColor(const Color& color)
@@ -70,96 +61,155 @@ void GameObject::SetColor(const Color& color)
 	m_Color = color;
 }
 
-void GameObject::SetWorldTransformation() const
+void GameObject::SetWorldTransformation( const Matrix& world )
 {
-	m_pEffectWorld->SetMatrix((float*)&GetWorldMatrix());
+	m_CurrentItem.World = world;
 }
 
-void GameObject::SetWorldTransformation( const Matrix& world )
+void GameObject::CreateVertexBuffer( RenderBuffer*& pVertexBuffer, const Vertex* pVertices, size_t count )
 {
-	m_pEffectWorld->SetMatrix((float*)&world);
+	AllocationScope allocationScope(ALLOCATION_TAG_RENDERER);
+	pVertexBuffer = m_pRenderer->CreateVertexBuffer(pVertices, count * sizeof(Vertex));
 }
 
-void GameObject::CreateVertexBuffer( ID3D10Buffer*& pVertexBuffer, Vertex* pVertices, size_t count )
+void GameObject::CreateVertexBuffer( RenderBuffer*& pVertexBuffer, const ColoredVertex* pVertices, size_t count )
 {
-	CreateBuffer(pVertexBuffer, pVertices, count, D3D10_BIND_VERTEX_BUFFER);
+	AllocationScope allocationScope(ALLOCATION_TAG_RENDERER);
+	pVertexBuffer = m_pRenderer->CreateVertexBuffer(pVertices, count * sizeof(ColoredVertex));
 }
 
-void GameObject::CreateIndexBuffer( ID3D10Buffer*& pIndexBuffer, unsigned* pIndices, size_t count )
+void GameObject::CreateIndexBuffer( RenderBuffer*& pIndexBuffer, const unsigned* pIndices, size_t count )
 {
-	CreateBuffer(pIndexBuffer, pIndices, count, D3D10_BIND_INDEX_BUFFER);
+	AllocationScope allocationScope(ALLOCATION_TAG_RENDERER);
+	pIndexBuffer = m_pRenderer->CreateIndexBuffer(pIndices, count);
 }
 
-void GameObject::SetVertexBuffer( ID3D10Buffer* pVertexBuffer )
+void GameObject::CreateDynamicVertexBuffer( RenderBuffer*& pVertexBuffer, size_t size )
 {
-	unsigned stride = sizeof(Vertex);
-	unsigned offset = 0;
-	m_pDevice->IASetVertexBuffers(0, 1, &pVertexBuffer, &stride, &offset);
+	AllocationScope allocationScope(ALLOCATION_TAG_RENDERER);
+	pVertexBuffer = m_pRenderer->CreateDynamicVertexBuffer(size);
 }
 
-void GameObject::DrawTriangles(ID3D10Buffer* pBuffer, size_t trianglesCount, const Color& color)
+void GameObject::CreateDynamicIndexBuffer( RenderBuffer*& pIndexBuffer, size_t count )
 {
-	DrawIndexed(pBuffer, trianglesCount * 3, D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST, color);
+	AllocationScope allocationScope(ALLOCATION_TAG_RENDERER);
+	pIndexBuffer = m_pRenderer->CreateDynamicIndexBuffer(count);
 }
 
-void GameObject::DrawLines(ID3D10Buffer* pBuffer, size_t linesCount, const Color& color)
+void GameObject::UpdateDynamicBuffer( RenderBuffer* pBuffer, const void* pData, size_t size )
 {
-	DrawIndexed(pBuffer, linesCount * 2, D3D10_PRIMITIVE_TOPOLOGY_LINELIST, color);
+	m_pRenderer->UpdateDynamicBuffer(pBuffer, pData, size);
 }
 
-template <typename T>
-void GameObject::CreateBuffer(  ID3D10Buffer*& pBuffer, T* pData, size_t count, D3D10_BIND_FLAG flag)
+void GameObject::ReleaseBuffer( RenderBuffer*& pBuffer )
 {
-	D3D10_BUFFER_DESC bufferDescription;
-	bufferDescription.Usage = D3D10_USAGE_IMMUTABLE;
-	bufferDescription.ByteWidth = sizeof(T) * count;
-	bufferDescription.BindFlags = flag;
-	bufferDescription.CPUAccessFlags = 0;
-	bufferDescription.MiscFlags = 0;
+	if (pBuffer)
+	{
+		m_pRenderer->ReleaseBuffer(pBuffer);
+		pBuffer = nullptr;
+	}
+}
 
-	D3D10_SUBRESOURCE_DATA initData;
-	initData.pSysMem = pData;
+void GameObject::SetVertexBuffer( RenderBuffer* pVertexBuffer )
+{
+	m_CurrentItem.pVertexBuffer = pVertexBuffer;
+	m_CurrentItem.pInstanceBuffer = nullptr;
+	m_CurrentItem.InstanceSize = 0;
+	m_CurrentItem.InstancesCount = 0;
+}
 
-	HR(m_pDevice->CreateBuffer(&bufferDescription, &initData, &pBuffer));
+void GameObject::SetInstancedVertexBuffers( RenderBuffer* pVertexBuffer, RenderBuffer* pInstanceBuffer, size_t instanceSize )
+{
+	m_CurrentItem.pVertexBuffer = pVertexBuffer;
+	m_CurrentItem.pInstanceBuffer = pInstanceBuffer;
+	m_CurrentItem.InstanceSize = instanceSize;
+}
+
+void GameObject::SetColoredVertexBuffer( RenderBuffer* pVertexBuffer )
+{
+	// the layout follows the pass of the draw
+	SetVertexBuffer(pVertexBuffer);
+}
+
+void GameObject::DrawTriangles(RenderBuffer* pBuffer, size_t trianglesCount, const Color& color, RenderLayer layer /*= RENDER_LAYER_FACES*/)
+{
+	Submit(pBuffer, trianglesCount * 3, TOPOLOGY_TRIANGLE_LIST, RENDER_PASS_SOLID, layer, color);
+}
+
+void GameObject::DrawLines(RenderBuffer* pBuffer, size_t linesCount, const Color& color, RenderLayer layer /*= RENDER_LAYER_OUTLINES*/)
+{
+	Submit(pBuffer, linesCount * 2, TOPOLOGY_LINE_LIST, RENDER_PASS_SOLID, layer, color);
 }
 
-void GameObject::DrawIndexed( ID3D10Buffer* pBuffer, size_t count, D3D10_PRIMITIVE_TOPOLOGY topology, const Color& color )
+void GameObject::DrawTriangleStrip(RenderBuffer* pBuffer, size_t indicesCount, size_t startIndex, int baseVertex, const Color& color)
 {
-	m_pDevice->IASetPrimitiveTopology(topology);
-	m_pDevice->IASetIndexBuffer(pBuffer, DXGI_FORMAT_R32_UINT, 0);
-	m_pEffectColor->SetFloatVector((float*)&color);
-	m_pTechnique->GetPassByIndex(0)->Apply(0);
-	m_pDevice->DrawIndexed(count, 0, 0);
+	m_CurrentItem.StartIndex = startIndex;
+	m_CurrentItem.BaseVertex = baseVertex;
+	Submit(pBuffer, indicesCount, TOPOLOGY_TRIANGLE_STRIP, RENDER_PASS_SOLID, RENDER_LAYER_FACES, color);
+}
+
+void GameObject::DrawTrianglesInstanced(RenderBuffer* pBuffer, size_t trianglesCount, size_t instancesCount)
+{
+	m_CurrentItem.InstancesCount = instancesCount;
+	Submit(pBuffer, trianglesCount * 3, TOPOLOGY_TRIANGLE_LIST, RENDER_PASS_INSTANCED_FACES, RENDER_LAYER_FACES, BLACK);
+}
+
+void GameObject::DrawLinesInstanced(RenderBuffer* pBuffer, size_t linesCount, size_t instancesCount, const Color& color)
+{
+	m_CurrentItem.InstancesCount = instancesCount;
+	Submit(pBuffer, linesCount * 2, TOPOLOGY_LINE_LIST, RENDER_PASS_INSTANCED_OUTLINES, RENDER_LAYER_OUTLINES, color);
+}
+
+void GameObject::DrawTrianglesColored(RenderBuffer* pBuffer, size_t trianglesCount)
+{
+	Submit(pBuffer, trianglesCount * 3, TOPOLOGY_TRIANGLE_LIST, RENDER_PASS_COLORED_FACES, RENDER_LAYER_FACES, BLACK);
+}
+
+void GameObject::DrawLinesColored(RenderBuffer* pBuffer, size_t linesCount, const Color& color)
+{
+	Submit(pBuffer, linesCount * 2, TOPOLOGY_LINE_LIST, RENDER_PASS_COLORED_OUTLINES, RENDER_LAYER_OUTLINES, color);
+}
+
+void GameObject::Submit( RenderBuffer* pIndexBuffer, size_t indicesCount, PrimitiveTopology topology, RenderPass pass, RenderLayer layer, const Color& color )
+{
+	m_CurrentItem.Layer = layer;
+	m_CurrentItem.Pass = pass;
+	m_CurrentItem.pIndexBuffer = pIndexBuffer;
+	m_CurrentItem.Topology = topology;
+	m_CurrentItem.DrawColor = color;
+	m_CurrentItem.IndicesCount = indicesCount;
+
+	m_pRenderQueue->Submit(m_CurrentItem);
+
+	// ranges belong to a single draw
+	m_CurrentItem.StartIndex = 0;
+	m_CurrentItem.BaseVertex = 0;
 }
 
 // static members initialization
 
-ID3D10Device*				GameObject::m_pDevice		= nullptr;
-ID3D10EffectTechnique*		GameObject::m_pTechnique	= nullptr;
-ID3D10EffectMatrixVariable* GameObject::m_pEffectWorld	= nullptr;
-ID3D10EffectVectorVariable* GameObject::m_pEffectColor	= nullptr;
+Renderer*		GameObject::m_pRenderer		= nullptr;
+RenderQueue*	GameObject::m_pRenderQueue	= nullptr;
+DrawItem		GameObject::m_CurrentItem;
 
 // scale modifiers
 
 void GameObject::ScaleX( float x )
 {
 	assert(!IsZero(x));
-	m_Scale.x *= x;
-	m_IsWorldMatrixChanged = true;
+	Scale(x, 1.0f, 1.0f);
 }
 
 void GameObject::ScaleY( float y )
 {
 	assert(!IsZero(y));
-	m_Scale.y *= y;
-	m_IsWorldMatrixChanged = true;
+	Scale(1.0f, y, 1.0f);
 }
 
 void GameObject::ScaleZ( float z )
 {
 	assert(!IsZero(z));
-	m_Scale.z *= z;
-	m_IsWorldMatrixChanged = true;
+	Scale(1.0f, 1.0f, z);
 }
 
 void GameObject::Scale( float x, float y, float z )
@@ -168,24 +218,18 @@ void GameObject::Scale( float x, float y, float z )
 	assert(!IsZero(y));
 	assert(!IsZero(z));
 
-	m_Scale.x *= x;
-	m_Scale.y *= y;
-	m_Scale.z *= z;
+	Vector3 scale = GetScale();
 
-	m_IsWorldMatrixChanged = true;
+	scale.x *= x;
+	scale.y *= y;
+	scale.z *= z;
+
+	TransformSystem::SetScale(m_Transform, scale);
 }
 
 void GameObject::Scale( const Vector3& scale )
 {
-	assert(!IsZero(scale.x));
-	assert(!IsZero(scale.y));
-	assert(!IsZero(scale.z));
-
-	m_Scale.x *= scale.x;
-	m_Scale.y *= scale.y;
-	m_Scale.z *= scale.z;
-
-	m_IsWorldMatrixChanged = true;
+	Scale(scale.x, scale.y, scale.z);
 }
 
 void GameObject::SetScale( float x, float y, float z )
@@ -194,20 +238,12 @@ void GameObject::SetScale( float x, float y, float z )
 	assert(!IsZero(y));
 	assert(!IsZero(z));
 
-	m_Scale = Vector3(x, y, z);
-
-	m_IsWorldMatrixChanged = true;
+	TransformSystem::SetScale(m_Transform, Vector3(x, y, z));
 }
 
 void GameObject::SetScale( const Vector3& scale )
 {
-	assert(!IsZero(scale.x));
-	assert(!IsZero(scale.y));
-	assert(!IsZero(scale.z));
-
-	m_Scale = scale;
-
-	m_IsWorldMatrixChanged = true;
+	SetScale(scale.x, scale.y, scale.z);
 }
 
 // rotation modifiers
@@ -215,121 +251,109 @@ void GameObject::SetScale( const Vector3& scale )
 void GameObject::RotateX( float angle )
 {
 	Quaternion qu;
-	D3DXQuaternionRotationYawPitchRoll(&qu, 0, angle, 0);
-	m_Rotation *= qu;
-	m_IsWorldMatrixChanged = true;
+	QuaternionRotationYawPitchRoll(&qu, 0, angle, 0);
+	Rotate(qu);
 }
 
 void GameObject::RotateY( float angle )
 {
 	Quaternion qu;
-	D3DXQuaternionRotationYawPitchRoll(&qu, angle, 0, 0);
-	m_Rotation *= qu;
-	m_IsWorldMatrixChanged = true;
+	QuaternionRotationYawPitchRoll(&qu, angle, 0, 0);
+	Rotate(qu);
 }
 
 void GameObject::RotateZ( float angle )
 {
 	Quaternion qu;
-	D3DXQuaternionRotationYawPitchRoll(&qu, 0, 0, angle);
-	m_Rotation *= qu;
-	m_IsWorldMatrixChanged = true;
+	QuaternionRotationYawPitchRoll(&qu, 0, 0, angle);
+	Rotate(qu);
 }
 
 void GameObject::Rotate( float x, float y, float z )
 {
 	Quaternion qu;
-	D3DXQuaternionRotationYawPitchRoll(&qu, y, x, z);
-	m_Rotation *= qu;
-	m_IsWorldMatrixChanged = true;
+	QuaternionRotationYawPitchRoll(&qu, y, x, z);
+	Rotate(qu);
 }
 
 void GameObject::Rotate( const Matrix& rotation )
 {
 	Quaternion qu;
-	D3DXQuaternionRotationMatrix(&qu, &rotation);
-	m_Rotation *= qu;
-	m_IsWorldMatrixChanged = true;
+	QuaternionRotationMatrix(&qu, &rotation);
+	Rotate(qu);
 }
 
 void GameObject::Rotate( const Quaternion& rotation )
 {
-	m_Rotation *= rotation;
-	m_IsWorldMatrixChanged = true;
+	TransformSystem::SetRotation(m_Transform, GetRotation() * rotation);
 }
 
 void GameObject::Rotate( const Vector3& axes, float angle )
 {
 	Quaternion qu;
-	D3DXQuaternionRotationAxis(&qu, &axes, angle);
-	m_Rotation *= qu;
-	m_IsWorldMatrixChanged = true;
+	QuaternionRotationAxis(&qu, &axes, angle);
+	Rotate(qu);
 }
 
 void GameObject::SetRotation( float x, float y, float z )
 {
-	D3DXQuaternionRotationYawPitchRoll(&m_Rotation, y, x, z);
-	m_IsWorldMatrixChanged = true;
+	Quaternion qu;
+	QuaternionRotationYawPitchRoll(&qu, y, x, z);
+	SetRotation(qu);
 }
 
 void GameObject::SetRotation( const Quaternion& rotation )
 {
-	m_Rotation = rotation;
-	m_IsWorldMatrixChanged = true;
+	TransformSystem::SetRotation(m_Transform, rotation);
 }
 
 void GameObject::SetRotation( const Vector3& axes, float angle )
 {
-	D3DXQuaternionRotationAxis(&m_Rotation, &axes, angle);
-	m_IsWorldMatrixChanged = true;
+	Quaternion qu;
+	QuaternionRotationAxis(&qu, &axes, angle);
+	SetRotation(qu);
 }
 
 void GameObject::SetRotation( const Matrix& rotation )
 {
-	D3DXQuaternionRotationMatrix(&m_Rotation, &rotation);
-	m_IsWorldMatrixChanged = true;
+	Quaternion qu;
+	QuaternionRotationMatrix(&qu, &rotation);
+	SetRotation(qu);
 }
 
 // translation modifiers
 
 void GameObject::TranslateX( float step )
 {
-	m_Position.x += step;
-	m_IsWorldMatrixChanged = true;
+	Translate(step, 0.0f, 0.0f);
 }
 
 void GameObject::TranslateY( float step )
 {
-	m_Position.y += step;
-	m_IsWorldMatrixChanged = true;
+	Translate(0.0f, step, 0.0f);
 }
 
 void GameObject::TranslateZ( float step )
 {
-	m_Position.z += step;
-	m_IsWorldMatrixChanged = true;
+	Translate(0.0f, 0.0f, step);
 }
 
 void GameObject::Translate( float x, float y, float z )
 {
-	m_Position += Vector3(x, y, z);
-	m_IsWorldMatrixChanged = true;
+	Translate(Vector3(x, y, z));
 }
 
 void GameObject::Translate( const Vector3& translation )
 {
-	m_Position += translation;
-	m_IsWorldMatrixChanged = true;
+	TransformSystem::SetPosition(m_Transform, GetPosition() + translation);
 }
 
 void GameObject::SetPosition( float x, float y, float z )
 {
-	m_Position = Vector3(x, y, z);
-	m_IsWorldMatrixChanged = true;
+	SetPosition(Vector3(x, y, z));
 }
 
 void GameObject::SetPosition( const Vector3& position )
 {
-	m_Position = position;
-	m_IsWorldMatrixChanged = true;
+	TransformSystem::SetPosition(m_Transform, position);
 }
@@ -1,53 +1,79 @@
 #pragma once
 
+#include "TransformSystem.h"
+#include "RenderQueue.h"
+
 class GameObject
 {
 public:
 	GameObject(const Color& color = BLACK);
-	virtual ~GameObject() {}
+	virtual ~GameObject();
 
 	const Matrix& GetWorldMatrix() const;
 
 	void SetWorldTransformationToIdentity();
 	
-	const Vector3&		GetScale()		const; 
-	const Quaternion&	GetRotation()	const;
-	const Vector3&		GetPosition()	const;
+	Vector3		GetScale()		const; 
+	Quaternion	GetRotation()	const;
+	Vector3		GetPosition()	const;
+
+	// slot of the world transformation in the TransformSystem
+	TransformSystem::Handle GetTransform() const;
 
 #pragma region rendering
 
 public:
-	virtual void Draw() const = 0;
+	// objects are drawn from a GameSnapshot, see Game::Draw
 
-	static void InitializeRenderingParameters(ID3D10Device* pDevice, ID3D10Effect* pEffect);
+	// buffers are created by pRenderer, draws are collected in pRenderQueue,
+	// which the game flushes once the whole scene is submitted
+	static void InitializeRenderingParameters(Renderer* pRenderer, RenderQueue* pRenderQueue);
 
 	void SetColor(const Color& color);
 
 protected:
-	void SetWorldTransformation() const;
+	// world matrix and vertex buffers are kept for the following draws
 	static void SetWorldTransformation(const Matrix& world);
 
-	static void CreateVertexBuffer(ID3D10Buffer*& pVertexBuffer, Vertex* pVertices, size_t count);
-	static void CreateIndexBuffer(ID3D10Buffer*& pIndexBuffer, unsigned* pIndices, size_t count);
+	static void CreateVertexBuffer(RenderBuffer*& pVertexBuffer, const Vertex* pVertices, size_t count);
+	static void CreateVertexBuffer(RenderBuffer*& pVertexBuffer, const ColoredVertex* pVertices, size_t count);
+	static void CreateIndexBuffer(RenderBuffer*& pIndexBuffer, const unsigned* pIndices, size_t count);
+
+	// buffers rewritten by the CPU with UpdateDynamicBuffer
+	static void CreateDynamicVertexBuffer(RenderBuffer*& pVertexBuffer, size_t size);
+	static void CreateDynamicIndexBuffer(RenderBuffer*& pIndexBuffer, size_t count);
+	static void UpdateDynamicBuffer(RenderBuffer* pBuffer, const void* pData, size_t size);
+
+	static void ReleaseBuffer(RenderBuffer*& pBuffer);
+
+	static void SetVertexBuffer(RenderBuffer* pVertexBuffer);
+	static void SetInstancedVertexBuffers(RenderBuffer* pVertexBuffer, RenderBuffer* pInstanceBuffer, size_t instanceSize);
+	static void SetColoredVertexBuffer(RenderBuffer* pVertexBuffer);
+
+	static void DrawTriangles(RenderBuffer* pBuffer, size_t trianglesCount, const Color& color, RenderLayer layer = RENDER_LAYER_FACES);
+	static void DrawLines(RenderBuffer* pBuffer, size_t linesCount, const Color& color, RenderLayer layer = RENDER_LAYER_OUTLINES);
+	static void DrawTriangleStrip(RenderBuffer* pBuffer, size_t indicesCount, size_t startIndex, int baseVertex, const Color& color);
 
-	static void SetVertexBuffer(ID3D10Buffer* pVertexBuffer);
+	// faces take the color of their instance, outlines are drawn in one color
+	static void DrawTrianglesInstanced(RenderBuffer* pBuffer, size_t trianglesCount, size_t instancesCount);
+	static void DrawLinesInstanced(RenderBuffer* pBuffer, size_t linesCount, size_t instancesCount, const Color& color);
 
-	static void DrawTriangles(ID3D10Buffer* pBuffer, size_t trianglesCount, const Color& color);
-	static void DrawLines(ID3D10Buffer* pBuffer, size_t linesCount, const Color& color);
+	// faces take the color of their vertices, outlines are drawn in one color
+	static void DrawTrianglesColored(RenderBuffer* pBuffer, size_t trianglesCount);
+	static void DrawLinesColored(RenderBuffer* pBuffer, size_t linesCount, const Color& color);
 
-	static ID3D10Device*				m_pDevice;
-	static ID3D10EffectTechnique*		m_pTechnique;
-	static ID3D10EffectMatrixVariable*	m_pEffectWorld;
-	static ID3D10EffectVectorVariable*	m_pEffectColor;
+	static Renderer*	m_pRenderer;
+	static RenderQueue*	m_pRenderQueue;
 
 	Color m_Color;
 
 private:
 
-	template <typename T>
-	static void CreateBuffer(ID3D10Buffer*& pBuffer, T* pData, size_t count, D3D10_BIND_FLAG flag); 
+	// completes the current item with the draw and submits it
+	static void Submit(RenderBuffer* pIndexBuffer, size_t indicesCount, PrimitiveTopology topology, RenderPass pass, RenderLayer layer, const Color& color);
 
-	static void DrawIndexed(ID3D10Buffer* pBuffer, size_t count, D3D10_PRIMITIVE_TOPOLOGY topology, const Color& color);
+	// world matrix and vertex buffers of the next draws
+	static DrawItem m_CurrentItem;
 
 #pragma endregion
 
@@ -101,11 +127,9 @@ public:
 
 private:
 
-	// world matrix components
-	Vector3		m_Scale;
-	Quaternion	m_Rotation;
-	Vector3		m_Position;
+	GameObject(const GameObject&);
+	GameObject& operator = (const GameObject&);
 
-	mutable Matrix	m_World;
-	mutable bool	m_IsWorldMatrixChanged;
+	// scale, rotation, position and world matrix are kept by the TransformSystem
+	TransformSystem::Handle m_Transform;
 };
@@ -0,0 +1,25 @@
+#include "pch.h"
+#include "GameSnapshot.h"
+
+ShapeSnapshot::ShapeSnapshot()
+	: pGeometry(nullptr)
+	, ShapeColor(WHITE)
+{
+	MatrixIdentity(&World);
+}
+
+GameSnapshot::GameSnapshot()
+	: Tick(0)
+	, StackVersion(0)
+	, StackMode(STACK_MERGED_MESH)
+	, ShapeHeight(0)
+	, Level(0)
+	, PlayedCubesCount(0)
+	, Score(0)
+	, HighScore(0)
+	, IsPaused(false)
+	, IsOver(false)
+{
+	MatrixIdentity(&GridWorld);
+	MatrixIdentity(&LevelPoleWorld);
+}
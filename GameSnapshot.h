@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Pit.h"
+#include "StackFaceMasks.h"
+
+class ShapeGeometry;
+
+enum StackRenderMode
+{
+	STACK_MERGED_MESH,	// one greedy mesh, see StackMeshBuilder
+	STACK_INSTANCED,	// one instance per visible cube
+};
+
+// a falling or previewed shape as it is drawn
+struct ShapeSnapshot
+{
+	ShapeSnapshot();
+
+	// owned by the shape set, which outlives every snapshot
+	const ShapeGeometry* pGeometry;
+	Matrix World;
+	Color ShapeColor;
+};
+
+// Everything the scene and the HUD are drawn from, copied out of the game
+// at the end of a simulation tick. The render thread only reads it, so it
+// never touches the objects the simulation is changing.
+struct GameSnapshot
+{
+	GameSnapshot();
+
+	// simulation ticks run before this snapshot was taken
+	uint64_t Tick;
+
+	Matrix GridWorld;
+	Matrix LevelPoleWorld;
+
+	// settled stack, its geometry is rebuilt when StackVersion changes
+	Pit StackPit;
+	StackFaceMasks FaceMasks;
+	unsigned StackVersion;
+	StackRenderMode StackMode;
+
+	ShapeSnapshot CurrentShape;
+	ShapeSnapshot NextShape;
+
+	// level of the current shape on the level pole
+	size_t ShapeHeight;
+
+	// HUD
+	unsigned Level;
+	unsigned PlayedCubesCount;
+	unsigned Score;
+	unsigned HighScore;
+
+	bool IsPaused;
+	bool IsOver;
+};
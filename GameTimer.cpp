@@ -1,47 +1,46 @@
 #include "pch.h"
 #include "GameTimer.h"
 
-GameTimer::GameTimer()
-	: m_DeltaTime(-1.0f)
+GameTimer::GameTimer(const Clock& clock /*= Clock::GetSteadyClock()*/)
+	: m_Clock(clock)
+	, m_DeltaTime(0)
 	, m_BaseTime(0)
 	, m_PausedTime(0)
-	, m_PreviousTime(0)
 	, m_StopTime(0)
+	, m_PreviousTime(0)
 	, m_IsStopped(false)
 {
-	long long countsPerSecond;
-	QueryPerformanceFrequency(reinterpret_cast<LARGE_INTEGER*>(&countsPerSecond));
-	m_SecondsPerCount = 1.0f / (float)countsPerSecond;
+	Reset();
 }
 
-float GameTimer::GetGameTime() const
+double GameTimer::GetGameTime() const
 {
-	if (m_IsStopped)
-	{
-		return (m_StopTime - m_BaseTime - m_PausedTime) * m_SecondsPerCount;
-	}
-	else
-	{
-		long long currentTime;
-		QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&currentTime));
+	return NanosecondsToSeconds(GetGameTimeNanoseconds());
+}
 
-		return (currentTime - m_BaseTime - m_PausedTime) * m_SecondsPerCount;
-	}
+double GameTimer::GetDeltaTime() const
+{
+	return NanosecondsToSeconds(m_DeltaTime);
 }
 
-float GameTimer::GetDeltaTime() const
+int64_t GameTimer::GetGameTimeNanoseconds() const
+{
+	int64_t currentTime = m_IsStopped ? m_StopTime : m_Clock.GetNanoseconds();
+	return currentTime - m_BaseTime - m_PausedTime;
+}
+
+int64_t GameTimer::GetDeltaTimeNanoseconds() const
 {
 	return m_DeltaTime;
 }
 
 void GameTimer::Reset()
 {
-	long long currentTime;
-	QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&currentTime));
+	int64_t currentTime = m_Clock.GetNanoseconds();
 
 	m_BaseTime		= currentTime;
 	m_PreviousTime	= currentTime;
-	m_DeltaTime		= -1.0;
+	m_DeltaTime		= 0;
 	m_PausedTime	= 0;
 	m_StopTime		= 0;
 	m_IsStopped		= false;
@@ -49,11 +48,10 @@ void GameTimer::Reset()
 
 void GameTimer::Start()
 {
-	long long currentTime;
-	QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&currentTime));
-
 	if (m_IsStopped)
 	{
+		int64_t currentTime = m_Clock.GetNanoseconds();
+
 		m_PausedTime += (currentTime - m_StopTime);
 		m_PreviousTime = currentTime;
 		m_StopTime = 0;
@@ -65,10 +63,7 @@ void GameTimer::Stop()
 {
 	if (!m_IsStopped)
 	{
-		long long currentTime;
-		QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&currentTime));
-
-		m_StopTime	= currentTime;
+		m_StopTime	= m_Clock.GetNanoseconds();
 		m_IsStopped	= true;
 	}
 }
@@ -77,18 +72,13 @@ void GameTimer::Tick()
 {
 	if (m_IsStopped)
 	{
-		m_DeltaTime = 0.0;
+		m_DeltaTime = 0;
 		return;
 	}
 
-	long long currentTime;
-	QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&currentTime));
+	int64_t currentTime = m_Clock.GetNanoseconds();
 
-	m_DeltaTime = (currentTime - m_PreviousTime) * m_SecondsPerCount;
+	// a monotonic clock never goes back, a clock given by a test might
+	m_DeltaTime = currentTime > m_PreviousTime ? currentTime - m_PreviousTime : 0;
 	m_PreviousTime = currentTime;
-
-	if (m_DeltaTime < 0)
-	{
-		m_DeltaTime = 0.0;
-	}
 }
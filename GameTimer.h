@@ -1,12 +1,22 @@
 #pragma once
 
+#include "Clock.h"
+
+// Game and frame time of the application. All times are kept as integer
+// nanoseconds of the clock, so they don't lose precision however long the
+// game runs; the seconds accessors convert on the way out.
 class GameTimer
 {
 public:
-    GameTimer();
+	// the clock must outlive the timer
+	explicit GameTimer(const Clock& clock = Clock::GetSteadyClock());
+
+	// time since Reset without the stopped periods
+	double GetGameTime() const;	// in seconds
+	double GetDeltaTime() const;	// in seconds
 
-	float GetGameTime() const;	// in seconds
-	float GetDeltaTime() const;	// in seconds
+	int64_t GetGameTimeNanoseconds() const;
+	int64_t GetDeltaTimeNanoseconds() const;
 
 	void Reset();	// Call before message loop.
 	void Start();	// Call when unpaused.
@@ -14,13 +24,14 @@ public:
 	void Tick();	// Call every frame.
 
 private:
-	float m_SecondsPerCount;
-	float m_DeltaTime;
+	const Clock& m_Clock;
+
+	int64_t m_DeltaTime;
 
-	long long m_BaseTime;
-	long long m_PausedTime;
-	long long m_StopTime;
-	long long m_PreviousTime;
+	int64_t m_BaseTime;
+	int64_t m_PausedTime;
+	int64_t m_StopTime;
+	int64_t m_PreviousTime;
 
 	bool m_IsStopped;
 };
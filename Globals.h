@@ -1,11 +1,5 @@
 #pragma once
 
-typedef D3DXVECTOR3 Vector3;
-typedef D3DXQUATERNION Quaternion;
-typedef D3DXMATRIX Matrix;
-
-typedef D3DXCOLOR Color;
-
 const float PI =	3.14159265358979323846f;
 const float E =		2.71828182845904523536f;
 
@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "GlyphAtlas.h"
+
+using namespace std;
+
+namespace
+{
+
+// texels left empty around every glyph, so sampling one never reads its neighbour
+const unsigned GLYPH_PADDING = 1;
+
+}
+
+// Glyph
+
+Glyph::Glyph()
+	: Left(0)
+	, Top(0)
+	, Width(0)
+	, Height(0)
+	, OffsetX(0)
+	, OffsetY(0)
+	, Advance(0)
+{
+}
+
+// GlyphAtlas
+
+GlyphAtlas::GlyphAtlas(unsigned width, unsigned height, int lineHeight)
+	: m_Width(width)
+	, m_Height(height)
+	, m_LineHeight(lineHeight)
+	, m_Coverage(width * height, 0)
+	, m_PenX(GLYPH_PADDING)
+	, m_PenY(GLYPH_PADDING)
+	, m_RowHeight(0)
+{
+	assert(width > 0 && height > 0);
+}
+
+bool GlyphAtlas::AddGlyph(char character, unsigned width, unsigned height, int offsetX, int offsetY, int advance, const uint8_t* pCoverage)
+{
+	assert(character >= FIRST_CHARACTER && character <= LAST_CHARACTER);
+
+	Glyph& glyph = m_Glyphs[character - FIRST_CHARACTER];
+	glyph = Glyph();
+	glyph.OffsetX = offsetX;
+	glyph.OffsetY = offsetY;
+	glyph.Advance = advance;
+
+	if (width == 0 || height == 0)
+	{
+		return true;
+	}
+
+	// on to the next row when this one is full
+	if (m_PenX + width + GLYPH_PADDING > m_Width)
+	{
+		m_PenX = GLYPH_PADDING;
+		m_PenY += m_RowHeight + GLYPH_PADDING;
+		m_RowHeight = 0;
+	}
+
+	if (m_PenX + width + GLYPH_PADDING > m_Width || m_PenY + height + GLYPH_PADDING > m_Height)
+	{
+		return false;
+	}
+
+	for (unsigned y = 0; y < height; ++y)
+	{
+		memcpy(&m_Coverage[(m_PenY + y) * m_Width + m_PenX], pCoverage + y * width, width);
+	}
+
+	glyph.Left = m_PenX;
+	glyph.Top = m_PenY;
+	glyph.Width = width;
+	glyph.Height = height;
+
+	m_PenX += width + GLYPH_PADDING;
+	m_RowHeight = max(m_RowHeight, height);
+
+	return true;
+}
+
+void GlyphAtlas::AddBoxGlyphs(unsigned width, unsigned height, int advance)
+{
+	const vector<uint8_t> box(width * height, 255);
+
+	for (char character = FIRST_CHARACTER; character <= LAST_CHARACTER; ++character)
+	{
+		// the space stays blank
+		bool isAdded = character == ' '
+			? AddGlyph(character, 0, 0, 0, 0, advance, nullptr)
+			: AddGlyph(character, width, height, 0, m_LineHeight - int(height), advance, &box.front());
+
+		assert(isAdded);
+		(void)isAdded;
+	}
+}
+
+const Glyph& GlyphAtlas::GetGlyph(char character) const
+{
+	static const Glyph EMPTY_GLYPH;
+
+	if (character < FIRST_CHARACTER || character > LAST_CHARACTER)
+	{
+		return EMPTY_GLYPH;
+	}
+
+	return m_Glyphs[character - FIRST_CHARACTER];
+}
+
+unsigned GlyphAtlas::GetWidth() const
+{
+	return m_Width;
+}
+
+unsigned GlyphAtlas::GetHeight() const
+{
+	return m_Height;
+}
+
+int GlyphAtlas::GetLineHeight() const
+{
+	return m_LineHeight;
+}
+
+const uint8_t* GlyphAtlas::GetCoverage() const
+{
+	return &m_Coverage.front();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// where a character is in the atlas and how it sits on a line, in pixels
+struct Glyph
+{
+	Glyph();
+
+	// rectangle in the atlas, empty for blanks like the space
+	unsigned Left;
+	unsigned Top;
+	unsigned Width;
+	unsigned Height;
+
+	// of the rectangle from the pen, y down from the top of the line
+	int OffsetX;
+	int OffsetY;
+
+	// pen move to the next character
+	int Advance;
+};
+
+// Coverage of the printable ASCII characters of one font packed into a
+// single channel bitmap, so any text is drawn from one texture. The
+// platform rasterizes the glyphs, see BlockOut::BuildGlyphAtlas; they are
+// packed here in rows, left to right.
+class GlyphAtlas
+{
+public:
+	static const char FIRST_CHARACTER = ' ';
+	static const char LAST_CHARACTER = '~';
+	static const size_t GLYPHS_COUNT = LAST_CHARACTER - FIRST_CHARACTER + 1;
+
+	GlyphAtlas(unsigned width, unsigned height, int lineHeight);
+
+	// pCoverage holds width * height bytes, rows from the top; returns false
+	// when the atlas has no room left for the glyph
+	bool AddGlyph(char character, unsigned width, unsigned height, int offsetX, int offsetY, int advance, const uint8_t* pCoverage);
+
+	// a solid box for every character, where no font can be rasterized
+	void AddBoxGlyphs(unsigned width, unsigned height, int advance);
+
+	// characters outside of the range or never added have no size and no advance
+	const Glyph& GetGlyph(char character) const;
+
+	unsigned GetWidth() const;
+	unsigned GetHeight() const;
+	int GetLineHeight() const;
+
+	// one byte per texel, rows from the top
+	const uint8_t* GetCoverage() const;
+
+private:
+	unsigned m_Width;
+	unsigned m_Height;
+	int m_LineHeight;
+
+	std::vector<uint8_t> m_Coverage;
+	Glyph m_Glyphs[GLYPHS_COUNT];
+
+	// where the next glyph goes and the height of the current row
+	unsigned m_PenX;
+	unsigned m_PenY;
+	unsigned m_RowHeight;
+};
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "Grid.h"
 #include "Box.h"
+#include "StackMeshBuilder.h"
+#include "AllocationTracker.h"
 
 using namespace std;
 
@@ -16,143 +18,105 @@ Grid* Grid::GetInstance()
 	return m_pInstance;
 }
 
-void Grid::Draw() const
+void Grid::Draw(const GameSnapshot& snapshot) const
 {	
-	SetWorldTransformation();
+	SetWorldTransformation(snapshot.GridWorld);
 	SetVertexBuffer(m_pVertexBuffer);
-	DrawLines(m_pIndexBuffer, m_IndicesCount / 2, m_Color);
+	DrawLines(m_pIndexBuffer, m_IndicesCount / 2, m_Color, RENDER_LAYER_BACKGROUND);
 }
 
 Grid::~Grid()
 {
-	DeleteBoxes();
-
-	SafeRelease(m_pVertexBuffer);
-	SafeRelease(m_pIndexBuffer);
+	ReleaseBuffer(m_pVertexBuffer);
+	ReleaseBuffer(m_pIndexBuffer);
+	ReleaseBuffer(m_pStackVertexBuffer);
+	ReleaseBuffer(m_pStackTrianglesIndexBuffer);
+	ReleaseBuffer(m_pStackLinesIndexBuffer);
+	ReleaseBuffer(m_pInstanceBuffer);
+
+	m_pInstance = nullptr;
 }
 
-void Grid::DrawBoxes() const
+void Grid::DrawBoxes(const GameSnapshot& snapshot)
 {
-	for (int z = Z_SIZE - 1; z >= 0; --z)
+	if (!m_IsStackBuilt || snapshot.StackVersion != m_BuiltStackVersion || snapshot.StackMode != m_BuiltStackMode)
 	{
-		bool hasBoxInLevel = false;
+		AllocationScope allocationScope(ALLOCATION_TAG_STACK);
 
-		for (size_t y = 0; y < Y_SIZE; ++y)
-		{
-			for (size_t x = 0; x < X_SIZE; ++x)
-			{
-				if (m_Boxes[z][y][x])
-				{
-					bool isTopVisible = true;
-					bool isLeftVisible = true;
-					bool isRightVisible = true;
-					bool isFrontVisible = true;
-					bool isBackVisible = true;
-
-					if (x <= X_SIZE / 2) isLeftVisible = false;
-					if (x >= X_SIZE / 2) isRightVisible = false;
-					if (y <= Y_SIZE / 2) isFrontVisible = false;
-					if (y >= Y_SIZE / 2) isBackVisible = false;
-					
-					if (HasBoxOn(x - 1, y, z)) isLeftVisible = false;
-					if (HasBoxOn(x + 1, y, z)) isRightVisible = false;
-					if (HasBoxOn(x, y - 1, z)) isFrontVisible = false;
-					if (HasBoxOn(x, y + 1, z)) isBackVisible = false;
-					if (HasBoxOn(x, y, z - 1)) isTopVisible = false;
-					
-					if (isTopVisible || isLeftVisible || isRightVisible || isFrontVisible || isBackVisible)
-					{
-						m_Boxes[z][y][x]->Draw();
-					}
-
-					hasBoxInLevel = true;
-				}
-			}
-		}
+		(snapshot.StackMode == STACK_MERGED_MESH)
+			? BuildStackMesh(snapshot.FaceMasks)
+			: BuildStackInstances(snapshot.StackPit, snapshot.FaceMasks);
 
-		if (!hasBoxInLevel)
-		{
-			break;
-		}
+		m_IsStackBuilt = true;
+		m_BuiltStackVersion = snapshot.StackVersion;
+		m_BuiltStackMode = snapshot.StackMode;
 	}
-}
-
-void Grid::DeleteBoxes()
-{
-	for (int z = Z_SIZE - 1; z >= 0; --z)
-	{
-		bool hasBoxInLevel = false;
 
-		for (size_t y = 0; y < Y_SIZE; ++y)
-		{
-			for (size_t x = 0; x < X_SIZE; ++x)
-			{
-				if (m_Boxes[z][y][x])
-				{
-					SafeDelete(m_Boxes[z][y][x]);
-					hasBoxInLevel = true;
-				}
-			}
-		}
+	// cells are offsets from the grid origin
+	SetWorldTransformation(snapshot.GridWorld);
 
-		if (!hasBoxInLevel)
+	if (snapshot.StackMode == STACK_MERGED_MESH)
+	{
+		if (m_StackTrianglesCount > 0)
 		{
-			break;
+			SetColoredVertexBuffer(m_pStackVertexBuffer);
+			DrawTrianglesColored(m_pStackTrianglesIndexBuffer, m_StackTrianglesCount);
+			DrawLinesColored(m_pStackLinesIndexBuffer, m_StackLinesCount, BLACK);
 		}
 	}
+	else
+	{
+		Box::DrawInstances(m_pInstanceBuffer, m_Instances.size());
+	}
+}
 
-	m_HighestLevelWithBox = Z_SIZE;
+void Grid::DeleteBoxes()
+{
+	m_Pit.Clear();
+	m_FaceMasks.Clear();
+	++m_StackVersion;
 }
 
 unsigned Grid::UpdateLevels()
 {
 	unsigned truncatedLevels = 0;
 
-	for (int level = Z_SIZE - 1; level >= int(m_HighestLevelWithBox); --level)
+	for (int level = Z_SIZE - 1; level >= int(m_Pit.GetHighestOccupiedLevel()); --level)
 	{
-		if (IsLevelFull(level))
+		if (m_Pit.IsLevelFull(level))
 		{
-			TruncateLevel(level);
-			level = Z_SIZE;
+			m_Pit.RemoveLevel(level);
+			m_FaceMasks.OnLevelRemoved(m_Pit, level);
+			// the level above moved here
+			++level;
 			++truncatedLevels;
 		}
 	}
 
+	if (truncatedLevels > 0)
+	{
+		++m_StackVersion;
+	}
+
 	return truncatedLevels;
 }
 
 bool Grid::HasBoxOn(size_t x, size_t y, size_t z) const
 {
-	if (x < 0 || x >= X_SIZE || y < 0 || y >= Y_SIZE || z < 0 || z >= Z_SIZE)
-	{
-		return false;
-	}
-
-	return !!m_Boxes[z][y][x];
+	// out of range coordinates wrap to large values and are reported free
+	return m_Pit.IsOccupied(int(x), int(y), int(z));
 }
 
 void Grid::SetBoxOn(size_t x, size_t y, size_t z)
 {
-	assert(x >= 0 && x < X_SIZE);
-	assert(y >= 0 && y < Y_SIZE);
-	assert(z >= 0 && z < Z_SIZE);
-
-	assert(!m_Boxes[z][y][x]);
-
-	if (z < m_HighestLevelWithBox)
-	{
-		m_HighestLevelWithBox = z;
-	}
-
-	Box* pBox = new Box(GetLevelColor(z));
-	Vector3 boxPositionInGrid((float)x, (float)y, (float)z);
-	pBox->SetPosition(GetPosition() + boxPositionInGrid);
-	m_Boxes[z][y][x] = pBox;
+	m_Pit.Occupy(x, y, z);
+	m_FaceMasks.OnCellOccupied(m_Pit, x, y, z);
+	++m_StackVersion;
 }
 
 size_t Grid::GetHighestLevelWithBox() const
 {
-	return m_HighestLevelWithBox;
+	return m_Pit.GetHighestOccupiedLevel();
 }
 
 bool Grid::HasBoxOnHighestLevel() const
@@ -160,6 +124,28 @@ bool Grid::HasBoxOnHighestLevel() const
 	return GetHighestLevelWithBox() == 0;
 }
 
+void Grid::SetPit(const Pit& pit)
+{
+	m_Pit = pit;
+	m_FaceMasks.Rebuild(m_Pit);
+	++m_StackVersion;
+}
+
+const Pit& Grid::GetPit() const
+{
+	return m_Pit;
+}
+
+const StackFaceMasks& Grid::GetFaceMasks() const
+{
+	return m_FaceMasks;
+}
+
+unsigned Grid::GetStackVersion() const
+{
+	return m_StackVersion;
+}
+
 const Color& Grid::GetLevelColor(unsigned level)
 {
 	return LEVELS_COLORS[level % LEVELS_COLORS_COUNT];
@@ -170,9 +156,27 @@ Grid::Grid(const Color& color)
 	, m_pVertexBuffer(nullptr)
 	, m_pIndexBuffer(nullptr)
 	, m_IndicesCount(0)
-	, m_HighestLevelWithBox(Z_SIZE)
+	, m_StackVersion(0)
+	, m_IsStackBuilt(false)
+	, m_BuiltStackVersion(0)
+	, m_BuiltStackMode(STACK_MERGED_MESH)
+	, m_pStackVertexBuffer(nullptr)
+	, m_pStackTrianglesIndexBuffer(nullptr)
+	, m_pStackLinesIndexBuffer(nullptr)
+	, m_StackTrianglesCount(0)
+	, m_StackLinesCount(0)
+	, m_pInstanceBuffer(nullptr)
 {
-	::ZeroMemory(m_Boxes, X_SIZE * Y_SIZE * Z_SIZE * sizeof(Box*));
+	m_Instances.reserve(X_SIZE * Y_SIZE * Z_SIZE);
+	CreateDynamicVertexBuffer(m_pInstanceBuffer, X_SIZE * Y_SIZE * Z_SIZE * sizeof(StackInstance));
+
+	// room for any stack, so rebuilding the mesh never allocates
+	m_StackVertices.reserve(StackMeshBuilder::GetMaxVerticesCount());
+	m_StackTriangleIndices.reserve(StackMeshBuilder::GetMaxTriangleIndicesCount());
+	m_StackLineIndices.reserve(StackMeshBuilder::GetMaxLineIndicesCount());
+	CreateDynamicVertexBuffer(m_pStackVertexBuffer, m_StackVertices.capacity() * sizeof(ColoredVertex));
+	CreateDynamicIndexBuffer(m_pStackTrianglesIndexBuffer, m_StackTriangleIndices.capacity());
+	CreateDynamicIndexBuffer(m_pStackLinesIndexBuffer, m_StackLineIndices.capacity());
 
 	// GENERATE VERTEX AND INDEX DATA
 
@@ -272,55 +276,30 @@ Grid::Grid(const Color& color)
 	CreateIndexBuffer(m_pIndexBuffer, &indices.front(), m_IndicesCount);
 }
 
-void Grid::TruncateLevel(int level)
+void Grid::BuildStackMesh(const StackFaceMasks& faceMasks)
 {
-	// delete level
-	for (size_t y = 0; y < Y_SIZE; ++y)
-	{
-		for (size_t x = 0; x < X_SIZE; ++x)
-		{
-			if (HasBoxOn(x, y, level))
-			{
-				SafeDelete(m_Boxes[level][y][x]);
-			}
-		}
-	}
+	StackMeshBuilder::Build(faceMasks, LEVELS_COLORS, LEVELS_COLORS_COUNT, m_StackVertices, m_StackTriangleIndices, m_StackLineIndices);
+
+	m_StackTrianglesCount = m_StackTriangleIndices.size() / 3;
+	m_StackLinesCount = m_StackLineIndices.size() / 2;
 
-	// move down upper levels
-	for (size_t z = level - 1; z >= m_HighestLevelWithBox; --z)
+	// rewritten in place, the buffers fit any stack
+	if (m_StackTrianglesCount > 0)
 	{
-		for (size_t y = 0; y < Y_SIZE; ++y)
-		{
-			for (size_t x = 0; x < X_SIZE; ++x)
-			{
-				if (HasBoxOn(x, y, z))
-				{
-					m_Boxes[z][y][x]->Translate(0, 0, 1);
-					m_Boxes[z][y][x]->SetColor(GetLevelColor(z + 1));
-					m_Boxes[z + 1][y][x] = m_Boxes[z][y][x];
-					m_Boxes[z][y][x] = nullptr;
-				}
-			}
-		}
+		UpdateDynamicBuffer(m_pStackVertexBuffer, &m_StackVertices.front(), m_StackVertices.size() * sizeof(ColoredVertex));
+		UpdateDynamicBuffer(m_pStackTrianglesIndexBuffer, &m_StackTriangleIndices.front(), m_StackTriangleIndices.size() * sizeof(unsigned));
+		UpdateDynamicBuffer(m_pStackLinesIndexBuffer, &m_StackLineIndices.front(), m_StackLineIndices.size() * sizeof(unsigned));
 	}
-
-	++m_HighestLevelWithBox;
 }
 
-bool Grid::IsLevelFull(int level) const
+void Grid::BuildStackInstances(const Pit& pit, const StackFaceMasks& faceMasks)
 {
-	for (size_t y = 0; y < Y_SIZE; ++y)
+	StackInstanceBuilder::Build(pit, faceMasks, LEVELS_COLORS, LEVELS_COLORS_COUNT, m_Instances);
+
+	if (!m_Instances.empty())
 	{
-		for (size_t x = 0; x < X_SIZE; ++x)
-		{
-			if (!HasBoxOn(x, y, level))
-			{
-				return false;
-			}
-		}
+		UpdateDynamicBuffer(m_pInstanceBuffer, &m_Instances.front(), m_Instances.size() * sizeof(StackInstance));
 	}
-
-	return true;
 }
 
 Grid* Grid::m_pInstance = nullptr;
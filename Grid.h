@@ -1,8 +1,8 @@
 #pragma once
 
 #include "GameObject.h"
-
-class Box;
+#include "GameSnapshot.h"
+#include "StackInstances.h"
 
 class Grid : public GameObject
 {
@@ -10,10 +10,16 @@ public:
 	static Grid* Create(const Color& color = GREEN);
 	static Grid* GetInstance();
 
-	virtual void Draw() const;
 	virtual ~Grid();
 
-	void DrawBoxes() const;
+	// Drawing reads the snapshot alone, the stack geometry is rendering
+	// state and the rest is simulation state.
+
+	void Draw(const GameSnapshot& snapshot) const;
+	// rebuilds the stack geometry when the stack or its render mode changed
+	// since the last draw
+	void DrawBoxes(const GameSnapshot& snapshot);
+
 	void DeleteBoxes();
 
 	// returns trucated levels count
@@ -25,28 +31,58 @@ public:
 	size_t GetHighestLevelWithBox() const;
 	bool HasBoxOnHighestLevel() const;
 
-	static const size_t X_SIZE = 5;
-	static const size_t Y_SIZE = 5;
-	static const size_t Z_SIZE = 12;
+	// replaces the whole stack, e.g. with a saved or a benchmark state
+	void SetPit(const Pit& pit);
+	const Pit& GetPit() const;
+	const StackFaceMasks& GetFaceMasks() const;
+
+	// changes with every change of the stack
+	unsigned GetStackVersion() const;
+
+	static const size_t X_SIZE = PIT_X_SIZE;
+	static const size_t Y_SIZE = PIT_Y_SIZE;
+	static const size_t Z_SIZE = PIT_Z_SIZE;
 
 	static const Color& GetLevelColor(unsigned level);
 
 private:
 	Grid(const Color& color);
 
-	void TruncateLevel(int level);
-	bool IsLevelFull(int level) const;
-
-	size_t m_HighestLevelWithBox;
-
 	static Grid* m_pInstance;
 
-	ID3D10Buffer* m_pVertexBuffer;
-	ID3D10Buffer* m_pIndexBuffer;
+	RenderBuffer* m_pVertexBuffer;
+	RenderBuffer* m_pIndexBuffer;
 
 	size_t m_IndicesCount;
 
-	Box* m_Boxes[Z_SIZE][Y_SIZE][X_SIZE];
+	void BuildStackMesh(const StackFaceMasks& faceMasks);
+	void BuildStackInstances(const Pit& pit, const StackFaceMasks& faceMasks);
+
+	Pit m_Pit;
+	// follows m_Pit cell by cell, so the stack is never scanned for neighbours
+	StackFaceMasks m_FaceMasks;
+	unsigned m_StackVersion;
+
+	// stack geometry is rebuilt on the first draw after a change
+	bool m_IsStackBuilt;
+	unsigned m_BuiltStackVersion;
+	StackRenderMode m_BuiltStackMode;
+
+	// merged mesh
+	RenderBuffer* m_pStackVertexBuffer;
+	RenderBuffer* m_pStackTrianglesIndexBuffer;
+	RenderBuffer* m_pStackLinesIndexBuffer;
+
+	size_t m_StackTrianglesCount;
+	size_t m_StackLinesCount;
+
+	std::vector<ColoredVertex> m_StackVertices;
+	std::vector<unsigned> m_StackTriangleIndices;
+	std::vector<unsigned> m_StackLineIndices;
+
+	// instanced cubes
+	RenderBuffer* m_pInstanceBuffer;
+	std::vector<StackInstance> m_Instances;
 
 	static const size_t LEVELS_COLORS_COUNT = 6;
 	static const Color LEVELS_COLORS[LEVELS_COLORS_COUNT];
@@ -0,0 +1,309 @@
+#include "pch.h"
+#include "HudLayer.h"
+#include "GameSnapshot.h"
+
+using namespace std;
+
+namespace
+{
+
+enum HudLine
+{
+	HUD_LINE_LEVEL,
+	HUD_LINE_NEXT,
+	HUD_LINE_NEXT_SHAPE,
+	HUD_LINE_CUBES,
+	HUD_LINE_CUBES_PLAYED,
+	HUD_LINE_PLAYED_CUBES,
+	HUD_LINE_SCORE,
+	HUD_LINE_SCORE_VALUE,
+	HUD_LINE_HIGH,
+	HUD_LINE_HIGH_SCORE,
+	HUD_LINE_HIGH_SCORE_VALUE,
+	HUD_LINE_PAUSE,
+	HUD_LINE_GAME_OVER,
+	HUD_LINE_NEW_GAME,
+
+	HUD_LINES_COUNT
+};
+
+// left edge of the game info panel, in pixels
+const int INFO_X = 705;
+
+struct Label
+{
+	HudLine Line;
+	int Y;
+	const char* Text;
+};
+
+// lines of the panel that never change
+const Label LABELS[] =
+{
+	{ HUD_LINE_NEXT, 80, "NEXT" },
+	{ HUD_LINE_NEXT_SHAPE, 100, "SHAPE:" },
+	{ HUD_LINE_CUBES, 250, "CUBES" },
+	{ HUD_LINE_CUBES_PLAYED, 270, "PLAYED:" },
+	{ HUD_LINE_SCORE, 350, "SCORE:" },
+	{ HUD_LINE_HIGH, 430, "HIGH" },
+	{ HUD_LINE_HIGH_SCORE, 450, "SCORE:" },
+};
+
+const size_t VERTICES_PER_GLYPH = 4;
+const size_t INDICES_PER_GLYPH = 6;
+
+}
+
+// TextLine
+
+HudLayer::TextLine::TextLine()
+	: X(0)
+	, Y(0)
+	, TextColor(WHITE)
+	, IsVisible(false)
+	, GlyphsCount(0)
+{
+	Text[0] = '\0';
+}
+
+// HudLayer
+
+HudLayer::HudLayer(Renderer& renderer, const GlyphAtlas& atlas)
+	: m_Renderer(renderer)
+	, m_AtlasWidth(float(atlas.GetWidth()))
+	, m_AtlasHeight(float(atlas.GetHeight()))
+	, m_pAtlasTexture(nullptr)
+	, m_pVertexBuffer(nullptr)
+	, m_pIndexBuffer(nullptr)
+	, m_Lines(HUD_LINES_COUNT)
+	, m_IsChanged(false)
+	, m_IsGameInfoFormatted(false)
+	, m_Level(0)
+	, m_PlayedCubesCount(0)
+	, m_Score(0)
+	, m_HighScore(0)
+	, m_ScreenWidth(0)
+	, m_ScreenHeight(0)
+	, m_UploadsCount(0)
+{
+	for (size_t i = 0; i < GlyphAtlas::GLYPHS_COUNT; ++i)
+	{
+		m_Glyphs[i] = atlas.GetGlyph(char(GlyphAtlas::FIRST_CHARACTER + i));
+	}
+
+	MatrixIdentity(&m_PixelsToClip);
+
+	m_pAtlasTexture = m_Renderer.CreateTexture(atlas.GetWidth(), atlas.GetHeight(), atlas.GetCoverage());
+
+	// every line full at once, the quads share one index pattern
+	const size_t maxGlyphsCount = HUD_LINES_COUNT * (LINE_SIZE - 1);
+
+	vector<unsigned> indices;
+	indices.reserve(maxGlyphsCount * INDICES_PER_GLYPH);
+
+	for (unsigned glyph = 0; glyph < maxGlyphsCount; ++glyph)
+	{
+		// clockwise on the screen, the front
+		const unsigned first = glyph * VERTICES_PER_GLYPH;
+		const unsigned quad[INDICES_PER_GLYPH] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+		indices.insert(indices.end(), quad, quad + INDICES_PER_GLYPH);
+	}
+
+	m_pIndexBuffer = m_Renderer.CreateIndexBuffer(&indices.front(), indices.size());
+	m_pVertexBuffer = m_Renderer.CreateDynamicVertexBuffer(maxGlyphsCount * VERTICES_PER_GLYPH * sizeof(TextVertex));
+	m_Vertices.reserve(maxGlyphsCount * VERTICES_PER_GLYPH);
+
+	for (size_t i = 0; i < sizeof(LABELS) / sizeof(LABELS[0]); ++i)
+	{
+		SetLine(LABELS[i].Line, INFO_X, LABELS[i].Y, LABELS[i].Text);
+	}
+}
+
+HudLayer::~HudLayer()
+{
+	m_Renderer.ReleaseTexture(m_pAtlasTexture);
+	m_Renderer.ReleaseBuffer(m_pVertexBuffer);
+	m_Renderer.ReleaseBuffer(m_pIndexBuffer);
+}
+
+void HudLayer::Update(const GameSnapshot& snapshot, unsigned screenWidth, unsigned screenHeight)
+{
+	// the values change only when a shape is placed or a game starts
+	if (!m_IsGameInfoFormatted
+		|| snapshot.Level != m_Level
+		|| snapshot.PlayedCubesCount != m_PlayedCubesCount
+		|| snapshot.Score != m_Score
+		|| snapshot.HighScore != m_HighScore)
+	{
+		m_GameInfoText.Format(snapshot);
+
+		m_IsGameInfoFormatted = true;
+		m_Level = snapshot.Level;
+		m_PlayedCubesCount = snapshot.PlayedCubesCount;
+		m_Score = snapshot.Score;
+		m_HighScore = snapshot.HighScore;
+
+		// lines with the same text as before keep their quads
+		SetLine(HUD_LINE_LEVEL, INFO_X, 20, m_GameInfoText.GetLevel());
+		SetLine(HUD_LINE_PLAYED_CUBES, INFO_X, 300, m_GameInfoText.GetPlayedCubes());
+		SetLine(HUD_LINE_SCORE_VALUE, INFO_X, 380, m_GameInfoText.GetScore());
+		SetLine(HUD_LINE_HIGH_SCORE_VALUE, INFO_X, 480, m_GameInfoText.GetHighScore());
+	}
+
+	// messages are centered on the screen
+	const int centerX = int(screenWidth / 2);
+	const int centerY = int(screenHeight / 2);
+
+	if (snapshot.IsPaused)
+	{
+		SetLine(HUD_LINE_PAUSE, centerX - 30, centerY - 10, "PAUSE", RED);
+	}
+	else
+	{
+		HideLine(HUD_LINE_PAUSE);
+	}
+
+	if (snapshot.IsOver && !snapshot.IsPaused)
+	{
+		SetLine(HUD_LINE_GAME_OVER, centerX - 60, centerY - 20, "GAME OVER");
+		SetLine(HUD_LINE_NEW_GAME, centerX - 130, centerY, "Press ENTER to start new game");
+	}
+	else
+	{
+		HideLine(HUD_LINE_GAME_OVER);
+		HideLine(HUD_LINE_NEW_GAME);
+	}
+
+	// y goes down in pixels and up in clip space
+	if ((screenWidth != m_ScreenWidth || screenHeight != m_ScreenHeight) && screenWidth > 0 && screenHeight > 0)
+	{
+		m_ScreenWidth = screenWidth;
+		m_ScreenHeight = screenHeight;
+
+		MatrixIdentity(&m_PixelsToClip);
+		m_PixelsToClip._11 = 2.0f / screenWidth;
+		m_PixelsToClip._22 = -2.0f / screenHeight;
+		m_PixelsToClip._41 = -1.0f;
+		m_PixelsToClip._42 = 1.0f;
+	}
+
+	if (!m_IsChanged)
+	{
+		return;
+	}
+
+	m_Vertices.clear();
+
+	for (size_t i = 0; i < m_Lines.size(); ++i)
+	{
+		const TextLine& line = m_Lines[i];
+
+		if (line.IsVisible)
+		{
+			m_Vertices.insert(m_Vertices.end(), line.Vertices, line.Vertices + line.GlyphsCount * VERTICES_PER_GLYPH);
+		}
+	}
+
+	if (!m_Vertices.empty())
+	{
+		m_Renderer.UpdateDynamicBuffer(m_pVertexBuffer, &m_Vertices.front(), m_Vertices.size() * sizeof(TextVertex));
+		++m_UploadsCount;
+	}
+
+	m_IsChanged = false;
+}
+
+void HudLayer::Draw()
+{
+	if (m_Vertices.empty())
+	{
+		return;
+	}
+
+	DrawItem item;
+	item.Layer = RENDER_LAYER_TRANSPARENT;
+	item.Pass = RENDER_PASS_TEXT;
+	item.pVertexBuffer = m_pVertexBuffer;
+	item.pIndexBuffer = m_pIndexBuffer;
+	item.pTexture = m_pAtlasTexture;
+	item.Topology = TOPOLOGY_TRIANGLE_LIST;
+	item.DrawColor = WHITE;
+	item.World = m_PixelsToClip;
+	item.IndicesCount = m_Vertices.size() / VERTICES_PER_GLYPH * INDICES_PER_GLYPH;
+
+	m_RenderQueue.Submit(item);
+	m_RenderQueue.Flush(m_Renderer);
+}
+
+size_t HudLayer::GetUploadsCount() const
+{
+	return m_UploadsCount;
+}
+
+void HudLayer::SetLine(size_t line, int x, int y, const char* text, const Color& color)
+{
+	assert(line < m_Lines.size() && strlen(text) < LINE_SIZE);
+
+	TextLine& textLine = m_Lines[line];
+
+	if (textLine.IsVisible && textLine.X == x && textLine.Y == y && textLine.TextColor == color && strcmp(textLine.Text, text) == 0)
+	{
+		return;
+	}
+
+	strcpy(textLine.Text, text);
+	textLine.X = x;
+	textLine.Y = y;
+	textLine.TextColor = color;
+	textLine.IsVisible = true;
+
+	LayoutLine(textLine);
+	m_IsChanged = true;
+}
+
+void HudLayer::HideLine(size_t line)
+{
+	assert(line < m_Lines.size());
+
+	if (m_Lines[line].IsVisible)
+	{
+		m_Lines[line].IsVisible = false;
+		m_IsChanged = true;
+	}
+}
+
+void HudLayer::LayoutLine(TextLine& line) const
+{
+	line.GlyphsCount = 0;
+
+	int penX = line.X;
+
+	for (const char* pCharacter = line.Text; *pCharacter; ++pCharacter)
+	{
+		assert(*pCharacter >= GlyphAtlas::FIRST_CHARACTER && *pCharacter <= GlyphAtlas::LAST_CHARACTER);
+		const Glyph& glyph = m_Glyphs[*pCharacter - GlyphAtlas::FIRST_CHARACTER];
+
+		if (glyph.Width > 0)
+		{
+			const float left = float(penX + glyph.OffsetX);
+			const float top = float(line.Y + glyph.OffsetY);
+			const float right = left + glyph.Width;
+			const float bottom = top + glyph.Height;
+
+			const float u0 = glyph.Left / m_AtlasWidth;
+			const float v0 = glyph.Top / m_AtlasHeight;
+			const float u1 = (glyph.Left + glyph.Width) / m_AtlasWidth;
+			const float v1 = (glyph.Top + glyph.Height) / m_AtlasHeight;
+
+			TextVertex* pQuad = &line.Vertices[line.GlyphsCount * VERTICES_PER_GLYPH];
+			pQuad[0] = TextVertex(left, top, u0, v0, line.TextColor);
+			pQuad[1] = TextVertex(right, top, u1, v0, line.TextColor);
+			pQuad[2] = TextVertex(right, bottom, u1, v1, line.TextColor);
+			pQuad[3] = TextVertex(left, bottom, u0, v1, line.TextColor);
+
+			++line.GlyphsCount;
+		}
+
+		penX += glyph.Advance;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "GlyphAtlas.h"
+#include "GameInfoText.h"
+#include "RenderQueue.h"
+
+struct GameSnapshot;
+
+// The game info panel and the pause and game over messages, drawn over the
+// scene as glyph quads of one atlas in a single draw. Every line keeps its
+// text and its quads; a line is laid out again only when its text or place
+// changes, and the vertices are uploaded only then, so a frame that shows
+// the same values as the previous one costs one draw.
+class HudLayer
+{
+public:
+	// the atlas is uploaded here and isn't needed afterwards
+	HudLayer(Renderer& renderer, const GlyphAtlas& atlas);
+	~HudLayer();
+
+	void Update(const GameSnapshot& snapshot, unsigned screenWidth, unsigned screenHeight);
+
+	// over whatever is drawn already
+	void Draw();
+
+	// uploads of the vertices since the layer was built
+	size_t GetUploadsCount() const;
+
+private:
+	HudLayer(const HudLayer&);
+	HudLayer& operator = (const HudLayer&);
+
+	// room for GameInfoText lines and the messages
+	static const size_t LINE_SIZE = 32;
+
+	struct TextLine
+	{
+		TextLine();
+
+		char Text[LINE_SIZE];
+		int X;
+		int Y;
+		Color TextColor;
+		bool IsVisible;
+
+		// two triangles per glyph with some coverage
+		TextVertex Vertices[(LINE_SIZE - 1) * 4];
+		size_t GlyphsCount;
+	};
+
+	void SetLine(size_t line, int x, int y, const char* text, const Color& color = WHITE);
+	void HideLine(size_t line);
+
+	void LayoutLine(TextLine& line) const;
+
+	Renderer& m_Renderer;
+	RenderQueue m_RenderQueue;
+
+	Glyph m_Glyphs[GlyphAtlas::GLYPHS_COUNT];
+	float m_AtlasWidth;
+	float m_AtlasHeight;
+
+	RenderTexture* m_pAtlasTexture;
+	RenderBuffer* m_pVertexBuffer;
+	RenderBuffer* m_pIndexBuffer;
+
+	std::vector<TextLine> m_Lines;
+	bool m_IsChanged;
+
+	// values the game info text was last formatted from
+	GameInfoText m_GameInfoText;
+	bool m_IsGameInfoFormatted;
+	unsigned m_Level;
+	unsigned m_PlayedCubesCount;
+	unsigned m_Score;
+	unsigned m_HighScore;
+
+	// pixels to clip space, for the current screen size
+	unsigned m_ScreenWidth;
+	unsigned m_ScreenHeight;
+	Matrix m_PixelsToClip;
+
+	// quads of the visible lines, as uploaded
+	std::vector<TextVertex> m_Vertices;
+	size_t m_UploadsCount;
+};
@@ -16,23 +16,20 @@ LevelPole* LevelPole::GetInstance()
 	return m_pInstance;
 }
 
-void LevelPole::Draw() const
+void LevelPole::Draw(const GameSnapshot& snapshot) const
 {
-	SetWorldTransformation();
+	SetWorldTransformation(snapshot.LevelPoleWorld);
 	SetVertexBuffer(m_pVertexBuffer);
-	DrawLevels();
+	DrawLevels(snapshot);
 	DrawLines(m_pIndexBuffer, m_IndicesCount / 2, m_Color);
 }
 
-void LevelPole::Update(size_t shapeHeight)
-{
-	m_ShapeCurrentHeight = shapeHeight;
-}
-
 LevelPole::~LevelPole()
 {
-	SafeRelease(m_pVertexBuffer);
-	SafeRelease(m_pIndexBuffer);
+	ReleaseBuffer(m_pVertexBuffer);
+	ReleaseBuffer(m_pIndexBuffer);
+
+	m_pInstance = nullptr;
 }
 
 LevelPole::LevelPole(const Color& color)
@@ -66,29 +63,23 @@ LevelPole::LevelPole(const Color& color)
 	CreateIndexBuffer(m_pIndexBuffer, &indices.front(), m_IndicesCount);
 }
 
-void LevelPole::DrawLevels() const
+void LevelPole::DrawLevels(const GameSnapshot& snapshot) const
 {
-	Grid* pGrid = Grid::GetInstance();
-	m_pDevice->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-	m_pDevice->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	const size_t highestLevelWithBox = snapshot.StackPit.GetHighestOccupiedLevel();
 
 	for (size_t i = 0; i < HEIGHT; ++i)
 	{
-		if (i >= HEIGHT - pGrid->GetHighestLevelWithBox())
+		if (i >= HEIGHT - highestLevelWithBox)
 		{
 			break;
 		}
 
-		m_pEffectColor->SetFloatVector((float*)&Grid::GetLevelColor(HEIGHT - i - 1));
-		m_pTechnique->GetPassByIndex(0)->Apply(0);
-		m_pDevice->DrawIndexed(4, i, i);
+		DrawTriangleStrip(m_pIndexBuffer, 4, i, i, Grid::GetLevelColor(HEIGHT - i - 1));
 	}
 
-	if (!pGrid->HasBoxOnHighestLevel())
+	if (highestLevelWithBox != 0)
 	{
-		m_pEffectColor->SetFloatVector((float*)&WHITE);
-		m_pTechnique->GetPassByIndex(0)->Apply(0);
-		m_pDevice->DrawIndexed(4, HEIGHT - m_ShapeCurrentHeight - 1, HEIGHT - m_ShapeCurrentHeight - 1);
+		DrawTriangleStrip(m_pIndexBuffer, 4, HEIGHT - snapshot.ShapeHeight - 1, HEIGHT - snapshot.ShapeHeight - 1, WHITE);
 	}
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GameObject.h"
+#include "GameSnapshot.h"
 
 class LevelPole : public GameObject
 {
@@ -8,24 +9,21 @@ public:
 	static LevelPole* Create(const Color& color = GREEN);
 	static LevelPole* GetInstance();
 
-	virtual void Draw() const;
-
-	void Update(size_t shapeHeight);
+	// levels of the stack and of the current shape in the snapshot
+	void Draw(const GameSnapshot& snapshot) const;
 
 	virtual ~LevelPole();
 
 private:
 	LevelPole(const Color& color);
 
-	void DrawLevels() const;
-
-	size_t m_ShapeCurrentHeight;
+	void DrawLevels(const GameSnapshot& snapshot) const;
 
 	static LevelPole* m_pInstance;
 	static const size_t HEIGHT = 12;
 
-	ID3D10Buffer* m_pVertexBuffer;
-	ID3D10Buffer* m_pIndexBuffer;
+	RenderBuffer* m_pVertexBuffer;
+	RenderBuffer* m_pIndexBuffer;
 
 	size_t m_IndicesCount;
 };
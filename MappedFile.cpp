@@ -0,0 +1,161 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile()
+	: m_pData(nullptr)
+	, m_Size(0)
+#ifdef _WIN32
+	, m_hFile(INVALID_HANDLE_VALUE)
+	, m_hMapping(nullptr)
+#else
+	, m_FileDescriptor(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& fileName)
+{
+	Close();
+
+	m_hFile = ::CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+
+	if (!::GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart == 0)
+	{
+		// an empty file cannot be mapped
+		Close();
+		return false;
+	}
+
+	m_hMapping = ::CreateFileMapping(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (!m_hMapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = static_cast<const char*>(::MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (!m_pData)
+	{
+		Close();
+		return false;
+	}
+
+	m_Size = size_t(fileSize.QuadPart);
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData)
+	{
+		::UnmapViewOfFile(m_pData);
+		m_pData = nullptr;
+	}
+
+	if (m_hMapping)
+	{
+		::CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+	}
+
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		::CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+
+	m_Size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& fileName)
+{
+	Close();
+
+	m_FileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+
+	if (m_FileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStatus;
+
+	if (::fstat(m_FileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* pData = ::mmap(nullptr, size_t(fileStatus.st_size), PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+
+	if (pData == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = static_cast<const char*>(pData);
+	m_Size = size_t(fileStatus.st_size);
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData)
+	{
+		::munmap(const_cast<char*>(m_pData), m_Size);
+		m_pData = nullptr;
+	}
+
+	if (m_FileDescriptor >= 0)
+	{
+		::close(m_FileDescriptor);
+		m_FileDescriptor = -1;
+	}
+
+	m_Size = 0;
+}
+
+#endif
+
+bool MappedFile::IsOpen() const
+{
+	return m_pData != nullptr;
+}
+
+const char* MappedFile::GetData() const
+{
+	return m_pData;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_Size;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	// returns false when the file does not exist or cannot be mapped
+	bool Open(const std::string& fileName);
+	void Close();
+
+	bool IsOpen() const;
+
+	const char* GetData() const;
+	size_t GetSize() const;
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator = (const MappedFile&);
+
+	const char* m_pData;
+	size_t m_Size;
+
+#ifdef _WIN32
+	HANDLE m_hFile;
+	HANDLE m_hMapping;
+#else
+	int m_FileDescriptor;
+#endif
+};
@@ -0,0 +1,197 @@
+#include "pch.h"
+#include "NullRenderer.h"
+
+using namespace std;
+
+namespace
+{
+
+typedef vector<char> NullBuffer;
+typedef vector<uint8_t> NullTexture;
+
+NullBuffer* ToNullBuffer(RenderBuffer* pBuffer)
+{
+	return reinterpret_cast<NullBuffer*>(pBuffer);
+}
+
+NullTexture* ToNullTexture(RenderTexture* pTexture)
+{
+	return reinterpret_cast<NullTexture*>(pTexture);
+}
+
+}
+
+RenderStatistics::RenderStatistics()
+	: DrawsCount(0)
+	, PassAppliesCount(0)
+	, VertexBufferBindsCount(0)
+	, IndexBufferBindsCount(0)
+	, TopologyChangesCount(0)
+	, TextureBindsCount(0)
+	, ColorUploadsCount(0)
+	, WorldUploadsCount(0)
+	, BufferUpdatesCount(0)
+{
+}
+
+NullRenderer::NullRenderer()
+	: m_BuffersCount(0)
+	, m_TexturesCount(0)
+{
+}
+
+NullRenderer::~NullRenderer()
+{
+	// every buffer and texture goes back before the renderer
+	assert(m_BuffersCount == 0 && m_TexturesCount == 0);
+}
+
+// buffers
+
+RenderBuffer* NullRenderer::CreateVertexBuffer(const void* pVertices, size_t size)
+{
+	return CreateBuffer(pVertices, size);
+}
+
+RenderBuffer* NullRenderer::CreateIndexBuffer(const unsigned* pIndices, size_t count)
+{
+	return CreateBuffer(pIndices, count * sizeof(unsigned));
+}
+
+RenderBuffer* NullRenderer::CreateDynamicVertexBuffer(size_t size)
+{
+	return CreateBuffer(nullptr, size);
+}
+
+RenderBuffer* NullRenderer::CreateDynamicIndexBuffer(size_t count)
+{
+	return CreateBuffer(nullptr, count * sizeof(unsigned));
+}
+
+void NullRenderer::UpdateDynamicBuffer(RenderBuffer* pBuffer, const void* pData, size_t size)
+{
+	NullBuffer* pNullBuffer = ToNullBuffer(pBuffer);
+	assert(size <= pNullBuffer->size());
+
+	memcpy(&pNullBuffer->front(), pData, size);
+	++m_Statistics.BufferUpdatesCount;
+}
+
+void NullRenderer::ReleaseBuffer(RenderBuffer* pBuffer)
+{
+	if (pBuffer)
+	{
+		delete ToNullBuffer(pBuffer);
+		--m_BuffersCount;
+	}
+}
+
+// textures
+
+RenderTexture* NullRenderer::CreateTexture(size_t width, size_t height, const uint8_t* pCoverage)
+{
+	assert(width > 0 && height > 0 && pCoverage);
+
+	NullTexture* pTexture = new NullTexture(pCoverage, pCoverage + width * height);
+	++m_TexturesCount;
+
+	return reinterpret_cast<RenderTexture*>(pTexture);
+}
+
+void NullRenderer::ReleaseTexture(RenderTexture* pTexture)
+{
+	if (pTexture)
+	{
+		delete ToNullTexture(pTexture);
+		--m_TexturesCount;
+	}
+}
+
+// draw submission
+
+void NullRenderer::BeginFrame()
+{
+	m_Statistics = RenderStatistics();
+}
+
+void NullRenderer::SetVertexBuffers(VertexFormat /*format*/, RenderBuffer* /*pVertexBuffer*/, RenderBuffer* /*pInstanceBuffer*/, size_t /*instanceSize*/)
+{
+	++m_Statistics.VertexBufferBindsCount;
+}
+
+void NullRenderer::SetIndexBuffer(RenderBuffer* /*pIndexBuffer*/)
+{
+	++m_Statistics.IndexBufferBindsCount;
+}
+
+void NullRenderer::SetTopology(PrimitiveTopology /*topology*/)
+{
+	++m_Statistics.TopologyChangesCount;
+}
+
+void NullRenderer::SetTexture(RenderTexture* /*pTexture*/)
+{
+	++m_Statistics.TextureBindsCount;
+}
+
+void NullRenderer::ApplyPass(RenderPass /*pass*/)
+{
+	++m_Statistics.PassAppliesCount;
+}
+
+void NullRenderer::DrawIndexed(size_t /*indicesCount*/, size_t /*startIndex*/, int /*baseVertex*/)
+{
+	++m_Statistics.DrawsCount;
+}
+
+void NullRenderer::DrawIndexedInstanced(size_t /*indicesCount*/, size_t /*instancesCount*/, size_t /*startIndex*/, int /*baseVertex*/)
+{
+	++m_Statistics.DrawsCount;
+}
+
+// constants
+
+void NullRenderer::SetColor(const Color& /*color*/)
+{
+	++m_Statistics.ColorUploadsCount;
+}
+
+void NullRenderer::SetWorld(const Matrix& /*world*/)
+{
+	++m_Statistics.WorldUploadsCount;
+}
+
+void NullRenderer::SetViewProjection(const Matrix& /*viewProjection*/)
+{
+}
+
+const RenderStatistics& NullRenderer::GetStatistics() const
+{
+	return m_Statistics;
+}
+
+size_t NullRenderer::GetBuffersCount() const
+{
+	return m_BuffersCount;
+}
+
+size_t NullRenderer::GetTexturesCount() const
+{
+	return m_TexturesCount;
+}
+
+RenderBuffer* NullRenderer::CreateBuffer(const void* pData, size_t size)
+{
+	assert(size > 0);
+
+	NullBuffer* pBuffer = new NullBuffer(size);
+
+	if (pData)
+	{
+		memcpy(&pBuffer->front(), pData, size);
+	}
+
+	++m_BuffersCount;
+
+	return reinterpret_cast<RenderBuffer*>(pBuffer);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Renderer.h"
+
+// what the renderer was asked for since the last BeginFrame
+struct RenderStatistics
+{
+	RenderStatistics();
+
+	size_t DrawsCount;
+	size_t PassAppliesCount;
+	size_t VertexBufferBindsCount;
+	size_t IndexBufferBindsCount;
+	size_t TopologyChangesCount;
+	size_t TextureBindsCount;
+	size_t ColorUploadsCount;
+	size_t WorldUploadsCount;
+	size_t BufferUpdatesCount;
+};
+
+// Draws nothing and counts what it is asked for. Buffers are kept in
+// memory, so creating and updating them costs what it does on the CPU side
+// of a real device. Needs no graphics API and runs on any platform; the
+// counts check RenderQueue, see BlockOutBench -render-queue.
+class NullRenderer : public Renderer
+{
+public:
+	NullRenderer();
+	virtual ~NullRenderer();
+
+	virtual RenderBuffer* CreateVertexBuffer(const void* pVertices, size_t size);
+	virtual RenderBuffer* CreateIndexBuffer(const unsigned* pIndices, size_t count);
+	virtual RenderBuffer* CreateDynamicVertexBuffer(size_t size);
+	virtual RenderBuffer* CreateDynamicIndexBuffer(size_t count);
+	virtual void UpdateDynamicBuffer(RenderBuffer* pBuffer, const void* pData, size_t size);
+	virtual void ReleaseBuffer(RenderBuffer* pBuffer);
+
+	virtual RenderTexture* CreateTexture(size_t width, size_t height, const uint8_t* pCoverage);
+	virtual void ReleaseTexture(RenderTexture* pTexture);
+
+	virtual void BeginFrame();
+
+	virtual void SetVertexBuffers(VertexFormat format, RenderBuffer* pVertexBuffer, RenderBuffer* pInstanceBuffer, size_t instanceSize);
+	virtual void SetIndexBuffer(RenderBuffer* pIndexBuffer);
+	virtual void SetTopology(PrimitiveTopology topology);
+	virtual void SetTexture(RenderTexture* pTexture);
+	virtual void ApplyPass(RenderPass pass);
+
+	virtual void DrawIndexed(size_t indicesCount, size_t startIndex, int baseVertex);
+	virtual void DrawIndexedInstanced(size_t indicesCount, size_t instancesCount, size_t startIndex, int baseVertex);
+
+	virtual void SetColor(const Color& color);
+	virtual void SetWorld(const Matrix& world);
+	virtual void SetViewProjection(const Matrix& viewProjection);
+
+	// counts of the current frame
+	const RenderStatistics& GetStatistics() const;
+
+	// buffers and textures created and not released yet
+	size_t GetBuffersCount() const;
+	size_t GetTexturesCount() const;
+
+private:
+	RenderBuffer* CreateBuffer(const void* pData, size_t size);
+
+	RenderStatistics m_Statistics;
+	size_t m_BuffersCount;
+	size_t m_TexturesCount;
+};
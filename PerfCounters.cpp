@@ -0,0 +1,226 @@
+#include "pch.h"
+#include "PerfCounters.h"
+#include "Clock.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace std;
+
+namespace
+{
+
+const char* COUNTER_NAMES[PERF_COUNTERS_COUNT] =
+{
+	"cycles",
+	"instructions",
+	"L1D misses",
+	"LLC misses",
+	"branch misses",
+};
+
+#ifdef __linux__
+
+struct CounterEvent
+{
+	uint32_t Type;
+	uint64_t Config;
+};
+
+const CounterEvent COUNTER_EVENTS[PERF_COUNTERS_COUNT] =
+{
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+// the value with the times the counter was enabled and actually counting
+struct CounterReading
+{
+	uint64_t Value;
+	uint64_t TimeEnabled;
+	uint64_t TimeRunning;
+};
+
+int OpenCounter(const CounterEvent& event)
+{
+	perf_event_attr attributes;
+	memset(&attributes, 0, sizeof(attributes));
+
+	attributes.size = sizeof(attributes);
+	attributes.type = event.Type;
+	attributes.config = event.Config;
+	attributes.disabled = 1;
+	attributes.exclude_kernel = 1;
+	attributes.exclude_hv = 1;
+	attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	// this thread on any CPU
+	return int(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+}
+
+#endif
+
+}
+
+PerfSample::PerfSample()
+	: Nanoseconds(0)
+{
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		Counts[i] = 0;
+		IsCounted[i] = false;
+	}
+}
+
+void PerfSample::Add(const PerfSample& other)
+{
+	Nanoseconds += other.Nanoseconds;
+
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		Counts[i] += other.Counts[i];
+		IsCounted[i] = IsCounted[i] && other.IsCounted[i];
+	}
+}
+
+PerfCounters::PerfCounters()
+	: m_StartTime(0)
+{
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		m_Counters[i] = -1;
+	}
+
+#ifdef __linux__
+	int error = 0;
+
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		m_Counters[i] = OpenCounter(COUNTER_EVENTS[i]);
+
+		if (m_Counters[i] < 0 && error == 0)
+		{
+			error = errno;
+		}
+	}
+
+	if (!IsAvailable())
+	{
+		m_UnavailabilityReason = string("perf_event_open failed: ") + strerror(error);
+
+		if (error == EACCES || error == EPERM)
+		{
+			m_UnavailabilityReason += ", see /proc/sys/kernel/perf_event_paranoid";
+		}
+	}
+#else
+	m_UnavailabilityReason = "hardware counters are read through perf_event_open on Linux only";
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		if (m_Counters[i] >= 0)
+		{
+			close(m_Counters[i]);
+		}
+	}
+#endif
+}
+
+bool PerfCounters::IsAvailable() const
+{
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		if (IsAvailable(PerfCounter(i)))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool PerfCounters::IsAvailable(PerfCounter counter) const
+{
+	assert(counter < PERF_COUNTERS_COUNT);
+	return m_Counters[counter] >= 0;
+}
+
+const string& PerfCounters::GetUnavailabilityReason() const
+{
+	return m_UnavailabilityReason;
+}
+
+void PerfCounters::Start()
+{
+#ifdef __linux__
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		if (m_Counters[i] >= 0)
+		{
+			ioctl(m_Counters[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(m_Counters[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+#endif
+
+	// last, so enabling the counters isn't timed
+	m_StartTime = Clock::GetSteadyClock().GetNanoseconds();
+}
+
+PerfSample PerfCounters::Stop()
+{
+	PerfSample sample;
+	sample.Nanoseconds = Clock::GetSteadyClock().GetNanoseconds() - m_StartTime;
+
+#ifdef __linux__
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		if (m_Counters[i] >= 0)
+		{
+			ioctl(m_Counters[i], PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+
+	for (unsigned i = 0; i < PERF_COUNTERS_COUNT; ++i)
+	{
+		CounterReading reading;
+
+		if (m_Counters[i] < 0 || read(m_Counters[i], &reading, sizeof(reading)) != sizeof(reading))
+		{
+			continue;
+		}
+
+		// a counter the kernel never scheduled counted nothing at all
+		if (reading.TimeRunning == 0)
+		{
+			continue;
+		}
+
+		sample.Counts[i] = reading.TimeRunning < reading.TimeEnabled
+			? uint64_t(double(reading.Value) * reading.TimeEnabled / reading.TimeRunning)
+			: reading.Value;
+		sample.IsCounted[i] = true;
+	}
+#endif
+
+	return sample;
+}
+
+const char* PerfCounters::GetCounterName(PerfCounter counter)
+{
+	assert(counter < PERF_COUNTERS_COUNT);
+	return COUNTER_NAMES[counter];
+}
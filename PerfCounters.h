@@ -0,0 +1,61 @@
+#pragma once
+
+enum PerfCounter
+{
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_L1D_MISSES,		// level 1 data cache read misses
+	PERF_LLC_MISSES,		// last level cache misses
+	PERF_BRANCH_MISSES,
+
+	PERF_COUNTERS_COUNT
+};
+
+// counts of one measured region
+struct PerfSample
+{
+	PerfSample();
+
+	// sums the regions, a counter is counted when it was counted in both
+	void Add(const PerfSample& other);
+
+	int64_t Nanoseconds;
+
+	// scaled up when the kernel multiplexed the counter with others
+	uint64_t Counts[PERF_COUNTERS_COUNT];
+	bool IsCounted[PERF_COUNTERS_COUNT];
+};
+
+// Hardware counters of the calling thread around a measured region, through
+// perf_event_open on Linux. Every counter is opened on its own, so a counter
+// the CPU or the kernel doesn't offer is left out without losing the others.
+// Where none can be opened, on other systems or with perf_event_paranoid set
+// too high, samples carry the wall clock time alone.
+class PerfCounters
+{
+public:
+	PerfCounters();
+	~PerfCounters();
+
+	// at least one hardware counter is open
+	bool IsAvailable() const;
+	bool IsAvailable(PerfCounter counter) const;
+
+	// why no counter could be opened, empty when one could
+	const std::string& GetUnavailabilityReason() const;
+
+	void Start();
+	PerfSample Stop();
+
+	static const char* GetCounterName(PerfCounter counter);
+
+private:
+	PerfCounters(const PerfCounters&);
+	PerfCounters& operator = (const PerfCounters&);
+
+	// file descriptors, -1 for counters not open
+	int m_Counters[PERF_COUNTERS_COUNT];
+	std::string m_UnavailabilityReason;
+
+	int64_t m_StartTime;
+};
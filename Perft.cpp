@@ -0,0 +1,511 @@
+#include "pch.h"
+#include "Perft.h"
+#include "EmbeddedShapeSets.h"
+#include "PositionNotation.h"
+
+using namespace std;
+
+namespace
+{
+
+// Standard positions. The counts of the first ply were checked against a
+// search moving cube vectors like Shape does; they must not change unless
+// the rules of the game do.
+const PerftPosition STANDARD_POSITIONS[] =
+{
+	// the start of a game
+	{ "start", "FlatFun", "5x5x12 0*12", "01234567", { 25, 1625, 89547 } },
+	{ "tetracubes", "Tetracubes", "5x5x12 0*12", "01234567", { 45, 16920, 3290556 } },
+
+	// four levels with one hole each, every piece can clear some
+	{ "holes", "FlatFun", "5x5x12 0*8/1fffffe/1ffffbf/1ffefff/ffffff", "5463", { 376, 86272, 16871906 } },
+
+	// a roof over the left three columns, reached only by sliding under it
+	{ "overhang", "Tetracubes", "5x5x12 0*9/739ce7/0*2", "0246", { 61, 17094, 3578830 } },
+
+	// the stack reaches level 3, most placements end the game
+	{ "near top", "FlatFun", "5x5x12 0*3/421/1ef7bdf/1fffffe/ffffff/1ffefff/1ffffbf/1efffff/1ffffef/1ffbfff", "1234", { 67, 3692, 192074 } },
+};
+
+const size_t STANDARD_POSITIONS_COUNT = sizeof(STANDARD_POSITIONS) / sizeof(STANDARD_POSITIONS[0]);
+
+bool IsLess(const Perft::Placement& a, const Perft::Placement& b)
+{
+	if (a.Top != b.Top)
+	{
+		return a.Top < b.Top;
+	}
+
+	if (a.LayersCount != b.LayersCount)
+	{
+		return a.LayersCount < b.LayersCount;
+	}
+
+	for (size_t i = 0; i < a.LayersCount; ++i)
+	{
+		if (a.Masks[i] != b.Masks[i])
+		{
+			return a.Masks[i] < b.Masks[i];
+		}
+	}
+
+	// the same cells, the smallest way to reach them first
+	if (a.Orientation != b.Orientation)
+	{
+		return a.Orientation < b.Orientation;
+	}
+
+	if (a.Z != b.Z)
+	{
+		return a.Z < b.Z;
+	}
+
+	return a.Y != b.Y ? a.Y < b.Y : a.X < b.X;
+}
+
+bool HasSameCells(const Perft::Placement& a, const Perft::Placement& b)
+{
+	return a.Top == b.Top && a.LayersCount == b.LayersCount &&
+		memcmp(a.Masks, b.Masks, a.LayersCount * sizeof(a.Masks[0])) == 0;
+}
+
+// Reachable resting places by a depth first walk over the states of the
+// falling piece, orientation and pivot cube; visited states are stamped, so
+// the buffer is cleared only when the stamp wraps.
+class PlacementGenerator
+{
+public:
+	PlacementGenerator()
+		: m_Stamp(0)
+	{
+	}
+
+	void Generate(const Pit& pit, const ShapeOrientationTable& piece, vector<Perft::Placement>& placements)
+	{
+		const size_t firstPlacement = placements.size();
+
+		if (!SetBounds(piece))
+		{
+			return;
+		}
+
+		if (++m_Stamp == 0)
+		{
+			fill(m_Visited.begin(), m_Visited.end(), 0u);
+			m_Stamp = 1;
+		}
+
+		// the spawn point of Shape
+		const State spawn = { 0, int(PIT_X_SIZE / 2), int(PIT_Y_SIZE / 2), 0 };
+
+		m_Stack.clear();
+		Visit(pit, piece, spawn);
+
+		while (!m_Stack.empty())
+		{
+			const State state = m_Stack.back();
+			m_Stack.pop_back();
+
+			const ShapeOrientation& orientation = piece.Orientations[state.Orientation];
+
+			State below = state;
+			++below.Z;
+
+			if (Fits(pit, piece, below))
+			{
+				Visit(pit, piece, below);
+			}
+			else
+			{
+				placements.push_back(MakePlacement(orientation, state));
+			}
+
+			static const int STEPS[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+
+			for (size_t i = 0; i < 4; ++i)
+			{
+				State moved = state;
+				moved.X += STEPS[i][0];
+				moved.Y += STEPS[i][1];
+
+				Visit(pit, piece, moved);
+			}
+
+			for (size_t rotation = 0; rotation < SHAPE_ROTATIONS_COUNT; ++rotation)
+			{
+				State rotated = state;
+				rotated.Orientation = orientation.Rotations[rotation];
+
+				Visit(pit, piece, rotated);
+			}
+		}
+
+		sort(placements.begin() + firstPlacement, placements.end(), IsLess);
+		placements.erase(unique(placements.begin() + firstPlacement, placements.end(), HasSameCells), placements.end());
+	}
+
+private:
+	struct State
+	{
+		int Orientation;
+		int X, Y, Z;
+	};
+
+	// pivot ranges of the orientations that fit in the pit, returns false
+	// when none does
+	bool SetBounds(const ShapeOrientationTable& piece)
+	{
+		bool hasFootprint = false;
+
+		for (size_t i = 0; i < piece.Count; ++i)
+		{
+			const ShapeOrientation& orientation = piece.Orientations[i];
+
+			if (!orientation.HasLayerMasks)
+			{
+				continue;
+			}
+
+			const int minimumX = -orientation.Minimum[0], maximumX = int(PIT_X_SIZE) - 1 - orientation.Maximum[0];
+			const int minimumY = -orientation.Minimum[1], maximumY = int(PIT_Y_SIZE) - 1 - orientation.Maximum[1];
+			const int maximumZ = int(PIT_Z_SIZE) - 1 - orientation.Maximum[2];
+
+			if (!hasFootprint)
+			{
+				m_MinimumX = minimumX, m_MaximumX = maximumX;
+				m_MinimumY = minimumY, m_MaximumY = maximumY;
+				m_MaximumZ = maximumZ;
+				hasFootprint = true;
+			}
+			else
+			{
+				m_MinimumX = min(m_MinimumX, minimumX), m_MaximumX = max(m_MaximumX, maximumX);
+				m_MinimumY = min(m_MinimumY, minimumY), m_MaximumY = max(m_MaximumY, maximumY);
+				m_MaximumZ = max(m_MaximumZ, maximumZ);
+			}
+		}
+
+		if (!hasFootprint || m_MaximumZ < 0)
+		{
+			return false;
+		}
+
+		m_SizeX = size_t(m_MaximumX - m_MinimumX + 1);
+		m_SizeY = size_t(m_MaximumY - m_MinimumY + 1);
+		m_SizeZ = size_t(m_MaximumZ + 1);
+
+		const size_t statesCount = piece.Count * m_SizeX * m_SizeY * m_SizeZ;
+
+		if (m_Visited.size() < statesCount)
+		{
+			m_Visited.resize(statesCount, 0u);
+		}
+
+		return true;
+	}
+
+	// the pivot never rises above level 0, cubes may
+	bool Fits(const Pit& pit, const ShapeOrientationTable& piece, const State& state) const
+	{
+		const ShapeOrientation& orientation = piece.Orientations[state.Orientation];
+
+		if (!orientation.HasLayerMasks)
+		{
+			return false;
+		}
+
+		const int cornerX = state.X + orientation.Minimum[0];
+		const int cornerY = state.Y + orientation.Minimum[1];
+		const int top = state.Z + orientation.Minimum[2];
+		const int bottom = state.Z + orientation.Maximum[2];
+
+		if (cornerX < 0 || state.X + orientation.Maximum[0] >= int(PIT_X_SIZE) ||
+			cornerY < 0 || state.Y + orientation.Maximum[1] >= int(PIT_Y_SIZE) ||
+			bottom >= int(PIT_Z_SIZE))
+		{
+			return false;
+		}
+
+		const size_t shift = size_t(cornerY) * PIT_X_SIZE + size_t(cornerX);
+
+		for (int z = max(top, 0); z <= bottom; ++z)
+		{
+			if ((orientation.LayerMasks[z - top] << shift) & pit.GetLevelMask(size_t(z)))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// states that don't fit are stamped too, so they are tested once
+	void Visit(const Pit& pit, const ShapeOrientationTable& piece, const State& state)
+	{
+		if (state.X < m_MinimumX || state.X > m_MaximumX || state.Y < m_MinimumY || state.Y > m_MaximumY || state.Z > m_MaximumZ)
+		{
+			return;
+		}
+
+		const size_t index = ((size_t(state.Orientation) * m_SizeX + size_t(state.X - m_MinimumX)) * m_SizeY + size_t(state.Y - m_MinimumY)) * m_SizeZ + size_t(state.Z);
+
+		if (m_Visited[index] == m_Stamp)
+		{
+			return;
+		}
+
+		m_Visited[index] = m_Stamp;
+
+		if (Fits(pit, piece, state))
+		{
+			m_Stack.push_back(state);
+		}
+	}
+
+	static Perft::Placement MakePlacement(const ShapeOrientation& orientation, const State& state)
+	{
+		Perft::Placement placement;
+
+		placement.Orientation = uint8_t(state.Orientation);
+		placement.X = int8_t(state.X);
+		placement.Y = int8_t(state.Y);
+		placement.Z = int8_t(state.Z);
+
+		placement.Top = int8_t(state.Z + orientation.Minimum[2]);
+		placement.LayersCount = uint8_t(orientation.Maximum[2] - orientation.Minimum[2] + 1);
+
+		const size_t shift = size_t(state.Y + orientation.Minimum[1]) * PIT_X_SIZE + size_t(state.X + orientation.Minimum[0]);
+
+		for (size_t i = 0; i < placement.LayersCount; ++i)
+		{
+			placement.Masks[i] = orientation.LayerMasks[i] << shift;
+		}
+
+		return placement;
+	}
+
+	int m_MinimumX, m_MaximumX;
+	int m_MinimumY, m_MaximumY;
+	int m_MaximumZ;
+	size_t m_SizeX, m_SizeY, m_SizeZ;
+
+	vector<uint32_t> m_Visited;
+	uint32_t m_Stamp;
+
+	vector<State> m_Stack;
+};
+
+// one per thread, with a placements buffer per ply
+class Searcher
+{
+public:
+	Searcher(const vector<const ShapeOrientationTable*>& pieces, size_t depth)
+		: m_Pieces(pieces)
+		, m_Placements(depth)
+	{
+	}
+
+	uint64_t Count(const Pit& pit, size_t ply, size_t depth)
+	{
+		if (depth == 0)
+		{
+			return 1;
+		}
+
+		const ShapeOrientationTable* pPiece = m_Pieces[ply % m_Pieces.size()];
+
+		if (!pPiece)
+		{
+			return 0;
+		}
+
+		vector<Perft::Placement>& placements = m_Placements[ply];
+		placements.clear();
+		m_Generator.Generate(pit, *pPiece, placements);
+
+		// the leaves need no placing
+		if (depth == 1)
+		{
+			return placements.size();
+		}
+
+		uint64_t nodesCount = 0;
+
+		for (size_t i = 0; i < placements.size(); ++i)
+		{
+			Pit next = pit;
+
+			if (Perft::Apply(next, placements[i]))
+			{
+				nodesCount += Count(next, ply + 1, depth - 1);
+			}
+		}
+
+		return nodesCount;
+	}
+
+private:
+	Searcher(const Searcher&);
+	Searcher& operator = (const Searcher&);
+
+	const vector<const ShapeOrientationTable*>& m_Pieces;
+	vector<vector<Perft::Placement> > m_Placements;
+	PlacementGenerator m_Generator;
+};
+
+}
+
+Perft::Options::Options()
+	: Depth(1)
+	, ThreadsCount(0)
+{
+}
+
+Perft::Result Perft::Run(const Pit& pit, const vector<const ShapeOrientationTable*>& pieces, const Options& options)
+{
+	assert(!pieces.empty());
+
+	Result result;
+	result.NodesCount = 0;
+
+	if (options.Depth == 0)
+	{
+		result.NodesCount = 1;
+		return result;
+	}
+
+	if (pieces[0])
+	{
+		GeneratePlacements(pit, *pieces[0], result.RootPlacements);
+	}
+
+	const size_t rootsCount = result.RootPlacements.size();
+	result.DividedCounts.assign(rootsCount, 1);
+
+	if (options.Depth > 1)
+	{
+		unsigned threadsCount = options.ThreadsCount ? options.ThreadsCount : max(1u, thread::hardware_concurrency());
+		threadsCount = unsigned(min(size_t(threadsCount), max(rootsCount, size_t(1))));
+
+		// subtrees differ a lot in size, so workers take the next root
+		// placement as they finish one
+		atomic<size_t> nextRoot(0);
+
+		auto job = [&](unsigned /*worker*/)
+		{
+			Searcher searcher(pieces, options.Depth);
+
+			for (size_t i = nextRoot++; i < rootsCount; i = nextRoot++)
+			{
+				Pit next = pit;
+				result.DividedCounts[i] = Apply(next, result.RootPlacements[i]) ? searcher.Count(next, 1, options.Depth - 1) : 0;
+			}
+		};
+
+		vector<thread> threads;
+
+		for (unsigned worker = 1; worker < threadsCount; ++worker)
+		{
+			threads.push_back(thread(job, worker));
+		}
+
+		job(0u);
+
+		for (size_t i = 0; i < threads.size(); ++i)
+		{
+			threads[i].join();
+		}
+	}
+
+	for (size_t i = 0; i < rootsCount; ++i)
+	{
+		result.NodesCount += result.DividedCounts[i];
+	}
+
+	return result;
+}
+
+void Perft::GeneratePlacements(const Pit& pit, const ShapeOrientationTable& piece, vector<Placement>& placements)
+{
+	PlacementGenerator generator;
+	generator.Generate(pit, piece, placements);
+}
+
+bool Perft::Apply(Pit& pit, const Placement& placement)
+{
+	for (size_t i = 0; i < placement.LayersCount; ++i)
+	{
+		const int z = placement.Top + int(i);
+
+		if (z >= 0)
+		{
+			pit.OccupyCells(size_t(z), placement.Masks[i]);
+		}
+	}
+
+	// as Grid::UpdateLevels
+	for (int level = int(PIT_Z_SIZE) - 1; level >= int(pit.GetHighestOccupiedLevel()); --level)
+	{
+		if (pit.IsLevelFull(level))
+		{
+			pit.RemoveLevel(level);
+			++level;
+		}
+	}
+
+	// as Grid::HasBoxOnHighestLevel
+	return pit.GetHighestOccupiedLevel() > 0;
+}
+
+size_t Perft::GetStandardPositionsCount()
+{
+	return STANDARD_POSITIONS_COUNT;
+}
+
+const PerftPosition& Perft::GetStandardPosition(size_t index)
+{
+	assert(index < STANDARD_POSITIONS_COUNT);
+	return STANDARD_POSITIONS[index];
+}
+
+const PerftPosition* Perft::FindStandardPosition(const string& name)
+{
+	for (size_t i = 0; i < STANDARD_POSITIONS_COUNT; ++i)
+	{
+		if (name == STANDARD_POSITIONS[i].Name)
+		{
+			return &STANDARD_POSITIONS[i];
+		}
+	}
+
+	return nullptr;
+}
+
+bool Perft::SetUp(const PerftPosition& position, Pit& pit, vector<const ShapeOrientationTable*>& pieces)
+{
+	const EmbeddedShapeSet* pSet = EmbeddedShapeSets::Find(position.ShapeSetName);
+
+	if (!pSet)
+	{
+		return false;
+	}
+
+	// standard positions are always well formed
+	pit = PositionNotation::Parse(position.Stack).Stack;
+
+	pieces.clear();
+
+	for (const char* pKind = position.Pieces; *pKind; ++pKind)
+	{
+		const size_t kind = size_t(*pKind - '0');
+
+		if (kind >= pSet->ShapesCount)
+		{
+			return false;
+		}
+
+		pieces.push_back(pSet->pShapes[kind].pOrientations);
+	}
+
+	return !pieces.empty();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Pit.h"
+#include "ShapeOrientation.h"
+
+// a position with published counts, see Perft::GetStandardPosition
+struct PerftPosition
+{
+	static const size_t MAX_DEPTH = 4;
+
+	const char* Name;
+
+	// embedded shape set the piece kinds refer to
+	const char* ShapeSetName;
+
+	// the stack in PositionNotation
+	const char* Stack;
+
+	// shape kinds as digits, repeated for deeper plies
+	const char* Pieces;
+
+	// perft(1), perft(2) and so on, 0 past the last published depth
+	uint64_t NodesCounts[MAX_DEPTH];
+};
+
+// Counts the distinct sequences of placements reachable from a pit with a
+// fixed sequence of pieces, like perft counts the leaves of the move tree in
+// chess engines. A placement is a resting place of the piece reachable from
+// the spawn point with the moves of the game, translations along x and y,
+// falling and the quarter turns of the orientation tables; placements that
+// cover the same cells are counted once. Placed pieces clear full levels
+// like Grid::UpdateLevels and a box left on level 0 ends the game, so such
+// a placement has no successors. The counts check move generators against
+// each other and, timed, compare their speed in nodes per second.
+class Perft
+{
+public:
+	struct Options
+	{
+		Options();
+
+		size_t Depth;
+
+		// 0 uses all hardware threads
+		unsigned ThreadsCount;
+	};
+
+	struct Placement
+	{
+		// orientation index in the piece table and pivot cube, the
+		// smallest of all the ways to reach these cells
+		uint8_t Orientation;
+		int8_t X, Y, Z;
+
+		// the cells, Masks[i] on level Top + i; cubes above the pit, on
+		// negative levels, are lost when the piece locks as in Shape::Destroy
+		int8_t Top;
+		uint8_t LayersCount;
+		Pit::LevelMask Masks[MAX_SHAPE_CUBES];
+	};
+
+	struct Result
+	{
+		uint64_t NodesCount;
+
+		// the root placements and the leaves under each of them, "divide"
+		std::vector<Placement> RootPlacements;
+		std::vector<uint64_t> DividedCounts;
+	};
+
+	// pieces[ply % pieces.size()] is placed at every ply; pieces without an
+	// orientation table (nullptr) have no placements. The subtrees of the
+	// root placements are split across threads.
+	static Result Run(const Pit& pit, const std::vector<const ShapeOrientationTable*>& pieces, const Options& options);
+
+	// appends the placements of the piece in the order described above
+	static void GeneratePlacements(const Pit& pit, const ShapeOrientationTable& piece, std::vector<Placement>& placements);
+
+	// locks the piece and clears full levels, returns false when the game
+	// is over
+	static bool Apply(Pit& pit, const Placement& placement);
+
+	static size_t GetStandardPositionsCount();
+	static const PerftPosition& GetStandardPosition(size_t index);
+
+	// returns nullptr for unknown names
+	static const PerftPosition* FindStandardPosition(const std::string& name);
+
+	// the pit and the pieces of a standard position, returns false when its
+	// shape set or a piece kind is unknown
+	static bool SetUp(const PerftPosition& position, Pit& pit, std::vector<const ShapeOrientationTable*>& pieces);
+};
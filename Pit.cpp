@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "Pit.h"
+
+Pit::Pit()
+{
+	Clear();
+}
+
+void Pit::Clear()
+{
+	memset(m_Levels, 0, sizeof(m_Levels));
+	m_HighestOccupiedLevel = PIT_Z_SIZE;
+}
+
+bool Pit::IsOccupied(int x, int y, int z) const
+{
+	if (x < 0 || x >= int(PIT_X_SIZE) || y < 0 || y >= int(PIT_Y_SIZE) || z < 0 || z >= int(PIT_Z_SIZE))
+	{
+		return false;
+	}
+
+	return (m_Levels[z] & GetCellMask(x, y)) != 0;
+}
+
+void Pit::Occupy(size_t x, size_t y, size_t z)
+{
+	assert(x < PIT_X_SIZE && y < PIT_Y_SIZE && z < PIT_Z_SIZE);
+	assert(!IsOccupied(int(x), int(y), int(z)));
+
+	m_Levels[z] |= GetCellMask(x, y);
+
+	if (z < m_HighestOccupiedLevel)
+	{
+		m_HighestOccupiedLevel = z;
+	}
+}
+
+void Pit::OccupyCells(size_t z, LevelMask cells)
+{
+	assert(z < PIT_Z_SIZE);
+	assert((cells & ~FULL_LEVEL_MASK) == 0 && (m_Levels[z] & cells) == 0);
+
+	if (cells == 0)
+	{
+		return;
+	}
+
+	m_Levels[z] |= cells;
+
+	if (z < m_HighestOccupiedLevel)
+	{
+		m_HighestOccupiedLevel = z;
+	}
+}
+
+Pit::LevelMask Pit::GetLevelMask(size_t z) const
+{
+	assert(z < PIT_Z_SIZE);
+	return m_Levels[z];
+}
+
+bool Pit::IsLevelFull(size_t z) const
+{
+	return GetLevelMask(z) == FULL_LEVEL_MASK;
+}
+
+void Pit::RemoveLevel(size_t z)
+{
+	assert(z < PIT_Z_SIZE);
+
+	for (size_t level = z; level > m_HighestOccupiedLevel; --level)
+	{
+		m_Levels[level] = m_Levels[level - 1];
+	}
+
+	if (m_HighestOccupiedLevel <= z)
+	{
+		m_Levels[m_HighestOccupiedLevel] = 0;
+		++m_HighestOccupiedLevel;
+	}
+}
+
+size_t Pit::GetHighestOccupiedLevel() const
+{
+	return m_HighestOccupiedLevel;
+}
+
+Pit::LevelMask Pit::GetCellMask(size_t x, size_t y)
+{
+	return LevelMask(1) << (y * PIT_X_SIZE + x);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "PitDimensions.h"
+
+// Occupancy of the pit cells without any rendering state, one bit mask per
+// level with bit y * PIT_X_SIZE + x set for an occupied cell. Level 0 is
+// the top one, so removed levels are filled from smaller z.
+class Pit
+{
+public:
+	typedef uint32_t LevelMask;
+
+	static const size_t CELLS_PER_LEVEL = PIT_X_SIZE * PIT_Y_SIZE;
+	static const LevelMask FULL_LEVEL_MASK = LevelMask((uint64_t(1) << CELLS_PER_LEVEL) - 1);
+
+	static_assert(CELLS_PER_LEVEL <= 32, "a pit level must fit in one mask");
+
+	Pit();
+
+	void Clear();
+
+	// cells outside the pit are reported free
+	bool IsOccupied(int x, int y, int z) const;
+	void Occupy(size_t x, size_t y, size_t z);
+	// every cell of the mask, all free
+	void OccupyCells(size_t z, LevelMask cells);
+
+	LevelMask GetLevelMask(size_t z) const;
+	bool IsLevelFull(size_t z) const;
+
+	// levels above the removed one move one level down
+	void RemoveLevel(size_t z);
+
+	// PIT_Z_SIZE for an empty pit
+	size_t GetHighestOccupiedLevel() const;
+
+	static LevelMask GetCellMask(size_t x, size_t y);
+
+private:
+	LevelMask m_Levels[PIT_Z_SIZE];
+	size_t m_HighestOccupiedLevel;
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+// size of the pit in cubes; level 0 is the top one, z grows downwards
+const size_t PIT_X_SIZE = 5;
+const size_t PIT_Y_SIZE = 5;
+const size_t PIT_Z_SIZE = 12;
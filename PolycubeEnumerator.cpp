@@ -0,0 +1,408 @@
+#include "pch.h"
+#include "PolycubeEnumerator.h"
+#include "Tracer.h"
+
+using namespace std;
+
+namespace
+{
+
+const size_t MAX_CUBES_COUNT = PolycubeEnumerator::MAX_CUBES_COUNT;
+
+// coordinates of a normalized polycube fit in 4 bits each
+const int COORDINATE_BITS = 4;
+const int COORDINATE_MASK = (1 << COORDINATE_BITS) - 1;
+
+// normalized coordinates go from 0 to the side length - 1, so a rod of
+// every cube still fits
+static_assert(MAX_CUBES_COUNT <= COORDINATE_MASK + 1, "the longest polycube must fit in the cell encoding");
+
+// cells are encoded as x | y << 4 | z << 8 and kept sorted
+struct Key
+{
+	uint16_t Cells[MAX_CUBES_COUNT];
+	uint8_t Count;
+
+	bool operator == (const Key& other) const
+	{
+		return Count == other.Count && equal(Cells, Cells + Count, other.Cells);
+	}
+
+	bool operator < (const Key& other) const
+	{
+		return lexicographical_compare(Cells, Cells + Count, other.Cells, other.Cells + other.Count);
+	}
+
+	int GetX(size_t i) const { return Cells[i] & COORDINATE_MASK; }
+	int GetY(size_t i) const { return (Cells[i] >> COORDINATE_BITS) & COORDINATE_MASK; }
+	int GetZ(size_t i) const { return Cells[i] >> (2 * COORDINATE_BITS); }
+};
+
+struct KeyHash
+{
+	size_t operator () (const Key& key) const
+	{
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ULL;
+
+		for (size_t i = 0; i < key.Count; ++i)
+		{
+			hash = (hash ^ key.Cells[i]) * 1099511628211ULL;
+		}
+
+		return size_t(hash ^ (hash >> 32));
+	}
+};
+
+typedef unordered_set<Key, KeyHash> KeySet;
+
+// signed axis permutation, cell' [i] = sign[i] * cell[axis[i]]
+struct Orientation
+{
+	int Axis[3];
+	int Sign[3];
+};
+
+// 24 rotations followed by the 24 reflections
+vector<Orientation> BuildOrientations()
+{
+	vector<Orientation> rotations, reflections;
+
+	int permutations[6][3] = { { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 0, 2, 1 }, { 2, 1, 0 }, { 1, 0, 2 } };
+
+	for (int p = 0; p < 6; ++p)
+	{
+		// the first three permutations are even
+		int parity = (p < 3) ? 1 : -1;
+
+		for (int signs = 0; signs < 8; ++signs)
+		{
+			Orientation orientation;
+
+			int determinant = parity;
+
+			for (int i = 0; i < 3; ++i)
+			{
+				orientation.Axis[i] = permutations[p][i];
+				orientation.Sign[i] = (signs & (1 << i)) ? -1 : 1;
+				determinant *= orientation.Sign[i];
+			}
+
+			(determinant > 0 ? rotations : reflections).push_back(orientation);
+		}
+	}
+
+	rotations.insert(rotations.end(), reflections.begin(), reflections.end());
+	return rotations;
+}
+
+const vector<Orientation> ORIENTATIONS = BuildOrientations();
+
+void GetExtents(const Key& key, int extents[3])
+{
+	extents[0] = extents[1] = extents[2] = 0;
+
+	for (size_t i = 0; i < key.Count; ++i)
+	{
+		extents[0] = max(extents[0], key.GetX(i) + 1);
+		extents[1] = max(extents[1], key.GetY(i) + 1);
+		extents[2] = max(extents[2], key.GetZ(i) + 1);
+	}
+}
+
+// smallest sorted encoding over the given orientations; when
+// isFlattest is set only orientations with x >= y >= z extents compete
+Key Canonicalize(const int (*cells)[3], size_t count, size_t orientationsCount, bool isFlattest = false)
+{
+	Key best;
+	best.Count = 0;
+
+	for (size_t o = 0; o < orientationsCount; ++o)
+	{
+		const Orientation& orientation = ORIENTATIONS[o];
+
+		int transformed[MAX_CUBES_COUNT][3];
+		int minimum[3] = { INT_MAX, INT_MAX, INT_MAX };
+		int maximum[3] = { INT_MIN, INT_MIN, INT_MIN };
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				transformed[i][axis] = orientation.Sign[axis] * cells[i][orientation.Axis[axis]];
+				minimum[axis] = min(minimum[axis], transformed[i][axis]);
+				maximum[axis] = max(maximum[axis], transformed[i][axis]);
+			}
+		}
+
+		if (isFlattest &&
+			!(maximum[0] - minimum[0] >= maximum[1] - minimum[1] && maximum[1] - minimum[1] >= maximum[2] - minimum[2]))
+		{
+			continue;
+		}
+
+		Key key;
+		key.Count = uint8_t(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			key.Cells[i] = uint16_t(
+				(transformed[i][0] - minimum[0]) |
+				(transformed[i][1] - minimum[1]) << COORDINATE_BITS |
+				(transformed[i][2] - minimum[2]) << (2 * COORDINATE_BITS));
+		}
+
+		sort(key.Cells, key.Cells + count);
+
+		if (best.Count == 0 || key < best)
+		{
+			best = key;
+		}
+	}
+
+	return best;
+}
+
+bool IsAccepted(const Key& key, const PolycubeEnumerator::Options& options)
+{
+	int extents[3];
+	GetExtents(key, extents);
+
+	int largest = max(extents[0], max(extents[1], extents[2]));
+	int smallest = min(extents[0], min(extents[1], extents[2]));
+
+	if (options.IsPlanarOnly && smallest != 1)
+	{
+		return false;
+	}
+
+	return options.MaxExtent == 0 || size_t(largest) <= options.MaxExtent;
+}
+
+// runs job(worker) on every worker thread and waits for all of them
+template <typename Job>
+void RunParallel(unsigned threadsCount, Job job)
+{
+	vector<thread> threads;
+
+	for (unsigned worker = 1; worker < threadsCount; ++worker)
+	{
+		threads.push_back(thread(job, worker));
+	}
+
+	job(0u);
+
+	for (size_t i = 0; i < threads.size(); ++i)
+	{
+		threads[i].join();
+	}
+}
+
+// all polycubes one cube larger than the given ones, in canonical form
+vector<Key> Grow(const vector<Key>& polycubes, const PolycubeEnumerator::Options& options, unsigned threadsCount)
+{
+	const size_t orientationsCount = options.IsReflectionIdentified ? 48 : 24;
+	const int NEIGHBOURS[6][3] = { { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 } };
+
+	// every candidate goes to the shard picked by its hash, so shards can
+	// be deduplicated independently
+	const unsigned shardsCount = threadsCount * 4;
+	vector<vector<vector<Key> > > candidates(threadsCount, vector<vector<Key> >(shardsCount));
+
+	RunParallel(threadsCount, [&](unsigned worker)
+	{
+		ScopedTrace trace("search", "grow");
+		size_t candidatesCount = 0;
+
+		KeyHash hash;
+
+		for (size_t p = worker; p < polycubes.size(); p += threadsCount)
+		{
+			const Key& parent = polycubes[p];
+
+			int cells[MAX_CUBES_COUNT][3];
+
+			for (size_t i = 0; i < parent.Count; ++i)
+			{
+				cells[i][0] = parent.GetX(i);
+				cells[i][1] = parent.GetY(i);
+				cells[i][2] = parent.GetZ(i);
+			}
+
+			for (size_t i = 0; i < parent.Count; ++i)
+			{
+				for (int n = 0; n < 6; ++n)
+				{
+					int* cell = cells[parent.Count];
+					cell[0] = cells[i][0] + NEIGHBOURS[n][0];
+					cell[1] = cells[i][1] + NEIGHBOURS[n][1];
+					cell[2] = cells[i][2] + NEIGHBOURS[n][2];
+
+					bool isOccupied = false;
+
+					for (size_t j = 0; j < parent.Count && !isOccupied; ++j)
+					{
+						isOccupied = cells[j][0] == cell[0] && cells[j][1] == cell[1] && cells[j][2] == cell[2];
+					}
+
+					if (isOccupied)
+					{
+						continue;
+					}
+
+					Key child = Canonicalize(cells, parent.Count + 1, orientationsCount);
+					++candidatesCount;
+
+					if (IsAccepted(child, options))
+					{
+						candidates[worker][hash(child) % shardsCount].push_back(child);
+					}
+				}
+			}
+		}
+
+		trace.SetArgument("nodes", candidatesCount);
+	});
+
+	vector<vector<Key> > shards(shardsCount);
+
+	RunParallel(threadsCount, [&](unsigned worker)
+	{
+		ScopedTrace trace("search", "deduplicate");
+
+		for (unsigned shard = worker; shard < shardsCount; shard += threadsCount)
+		{
+			KeySet unique;
+
+			for (unsigned producer = 0; producer < threadsCount; ++producer)
+			{
+				unique.insert(candidates[producer][shard].begin(), candidates[producer][shard].end());
+			}
+
+			shards[shard].assign(unique.begin(), unique.end());
+		}
+	});
+
+	vector<Key> grown;
+
+	for (unsigned shard = 0; shard < shardsCount; ++shard)
+	{
+		grown.insert(grown.end(), shards[shard].begin(), shards[shard].end());
+	}
+
+	sort(grown.begin(), grown.end());
+
+	return grown;
+}
+
+PolycubeEnumerator::Polycube ToPolycube(const Key& canonical)
+{
+	int cells[MAX_CUBES_COUNT][3];
+
+	for (size_t i = 0; i < canonical.Count; ++i)
+	{
+		cells[i][0] = canonical.GetX(i);
+		cells[i][1] = canonical.GetY(i);
+		cells[i][2] = canonical.GetZ(i);
+	}
+
+	// lay the piece flat: shortest side along z, longest along x
+	Key key = Canonicalize(cells, canonical.Count, 24, true);
+
+	int extents[3];
+	GetExtents(key, extents);
+
+	// pivot on the cube nearest to the bounding box center
+	size_t pivot = 0;
+	int bestDistance = INT_MAX;
+
+	for (size_t i = 0; i < key.Count; ++i)
+	{
+		int dx = 2 * key.GetX(i) + 1 - extents[0];
+		int dy = 2 * key.GetY(i) + 1 - extents[1];
+		int dz = 2 * key.GetZ(i) + 1 - extents[2];
+		int distance = dx * dx + dy * dy + dz * dz;
+
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			pivot = i;
+		}
+	}
+
+	PolycubeEnumerator::Polycube polycube(key.Count);
+
+	for (size_t i = 0; i < key.Count; ++i)
+	{
+		polycube[i].x = key.GetX(i) - key.GetX(pivot);
+		polycube[i].y = key.GetY(i) - key.GetY(pivot);
+		polycube[i].z = key.GetZ(i) - key.GetZ(pivot);
+	}
+
+	return polycube;
+}
+
+}
+
+PolycubeEnumerator::Options::Options()
+	: MinCubesCount(1)
+	, MaxCubesCount(4)
+	, IsReflectionIdentified(false)
+	, IsPlanarOnly(false)
+	, MaxExtent(0)
+	, ThreadsCount(0)
+{
+}
+
+vector<PolycubeEnumerator::Polycube> PolycubeEnumerator::Enumerate(const Options& options)
+{
+	assert(options.MinCubesCount >= 1);
+	assert(options.MinCubesCount <= options.MaxCubesCount && options.MaxCubesCount <= MAX_CUBES_COUNT);
+
+	unsigned threadsCount = options.ThreadsCount ? options.ThreadsCount : max(1u, thread::hardware_concurrency());
+
+	Key monocube;
+	monocube.Count = 1;
+	monocube.Cells[0] = 0;
+
+	vector<Key> level(1, monocube);
+	vector<Polycube> polycubes;
+
+	for (size_t cubesCount = 1; cubesCount <= options.MaxCubesCount; ++cubesCount)
+	{
+		if (cubesCount > 1)
+		{
+			ScopedTrace trace("search", "enumerate level");
+			level = Grow(level, options, threadsCount);
+			trace.SetArgument("polycubes", level.size());
+		}
+
+		if (cubesCount >= options.MinCubesCount)
+		{
+			for (vector<Key>::const_iterator it = level.begin(); it != level.end(); ++it)
+			{
+				polycubes.push_back(ToPolycube(*it));
+			}
+		}
+	}
+
+	return polycubes;
+}
+
+void PolycubeEnumerator::WriteShapeSet(ostream& stream, const vector<Polycube>& polycubes)
+{
+	stream << polycubes.size() << "\n\n";
+
+	for (vector<Polycube>::const_iterator it = polycubes.begin(); it != polycubes.end(); ++it)
+	{
+		// no vertices, triangles and lines
+		stream << "0\n0\n0\n" << it->size() << "\n";
+
+		for (Polycube::const_iterator cube = it->begin(); cube != it->end(); ++cube)
+		{
+			stream << cube->x << " " << cube->y << " " << cube->z << "\n";
+		}
+
+		stream << "\n";
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// Enumerates free polycubes (connected sets of unit cubes, counted once per
+// rotation class, optionally also identifying mirror images) by growing
+// every polycube of size n by one cube into all polycubes of size n + 1.
+// Candidates are reduced to a canonical form, the smallest encoding over
+// all orientations, and deduplicated in hash sets. Growth and
+// deduplication are split across threads.
+class PolycubeEnumerator
+{
+public:
+	static const size_t MAX_CUBES_COUNT = 16;
+
+	struct Options
+	{
+		Options();
+
+		size_t MinCubesCount;
+		size_t MaxCubesCount;
+
+		// treat mirror images as the same polycube
+		bool IsReflectionIdentified;
+
+		// only polycubes one cube thick
+		bool IsPlanarOnly;
+
+		// largest allowed bounding box side, 0 means unlimited
+		size_t MaxExtent;
+
+		// 0 uses all hardware threads
+		unsigned ThreadsCount;
+	};
+
+	struct Cube
+	{
+		int x, y, z;
+	};
+
+	typedef std::vector<Cube> Polycube;
+
+	// returns polycubes ordered by size, then by canonical form; cubes are
+	// given relative to the cube nearest to the bounding box center, with
+	// the shortest side along z and the longest along x
+	static std::vector<Polycube> Enumerate(const Options& options);
+
+	// writes the set in the text shape set format, meshes are generated
+	// from the cubes when the set is loaded
+	static void WriteShapeSet(std::ostream& stream, const std::vector<Polycube>& polycubes);
+};
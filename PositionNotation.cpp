@@ -0,0 +1,350 @@
+#include "pch.h"
+#include "PositionNotation.h"
+
+using namespace std;
+
+namespace
+{
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+class Parser
+{
+public:
+	Parser(const char* pText, size_t size)
+		: m_pStart(pText)
+		, m_pCurrent(pText)
+		, m_pEnd(pText + size)
+	{
+	}
+
+	GamePosition Parse()
+	{
+		GamePosition position;
+
+		ParseSize();
+		Expect(' ', "a space before the levels");
+		ParseLevels(position.Stack);
+
+		if (m_pCurrent == m_pEnd)
+		{
+			return position;
+		}
+
+		Expect(' ', "a space before the current shape");
+
+		if (!Skip('-'))
+		{
+			position.ShapeKind = ParseKind();
+			Expect(':', "':' before the orientation");
+			position.Orientation = ParseNumber<unsigned>("an orientation", 10);
+			Expect('@', "'@' before the position");
+			position.ShapeX = ParseNumber<int>("x", 10);
+			Expect(',', "',' before y");
+			position.ShapeY = ParseNumber<int>("y", 10);
+			Expect(',', "',' before z");
+			position.ShapeZ = ParseNumber<int>("z", 10);
+		}
+
+		Expect(' ', "a space before the next shape");
+
+		if (!Skip('-'))
+		{
+			position.NextShapeKind = ParseKind();
+		}
+
+		Expect(' ', "a space before the score");
+		position.Score = ParseNumber<unsigned>("a score", 10);
+		Expect(' ', "a space before the level");
+		position.Level = ParseNumber<unsigned>("a level", 10);
+		Expect(' ', "a space before the random state");
+
+		const char* pToken = m_pCurrent;
+		position.RandomState = ParseNumber<uint64_t>("a random state", 16);
+
+		if (position.RandomState == 0)
+		{
+			m_pCurrent = pToken;
+			ThrowError("the random state must not be 0");
+		}
+
+		if (m_pCurrent != m_pEnd)
+		{
+			ThrowError("unexpected text after the random state");
+		}
+
+		return position;
+	}
+
+private:
+	void ParseSize()
+	{
+		const size_t sizes[3] = { PIT_X_SIZE, PIT_Y_SIZE, PIT_Z_SIZE };
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (axis > 0)
+			{
+				Expect('x', "'x' between the pit sizes");
+			}
+
+			const char* pToken = m_pCurrent;
+
+			if (ParseNumber<size_t>("a pit size", 10) != sizes[axis])
+			{
+				m_pCurrent = pToken;
+				ThrowError("the pit is " + to_string(PIT_X_SIZE) + "x" + to_string(PIT_Y_SIZE) + "x" + to_string(PIT_Z_SIZE));
+			}
+		}
+	}
+
+	void ParseLevels(Pit& pit)
+	{
+		size_t z = 0;
+
+		do
+		{
+			const char* pToken = m_pCurrent;
+			const Pit::LevelMask mask = ParseNumber<Pit::LevelMask>("a level mask", 16);
+
+			if ((mask & ~Pit::FULL_LEVEL_MASK) != 0)
+			{
+				m_pCurrent = pToken;
+				ThrowError("the level mask has cells outside the pit");
+			}
+
+			size_t count = 1;
+
+			if (Skip('*'))
+			{
+				count = ParseNumber<size_t>("a levels count", 10);
+			}
+
+			if (count > PIT_Z_SIZE - z)
+			{
+				m_pCurrent = pToken;
+				ThrowError("more than " + to_string(PIT_Z_SIZE) + " levels");
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				pit.OccupyCells(z++, mask);
+			}
+		}
+		while (Skip('/'));
+
+		if (z != PIT_Z_SIZE)
+		{
+			ThrowError(to_string(z) + " levels instead of " + to_string(PIT_Z_SIZE));
+		}
+	}
+
+	int ParseKind()
+	{
+		const char* pToken = m_pCurrent;
+		const unsigned kind = ParseNumber<unsigned>("a shape kind", 10);
+
+		if (kind > unsigned(INT_MAX))
+		{
+			m_pCurrent = pToken;
+			ThrowError("the shape kind is out of range");
+		}
+
+		return int(kind);
+	}
+
+	template <typename NumberType>
+	NumberType ParseNumber(const char* what, int base)
+	{
+		NumberType number = 0;
+
+		// from_chars takes a minus sign, but no plus sign and no 0x prefix
+		const from_chars_result result = from_chars(m_pCurrent, m_pEnd, number, base);
+
+		if (result.ec == errc::result_out_of_range)
+		{
+			ThrowError(string(what) + " out of range");
+		}
+
+		if (result.ec != errc())
+		{
+			ThrowError(string("expected ") + what);
+		}
+
+		m_pCurrent = result.ptr;
+		return number;
+	}
+
+	bool Skip(char character)
+	{
+		if (m_pCurrent != m_pEnd && *m_pCurrent == character)
+		{
+			++m_pCurrent;
+			return true;
+		}
+
+		return false;
+	}
+
+	void Expect(char character, const char* what)
+	{
+		if (!Skip(character))
+		{
+			ThrowError(string("expected ") + what);
+		}
+	}
+
+	void ThrowError(const string& message) const
+	{
+		throw NotationError(size_t(m_pCurrent - m_pStart) + 1, message);
+	}
+
+	const char* m_pStart;
+	const char* m_pCurrent;
+	const char* m_pEnd;
+};
+
+void AppendDecimal(string& text, int64_t number)
+{
+	char digits[24];
+	const to_chars_result result = to_chars(digits, digits + sizeof(digits), number);
+	text.append(digits, result.ptr);
+}
+
+void AppendHexadecimal(string& text, uint64_t number)
+{
+	char digits[16];
+	char* pDigit = digits + sizeof(digits);
+
+	do
+	{
+		*--pDigit = HEX_DIGITS[number & 0xF];
+		number >>= 4;
+	}
+	while (number != 0);
+
+	text.append(pDigit, digits + sizeof(digits));
+}
+
+}
+
+// GamePosition
+
+GamePosition::GamePosition()
+	: ShapeKind(-1)
+	, NextShapeKind(-1)
+	, Orientation(0)
+	, ShapeX(int(PIT_X_SIZE / 2))
+	, ShapeY(int(PIT_Y_SIZE / 2))
+	, ShapeZ(0)
+	, Score(0)
+	, Level(0)
+	, RandomState(1)
+{
+}
+
+// NotationError
+
+NotationError::NotationError(size_t column, const string& message)
+	: runtime_error("column " + to_string(column) + ": " + message)
+	, m_Column(column)
+{
+}
+
+size_t NotationError::GetColumn() const
+{
+	return m_Column;
+}
+
+// PositionNotation
+
+GamePosition PositionNotation::Parse(const string& text)
+{
+	return Parse(text.data(), text.size());
+}
+
+GamePosition PositionNotation::Parse(const char* pText, size_t size)
+{
+	Parser parser(pText, size);
+	return parser.Parse();
+}
+
+string PositionNotation::Print(const GamePosition& position)
+{
+	string text;
+	Print(position, text);
+	return text;
+}
+
+void PositionNotation::Print(const GamePosition& position, string& text)
+{
+	AppendDecimal(text, PIT_X_SIZE);
+	text += 'x';
+	AppendDecimal(text, PIT_Y_SIZE);
+	text += 'x';
+	AppendDecimal(text, PIT_Z_SIZE);
+	text += ' ';
+
+	for (size_t z = 0; z < PIT_Z_SIZE; )
+	{
+		const Pit::LevelMask mask = position.Stack.GetLevelMask(z);
+		size_t count = 1;
+
+		while (z + count < PIT_Z_SIZE && position.Stack.GetLevelMask(z + count) == mask)
+		{
+			++count;
+		}
+
+		if (z > 0)
+		{
+			text += '/';
+		}
+
+		AppendHexadecimal(text, mask);
+
+		if (count > 1)
+		{
+			text += '*';
+			AppendDecimal(text, int64_t(count));
+		}
+
+		z += count;
+	}
+
+	text += ' ';
+
+	if (position.ShapeKind >= 0)
+	{
+		AppendDecimal(text, position.ShapeKind);
+		text += ':';
+		AppendDecimal(text, position.Orientation);
+		text += '@';
+		AppendDecimal(text, position.ShapeX);
+		text += ',';
+		AppendDecimal(text, position.ShapeY);
+		text += ',';
+		AppendDecimal(text, position.ShapeZ);
+	}
+	else
+	{
+		text += '-';
+	}
+
+	text += ' ';
+
+	if (position.NextShapeKind >= 0)
+	{
+		AppendDecimal(text, position.NextShapeKind);
+	}
+	else
+	{
+		text += '-';
+	}
+
+	text += ' ';
+	AppendDecimal(text, position.Score);
+	text += ' ';
+	AppendDecimal(text, position.Level);
+	text += ' ';
+	AppendHexadecimal(text, position.RandomState);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Pit.h"
+
+// what it takes to go on with a game from any point, see Game::SetPosition
+struct GamePosition
+{
+	GamePosition();
+
+	Pit Stack;
+
+	// kinds of the current shape set, -1 to draw a random one
+	int ShapeKind;
+	int NextShapeKind;
+
+	// of the current shape, index in the orientation table of its kind
+	unsigned Orientation;
+	// of its pivot cube
+	int ShapeX, ShapeY, ShapeZ;
+
+	unsigned Score;
+	unsigned Level;
+
+	// of the random numbers the next shapes are drawn with, never zero
+	uint64_t RandomState;
+};
+
+// syntax or range error in a position, the column is 1-based
+class NotationError : public std::runtime_error
+{
+public:
+	NotationError(size_t column, const std::string& message);
+
+	size_t GetColumn() const;
+
+private:
+	size_t m_Column;
+};
+
+// A position in one line, like FEN does for chess:
+//
+//   5x5x12 0*8/1fffffe/1ffffbf/1ffefff/ffffff 5:3@2,2,0 1 40 2 9e3779b97f4a7c15
+//
+// Fields are separated by one space: the pit size; the levels from the
+// top one down as hexadecimal masks (bit y * X + x), separated by '/',
+// where m*n stands for n levels with mask m; the current shape as
+// kind:orientation@x,y,z of its pivot cube, or '-'; the next shape kind
+// or '-'; the score; the level and the state of the random numbers in
+// hexadecimal. Everything after the levels may be left out together, for
+// the default values of GamePosition. The parser allocates only to throw
+// and the printer writes runs of equal levels with '*'.
+class PositionNotation
+{
+public:
+	// throws NotationError
+	static GamePosition Parse(const std::string& text);
+	static GamePosition Parse(const char* pText, size_t size);
+
+	static std::string Print(const GamePosition& position);
+	// appends, so a buffer can be reused
+	static void Print(const GamePosition& position, std::string& text);
+};
@@ -0,0 +1,35 @@
+#include "pch.h"
+#include "Random.h"
+
+Random::Random(uint64_t seed)
+{
+	Seed(seed);
+}
+
+void Random::Seed(uint64_t seed)
+{
+	m_State = seed ? seed : 0x9E3779B97F4A7C15ull;
+}
+
+uint64_t Random::GetState() const
+{
+	return m_State;
+}
+
+uint32_t Random::Next()
+{
+	m_State ^= m_State >> 12;
+	m_State ^= m_State << 25;
+	m_State ^= m_State >> 27;
+
+	// the high bits are the good ones
+	return uint32_t((m_State * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+unsigned Random::Next(unsigned bound)
+{
+	assert(bound > 0);
+
+	// multiply and shift instead of a modulo, the bias is below 2^-32 * bound
+	return unsigned((uint64_t(Next()) * bound) >> 32);
+}
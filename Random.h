@@ -0,0 +1,24 @@
+#pragma once
+
+// Small, fast pseudo random numbers, xorshift64* (Vigna). Unlike rand() the
+// sequence of a seed is the same with every compiler and CRT, so seeded
+// benchmarks and replays see the same games everywhere.
+class Random
+{
+public:
+	explicit Random(uint64_t seed = 1);
+
+	// a zero seed is replaced, xorshift never leaves zero
+	void Seed(uint64_t seed);
+
+	// never zero, Seed(GetState()) goes on with the same sequence
+	uint64_t GetState() const;
+
+	uint32_t Next();
+
+	// in [0, bound), bound must not be 0
+	unsigned Next(unsigned bound);
+
+private:
+	uint64_t m_State;
+};
@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "RenderQueue.h"
+
+using namespace std;
+
+namespace
+{
+
+const VertexFormat PASS_VERTEX_FORMATS[RENDER_PASSES_COUNT] =
+{
+	VERTEX_FORMAT_POSITION,
+	VERTEX_FORMAT_INSTANCED,
+	VERTEX_FORMAT_INSTANCED,
+	VERTEX_FORMAT_COLORED,
+	VERTEX_FORMAT_COLORED,
+	VERTEX_FORMAT_TEXT,
+};
+
+const size_t VERTEX_SIZES[VERTEX_FORMATS_COUNT] =
+{
+	sizeof(Vertex),
+	sizeof(Vertex),
+	sizeof(ColoredVertex),
+	sizeof(TextVertex),
+};
+
+// negative, zero or positive like memcmp, for any two values of a type
+template <typename T>
+int CompareBytes(const T& first, const T& second)
+{
+	return memcmp(&first, &second, sizeof(T));
+}
+
+// the fields are in the order of how much their change costs
+class DrawItemOrder
+{
+public:
+	DrawItemOrder(const vector<DrawItem>& items)
+		: m_Items(items)
+	{
+	}
+
+	bool operator () (unsigned first, unsigned second) const
+	{
+		const DrawItem& a = m_Items[first];
+		const DrawItem& b = m_Items[second];
+
+		if (a.Layer != b.Layer)
+		{
+			return a.Layer < b.Layer;
+		}
+
+		if (a.Layer != RENDER_LAYER_TRANSPARENT)
+		{
+			if (a.Pass != b.Pass) return a.Pass < b.Pass;
+			if (a.pTexture != b.pTexture) return less<RenderTexture*>()(a.pTexture, b.pTexture);
+			if (a.pVertexBuffer != b.pVertexBuffer) return less<RenderBuffer*>()(a.pVertexBuffer, b.pVertexBuffer);
+			if (a.pInstanceBuffer != b.pInstanceBuffer) return less<RenderBuffer*>()(a.pInstanceBuffer, b.pInstanceBuffer);
+			if (a.pIndexBuffer != b.pIndexBuffer) return less<RenderBuffer*>()(a.pIndexBuffer, b.pIndexBuffer);
+			if (a.Topology != b.Topology) return a.Topology < b.Topology;
+
+			int world = CompareBytes(a.World, b.World);
+			if (world != 0) return world < 0;
+
+			int color = CompareBytes(a.DrawColor, b.DrawColor);
+			if (color != 0) return color < 0;
+		}
+
+		// equal state keeps the submission order
+		return first < second;
+	}
+
+private:
+	const vector<DrawItem>& m_Items;
+};
+
+}
+
+VertexFormat GetPassVertexFormat(RenderPass pass)
+{
+	assert(pass < RENDER_PASSES_COUNT);
+	return PASS_VERTEX_FORMATS[pass];
+}
+
+size_t GetVertexSize(VertexFormat format)
+{
+	assert(format < VERTEX_FORMATS_COUNT);
+	return VERTEX_SIZES[format];
+}
+
+// DrawItem
+
+DrawItem::DrawItem()
+	: Layer(RENDER_LAYER_FACES)
+	, Pass(RENDER_PASS_SOLID)
+	, pVertexBuffer(nullptr)
+	, pInstanceBuffer(nullptr)
+	, InstanceSize(0)
+	, pIndexBuffer(nullptr)
+	, pTexture(nullptr)
+	, Topology(TOPOLOGY_TRIANGLE_LIST)
+	, DrawColor(BLACK)
+	, IndicesCount(0)
+	, StartIndex(0)
+	, BaseVertex(0)
+	, InstancesCount(0)
+{
+	MatrixIdentity(&World);
+}
+
+// RenderQueue
+
+void RenderQueue::Submit(const DrawItem& item)
+{
+	assert(item.Layer < RENDER_LAYERS_COUNT && item.Pass < RENDER_PASSES_COUNT);
+	assert(item.pVertexBuffer && item.pIndexBuffer);
+	assert((GetPassVertexFormat(item.Pass) == VERTEX_FORMAT_INSTANCED) == (item.pInstanceBuffer != nullptr));
+	assert((item.pInstanceBuffer != nullptr) == (item.InstancesCount > 0));
+	assert((item.Pass == RENDER_PASS_TEXT) == (item.pTexture != nullptr));
+
+	m_Items.push_back(item);
+}
+
+void RenderQueue::Flush(Renderer& renderer)
+{
+	m_Order.resize(m_Items.size());
+
+	for (size_t i = 0; i < m_Order.size(); ++i)
+	{
+		m_Order[i] = unsigned(i);
+	}
+
+	sort(m_Order.begin(), m_Order.end(), DrawItemOrder(m_Items));
+
+	renderer.BeginFrame();
+
+	const DrawItem* pPrevious = nullptr;
+	bool isPassApplied = false;
+
+	for (size_t i = 0; i < m_Order.size(); ++i)
+	{
+		const DrawItem& item = m_Items[m_Order[i]];
+		VertexFormat format = GetPassVertexFormat(item.Pass);
+
+		if (!pPrevious
+			|| format != GetPassVertexFormat(pPrevious->Pass)
+			|| item.pVertexBuffer != pPrevious->pVertexBuffer
+			|| item.pInstanceBuffer != pPrevious->pInstanceBuffer
+			|| item.InstanceSize != pPrevious->InstanceSize)
+		{
+			renderer.SetVertexBuffers(format, item.pVertexBuffer, item.pInstanceBuffer, item.InstanceSize);
+		}
+
+		if (!pPrevious || item.pIndexBuffer != pPrevious->pIndexBuffer)
+		{
+			renderer.SetIndexBuffer(item.pIndexBuffer);
+		}
+
+		if (!pPrevious || item.Topology != pPrevious->Topology)
+		{
+			renderer.SetTopology(item.Topology);
+		}
+
+		// a changed constant or texture is bound by the next apply of the pass
+		if (item.pTexture && (!pPrevious || item.pTexture != pPrevious->pTexture))
+		{
+			renderer.SetTexture(item.pTexture);
+			isPassApplied = false;
+		}
+
+		if (!pPrevious || CompareBytes(item.World, pPrevious->World) != 0)
+		{
+			renderer.SetWorld(item.World);
+			isPassApplied = false;
+		}
+
+		if (!pPrevious || CompareBytes(item.DrawColor, pPrevious->DrawColor) != 0)
+		{
+			renderer.SetColor(item.DrawColor);
+			isPassApplied = false;
+		}
+
+		if (!isPassApplied || item.Pass != pPrevious->Pass)
+		{
+			renderer.ApplyPass(item.Pass);
+			isPassApplied = true;
+		}
+
+		if (item.InstancesCount > 0)
+		{
+			renderer.DrawIndexedInstanced(item.IndicesCount, item.InstancesCount, item.StartIndex, item.BaseVertex);
+		}
+		else
+		{
+			renderer.DrawIndexed(item.IndicesCount, item.StartIndex, item.BaseVertex);
+		}
+
+		pPrevious = &item;
+	}
+
+	m_Items.clear();
+}
+
+size_t RenderQueue::GetItemsCount() const
+{
+	return m_Items.size();
+}
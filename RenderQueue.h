@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Renderer.h"
+
+// Draws of a frame are collected first and sent to a Renderer sorted
+// by their state, so consecutive draws sharing a pass, buffers or constants
+// bind them only once. Everything a draw needs is in its DrawItem, the
+// queue never reads back device state.
+
+// layers are drawn in this order, whatever the state of their draws
+enum RenderLayer
+{
+	RENDER_LAYER_BACKGROUND,	// lines the stack is drawn over
+	RENDER_LAYER_FACES,			// opaque faces
+	RENDER_LAYER_OUTLINES,		// lines drawn over opaque faces
+	RENDER_LAYER_TRANSPARENT,	// kept in submission order for blending
+
+	RENDER_LAYERS_COUNT
+};
+
+struct DrawItem
+{
+	DrawItem();
+
+	RenderLayer		Layer;
+	RenderPass		Pass;
+
+	RenderBuffer*	pVertexBuffer;
+	RenderBuffer*	pInstanceBuffer;	// instanced passes only
+	size_t			InstanceSize;
+	RenderBuffer*	pIndexBuffer;
+	RenderTexture*	pTexture;			// text pass only
+
+	PrimitiveTopology Topology;
+
+	// constants of the pass
+	Color			DrawColor;
+	Matrix			World;
+
+	size_t			IndicesCount;
+	size_t			StartIndex;
+	int				BaseVertex;
+	size_t			InstancesCount;		// 0 for a draw without instances
+};
+
+class RenderQueue
+{
+public:
+	void Submit(const DrawItem& item);
+
+	// sorts and draws everything submitted since the last flush
+	void Flush(Renderer& renderer);
+
+	size_t GetItemsCount() const;
+
+private:
+	typedef std::vector<DrawItem> DrawItemContainer;
+
+	// kept between frames, so a steady scene does not allocate
+	DrawItemContainer m_Items;
+	std::vector<unsigned> m_Order;
+};
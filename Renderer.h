@@ -0,0 +1,108 @@
+#pragma once
+
+// Everything the game asks of the graphics API: buffers, per-draw state
+// and constants. The game holds no device objects, so the whole frame also
+// runs with NullRenderer where there is no GPU.
+
+// created and released by the renderer, opaque to the game
+class RenderBuffer;
+class RenderTexture;
+
+enum PrimitiveTopology
+{
+	TOPOLOGY_TRIANGLE_LIST,
+	TOPOLOGY_TRIANGLE_STRIP,
+	TOPOLOGY_LINE_LIST,
+};
+
+// passes of BlockOut.fx
+enum RenderPass
+{
+	RENDER_PASS_SOLID,				// BlockOutTechnique, g_Color
+	RENDER_PASS_INSTANCED_FACES,	// InstancedTechnique, instance colors
+	RENDER_PASS_INSTANCED_OUTLINES,	// InstancedTechnique, g_Color
+	RENDER_PASS_COLORED_FACES,		// ColoredTechnique, vertex colors
+	RENDER_PASS_COLORED_OUTLINES,	// ColoredTechnique, g_Color
+	RENDER_PASS_TEXT,				// TextTechnique, vertex colors times the coverage of g_Atlas
+
+	RENDER_PASSES_COUNT
+};
+
+// input layout the vertex buffers of a pass are read with
+enum VertexFormat
+{
+	VERTEX_FORMAT_POSITION,		// Vertex
+	VERTEX_FORMAT_INSTANCED,	// Vertex and a per instance buffer
+	VERTEX_FORMAT_COLORED,		// ColoredVertex
+	VERTEX_FORMAT_TEXT,			// TextVertex
+
+	VERTEX_FORMATS_COUNT
+};
+
+VertexFormat GetPassVertexFormat(RenderPass pass);
+
+// stride of the vertex buffer, the instance buffer has its own
+size_t GetVertexSize(VertexFormat format);
+
+class Renderer
+{
+public:
+	virtual ~Renderer() {}
+
+#pragma region buffers
+
+	// immutable buffers
+	virtual RenderBuffer* CreateVertexBuffer(const void* pVertices, size_t size) = 0;
+	virtual RenderBuffer* CreateIndexBuffer(const unsigned* pIndices, size_t count) = 0;
+
+	// buffers rewritten by the CPU with UpdateDynamicBuffer
+	virtual RenderBuffer* CreateDynamicVertexBuffer(size_t size) = 0;
+	virtual RenderBuffer* CreateDynamicIndexBuffer(size_t count) = 0;
+	virtual void UpdateDynamicBuffer(RenderBuffer* pBuffer, const void* pData, size_t size) = 0;
+
+	virtual void ReleaseBuffer(RenderBuffer* pBuffer) = 0;
+
+#pragma endregion
+
+#pragma region textures
+
+	// immutable, one byte of coverage per texel, rows from the top
+	virtual RenderTexture* CreateTexture(size_t width, size_t height, const uint8_t* pCoverage) = 0;
+	virtual void ReleaseTexture(RenderTexture* pTexture) = 0;
+
+#pragma endregion
+
+#pragma region draw submission
+
+	// Calls come from RenderQueue::Flush with only the state that differs
+	// from the previous draw. Constants are uploaded by ApplyPass, so it
+	// follows every change of them.
+
+	// called at the start of every flush, device state is unknown then
+	virtual void BeginFrame() = 0;
+
+	virtual void SetVertexBuffers(VertexFormat format, RenderBuffer* pVertexBuffer, RenderBuffer* pInstanceBuffer, size_t instanceSize) = 0;
+	virtual void SetIndexBuffer(RenderBuffer* pIndexBuffer) = 0;
+	virtual void SetTopology(PrimitiveTopology topology) = 0;
+
+	// read by the text pass, bound by ApplyPass like the constants
+	virtual void SetTexture(RenderTexture* pTexture) = 0;
+
+	virtual void ApplyPass(RenderPass pass) = 0;
+
+	virtual void DrawIndexed(size_t indicesCount, size_t startIndex, int baseVertex) = 0;
+	virtual void DrawIndexedInstanced(size_t indicesCount, size_t instancesCount, size_t startIndex, int baseVertex) = 0;
+
+#pragma endregion
+
+#pragma region constants
+
+	// per draw
+	virtual void SetColor(const Color& color) = 0;
+	virtual void SetWorld(const Matrix& world) = 0;
+
+	// per camera
+	virtual void SetViewProjection(const Matrix& viewProjection) = 0;
+
+#pragma endregion
+};
@@ -1,15 +1,35 @@
 #include "pch.h"
 #include "Shape.h"
 #include "Grid.h"
+#include "ShapeFactory.h"
+#include "ShapeGeometry.h"
+#include "ShapeOrientation.h"
 
-void Shape::Draw() const
+Shape::~Shape()
 {
-	SetWorldTransformation();
-	SetVertexBuffer(m_pVertexBuffer);
-	// draw border
-	DrawLines(m_pLineIndexBuffer, m_LinesCount, WHITE);
+	if (m_pGeometry)
+	{
+		m_pGeometry->Release();
+	}
+}
+
+void Shape::Publish(ShapeSnapshot& snapshot) const
+{
+	snapshot.pGeometry = m_pGeometry;
+	snapshot.World = GetWorldMatrix();
+	snapshot.ShapeColor = m_Color;
+}
+
+void Shape::Draw(const ShapeSnapshot& snapshot)
+{
+	const ShapeGeometry* pGeometry = snapshot.pGeometry;
+
+	SetWorldTransformation(snapshot.World);
+	SetVertexBuffer(pGeometry->GetVertexBuffer());
+	// draw border, before the translucent faces so the far edges show through
+	DrawLines(pGeometry->GetLinesIndexBuffer(), pGeometry->GetLinesCount(), WHITE, RENDER_LAYER_TRANSPARENT);
 	// draw shape
-	DrawTriangles(m_pTriangleIndexBuffer, m_TrianglesCount, m_Color);
+	DrawTriangles(pGeometry->GetTrianglesIndexBuffer(), pGeometry->GetTrianglesCount(), snapshot.ShapeColor, RENDER_LAYER_TRANSPARENT);
 }
 
 void Shape::Update(float time)
@@ -24,14 +44,14 @@ void Shape::Update(float time)
 		case TRANSLATION:
 			{
 				Vector3 position;
-				D3DXVec3Lerp(&position, &m_StartPosition, &m_FinalPosition, m_InterpolationRatio);
+				Vec3Lerp(&position, &m_StartPosition, &m_FinalPosition, m_InterpolationRatio);
 				SetPosition(position);
 			}
 			break;
 		case ROTATION:
 			{
 				Quaternion rotation;
-				D3DXQuaternionSlerp(&rotation, &m_StartRotation, &m_FinalRotation, m_InterpolationRatio);
+				QuaternionSlerp(&rotation, &m_StartRotation, &m_FinalRotation, m_InterpolationRatio);
 				SetRotation(rotation);
 			}
 			break;
@@ -62,7 +82,7 @@ void Shape::Destroy()
 		}
 	}
 
-	delete this;
+	ShapeFactory::RecycleShape(this);
 }
 
 bool Shape::IsAnimationStarted() const
@@ -114,54 +134,54 @@ bool Shape::TryToTranslate(float x, float y, float z)
 bool Shape::TryToRotate(float x, float y, float z)
 {
 	Matrix rotation;
-	D3DXMatrixRotationYawPitchRoll(&rotation, y, x, z);
-
-	CubesContainer oldCubesRelativePositions = m_CubesRelativePositions;
+	MatrixRotationYawPitchRoll(&rotation, y, x, z);
 
-	CubesContainer::iterator it = m_CubesRelativePositions.begin();
-	for ( ; it != m_CubesRelativePositions.end(); ++it)
-	{
-		D3DXVec3TransformCoord(&*it, &*it, &rotation);
-
-		it->x = float(Round(it->x));
-		it->y = float(Round(it->y));
-		it->z = float(Round(it->z));
-	}
+	// same size as the cubes, so the copy reuses the capacity
+	m_PreviousCubesRelativePositions = m_CubesRelativePositions;
+	RotateCubes(rotation);
 
 	if (!IsMovePosible())
 	{
-		m_CubesRelativePositions = oldCubesRelativePositions;
+		m_CubesRelativePositions.swap(m_PreviousCubesRelativePositions);
 		return false;
 	}
 	else
 	{
 		Quaternion qu;
-		D3DXQuaternionRotationMatrix(&qu, &rotation);
+		QuaternionRotationMatrix(&qu, &rotation);
 		StartToRotate(qu, ANIMATION_TIME_DURATION);
 		return true;
 	}
 }
 
-Shape::Shape(	
-	ID3D10Buffer* pVertexBuffer,
-	ID3D10Buffer* pTriangleIndexBuffer,
-	ID3D10Buffer* pLineIndexBuffer,
-	size_t trianglesCount,
-	size_t linesCount,
-	const CubesContainer& cubes,
-	const Color& color /*= Color(1.0f, 1.0f, 1.0f, 0.25f*/
-)
-		: GameObject(color)
-		, m_pVertexBuffer(pVertexBuffer)
-		, m_pTriangleIndexBuffer(pTriangleIndexBuffer)
-		, m_pLineIndexBuffer(pLineIndexBuffer)
-		, m_TrianglesCount(trianglesCount)
-		, m_LinesCount(linesCount)
-		, m_CubesRelativePositions(cubes)
-		, m_IsAnimationStarted(false)
-		, m_CurrentTimeFromStartOfAnimation(0.0f)
-		, m_PositionInGrid(float(Grid::X_SIZE / 2), float(Grid::Y_SIZE / 2), 0.0f)
+Shape::Shape(const ShapeGeometry* pGeometry)
+	: m_pGeometry(nullptr)
+{
+	// enough for every shape with an orientation table
+	m_CubesRelativePositions.reserve(MAX_SHAPE_CUBES);
+	m_PreviousCubesRelativePositions.reserve(MAX_SHAPE_CUBES);
+
+	Reset(pGeometry);
+}
+
+void Shape::Reset(const ShapeGeometry* pGeometry)
 {
+	pGeometry->AddRef();
+
+	if (m_pGeometry)
+	{
+		m_pGeometry->Release();
+	}
+
+	m_pGeometry = pGeometry;
+	m_CubesRelativePositions = pGeometry->GetCubesRelativePositions();
+	m_PositionInGrid = Vector3(float(Grid::X_SIZE / 2), float(Grid::Y_SIZE / 2), 0.0f);
+
+	m_IsAnimationStarted = false;
+	m_CurrentTimeFromStartOfAnimation = 0.0f;
+
+	SetColor(Color(1.0f, 1.0f, 1.0f, 0.25f));
+	SetWorldTransformationToIdentity();
 }
 
 bool Shape::IsMovePosible() const
@@ -187,6 +207,146 @@ bool Shape::IsMovePosible() const
 	return true;
 }
 
+int Shape::GetOrientation() const
+{
+	const ShapeOrientationTable* pOrientations = m_pGeometry->GetOrientations();
+
+	if (!pOrientations)
+	{
+		return -1;
+	}
+
+	for (size_t i = 0; i < pOrientations->Count; ++i)
+	{
+		const ShapeOrientation& orientation = pOrientations->Orientations[i];
+		bool hasSameCubes = orientation.CubesCount == m_CubesRelativePositions.size();
+
+		// both have distinct cubes, so containing all of them is enough
+		for (size_t cube = 0; cube < m_CubesRelativePositions.size() && hasSameCubes; ++cube)
+		{
+			const Vector3& position = m_CubesRelativePositions[cube];
+			hasSameCubes = false;
+
+			for (size_t other = 0; other < orientation.CubesCount && !hasSameCubes; ++other)
+			{
+				hasSameCubes = Round(position.x) == orientation.Cubes[other][0] &&
+					Round(position.y) == orientation.Cubes[other][1] &&
+					Round(position.z) == orientation.Cubes[other][2];
+			}
+		}
+
+		if (hasSameCubes)
+		{
+			return int(i);
+		}
+	}
+
+	return -1;
+}
+
+const Vector3& Shape::GetPositionInGrid() const
+{
+	return m_PositionInGrid;
+}
+
+void Shape::Place(unsigned orientation, const Vector3& positionInGrid)
+{
+	const ShapeOrientationTable* pOrientations = m_pGeometry->GetOrientations();
+	const int currentOrientation = GetOrientation();
+
+	assert(pOrientations && orientation < pOrientations->Count && currentOrientation >= 0);
+
+	// a move still animated ends at once
+	if (m_IsAnimationStarted)
+	{
+		if (m_AnimationType == TRANSLATION)
+		{
+			SetPosition(m_FinalPosition);
+		}
+		else
+		{
+			SetRotation(m_FinalRotation);
+		}
+
+		m_IsAnimationStarted = false;
+	}
+
+	// the quarter turns from the current orientation, breadth first
+	uint8_t previous[MAX_SHAPE_ORIENTATIONS];
+	uint8_t turns[MAX_SHAPE_ORIENTATIONS];
+	bool isReached[MAX_SHAPE_ORIENTATIONS] = {};
+
+	uint8_t queue[MAX_SHAPE_ORIENTATIONS];
+	size_t queueSize = 0;
+
+	queue[queueSize++] = uint8_t(currentOrientation);
+	isReached[currentOrientation] = true;
+
+	for (size_t i = 0; i < queueSize && !isReached[orientation]; ++i)
+	{
+		for (int rotation = 0; rotation < SHAPE_ROTATIONS_COUNT; ++rotation)
+		{
+			const uint8_t next = pOrientations->Orientations[queue[i]].Rotations[rotation];
+
+			if (!isReached[next])
+			{
+				isReached[next] = true;
+				previous[next] = queue[i];
+				turns[next] = uint8_t(rotation);
+				queue[queueSize++] = next;
+			}
+		}
+	}
+
+	uint8_t path[MAX_SHAPE_ORIENTATIONS];
+	size_t pathLength = 0;
+
+	for (unsigned at = orientation; at != unsigned(currentOrientation); at = previous[at])
+	{
+		path[pathLength++] = turns[at];
+	}
+
+	// the angles of the rotation keys, see Game::Update
+	static const float ANGLES[SHAPE_ROTATIONS_COUNT][3] =
+	{
+		{ -PI_HALF, 0.0f, 0.0f }, { PI_HALF, 0.0f, 0.0f },
+		{ 0.0f, -PI_HALF, 0.0f }, { 0.0f, PI_HALF, 0.0f },
+		{ 0.0f, 0.0f, -PI_HALF }, { 0.0f, 0.0f, PI_HALF },
+	};
+
+	Quaternion worldRotation = GetRotation();
+
+	while (pathLength > 0)
+	{
+		const float* angles = ANGLES[path[--pathLength]];
+
+		Matrix rotation;
+		MatrixRotationYawPitchRoll(&rotation, angles[1], angles[0], angles[2]);
+		RotateCubes(rotation);
+
+		Quaternion qu;
+		QuaternionRotationMatrix(&qu, &rotation);
+		worldRotation = worldRotation * qu;
+	}
+
+	SetRotation(worldRotation);
+	SetPosition(GetPosition() + positionInGrid - m_PositionInGrid);
+	m_PositionInGrid = positionInGrid;
+}
+
+void Shape::RotateCubes(const Matrix& rotation)
+{
+	CubesContainer::iterator it = m_CubesRelativePositions.begin();
+	for ( ; it != m_CubesRelativePositions.end(); ++it)
+	{
+		Vec3TransformCoord(&*it, &*it, &rotation);
+
+		it->x = float(Round(it->x));
+		it->y = float(Round(it->y));
+		it->z = float(Round(it->z));
+	}
+}
+
 void Shape::StartToTranslate( const Vector3& translation, float animationTime )
 {
 	m_AnimationTime = animationTime;
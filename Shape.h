@@ -1,15 +1,25 @@
 #pragma once
 
 #include "GameObject.h"
+#include "GameSnapshot.h"
+
+class ShapeGeometry;
 
 class Shape : public GameObject
 {
 	friend class ShapeFactory;
+	friend class ShapeGeometry;
 
 public:
-	virtual void Draw() const;
+	virtual ~Shape();
+
+	// copies what the shape is drawn from
+	void Publish(ShapeSnapshot& snapshot) const;
+	static void Draw(const ShapeSnapshot& snapshot);
 
 	void Update(float time);
+	// leaves the cubes in the grid and hands the shape back to the
+	// ShapeFactory, which reuses it for a later shape
 	void Destroy();
 
 	bool IsAnimationStarted() const;
@@ -20,29 +30,39 @@ public:
 	bool TryToTranslate(float x, float y, float z);
 	bool TryToRotate(float x, float y, float z);
 
+	// whether the cubes fit in the grid where the shape is now
+	bool IsMovePosible() const;
+
+	// index in the orientation table of the geometry, -1 without a table
+	int GetOrientation() const;
+	// of the pivot cube
+	const Vector3& GetPositionInGrid() const;
+
+	// turns the shape into the orientation of the table with its quarter
+	// turns and moves the pivot cube to the cell, without animation and
+	// without checking the grid
+	void Place(unsigned orientation, const Vector3& positionInGrid);
+
 private:
 
 	typedef std::vector<Vector3> CubesContainer;
 
-	Shape(ID3D10Buffer* pVertexBuffer,
-		  ID3D10Buffer* pTriangleIndexBuffer,
-		  ID3D10Buffer* pLineIndexBuffer,
-		  size_t trianglesCount,
-		  size_t linesCount,
-		  const CubesContainer& cubes,
-		  const Color& color = Color(1.0f, 1.0f, 1.0f, 0.25f));
+	Shape(const ShapeGeometry* pGeometry);
 
-	bool IsMovePosible() const;
+	// into a new shape of the geometry at the initial position, keeping the
+	// transform slot and the capacity of the cube containers
+	void Reset(const ShapeGeometry* pGeometry);
 
-	ID3D10Buffer* m_pVertexBuffer;
-	ID3D10Buffer* m_pTriangleIndexBuffer;
-	ID3D10Buffer* m_pLineIndexBuffer;
+	// around the pivot cube, rounded back to whole cells
+	void RotateCubes(const Matrix& rotation);
 
-	size_t m_TrianglesCount;
-	size_t m_LinesCount;
+	// shared with every other shape of the same kind
+	const ShapeGeometry* m_pGeometry;
 
 	Vector3 m_PositionInGrid;
 	CubesContainer m_CubesRelativePositions;
+	// the cubes before the last rotation, to take it back without allocating
+	CubesContainer m_PreviousCubesRelativePositions;
 
 #pragma region animation
 
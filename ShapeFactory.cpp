@@ -1,118 +1,86 @@
 #include "pch.h"
 #include "ShapeFactory.h"
+#include "ShapeLibrary.h"
 #include "Shape.h"
+#include "ShapeGeometry.h"
+#include "Random.h"
+#include "AllocationTracker.h"
 
 using namespace std;
 
-void ShapeFactory::LoadShapeSetFromFile( const std::string& fileName )
+void ShapeFactory::SetShapeSet( const ShapeSet* pShapeSet )
 {
-	ifstream file(fileName.c_str());
-
-	if (file.fail())
-	{
-		::MessageBox(0, ("Missing file " + fileName).c_str(), "Error", MB_ICONERROR);
-		exit(1);
-	}
-
-	size_t shapesCount;
-	file >> shapesCount;
-
-	m_Shapes.resize(shapesCount);
-
-	for (size_t i = 0; i < shapesCount; ++i)
-	{
-		LoadShape(file, m_Shapes[i]);
-	}
-
-	file.close();
+	assert(pShapeSet && pShapeSet->GetShapesCount() > 0);
+	m_pShapeSet = pShapeSet;
 }
 
-Shape* ShapeFactory::CreateShape( unsigned shapeKind )
+const ShapeSet* ShapeFactory::GetShapeSet()
 {
-	return NewShape(m_Shapes[shapeKind]);
+	return m_pShapeSet;
 }
 
-Shape* ShapeFactory::CreateRandomShape()
+Shape* ShapeFactory::CreateShape( unsigned shapeKind )
 {
-	return NewShape(m_Shapes[rand() % m_Shapes.size()]);
+	assert(m_pShapeSet);
+	return NewShape(m_pShapeSet->GetShape(shapeKind));
 }
 
-void ShapeFactory::ReleaseBuffers()
+Shape* ShapeFactory::CreateRandomShape(Random& random)
 {
-	for (ShapesDataContainer::iterator it = m_Shapes.begin(); it != m_Shapes.end(); ++it)
-	{
-		SafeRelease(it->pVertexBuffer);
-		SafeRelease(it->pLinesIndexBuffer);
-		SafeRelease(it->pTrianglesIndexBuffer);
-	}
+	assert(m_pShapeSet);
+	return NewShape(m_pShapeSet->GetShape(random.Next(unsigned(m_pShapeSet->GetShapesCount()))));
 }
 
-void ShapeFactory::LoadShape( istream& stream, ShapeData& shapeData )
+int ShapeFactory::GetShapeKind(const Shape& shape)
 {
-	// LOAD VERTICES
-
-	size_t verticesCount;
-	stream >> verticesCount;
-
-	vector<Vertex> vertices;
+	assert(m_pShapeSet);
 
-	for (size_t i = 0; i < verticesCount; ++i)
+	for (unsigned kind = 0; kind < m_pShapeSet->GetShapesCount(); ++kind)
 	{
-		Vector3 position;
-		stream >> position;
-		vertices.push_back(Vertex(position));
+		if (m_pShapeSet->GetShape(kind) == shape.m_pGeometry)
+		{
+			return int(kind);
+		}
 	}
 
-	// LOAD TRIANGLE INDICES
-
-	stream >> shapeData.TrianglesCount;
-
-	vector<unsigned> triangleIndices(shapeData.TrianglesCount * 3);
-
-	for (size_t i = 0; i < shapeData.TrianglesCount * 3; ++i)
-	{
-		stream >> triangleIndices[i];
-	}
+	return -1;
+}
 
-	// LOAD LINE INDICES
+void ShapeFactory::RecycleShape(Shape* pShape)
+{
+	assert(pShape);
 
-	stream >> shapeData.LinesCount;
+	pShape->m_pGeometry->Release();
+	pShape->m_pGeometry = nullptr;
 
-	vector<unsigned> lineIndices(shapeData.LinesCount * 2);
+	m_RecycledShapes.push_back(pShape);
+}
 
-	for (size_t i = 0; i < shapeData.LinesCount * 2; ++i)
+void ShapeFactory::DeleteRecycledShapes()
+{
+	for (size_t i = 0; i < m_RecycledShapes.size(); ++i)
 	{
-		stream >> lineIndices[i];
+		delete m_RecycledShapes[i];
 	}
 
-	// LOAD COMPOUND CUBES POSITIONS
-
-	size_t cubesCount;
-	stream >> cubesCount;
+	m_RecycledShapes.clear();
+}
 
-	shapeData.CubesRelativePositions.resize(cubesCount);
+Shape* ShapeFactory::NewShape(const ShapeGeometry* pGeometry)
+{
+	AllocationScope allocationScope(ALLOCATION_TAG_SHAPES);
 
-	for (size_t i = 0; i < cubesCount; ++i)
+	if (m_RecycledShapes.empty())
 	{
-		stream >> shapeData.CubesRelativePositions[i];
+		return new Shape(pGeometry);
 	}
 
-	// CREATE BUFFERS
+	Shape* pShape = m_RecycledShapes.back();
+	m_RecycledShapes.pop_back();
 
-	Shape::CreateVertexBuffer(shapeData.pVertexBuffer, &vertices.front(), verticesCount);
-	Shape::CreateIndexBuffer(shapeData.pTrianglesIndexBuffer, &triangleIndices.front(), shapeData.TrianglesCount * 3);
-	Shape::CreateIndexBuffer(shapeData.pLinesIndexBuffer, &lineIndices.front(), shapeData.LinesCount * 2);
-}
-
-Shape* ShapeFactory::NewShape(const ShapeData& shapeData)
-{
-	return new Shape(
-		shapeData.pVertexBuffer,
-		shapeData.pTrianglesIndexBuffer,
-		shapeData.pLinesIndexBuffer,
-		shapeData.TrianglesCount,
-		shapeData.LinesCount,
-		shapeData.CubesRelativePositions);
+	pShape->Reset(pGeometry);
+	return pShape;
 }
 
-std::vector<ShapeFactory::ShapeData> ShapeFactory::m_Shapes;
+const ShapeSet* ShapeFactory::m_pShapeSet = nullptr;
+vector<Shape*> ShapeFactory::m_RecycledShapes;
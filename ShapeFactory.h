@@ -1,33 +1,32 @@
 #pragma once
 
 class Shape;
+class ShapeSet;
+class ShapeGeometry;
+class Random;
 
 class ShapeFactory
 {
 public:
-	static void LoadShapeSetFromFile(const std::string& fileName);
-	static Shape* CreateShape(unsigned shapeKind);
-	static Shape* CreateRandomShape();
-
-	static void ReleaseBuffers();
-
-private:
+	// selects the set new shapes are created from, see ShapeLibrary
+	static void SetShapeSet(const ShapeSet* pShapeSet);
+	static const ShapeSet* GetShapeSet();
 
-	struct ShapeData
-	{
-		ID3D10Buffer* pVertexBuffer;
-		ID3D10Buffer* pTrianglesIndexBuffer;
-		ID3D10Buffer* pLinesIndexBuffer;
+	static Shape* CreateShape(unsigned shapeKind);
+	static Shape* CreateRandomShape(Random& random);
 
-		size_t TrianglesCount;
-		size_t LinesCount;
+	// -1 for shapes of another set
+	static int GetShapeKind(const Shape& shape);
 
-		std::vector<Vector3> CubesRelativePositions;
-	};
+	// Shapes are created for every piece, so they are kept for reuse instead
+	// of deleted and a game in progress creates them without allocating.
+	// Recycled shapes hold no geometry, the shape sets may go meanwhile.
+	static void RecycleShape(Shape* pShape);
+	static void DeleteRecycledShapes();
 
-	static void LoadShape(std::istream& stream, ShapeData& shapeData);
-	static Shape* NewShape(const ShapeData& shapeData);
+private:
+	static Shape* NewShape(const ShapeGeometry* pGeometry);
 
-	typedef std::vector<ShapeData> ShapesDataContainer;
-	static ShapesDataContainer m_Shapes;
+	static const ShapeSet* m_pShapeSet;
+	static std::vector<Shape*> m_RecycledShapes;
 };
@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "ShapeGeometry.h"
+#include "Shape.h"
+#include "ShapeSetImage.h"
+#include "ShapeOrientation.h"
+
+using namespace std;
+
+ShapeGeometry::ShapeGeometry(const ShapeGeometryView& view, const ShapeOrientationTable* pOrientations)
+	: m_Vertices(view.pVertices, view.pVertices + view.VerticesCount)
+	, m_TriangleIndices(view.pTriangleIndices, view.pTriangleIndices + view.TrianglesCount * 3)
+	, m_LineIndices(view.pLineIndices, view.pLineIndices + view.LinesCount * 2)
+	, m_pVertexBuffer(nullptr)
+	, m_pTrianglesIndexBuffer(nullptr)
+	, m_pLinesIndexBuffer(nullptr)
+	, m_TrianglesCount(view.TrianglesCount)
+	, m_LinesCount(view.LinesCount)
+	, m_CubesRelativePositions(view.pCubes, view.pCubes + view.CubesCount)
+	, m_pOrientations(pOrientations)
+	, m_pBuiltOrientations(nullptr)
+	, m_ReferencesCount(1)
+{
+	assert(view.VerticesCount > 0 && view.TrianglesCount > 0 && view.LinesCount > 0);
+
+	if (!m_pOrientations)
+	{
+		BuildOrientations();
+	}
+}
+
+void ShapeGeometry::AddRef() const
+{
+	++m_ReferencesCount;
+}
+
+void ShapeGeometry::Release() const
+{
+	assert(m_ReferencesCount > 0);
+
+	if (--m_ReferencesCount == 0)
+	{
+		delete this;
+	}
+}
+
+RenderBuffer* ShapeGeometry::GetVertexBuffer() const
+{
+	CreateBuffers();
+	return m_pVertexBuffer;
+}
+
+RenderBuffer* ShapeGeometry::GetTrianglesIndexBuffer() const
+{
+	CreateBuffers();
+	return m_pTrianglesIndexBuffer;
+}
+
+RenderBuffer* ShapeGeometry::GetLinesIndexBuffer() const
+{
+	CreateBuffers();
+	return m_pLinesIndexBuffer;
+}
+
+size_t ShapeGeometry::GetTrianglesCount() const
+{
+	return m_TrianglesCount;
+}
+
+size_t ShapeGeometry::GetLinesCount() const
+{
+	return m_LinesCount;
+}
+
+const ShapeGeometry::CubesContainer& ShapeGeometry::GetCubesRelativePositions() const
+{
+	return m_CubesRelativePositions;
+}
+
+const ShapeOrientationTable* ShapeGeometry::GetOrientations() const
+{
+	return m_pOrientations;
+}
+
+ShapeGeometry::~ShapeGeometry()
+{
+	Shape::ReleaseBuffer(m_pVertexBuffer);
+	Shape::ReleaseBuffer(m_pTrianglesIndexBuffer);
+	Shape::ReleaseBuffer(m_pLinesIndexBuffer);
+
+	SafeDelete(m_pBuiltOrientations);
+}
+
+void ShapeGeometry::BuildOrientations()
+{
+	if (m_CubesRelativePositions.size() > MAX_SHAPE_CUBES)
+	{
+		return;
+	}
+
+	int cubes[MAX_SHAPE_CUBES][3];
+
+	for (size_t i = 0; i < m_CubesRelativePositions.size(); ++i)
+	{
+		const Vector3& position = m_CubesRelativePositions[i];
+		const float coordinates[3] = { position.x, position.y, position.z };
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			// the table is kept in int8, far more than any pit needs
+			if (coordinates[axis] != floor(coordinates[axis]) || fabs(coordinates[axis]) > 64.0f)
+			{
+				return;
+			}
+
+			cubes[i][axis] = int(coordinates[axis]);
+		}
+	}
+
+	m_pBuiltOrientations = new ShapeOrientationTable(ShapeOrientationBuilder::Build(cubes, m_CubesRelativePositions.size()));
+	m_pOrientations = m_pBuiltOrientations;
+}
+
+void ShapeGeometry::CreateBuffers() const
+{
+	// shapes are made on the simulation thread, the renderer is used by the
+	// render thread alone
+	if (m_pVertexBuffer)
+	{
+		return;
+	}
+
+	Shape::CreateVertexBuffer(m_pVertexBuffer, &m_Vertices.front(), m_Vertices.size());
+	Shape::CreateIndexBuffer(m_pTrianglesIndexBuffer, &m_TriangleIndices.front(), m_TriangleIndices.size());
+	Shape::CreateIndexBuffer(m_pLinesIndexBuffer, &m_LineIndices.front(), m_LineIndices.size());
+
+	// the buffers hold them now
+	vector<Vertex>().swap(m_Vertices);
+	vector<unsigned>().swap(m_TriangleIndices);
+	vector<unsigned>().swap(m_LineIndices);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+struct ShapeGeometryView;
+struct ShapeOrientationTable;
+class RenderBuffer;
+
+// immutable GPU buffers and cube layout of one shape kind, shared by all
+// Shape instances of that kind through reference counting
+class ShapeGeometry
+{
+public:
+	typedef std::vector<Vector3> CubesContainer;
+
+	// the view is copied, so the geometry may outlive its shape set; without
+	// precomputed orientations they are built from the cubes when the shape
+	// fits in an orientation table
+	explicit ShapeGeometry(const ShapeGeometryView& view, const ShapeOrientationTable* pOrientations = nullptr);
+
+	void AddRef() const;
+	void Release() const;
+
+	// buffers are created by the first call, on the thread that draws
+	RenderBuffer* GetVertexBuffer() const;
+	RenderBuffer* GetTrianglesIndexBuffer() const;
+	RenderBuffer* GetLinesIndexBuffer() const;
+
+	size_t GetTrianglesCount() const;
+	size_t GetLinesCount() const;
+
+	const CubesContainer& GetCubesRelativePositions() const;
+
+	// returns nullptr for shapes with more than MAX_SHAPE_CUBES cubes or
+	// with cubes off the integer grid
+	const ShapeOrientationTable* GetOrientations() const;
+
+private:
+	// destroyed only by the last Release()
+	~ShapeGeometry();
+
+	void BuildOrientations();
+	void CreateBuffers() const;
+
+	ShapeGeometry(const ShapeGeometry&);
+	ShapeGeometry& operator = (const ShapeGeometry&);
+
+	// copied from the view until the buffers are created from them
+	mutable std::vector<Vertex> m_Vertices;
+	mutable std::vector<unsigned> m_TriangleIndices;
+	mutable std::vector<unsigned> m_LineIndices;
+
+	mutable RenderBuffer* m_pVertexBuffer;
+	mutable RenderBuffer* m_pTrianglesIndexBuffer;
+	mutable RenderBuffer* m_pLinesIndexBuffer;
+
+	size_t m_TrianglesCount;
+	size_t m_LinesCount;
+
+	const CubesContainer m_CubesRelativePositions;
+
+	const ShapeOrientationTable* m_pOrientations;
+	ShapeOrientationTable* m_pBuiltOrientations;
+
+	mutable unsigned m_ReferencesCount;
+};
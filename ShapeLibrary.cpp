@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "ShapeLibrary.h"
+#include "ShapeGeometry.h"
+#include "ShapeSetParser.h"
+#include "EmbeddedShapeSets.h"
+
+using namespace std;
+
+// ShapeSet
+
+const string& ShapeSet::GetName() const
+{
+	return m_Name;
+}
+
+size_t ShapeSet::GetShapesCount() const
+{
+	return m_Shapes.size();
+}
+
+const ShapeGeometry* ShapeSet::GetShape(unsigned shapeKind) const
+{
+	assert(shapeKind < m_Shapes.size());
+
+	if (!m_Shapes[shapeKind])
+	{
+		const ShapeOrientationTable* pOrientations = m_pEmbeddedSet ? m_pEmbeddedSet->pShapes[shapeKind].pOrientations : nullptr;
+		m_Shapes[shapeKind] = new ShapeGeometry(GetShapeView(shapeKind), pOrientations);
+	}
+
+	return m_Shapes[shapeKind];
+}
+
+const ShapeGeometryView& ShapeSet::GetShapeView(unsigned shapeKind) const
+{
+	assert(shapeKind < m_Views.size());
+
+	ShapeGeometryView& view = m_Views[shapeKind];
+
+	if (!view.pVertices && !m_Image.GetShapeView(shapeKind, view))
+	{
+		throw ShapeSetError("Corrupted shape set " + m_Name);
+	}
+
+	return view;
+}
+
+ShapeSet::ShapeSet(const string& name)
+	: m_Name(name)
+	, m_pEmbeddedSet(nullptr)
+{
+}
+
+ShapeSet::~ShapeSet()
+{
+	// shapes still alive keep their own references to the geometry
+	for (ShapesContainer::iterator it = m_Shapes.begin(); it != m_Shapes.end(); ++it)
+	{
+		if (*it)
+		{
+			(*it)->Release();
+		}
+	}
+}
+
+void ShapeSet::Open()
+{
+	if (!m_File.Open(m_Name))
+	{
+		throw ShapeSetError("Missing file " + m_Name);
+	}
+
+	if (ShapeSetImage::HasBinaryHeader(m_File.GetData(), m_File.GetSize()))
+	{
+		// precompiled set, used in place
+		m_Image = ShapeSetImage(m_File.GetData(), m_File.GetSize());
+	}
+	else
+	{
+		ShapeSetImage::BuildFromText(m_File.GetData(), m_File.GetSize(), m_Name, m_ConvertedImage);
+
+		m_File.Close();
+		m_Image = ShapeSetImage(&m_ConvertedImage.front(), m_ConvertedImage.size());
+	}
+
+	if (!m_Image.IsValid())
+	{
+		throw ShapeSetError("Invalid or unsupported shape set " + m_Name);
+	}
+
+	ShapeGeometryView emptyView = {};
+
+	m_Shapes.assign(m_Image.GetShapesCount(), nullptr);
+	m_Views.assign(m_Image.GetShapesCount(), emptyView);
+}
+
+void ShapeSet::Open(const EmbeddedShapeSet& embeddedSet)
+{
+	ShapeSetImage::BuildFromEmbedded(embeddedSet, m_ConvertedImage);
+
+	m_Image = ShapeSetImage(&m_ConvertedImage.front(), m_ConvertedImage.size());
+	m_pEmbeddedSet = &embeddedSet;
+
+	ShapeGeometryView emptyView = {};
+
+	m_Shapes.assign(m_Image.GetShapesCount(), nullptr);
+	m_Views.assign(m_Image.GetShapesCount(), emptyView);
+}
+
+// ShapeLibrary
+
+const ShapeSet* ShapeLibrary::LoadShapeSetFromFile( const string& fileName )
+{
+	ShapeSetsContainer::const_iterator cached = m_ShapeSets.find(fileName);
+
+	if (cached != m_ShapeSets.end())
+	{
+		return cached->second;
+	}
+
+	ShapeSet* pShapeSet = new ShapeSet(fileName);
+
+	try
+	{
+		pShapeSet->Open();
+	}
+	catch (...)
+	{
+		delete pShapeSet;
+		throw;
+	}
+
+	m_ShapeSets[fileName] = pShapeSet;
+
+	return pShapeSet;
+}
+
+const ShapeSet* ShapeLibrary::LoadEmbeddedShapeSet( const string& name )
+{
+	ShapeSetsContainer::const_iterator cached = m_ShapeSets.find(name);
+
+	if (cached != m_ShapeSets.end())
+	{
+		return cached->second;
+	}
+
+	const EmbeddedShapeSet* pEmbeddedSet = EmbeddedShapeSets::Find(name);
+
+	if (!pEmbeddedSet)
+	{
+		throw ShapeSetError("Unknown shape set " + name);
+	}
+
+	ShapeSet* pShapeSet = new ShapeSet(name);
+	pShapeSet->Open(*pEmbeddedSet);
+
+	m_ShapeSets[name] = pShapeSet;
+
+	return pShapeSet;
+}
+
+const ShapeSet* ShapeLibrary::GetShapeSet( const string& name )
+{
+	ShapeSetsContainer::const_iterator it = m_ShapeSets.find(name);
+	return (it != m_ShapeSets.end()) ? it->second : nullptr;
+}
+
+void ShapeLibrary::ReleaseShapeSets()
+{
+	for (ShapeSetsContainer::iterator it = m_ShapeSets.begin(); it != m_ShapeSets.end(); ++it)
+	{
+		delete it->second;
+	}
+
+	m_ShapeSets.clear();
+}
+
+ShapeLibrary::ShapeSetsContainer ShapeLibrary::m_ShapeSets;
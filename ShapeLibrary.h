@@ -0,0 +1,75 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "ShapeSetImage.h"
+
+class ShapeGeometry;
+struct EmbeddedShapeSet;
+
+// ordered collection of shape kinds backed by a binary shape set image,
+// either memory mapped from a precompiled file, converted from text or
+// built from a set embedded in the executable; shape geometry is created
+// on first use of every kind
+class ShapeSet
+{
+	friend class ShapeLibrary;
+
+public:
+	const std::string& GetName() const;
+
+	size_t GetShapesCount() const;
+	const ShapeGeometry* GetShape(unsigned shapeKind) const;
+
+	// view into the image, valid while the set is loaded
+	const ShapeGeometryView& GetShapeView(unsigned shapeKind) const;
+
+private:
+	ShapeSet(const std::string& name);
+	~ShapeSet();
+
+	ShapeSet(const ShapeSet&);
+	ShapeSet& operator = (const ShapeSet&);
+
+	// throws ShapeSetError
+	void Open();
+	void Open(const EmbeddedShapeSet& embeddedSet);
+
+	std::string m_Name;
+
+	MappedFile m_File;
+	std::vector<char> m_ConvertedImage;
+	ShapeSetImage m_Image;
+
+	// precomputed orientations of an embedded set
+	const EmbeddedShapeSet* m_pEmbeddedSet;
+
+	typedef std::vector<const ShapeGeometry*> ShapesContainer;
+	mutable ShapesContainer m_Shapes;
+
+	typedef std::vector<ShapeGeometryView> ViewsContainer;
+	mutable ViewsContainer m_Views;
+};
+
+// keeps every shape set loaded once for the lifetime of the application,
+// so switching between sets or starting a new game does not touch the disk
+// or recreate any buffer
+class ShapeLibrary
+{
+public:
+	// accepts both the text and the precompiled binary format and returns
+	// the cached set when the file was already loaded, throws ShapeSetError
+	static const ShapeSet* LoadShapeSetFromFile(const std::string& fileName);
+
+	// one of the sets compiled into the executable, see EmbeddedShapeSets,
+	// throws ShapeSetError for unknown names
+	static const ShapeSet* LoadEmbeddedShapeSet(const std::string& name);
+
+	// returns nullptr when the set was not loaded
+	static const ShapeSet* GetShapeSet(const std::string& name);
+
+	static void ReleaseShapeSets();
+
+private:
+	typedef std::map<std::string, ShapeSet*> ShapeSetsContainer;
+	static ShapeSetsContainer m_ShapeSets;
+};
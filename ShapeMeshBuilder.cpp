@@ -0,0 +1,337 @@
+#include "pch.h"
+#include "ShapeMeshBuilder.h"
+
+using namespace std;
+
+namespace
+{
+
+// integer point, cube centers are at even and face corners at odd
+// coordinates once doubled
+struct Point
+{
+	int c[3];
+
+	bool operator < (const Point& other) const
+	{
+		return lexicographical_compare(c, c + 3, other.c, other.c + 3);
+	}
+};
+
+Point MakePoint(int x, int y, int z)
+{
+	Point point = { { x, y, z } };
+	return point;
+}
+
+const int FACES_COUNT = 6;
+
+// face f has its normal along axis f / 2, pointing to the negative side for even f
+int GetNormalAxis(int face)		{ return face / 2; }
+int GetNormalSign(int face)		{ return (face % 2) ? 1 : -1; }
+
+class MeshWriter
+{
+public:
+	MeshWriter(vector<Vertex>& vertices, vector<unsigned>& triangleIndices, vector<unsigned>& lineIndices)
+		: m_Vertices(vertices)
+		, m_TriangleIndices(triangleIndices)
+		, m_LineIndices(lineIndices)
+	{
+	}
+
+	// corners given in doubled coordinates and in cyclic order
+	void AddQuad(Point corners[4], int face)
+	{
+		// keep the winding clockwise seen from outside, which is front facing
+		// with the default rasterizer state: (c1 - c0) x (c2 - c0) must point out
+		int a[3], b[3];
+
+		for (int i = 0; i < 3; ++i)
+		{
+			a[i] = corners[1].c[i] - corners[0].c[i];
+			b[i] = corners[2].c[i] - corners[0].c[i];
+		}
+
+		int cross[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+
+		if (cross[GetNormalAxis(face)] * GetNormalSign(face) < 0)
+		{
+			swap(corners[1], corners[3]);
+		}
+
+		unsigned indices[4];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			indices[i] = GetVertexIndex(corners[i]);
+		}
+
+		unsigned triangles[6] = { indices[0], indices[1], indices[2], indices[0], indices[2], indices[3] };
+		m_TriangleIndices.insert(m_TriangleIndices.end(), triangles, triangles + 6);
+	}
+
+	void AddLine(const Point& from, const Point& to)
+	{
+		m_LineIndices.push_back(GetVertexIndex(from));
+		m_LineIndices.push_back(GetVertexIndex(to));
+	}
+
+private:
+	unsigned GetVertexIndex(const Point& corner)
+	{
+		map<Point, unsigned>::const_iterator found = m_VertexIndices.find(corner);
+
+		if (found != m_VertexIndices.end())
+		{
+			return found->second;
+		}
+
+		m_Vertices.push_back(Vertex(0.5f * corner.c[0], 0.5f * corner.c[1], 0.5f * corner.c[2]));
+		m_VertexIndices[corner] = unsigned(m_Vertices.size() - 1);
+
+		return unsigned(m_Vertices.size() - 1);
+	}
+
+	vector<Vertex>& m_Vertices;
+	vector<unsigned>& m_TriangleIndices;
+	vector<unsigned>& m_LineIndices;
+
+	map<Point, unsigned> m_VertexIndices;
+};
+
+}
+
+bool ShapeMeshBuilder::Build(
+	const Vector3* pCubes,
+	size_t cubesCount,
+	vector<Vertex>& vertices,
+	vector<unsigned>& triangleIndices,
+	vector<unsigned>& lineIndices
+)
+{
+	vertices.clear();
+	triangleIndices.clear();
+	lineIndices.clear();
+
+	// COLLECT CUBES
+
+	set<Point> cubes;
+	Point minimum = { { INT_MAX, INT_MAX, INT_MAX } };
+	Point maximum = { { INT_MIN, INT_MIN, INT_MIN } };
+
+	for (size_t i = 0; i < cubesCount; ++i)
+	{
+		Point cube = MakePoint(Round(pCubes[i].x), Round(pCubes[i].y), Round(pCubes[i].z));
+
+		if (!IsZero(pCubes[i].x - cube.c[0]) || !IsZero(pCubes[i].y - cube.c[1]) || !IsZero(pCubes[i].z - cube.c[2]) ||
+			!cubes.insert(cube).second)
+		{
+			return false;
+		}
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			minimum.c[axis] = min(minimum.c[axis], cube.c[axis]);
+			maximum.c[axis] = max(maximum.c[axis], cube.c[axis]);
+		}
+	}
+
+	MeshWriter writer(vertices, triangleIndices, lineIndices);
+
+	// exposed face of a cube, given in (normal axis, u, v) coordinates of a face direction
+	struct IsExposed
+	{
+		const set<Point>& Cubes;
+		int Face, U, V;
+
+		bool operator () (int w, int u, int v) const
+		{
+			Point cube, neighbour;
+			cube.c[GetNormalAxis(Face)] = w;
+			cube.c[U] = u;
+			cube.c[V] = v;
+			neighbour = cube;
+			neighbour.c[GetNormalAxis(Face)] += GetNormalSign(Face);
+			return Cubes.count(cube) && !Cubes.count(neighbour);
+		}
+	};
+
+	// MERGE EXPOSED FACES INTO RECTANGLES
+
+	for (int face = 0; face < FACES_COUNT; ++face)
+	{
+		int w = GetNormalAxis(face);
+		int u = (w + 1) % 3;
+		int v = (w + 2) % 3;
+
+		IsExposed isExposed = { cubes, face, u, v };
+
+		int width = maximum.c[u] - minimum.c[u] + 1;
+		int height = maximum.c[v] - minimum.c[v] + 1;
+
+		for (int slice = minimum.c[w]; slice <= maximum.c[w]; ++slice)
+		{
+			vector<bool> isMerged(width * height, false);
+
+			for (int j = 0; j < height; ++j)
+			{
+				for (int i = 0; i < width; ++i)
+				{
+					if (isMerged[j * width + i] || !isExposed(slice, minimum.c[u] + i, minimum.c[v] + j))
+					{
+						continue;
+					}
+
+					// grow along u, then along v while the whole row fits
+					int rectangleWidth = 1;
+
+					while (i + rectangleWidth < width &&
+						   !isMerged[j * width + i + rectangleWidth] &&
+						   isExposed(slice, minimum.c[u] + i + rectangleWidth, minimum.c[v] + j))
+					{
+						++rectangleWidth;
+					}
+
+					int rectangleHeight = 1;
+
+					for ( ; j + rectangleHeight < height; ++rectangleHeight)
+					{
+						bool isRowExposed = true;
+
+						for (int k = i; k < i + rectangleWidth && isRowExposed; ++k)
+						{
+							isRowExposed = !isMerged[(j + rectangleHeight) * width + k] &&
+										   isExposed(slice, minimum.c[u] + k, minimum.c[v] + j + rectangleHeight);
+						}
+
+						if (!isRowExposed)
+						{
+							break;
+						}
+					}
+
+					for (int y = j; y < j + rectangleHeight; ++y)
+					{
+						for (int x = i; x < i + rectangleWidth; ++x)
+						{
+							isMerged[y * width + x] = true;
+						}
+					}
+
+					int u0 = 2 * (minimum.c[u] + i) - 1;
+					int u1 = 2 * (minimum.c[u] + i + rectangleWidth - 1) + 1;
+					int v0 = 2 * (minimum.c[v] + j) - 1;
+					int v1 = 2 * (minimum.c[v] + j + rectangleHeight - 1) + 1;
+
+					Point corners[4];
+					int us[4] = { u0, u0, u1, u1 };
+					int vs[4] = { v0, v1, v1, v0 };
+
+					for (int corner = 0; corner < 4; ++corner)
+					{
+						corners[corner].c[w] = 2 * slice + GetNormalSign(face);
+						corners[corner].c[u] = us[corner];
+						corners[corner].c[v] = vs[corner];
+					}
+
+					writer.AddQuad(corners, face);
+				}
+			}
+		}
+	}
+
+	// FIND OUTLINE EDGES
+
+	// unit edges keyed by their lower end and axis, with the directions
+	// of the faces touching them as a bit mask and their count
+	typedef pair<Point, int> UnitEdge;
+	map<UnitEdge, pair<unsigned, unsigned> > unitEdges;
+
+	for (set<Point>::const_iterator it = cubes.begin(); it != cubes.end(); ++it)
+	{
+		for (int face = 0; face < FACES_COUNT; ++face)
+		{
+			int w = GetNormalAxis(face);
+			IsExposed isExposed = { cubes, face, (w + 1) % 3, (w + 2) % 3 };
+
+			if (!isExposed(it->c[w], it->c[(w + 1) % 3], it->c[(w + 2) % 3]))
+			{
+				continue;
+			}
+
+			for (int edgeAxis = 0; edgeAxis < 3; ++edgeAxis)
+			{
+				if (edgeAxis == w)
+				{
+					continue;
+				}
+
+				int side = 3 - w - edgeAxis;
+
+				for (int sign = -1; sign <= 1; sign += 2)
+				{
+					Point from;
+					from.c[w] = 2 * it->c[w] + GetNormalSign(face);
+					from.c[side] = 2 * it->c[side] + sign;
+					from.c[edgeAxis] = 2 * it->c[edgeAxis] - 1;
+
+					pair<unsigned, unsigned>& faces = unitEdges[UnitEdge(from, edgeAxis)];
+					faces.first |= 1 << face;
+					++faces.second;
+				}
+			}
+		}
+	}
+
+	// MERGE COLLINEAR OUTLINE EDGES
+
+	// map order keeps collinear unit edges next to each other only along
+	// the last coordinate, so bucket them by axis and line first
+	map<pair<int, pair<int, int> >, vector<int> > lines;
+
+	for (map<UnitEdge, pair<unsigned, unsigned> >::const_iterator it = unitEdges.begin(); it != unitEdges.end(); ++it)
+	{
+		unsigned faceMask = it->second.first;
+		bool isBetweenCoplanarFaces = it->second.second == 2 && (faceMask & (faceMask - 1)) == 0;
+
+		if (isBetweenCoplanarFaces)
+		{
+			continue;
+		}
+
+		const Point& from = it->first.first;
+		int axis = it->first.second;
+
+		lines[make_pair(axis, make_pair(from.c[(axis + 1) % 3], from.c[(axis + 2) % 3]))].push_back(from.c[axis]);
+	}
+
+	for (map<pair<int, pair<int, int> >, vector<int> >::iterator it = lines.begin(); it != lines.end(); ++it)
+	{
+		int axis = it->first.first;
+		vector<int>& starts = it->second;
+		sort(starts.begin(), starts.end());
+
+		for (size_t i = 0; i < starts.size(); )
+		{
+			size_t end = i + 1;
+
+			while (end < starts.size() && starts[end] == starts[end - 1] + 2)
+			{
+				++end;
+			}
+
+			Point from, to;
+			from.c[axis] = starts[i];
+			to.c[axis] = starts[end - 1] + 2;
+			from.c[(axis + 1) % 3] = to.c[(axis + 1) % 3] = it->first.second.first;
+			from.c[(axis + 2) % 3] = to.c[(axis + 2) % 3] = it->first.second.second;
+
+			writer.AddLine(from, to);
+
+			i = end;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Builds the piece mesh from its cube positions alone. Faces shared by two
+// cubes are dropped, the remaining coplanar faces are merged greedily into
+// rectangles and only the edges where the surface bends (or which are
+// shared by diagonal cubes) are emitted for the outline, merged into the
+// longest straight lines. Cubes are unit sized and centered on their
+// integer positions, like the hand authored meshes.
+class ShapeMeshBuilder
+{
+public:
+	// returns false when a position is not integral or appears twice
+	static bool Build(
+		const Vector3* pCubes,
+		size_t cubesCount,
+		std::vector<Vertex>& vertices,
+		std::vector<unsigned>& triangleIndices,
+		std::vector<unsigned>& lineIndices);
+};
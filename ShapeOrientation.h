@@ -0,0 +1,210 @@
+#pragma once
+
+#include "PitDimensions.h"
+
+// quarter turns of a piece around its pivot cube, in the order of the
+// rotation keys A, Q, S, W, D and E
+enum ShapeRotation
+{
+	ROTATE_X_NEGATIVE,
+	ROTATE_X_POSITIVE,
+	ROTATE_Y_NEGATIVE,
+	ROTATE_Y_POSITIVE,
+	ROTATE_Z_NEGATIVE,
+	ROTATE_Z_POSITIVE,
+
+	SHAPE_ROTATIONS_COUNT
+};
+
+const size_t MAX_SHAPE_CUBES = 16;
+const size_t MAX_SHAPE_ORIENTATIONS = 24;
+
+// one distinct orientation of a piece, cubes relative to the pivot
+struct ShapeOrientation
+{
+	int8_t	Cubes[MAX_SHAPE_CUBES][3];	// sorted by x, y, z
+	uint8_t	CubesCount;
+
+	// bounding box, inclusive
+	int8_t	Minimum[3];
+	int8_t	Maximum[3];
+
+	// Collision masks, one per layer from Minimum[2] downwards, in the bit
+	// layout of a pit level (bit y * PIT_X_SIZE + x) with the bounding box
+	// corner at cell (0, 0). Shifting them by the corner cell of a placement
+	// gives the occupied cells directly. Only valid when the footprint fits
+	// in the pit.
+	uint32_t LayerMasks[MAX_SHAPE_CUBES];
+	bool HasLayerMasks;
+
+	// orientation index reached by each ShapeRotation
+	uint8_t Rotations[SHAPE_ROTATIONS_COUNT];
+};
+
+struct ShapeOrientationTable
+{
+	ShapeOrientation Orientations[MAX_SHAPE_ORIENTATIONS];
+	uint8_t Count;
+};
+
+// Builds the orientation tables with the same quarter turns as
+// Shape::TryToRotate. Everything is constexpr, so the tables of the
+// embedded shape sets are computed by the compiler; the same code builds
+// them for shape sets loaded from files.
+class ShapeOrientationBuilder
+{
+public:
+	// cubes must be distinct and at most MAX_SHAPE_CUBES
+	template <size_t N>
+	static constexpr ShapeOrientationTable Build(const int (&cubes)[N][3])
+	{
+		static_assert(N > 0 && N <= MAX_SHAPE_CUBES, "unsupported cubes count");
+		return Build(cubes, N);
+	}
+
+	static constexpr ShapeOrientationTable Build(const int (*cubes)[3], size_t count)
+	{
+		ShapeOrientationTable table = {};
+
+		ShapeOrientation& first = table.Orientations[0];
+		first.CubesCount = uint8_t(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				first.Cubes[i][axis] = int8_t(cubes[i][axis]);
+			}
+		}
+
+		SortCubes(first);
+		table.Count = 1;
+
+		// breadth first over quarter turns, at most 24 orientations exist
+		for (size_t i = 0; i < table.Count; ++i)
+		{
+			for (int rotation = 0; rotation < SHAPE_ROTATIONS_COUNT; ++rotation)
+			{
+				ShapeOrientation rotated = {};
+				rotated.CubesCount = table.Orientations[i].CubesCount;
+
+				for (size_t cube = 0; cube < rotated.CubesCount; ++cube)
+				{
+					RotateCube(table.Orientations[i].Cubes[cube], ShapeRotation(rotation), rotated.Cubes[cube]);
+				}
+
+				SortCubes(rotated);
+
+				size_t found = 0;
+
+				while (found < table.Count && !HasSameCubes(table.Orientations[found], rotated))
+				{
+					++found;
+				}
+
+				if (found == table.Count)
+				{
+					table.Orientations[table.Count++] = rotated;
+				}
+
+				table.Orientations[i].Rotations[rotation] = uint8_t(found);
+			}
+		}
+
+		for (size_t i = 0; i < table.Count; ++i)
+		{
+			BuildCollisionMasks(table.Orientations[i]);
+		}
+
+		return table;
+	}
+
+	// the quarter turns of MatrixRotationYawPitchRoll applied to a row vector
+	static constexpr void RotateCube(const int8_t cube[3], ShapeRotation rotation, int8_t rotated[3])
+	{
+		int8_t x = cube[0], y = cube[1], z = cube[2];
+
+		switch (rotation)
+		{
+		case ROTATE_X_NEGATIVE: rotated[0] = x;		rotated[1] = z;		rotated[2] = -y;	break;
+		case ROTATE_X_POSITIVE: rotated[0] = x;		rotated[1] = -z;	rotated[2] = y;		break;
+		case ROTATE_Y_NEGATIVE: rotated[0] = -z;	rotated[1] = y;		rotated[2] = x;		break;
+		case ROTATE_Y_POSITIVE: rotated[0] = z;		rotated[1] = y;		rotated[2] = -x;	break;
+		case ROTATE_Z_NEGATIVE: rotated[0] = y;		rotated[1] = -x;	rotated[2] = z;		break;
+		case ROTATE_Z_POSITIVE: rotated[0] = -y;	rotated[1] = x;		rotated[2] = z;		break;
+		default:				rotated[0] = x;		rotated[1] = y;		rotated[2] = z;		break;
+		}
+	}
+
+private:
+	static constexpr bool IsLess(const int8_t a[3], const int8_t b[3])
+	{
+		return a[0] != b[0] ? a[0] < b[0] : (a[1] != b[1] ? a[1] < b[1] : a[2] < b[2]);
+	}
+
+	static constexpr void SortCubes(ShapeOrientation& orientation)
+	{
+		// insertion sort, pieces are small
+		for (size_t i = 1; i < orientation.CubesCount; ++i)
+		{
+			for (size_t j = i; j > 0 && IsLess(orientation.Cubes[j], orientation.Cubes[j - 1]); --j)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					int8_t cube = orientation.Cubes[j][axis];
+					orientation.Cubes[j][axis] = orientation.Cubes[j - 1][axis];
+					orientation.Cubes[j - 1][axis] = cube;
+				}
+			}
+		}
+	}
+
+	static constexpr bool HasSameCubes(const ShapeOrientation& a, const ShapeOrientation& b)
+	{
+		for (size_t i = 0; i < a.CubesCount; ++i)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (a.Cubes[i][axis] != b.Cubes[i][axis])
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	static constexpr void BuildCollisionMasks(ShapeOrientation& orientation)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			orientation.Minimum[axis] = orientation.Cubes[0][axis];
+			orientation.Maximum[axis] = orientation.Cubes[0][axis];
+
+			for (size_t i = 1; i < orientation.CubesCount; ++i)
+			{
+				if (orientation.Cubes[i][axis] < orientation.Minimum[axis]) orientation.Minimum[axis] = orientation.Cubes[i][axis];
+				if (orientation.Cubes[i][axis] > orientation.Maximum[axis]) orientation.Maximum[axis] = orientation.Cubes[i][axis];
+			}
+		}
+
+		orientation.HasLayerMasks =
+			size_t(orientation.Maximum[0] - orientation.Minimum[0]) < PIT_X_SIZE &&
+			size_t(orientation.Maximum[1] - orientation.Minimum[1]) < PIT_Y_SIZE;
+
+		if (!orientation.HasLayerMasks)
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < orientation.CubesCount; ++i)
+		{
+			size_t x = size_t(orientation.Cubes[i][0] - orientation.Minimum[0]);
+			size_t y = size_t(orientation.Cubes[i][1] - orientation.Minimum[1]);
+			size_t layer = size_t(orientation.Cubes[i][2] - orientation.Minimum[2]);
+
+			orientation.LayerMasks[layer] |= 1u << (y * PIT_X_SIZE + x);
+		}
+	}
+};
@@ -0,0 +1,212 @@
+#include "pch.h"
+#include "ShapeSetImage.h"
+#include "ShapeSetParser.h"
+#include "MappedFile.h"
+#include "EmbeddedShapeSets.h"
+#include "ShapeMeshBuilder.h"
+
+using namespace std;
+
+namespace
+{
+
+template <typename T>
+uint32_t AppendArray(vector<char>& image, const vector<T>& data)
+{
+	size_t offset = image.size();
+	image.resize(offset + data.size() * sizeof(T));
+
+	if (!data.empty())
+	{
+		memcpy(&image[offset], &data.front(), data.size() * sizeof(T));
+	}
+
+	return uint32_t(offset);
+}
+
+}
+
+static_assert(sizeof(Vertex) == 3 * sizeof(float), "Vertex must match the shape set image layout");
+static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3 must match the shape set image layout");
+
+ShapeSetImage::ShapeSetImage()
+	: m_pData(nullptr)
+	, m_Size(0)
+{
+}
+
+ShapeSetImage::ShapeSetImage(const char* pData, size_t size)
+	: m_pData(pData)
+	, m_Size(size)
+{
+}
+
+bool ShapeSetImage::IsValid() const
+{
+	if (!HasBinaryHeader(m_pData, m_Size))
+	{
+		return false;
+	}
+
+	const Header* pHeader = GetHeader();
+
+	return pHeader->Version == VERSION
+		&& pHeader->ImageSize == m_Size
+		&& pHeader->ShapesCount > 0
+		&& IsInImage(sizeof(Header), pHeader->ShapesCount, sizeof(ShapeRecord));
+}
+
+size_t ShapeSetImage::GetShapesCount() const
+{
+	assert(IsValid());
+	return GetHeader()->ShapesCount;
+}
+
+bool ShapeSetImage::GetShapeView(unsigned shapeKind, ShapeGeometryView& view) const
+{
+	assert(shapeKind < GetShapesCount());
+
+	ShapeRecord record;
+	memcpy(&record, m_pData + sizeof(Header) + shapeKind * sizeof(ShapeRecord), sizeof(ShapeRecord));
+
+	if (!IsInImage(record.VerticesOffset, record.VerticesCount, sizeof(Vertex)) ||
+		!IsInImage(record.TriangleIndicesOffset, uint64_t(record.TrianglesCount) * 3, sizeof(unsigned)) ||
+		!IsInImage(record.LineIndicesOffset, uint64_t(record.LinesCount) * 2, sizeof(unsigned)) ||
+		!IsInImage(record.CubesOffset, record.CubesCount, sizeof(Vector3)))
+	{
+		return false;
+	}
+
+	// the renderers read vertices by these indices without checks, and
+	// buffers can't be empty
+	if (record.VerticesCount == 0 || record.TrianglesCount == 0 || record.LinesCount == 0 || record.CubesCount == 0 ||
+		!AreIndicesBelow(record.TriangleIndicesOffset, uint64_t(record.TrianglesCount) * 3, record.VerticesCount) ||
+		!AreIndicesBelow(record.LineIndicesOffset, uint64_t(record.LinesCount) * 2, record.VerticesCount))
+	{
+		return false;
+	}
+
+	view.pVertices			= reinterpret_cast<const Vertex*>(m_pData + record.VerticesOffset);
+	view.VerticesCount		= record.VerticesCount;
+	view.pTriangleIndices	= reinterpret_cast<const unsigned*>(m_pData + record.TriangleIndicesOffset);
+	view.TrianglesCount		= record.TrianglesCount;
+	view.pLineIndices		= reinterpret_cast<const unsigned*>(m_pData + record.LineIndicesOffset);
+	view.LinesCount			= record.LinesCount;
+	view.pCubes				= reinterpret_cast<const Vector3*>(m_pData + record.CubesOffset);
+	view.CubesCount			= record.CubesCount;
+
+	return true;
+}
+
+void ShapeSetImage::BuildFromText(const char* pText, size_t size, const string& sourceName, vector<char>& image)
+{
+	ShapeSetParser parser(pText, size, sourceName);
+	parser.Parse(image);
+}
+
+void ShapeSetImage::BuildFromEmbedded(const EmbeddedShapeSet& shapeSet, vector<char>& image)
+{
+	size_t recordsOffset = sizeof(Header);
+
+	image.assign(recordsOffset + shapeSet.ShapesCount * sizeof(ShapeRecord), 0);
+
+	for (size_t shape = 0; shape < shapeSet.ShapesCount; ++shape)
+	{
+		const EmbeddedShape& embeddedShape = shapeSet.pShapes[shape];
+
+		vector<Vector3> cubes(embeddedShape.CubesCount);
+
+		for (size_t i = 0; i < cubes.size(); ++i)
+		{
+			cubes[i] = Vector3(
+				float(embeddedShape.pCubes[i][0]),
+				float(embeddedShape.pCubes[i][1]),
+				float(embeddedShape.pCubes[i][2]));
+		}
+
+		vector<Vertex> vertices;
+		vector<unsigned> triangleIndices;
+		vector<unsigned> lineIndices;
+
+		// embedded cubes are checked when the tables are compiled
+		bool isBuilt = ShapeMeshBuilder::Build(&cubes.front(), cubes.size(), vertices, triangleIndices, lineIndices);
+		assert(isBuilt);
+		(void)isBuilt;
+
+		ShapeRecord record;
+		record.CubesOffset				= AppendArray(image, cubes);
+		record.CubesCount				= uint32_t(cubes.size());
+		record.VerticesOffset			= AppendArray(image, vertices);
+		record.VerticesCount			= uint32_t(vertices.size());
+		record.TriangleIndicesOffset	= AppendArray(image, triangleIndices);
+		record.TrianglesCount			= uint32_t(triangleIndices.size() / 3);
+		record.LineIndicesOffset		= AppendArray(image, lineIndices);
+		record.LinesCount				= uint32_t(lineIndices.size() / 2);
+
+		memcpy(&image[recordsOffset + shape * sizeof(ShapeRecord)], &record, sizeof(record));
+	}
+
+	Header header;
+	memcpy(header.Magic, MAGIC, sizeof(header.Magic));
+	header.Version		= VERSION;
+	header.ShapesCount	= uint32_t(shapeSet.ShapesCount);
+	header.ImageSize	= uint32_t(image.size());
+
+	memcpy(&image.front(), &header, sizeof(header));
+}
+
+void ShapeSetImage::ConvertTextFile(const string& textFileName, const string& binaryFileName)
+{
+	MappedFile input;
+
+	if (!input.Open(textFileName))
+	{
+		throw ShapeSetError("Missing file " + textFileName);
+	}
+
+	vector<char> image;
+	BuildFromText(input.GetData(), input.GetSize(), textFileName, image);
+
+	ofstream output(binaryFileName.c_str(), ios::binary);
+	output.write(&image.front(), image.size());
+
+	if (output.fail())
+	{
+		throw ShapeSetError("Cannot write file " + binaryFileName);
+	}
+}
+
+bool ShapeSetImage::HasBinaryHeader(const char* pData, size_t size)
+{
+	return pData && size >= sizeof(Header) && memcmp(pData, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+const ShapeSetImage::Header* ShapeSetImage::GetHeader() const
+{
+	return reinterpret_cast<const Header*>(m_pData);
+}
+
+bool ShapeSetImage::IsInImage(uint32_t offset, uint64_t count, size_t elementSize) const
+{
+	// offsets must keep the arrays 4 byte aligned for in place access
+	return offset % sizeof(uint32_t) == 0
+		&& offset <= m_Size
+		&& count <= (m_Size - offset) / elementSize;
+}
+
+bool ShapeSetImage::AreIndicesBelow(uint32_t offset, uint64_t count, uint32_t verticesCount) const
+{
+	const unsigned* pIndices = reinterpret_cast<const unsigned*>(m_pData + offset);
+
+	for (uint64_t i = 0; i < count; ++i)
+	{
+		if (pIndices[i] >= verticesCount)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const char ShapeSetImage::MAGIC[4] = { 'B', 'O', 'S', 'S' };
@@ -0,0 +1,95 @@
+#pragma once
+
+struct EmbeddedShapeSet;
+
+// geometry of one shape kind pointing straight into a shape set image
+struct ShapeGeometryView
+{
+	const Vertex*	pVertices;
+	size_t			VerticesCount;
+
+	const unsigned*	pTriangleIndices;
+	size_t			TrianglesCount;
+
+	const unsigned*	pLineIndices;
+	size_t			LinesCount;
+
+	const Vector3*	pCubes;
+	size_t			CubesCount;
+};
+
+// Precompiled (binary) shape set. The image layout is
+//
+//	Header
+//	ShapeRecord[ShapesCount]
+//	vertex, index and cube arrays referenced by the records
+//
+// All fields are little endian 32 bit values and records hold byte offsets
+// from the start of the image, so a memory mapped file is used in place.
+// Records are validated when a shape is requested, so opening an image does
+// not depend on the number of shapes in it.
+class ShapeSetImage
+{
+	friend class ShapeSetParser;
+
+public:
+	static const unsigned VERSION = 1;
+
+	ShapeSetImage();
+	ShapeSetImage(const char* pData, size_t size);
+
+	// checks the header, returns false for text or foreign files
+	bool IsValid() const;
+
+	size_t GetShapesCount() const;
+
+	// returns false when the record points outside the image, has an
+	// empty array or indices past its vertices
+	bool GetShapeView(unsigned shapeKind, ShapeGeometryView& view) const;
+
+	// parses the text shape set format into a binary image,
+	// throws ShapeSetParseError
+	static void BuildFromText(const char* pText, size_t size, const std::string& sourceName, std::vector<char>& image);
+
+	// builds the image of a shape set compiled into the executable,
+	// meshes are generated from the cubes
+	static void BuildFromEmbedded(const EmbeddedShapeSet& shapeSet, std::vector<char>& image);
+
+	// text to binary converter, used by the -convert command line option,
+	// throws ShapeSetError
+	static void ConvertTextFile(const std::string& textFileName, const std::string& binaryFileName);
+
+	static bool HasBinaryHeader(const char* pData, size_t size);
+
+private:
+
+	struct Header
+	{
+		char		Magic[4];
+		uint32_t	Version;
+		uint32_t	ShapesCount;
+		uint32_t	ImageSize;
+	};
+
+	struct ShapeRecord
+	{
+		uint32_t VerticesOffset;
+		uint32_t VerticesCount;
+		uint32_t TriangleIndicesOffset;
+		uint32_t TrianglesCount;
+		uint32_t LineIndicesOffset;
+		uint32_t LinesCount;
+		uint32_t CubesOffset;
+		uint32_t CubesCount;
+	};
+
+	const Header* GetHeader() const;
+	bool IsInImage(uint32_t offset, uint64_t count, size_t elementSize) const;
+	// of an index array already checked with IsInImage
+	bool AreIndicesBelow(uint32_t offset, uint64_t count, uint32_t verticesCount) const;
+
+	const char* m_pData;
+	size_t m_Size;
+
+	static const char MAGIC[4];
+};
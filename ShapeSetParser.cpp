@@ -0,0 +1,286 @@
+#include "pch.h"
+#include "ShapeSetParser.h"
+#include "ShapeSetImage.h"
+#include "ShapeMeshBuilder.h"
+
+using namespace std;
+
+namespace
+{
+
+// keeps a single malformed count from reserving gigabytes
+const size_t MAX_ELEMENTS_COUNT = 1 << 20;
+
+template <typename T>
+void Append(vector<char>& image, const T& value)
+{
+	size_t offset = image.size();
+	image.resize(offset + sizeof(T));
+	memcpy(&image[offset], &value, sizeof(T));
+}
+
+template <typename T>
+uint32_t AppendArray(vector<char>& image, const vector<T>& data)
+{
+	size_t offset = image.size();
+	image.resize(offset + data.size() * sizeof(T));
+
+	if (!data.empty())
+	{
+		memcpy(&image[offset], &data.front(), data.size() * sizeof(T));
+	}
+
+	return uint32_t(offset);
+}
+
+template <typename T>
+void Write(vector<char>& image, size_t offset, const T& value)
+{
+	memcpy(&image[offset], &value, sizeof(T));
+}
+
+}
+
+// ShapeSetParseError
+
+ShapeSetParseError::ShapeSetParseError(const string& sourceName, size_t line, size_t column, const string& message)
+	: ShapeSetError(sourceName + "(" + to_string(line) + ":" + to_string(column) + "): " + message)
+	, m_Line(line)
+	, m_Column(column)
+{
+}
+
+size_t ShapeSetParseError::GetLine() const
+{
+	return m_Line;
+}
+
+size_t ShapeSetParseError::GetColumn() const
+{
+	return m_Column;
+}
+
+// ShapeSetParser
+
+ShapeSetParser::ShapeSetParser(const char* pText, size_t size, const string& sourceName)
+	: m_pCurrent(pText)
+	, m_pEnd(pText + size)
+	, m_pLineStart(pText)
+	, m_Line(1)
+	, m_SourceName(sourceName)
+{
+}
+
+void ShapeSetParser::Parse(vector<char>& image)
+{
+	size_t shapesCount = ParseCount("shapes count");
+
+	if (shapesCount == 0)
+	{
+		ThrowError("shape set has no shapes");
+	}
+
+	size_t recordsOffset = sizeof(ShapeSetImage::Header);
+
+	image.clear();
+	// the binary data of a shape given with its mesh is smaller than its
+	// text; meshes generated from the cubes are larger and may grow it
+	image.reserve(recordsOffset + shapesCount * sizeof(ShapeSetImage::ShapeRecord) + size_t(m_pEnd - m_pCurrent));
+	image.resize(recordsOffset + shapesCount * sizeof(ShapeSetImage::ShapeRecord), 0);
+
+	for (size_t shape = 0; shape < shapesCount; ++shape)
+	{
+		ParseShape(image, recordsOffset + shape * sizeof(ShapeSetImage::ShapeRecord));
+	}
+
+	SkipWhitespace();
+
+	if (m_pCurrent != m_pEnd)
+	{
+		ThrowError("unexpected data after the last shape");
+	}
+
+	ShapeSetImage::Header header;
+	memcpy(header.Magic, ShapeSetImage::MAGIC, sizeof(header.Magic));
+	header.Version		= ShapeSetImage::VERSION;
+	header.ShapesCount	= uint32_t(shapesCount);
+	header.ImageSize	= uint32_t(image.size());
+
+	Write(image, 0, header);
+}
+
+void ShapeSetParser::ParseShape(vector<char>& image, size_t recordOffset)
+{
+	ShapeSetImage::ShapeRecord record;
+
+	// VERTICES
+
+	size_t verticesCount = ParseCount("vertices count");
+
+	record.VerticesOffset = uint32_t(image.size());
+	record.VerticesCount = uint32_t(verticesCount);
+
+	for (size_t i = 0; i < 3 * verticesCount; ++i)
+	{
+		Append(image, ParseFloat("vertex coordinate"));
+	}
+
+	// TRIANGLE INDICES
+
+	size_t trianglesCount = ParseCount("triangles count");
+
+	record.TriangleIndicesOffset = uint32_t(image.size());
+	record.TrianglesCount = uint32_t(trianglesCount);
+
+	for (size_t i = 0; i < 3 * trianglesCount; ++i)
+	{
+		Append(image, ParseIndex(verticesCount, "triangle index"));
+	}
+
+	// LINE INDICES
+
+	size_t linesCount = ParseCount("lines count");
+
+	record.LineIndicesOffset = uint32_t(image.size());
+	record.LinesCount = uint32_t(linesCount);
+
+	for (size_t i = 0; i < 2 * linesCount; ++i)
+	{
+		Append(image, ParseIndex(verticesCount, "line index"));
+	}
+
+	// COMPOUND CUBES POSITIONS
+
+	size_t cubesCount = ParseCount("cubes count");
+
+	if (cubesCount == 0)
+	{
+		ThrowError("shape has no cubes");
+	}
+
+	// the mesh errors point at the first cube coordinate, lines away
+	SkipWhitespace();
+	const char* pCubesToken = m_pCurrent;
+	const char* pCubesLineStart = m_pLineStart;
+	const size_t cubesLine = m_Line;
+
+	vector<Vector3> cubes(cubesCount);
+
+	for (size_t i = 0; i < cubesCount; ++i)
+	{
+		cubes[i].x = ParseFloat("cube coordinate");
+		cubes[i].y = ParseFloat("cube coordinate");
+		cubes[i].z = ParseFloat("cube coordinate");
+	}
+
+	record.CubesOffset = AppendArray(image, cubes);
+	record.CubesCount = uint32_t(cubesCount);
+
+	// GENERATED MESH
+
+	if (verticesCount == 0)
+	{
+		// shapes given only by their cubes
+		vector<Vertex> vertices;
+		vector<unsigned> triangleIndices;
+		vector<unsigned> lineIndices;
+
+		if (!ShapeMeshBuilder::Build(&cubes.front(), cubes.size(), vertices, triangleIndices, lineIndices))
+		{
+			m_pCurrent = pCubesToken;
+			m_pLineStart = pCubesLineStart;
+			m_Line = cubesLine;
+			ThrowError("cube positions must be distinct integers to generate the mesh");
+		}
+
+		record.VerticesOffset			= AppendArray(image, vertices);
+		record.VerticesCount			= uint32_t(vertices.size());
+		record.TriangleIndicesOffset	= AppendArray(image, triangleIndices);
+		record.TrianglesCount			= uint32_t(triangleIndices.size() / 3);
+		record.LineIndicesOffset		= AppendArray(image, lineIndices);
+		record.LinesCount				= uint32_t(lineIndices.size() / 2);
+	}
+	else if (trianglesCount == 0 || linesCount == 0)
+	{
+		ThrowError("shape has no triangles or lines");
+	}
+
+	Write(image, recordOffset, record);
+}
+
+size_t ShapeSetParser::ParseCount(const char* what)
+{
+	// the line and its start move with the whitespace, the error points at the number
+	SkipWhitespace();
+	const char* pToken = m_pCurrent;
+	size_t count = ParseNumber<size_t>(what);
+
+	if (count > MAX_ELEMENTS_COUNT)
+	{
+		m_pCurrent = pToken;
+		ThrowError(string(what) + " is too large");
+	}
+
+	return count;
+}
+
+unsigned ShapeSetParser::ParseIndex(size_t verticesCount, const char* what)
+{
+	// see ParseCount
+	SkipWhitespace();
+	const char* pToken = m_pCurrent;
+	unsigned index = ParseNumber<unsigned>(what);
+
+	if (index >= verticesCount)
+	{
+		m_pCurrent = pToken;
+		ThrowError(string(what) + " " + to_string(index) + " is out of range");
+	}
+
+	return index;
+}
+
+float ShapeSetParser::ParseFloat(const char* what)
+{
+	return ParseNumber<float>(what);
+}
+
+template <typename NumberType>
+NumberType ShapeSetParser::ParseNumber(const char* what)
+{
+	SkipWhitespace();
+
+	if (m_pCurrent == m_pEnd)
+	{
+		ThrowError(string("unexpected end of file, expected ") + what);
+	}
+
+	NumberType number;
+	from_chars_result result = from_chars(m_pCurrent, m_pEnd, number);
+
+	if (result.ec != errc() || (result.ptr != m_pEnd && !isspace((unsigned char)*result.ptr)))
+	{
+		ThrowError(string("invalid ") + what);
+	}
+
+	m_pCurrent = result.ptr;
+
+	return number;
+}
+
+void ShapeSetParser::SkipWhitespace()
+{
+	for ( ; m_pCurrent != m_pEnd && isspace((unsigned char)*m_pCurrent); ++m_pCurrent)
+	{
+		if (*m_pCurrent == '\n')
+		{
+			++m_Line;
+			m_pLineStart = m_pCurrent + 1;
+		}
+	}
+}
+
+void ShapeSetParser::ThrowError(const string& message) const
+{
+	throw ShapeSetParseError(m_SourceName, m_Line, size_t(m_pCurrent - m_pLineStart) + 1, message);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// failure to open, parse or validate a shape set
+class ShapeSetError : public std::runtime_error
+{
+public:
+	explicit ShapeSetError(const std::string& message)
+		: std::runtime_error(message)
+	{
+	}
+};
+
+// syntax or range error in a text shape set, positions are 1-based
+class ShapeSetParseError : public ShapeSetError
+{
+public:
+	ShapeSetParseError(const std::string& sourceName, size_t line, size_t column, const std::string& message);
+
+	size_t GetLine() const;
+	size_t GetColumn() const;
+
+private:
+	size_t m_Line;
+	size_t m_Column;
+};
+
+// Single pass parser of the text shape set format. It works on the whole
+// file in memory (usually a MappedFile) and converts numbers with
+// std::from_chars, so it is locale independent and does not allocate per
+// number. The result is written straight into a binary ShapeSetImage.
+// Shapes with no vertices get their mesh generated from the cube positions
+// by ShapeMeshBuilder.
+class ShapeSetParser
+{
+public:
+	ShapeSetParser(const char* pText, size_t size, const std::string& sourceName);
+
+	// throws ShapeSetParseError
+	void Parse(std::vector<char>& image);
+
+private:
+	void ParseShape(std::vector<char>& image, size_t recordOffset);
+
+	size_t ParseCount(const char* what);
+	unsigned ParseIndex(size_t verticesCount, const char* what);
+	float ParseFloat(const char* what);
+
+	template <typename NumberType>
+	NumberType ParseNumber(const char* what);
+
+	void SkipWhitespace();
+
+	void ThrowError(const std::string& message) const;
+
+	const char* m_pCurrent;
+	const char* m_pEnd;
+	const char* m_pLineStart;
+	size_t m_Line;
+
+	const std::string& m_SourceName;
+};
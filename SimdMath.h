@@ -0,0 +1,509 @@
+#pragma once
+
+// Header only replacement of the D3DX math used by the game: the types keep
+// the D3DX memory layout (row major matrices applied to row vectors) and the
+// functions keep the D3DX names without the prefix, argument order and
+// results, so the renderer can hand them straight to Direct3D. Matrix
+// products, point transforms and quaternion interpolation run on SSE when
+// available; define MATH_NO_SIMD to force the scalar code. Both paths add
+// the products in the same order, so they give the same results.
+
+#if !defined(MATH_NO_SIMD) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__))
+#define MATH_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+struct Vector3
+{
+	Vector3() {}
+	Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
+	explicit Vector3(const float* pValues) : x(pValues[0]), y(pValues[1]), z(pValues[2]) {}
+
+	operator float* () { return &x; }
+	operator const float* () const { return &x; }
+
+	Vector3& operator += (const Vector3& v) { x += v.x; y += v.y; z += v.z; return *this; }
+	Vector3& operator -= (const Vector3& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+	Vector3& operator *= (float s) { x *= s; y *= s; z *= s; return *this; }
+	Vector3& operator /= (float s) { float inverse = 1.0f / s; x *= inverse; y *= inverse; z *= inverse; return *this; }
+
+	Vector3 operator + () const { return *this; }
+	Vector3 operator - () const { return Vector3(-x, -y, -z); }
+
+	Vector3 operator + (const Vector3& v) const { return Vector3(x + v.x, y + v.y, z + v.z); }
+	Vector3 operator - (const Vector3& v) const { return Vector3(x - v.x, y - v.y, z - v.z); }
+	Vector3 operator * (float s) const { return Vector3(x * s, y * s, z * s); }
+	Vector3 operator / (float s) const { float inverse = 1.0f / s; return Vector3(x * inverse, y * inverse, z * inverse); }
+
+	friend Vector3 operator * (float s, const Vector3& v) { return v * s; }
+
+	bool operator == (const Vector3& v) const { return x == v.x && y == v.y && z == v.z; }
+	bool operator != (const Vector3& v) const { return !(*this == v); }
+
+	float x, y, z;
+};
+
+struct Quaternion
+{
+	Quaternion() {}
+	Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	explicit Quaternion(const float* pValues) : x(pValues[0]), y(pValues[1]), z(pValues[2]), w(pValues[3]) {}
+
+	operator float* () { return &x; }
+	operator const float* () const { return &x; }
+
+	// q1 * q2 rotates by q1 first, like D3DXQUATERNION
+	inline Quaternion& operator *= (const Quaternion& q);
+	inline Quaternion operator * (const Quaternion& q) const;
+
+	Quaternion operator + (const Quaternion& q) const { return Quaternion(x + q.x, y + q.y, z + q.z, w + q.w); }
+	Quaternion operator - (const Quaternion& q) const { return Quaternion(x - q.x, y - q.y, z - q.z, w - q.w); }
+	Quaternion operator * (float s) const { return Quaternion(x * s, y * s, z * s, w * s); }
+
+	bool operator == (const Quaternion& q) const { return x == q.x && y == q.y && z == q.z && w == q.w; }
+	bool operator != (const Quaternion& q) const { return !(*this == q); }
+
+	float x, y, z, w;
+};
+
+struct Matrix
+{
+	Matrix() {}
+	Matrix(
+		float f11, float f12, float f13, float f14,
+		float f21, float f22, float f23, float f24,
+		float f31, float f32, float f33, float f34,
+		float f41, float f42, float f43, float f44)
+		: _11(f11), _12(f12), _13(f13), _14(f14)
+		, _21(f21), _22(f22), _23(f23), _24(f24)
+		, _31(f31), _32(f32), _33(f33), _34(f34)
+		, _41(f41), _42(f42), _43(f43), _44(f44)
+	{
+	}
+
+	operator float* () { return &_11; }
+	operator const float* () const { return &_11; }
+
+	float& operator () (unsigned row, unsigned column) { return m[row][column]; }
+	float operator () (unsigned row, unsigned column) const { return m[row][column]; }
+
+	inline Matrix& operator *= (const Matrix& matrix);
+	inline Matrix operator * (const Matrix& matrix) const;
+
+	bool operator == (const Matrix& matrix) const { return memcmp(m, matrix.m, sizeof(m)) == 0; }
+	bool operator != (const Matrix& matrix) const { return !(*this == matrix); }
+
+	union
+	{
+		struct
+		{
+			float _11, _12, _13, _14;
+			float _21, _22, _23, _24;
+			float _31, _32, _33, _34;
+			float _41, _42, _43, _44;
+		};
+
+		float m[4][4];
+	};
+};
+
+struct Color
+{
+	Color() {}
+	Color(float r, float g, float b, float a) : r(r), g(g), b(b), a(a) {}
+	explicit Color(const float* pValues) : r(pValues[0]), g(pValues[1]), b(pValues[2]), a(pValues[3]) {}
+
+	operator float* () { return &r; }
+	operator const float* () const { return &r; }
+
+	Color operator + (const Color& c) const { return Color(r + c.r, g + c.g, b + c.b, a + c.a); }
+	Color operator - (const Color& c) const { return Color(r - c.r, g - c.g, b - c.b, a - c.a); }
+	Color operator * (float s) const { return Color(r * s, g * s, b * s, a * s); }
+
+	bool operator == (const Color& c) const { return r == c.r && g == c.g && b == c.b && a == c.a; }
+	bool operator != (const Color& c) const { return !(*this == c); }
+
+	float r, g, b, a;
+};
+
+#pragma region vector functions
+
+inline float Vec3Dot(const Vector3* pV1, const Vector3* pV2)
+{
+	return pV1->x * pV2->x + pV1->y * pV2->y + pV1->z * pV2->z;
+}
+
+inline float Vec3Length(const Vector3* pV)
+{
+	return sqrtf(Vec3Dot(pV, pV));
+}
+
+inline Vector3* Vec3Cross(Vector3* pOut, const Vector3* pV1, const Vector3* pV2)
+{
+	Vector3 cross(
+		pV1->y * pV2->z - pV1->z * pV2->y,
+		pV1->z * pV2->x - pV1->x * pV2->z,
+		pV1->x * pV2->y - pV1->y * pV2->x);
+
+	*pOut = cross;
+	return pOut;
+}
+
+inline Vector3* Vec3Normalize(Vector3* pOut, const Vector3* pV)
+{
+	float length = Vec3Length(pV);
+
+	if (length == 0.0f)
+	{
+		*pOut = Vector3(0.0f, 0.0f, 0.0f);
+	}
+	else
+	{
+		*pOut = *pV / length;
+	}
+
+	return pOut;
+}
+
+inline Vector3* Vec3Lerp(Vector3* pOut, const Vector3* pV1, const Vector3* pV2, float s)
+{
+	pOut->x = pV1->x + s * (pV2->x - pV1->x);
+	pOut->y = pV1->y + s * (pV2->y - pV1->y);
+	pOut->z = pV1->z + s * (pV2->z - pV1->z);
+	return pOut;
+}
+
+// transforms (x, y, z, 1) and projects the result back to w = 1
+inline Vector3* Vec3TransformCoord(Vector3* pOut, const Vector3* pV, const Matrix* pM)
+{
+#ifdef MATH_USE_SSE
+	__m128 result = _mm_mul_ps(_mm_set1_ps(pV->x), _mm_loadu_ps(pM->m[0]));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(pV->y), _mm_loadu_ps(pM->m[1])));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(pV->z), _mm_loadu_ps(pM->m[2])));
+	result = _mm_add_ps(result, _mm_loadu_ps(pM->m[3]));
+
+	float values[4];
+	_mm_storeu_ps(values, result);
+#else
+	float values[4];
+
+	for (int column = 0; column < 4; ++column)
+	{
+		values[column] = pV->x * pM->m[0][column] + pV->y * pM->m[1][column] + pV->z * pM->m[2][column] + pM->m[3][column];
+	}
+#endif
+
+	float inverseW = 1.0f / values[3];
+
+	pOut->x = values[0] * inverseW;
+	pOut->y = values[1] * inverseW;
+	pOut->z = values[2] * inverseW;
+	return pOut;
+}
+
+#pragma endregion
+
+#pragma region matrix functions
+
+inline Matrix* MatrixIdentity(Matrix* pOut)
+{
+	*pOut = Matrix(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+	return pOut;
+}
+
+// pOut may alias either argument
+inline Matrix* MatrixMultiply(Matrix* pOut, const Matrix* pM1, const Matrix* pM2)
+{
+#ifdef MATH_USE_SSE
+	__m128 row0 = _mm_loadu_ps(pM2->m[0]);
+	__m128 row1 = _mm_loadu_ps(pM2->m[1]);
+	__m128 row2 = _mm_loadu_ps(pM2->m[2]);
+	__m128 row3 = _mm_loadu_ps(pM2->m[3]);
+
+	__m128 result[4];
+
+	for (int i = 0; i < 4; ++i)
+	{
+		__m128 r = _mm_mul_ps(_mm_set1_ps(pM1->m[i][0]), row0);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pM1->m[i][1]), row1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pM1->m[i][2]), row2));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pM1->m[i][3]), row3));
+		result[i] = r;
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		_mm_storeu_ps(pOut->m[i], result[i]);
+	}
+#else
+	Matrix result;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			result.m[i][j] = pM1->m[i][0] * pM2->m[0][j] + pM1->m[i][1] * pM2->m[1][j] + pM1->m[i][2] * pM2->m[2][j] + pM1->m[i][3] * pM2->m[3][j];
+		}
+	}
+
+	*pOut = result;
+#endif
+
+	return pOut;
+}
+
+inline Matrix* MatrixScaling(Matrix* pOut, float x, float y, float z)
+{
+	MatrixIdentity(pOut);
+	pOut->_11 = x;
+	pOut->_22 = y;
+	pOut->_33 = z;
+	return pOut;
+}
+
+inline Matrix* MatrixTranslation(Matrix* pOut, float x, float y, float z)
+{
+	MatrixIdentity(pOut);
+	pOut->_41 = x;
+	pOut->_42 = y;
+	pOut->_43 = z;
+	return pOut;
+}
+
+inline Matrix* MatrixRotationQuaternion(Matrix* pOut, const Quaternion* pQ)
+{
+	float x = pQ->x, y = pQ->y, z = pQ->z, w = pQ->w;
+
+	*pOut = Matrix(
+		1.0f - 2.0f * (y * y + z * z),	2.0f * (x * y + z * w),			2.0f * (x * z - y * w),			0.0f,
+		2.0f * (x * y - z * w),			1.0f - 2.0f * (x * x + z * z),	2.0f * (y * z + x * w),			0.0f,
+		2.0f * (x * z + y * w),			2.0f * (y * z - x * w),			1.0f - 2.0f * (x * x + y * y),	0.0f,
+		0.0f,							0.0f,							0.0f,							1.0f);
+	return pOut;
+}
+
+// roll around z first, then pitch around x and yaw around y
+inline Matrix* MatrixRotationYawPitchRoll(Matrix* pOut, float yaw, float pitch, float roll)
+{
+	float sy = sinf(yaw), cy = cosf(yaw);
+	float sp = sinf(pitch), cp = cosf(pitch);
+	float sr = sinf(roll), cr = cosf(roll);
+
+	*pOut = Matrix(
+		cr * cy + sr * sp * sy,		sr * cp,	sr * sp * cy - cr * sy,		0.0f,
+		cr * sp * sy - sr * cy,		cr * cp,	sr * sy + cr * sp * cy,		0.0f,
+		cp * sy,					-sp,		cp * cy,					0.0f,
+		0.0f,						0.0f,		0.0f,						1.0f);
+	return pOut;
+}
+
+inline Matrix* MatrixLookAtLH(Matrix* pOut, const Vector3* pEye, const Vector3* pAt, const Vector3* pUp)
+{
+	Vector3 xAxis, yAxis, zAxis;
+
+	Vector3 direction = *pAt - *pEye;
+	Vec3Normalize(&zAxis, &direction);
+	Vec3Cross(&xAxis, pUp, &zAxis);
+	Vec3Normalize(&xAxis, &xAxis);
+	Vec3Cross(&yAxis, &zAxis, &xAxis);
+
+	*pOut = Matrix(
+		xAxis.x,					yAxis.x,					zAxis.x,					0.0f,
+		xAxis.y,					yAxis.y,					zAxis.y,					0.0f,
+		xAxis.z,					yAxis.z,					zAxis.z,					0.0f,
+		-Vec3Dot(&xAxis, pEye),		-Vec3Dot(&yAxis, pEye),		-Vec3Dot(&zAxis, pEye),		1.0f);
+	return pOut;
+}
+
+inline Matrix* MatrixPerspectiveFovLH(Matrix* pOut, float fovY, float aspect, float zNear, float zFar)
+{
+	float yScale = 1.0f / tanf(0.5f * fovY);
+	float xScale = yScale / aspect;
+	float depth = zFar / (zFar - zNear);
+
+	*pOut = Matrix(
+		xScale,	0.0f,	0.0f,				0.0f,
+		0.0f,	yScale,	0.0f,				0.0f,
+		0.0f,	0.0f,	depth,				1.0f,
+		0.0f,	0.0f,	-zNear * depth,		0.0f);
+	return pOut;
+}
+
+Matrix& Matrix::operator *= (const Matrix& matrix)
+{
+	MatrixMultiply(this, this, &matrix);
+	return *this;
+}
+
+Matrix Matrix::operator * (const Matrix& matrix) const
+{
+	Matrix result;
+	MatrixMultiply(&result, this, &matrix);
+	return result;
+}
+
+#pragma endregion
+
+#pragma region quaternion functions
+
+inline Quaternion* QuaternionIdentity(Quaternion* pOut)
+{
+	*pOut = Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+	return pOut;
+}
+
+inline float QuaternionDot(const Quaternion* pQ1, const Quaternion* pQ2)
+{
+	return pQ1->x * pQ2->x + pQ1->y * pQ2->y + pQ1->z * pQ2->z + pQ1->w * pQ2->w;
+}
+
+inline Quaternion* QuaternionNormalize(Quaternion* pOut, const Quaternion* pQ)
+{
+	float length = sqrtf(QuaternionDot(pQ, pQ));
+
+	if (length == 0.0f)
+	{
+		*pOut = Quaternion(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+	else
+	{
+		*pOut = *pQ * (1.0f / length);
+	}
+
+	return pOut;
+}
+
+// rotation by pQ1 followed by pQ2, pOut may alias either argument
+inline Quaternion* QuaternionMultiply(Quaternion* pOut, const Quaternion* pQ1, const Quaternion* pQ2)
+{
+	const Quaternion& a = *pQ2;
+	const Quaternion& b = *pQ1;
+
+	Quaternion result(
+		a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+
+	*pOut = result;
+	return pOut;
+}
+
+inline Quaternion* QuaternionRotationAxis(Quaternion* pOut, const Vector3* pAxis, float angle)
+{
+	Vector3 axis;
+	Vec3Normalize(&axis, pAxis);
+
+	float s = sinf(0.5f * angle);
+
+	*pOut = Quaternion(axis.x * s, axis.y * s, axis.z * s, cosf(0.5f * angle));
+	return pOut;
+}
+
+// same order of rotations as MatrixRotationYawPitchRoll
+inline Quaternion* QuaternionRotationYawPitchRoll(Quaternion* pOut, float yaw, float pitch, float roll)
+{
+	float sy = sinf(0.5f * yaw), cy = cosf(0.5f * yaw);
+	float sp = sinf(0.5f * pitch), cp = cosf(0.5f * pitch);
+	float sr = sinf(0.5f * roll), cr = cosf(0.5f * roll);
+
+	*pOut = Quaternion(
+		cy * sp * cr + sy * cp * sr,
+		sy * cp * cr - cy * sp * sr,
+		cy * cp * sr - sy * sp * cr,
+		cy * cp * cr + sy * sp * sr);
+	return pOut;
+}
+
+// pM must be a pure rotation
+inline Quaternion* QuaternionRotationMatrix(Quaternion* pOut, const Matrix* pM)
+{
+	const Matrix& m = *pM;
+	float trace = m._11 + m._22 + m._33;
+
+	if (trace > 0.0f)
+	{
+		float s = 2.0f * sqrtf(trace + 1.0f);
+		*pOut = Quaternion((m._23 - m._32) / s, (m._31 - m._13) / s, (m._12 - m._21) / s, 0.25f * s);
+	}
+	else if (m._11 > m._22 && m._11 > m._33)
+	{
+		float s = 2.0f * sqrtf(1.0f + m._11 - m._22 - m._33);
+		*pOut = Quaternion(0.25f * s, (m._12 + m._21) / s, (m._13 + m._31) / s, (m._23 - m._32) / s);
+	}
+	else if (m._22 > m._33)
+	{
+		float s = 2.0f * sqrtf(1.0f + m._22 - m._11 - m._33);
+		*pOut = Quaternion((m._12 + m._21) / s, 0.25f * s, (m._23 + m._32) / s, (m._31 - m._13) / s);
+	}
+	else
+	{
+		float s = 2.0f * sqrtf(1.0f + m._33 - m._11 - m._22);
+		*pOut = Quaternion((m._13 + m._31) / s, (m._23 + m._32) / s, 0.25f * s, (m._12 - m._21) / s);
+	}
+
+	return pOut;
+}
+
+// spherical interpolation along the shorter arc
+inline Quaternion* QuaternionSlerp(Quaternion* pOut, const Quaternion* pQ1, const Quaternion* pQ2, float t)
+{
+	float dot = QuaternionDot(pQ1, pQ2);
+	float sign = 1.0f;
+
+	if (dot < 0.0f)
+	{
+		sign = -1.0f;
+		dot = -dot;
+	}
+
+	float weight1 = 1.0f - t;
+	float weight2 = t;
+
+	// nearly equal rotations fall back to linear interpolation
+	if (1.0f - dot > 0.001f)
+	{
+		float theta = acosf(dot);
+		float inverseSinTheta = 1.0f / sinf(theta);
+
+		weight1 = sinf(theta * weight1) * inverseSinTheta;
+		weight2 = sinf(theta * weight2) * inverseSinTheta;
+	}
+
+	weight2 *= sign;
+
+#ifdef MATH_USE_SSE
+	__m128 result = _mm_add_ps(
+		_mm_mul_ps(_mm_set1_ps(weight1), _mm_loadu_ps(&pQ1->x)),
+		_mm_mul_ps(_mm_set1_ps(weight2), _mm_loadu_ps(&pQ2->x)));
+
+	_mm_storeu_ps(&pOut->x, result);
+#else
+	*pOut = Quaternion(
+		weight1 * pQ1->x + weight2 * pQ2->x,
+		weight1 * pQ1->y + weight2 * pQ2->y,
+		weight1 * pQ1->z + weight2 * pQ2->z,
+		weight1 * pQ1->w + weight2 * pQ2->w);
+#endif
+
+	return pOut;
+}
+
+Quaternion& Quaternion::operator *= (const Quaternion& q)
+{
+	QuaternionMultiply(this, this, &q);
+	return *this;
+}
+
+Quaternion Quaternion::operator * (const Quaternion& q) const
+{
+	Quaternion result;
+	QuaternionMultiply(&result, this, &q);
+	return result;
+}
+
+#pragma endregion
@@ -0,0 +1,149 @@
+#include "pch.h"
+#include "Simulation.h"
+#include "Clock.h"
+#include "FrameProfiler.h"
+
+using namespace std;
+
+namespace
+{
+
+// from whole ticks, so a sum of tick times doesn't drift from the clock
+int64_t GetTicksTime(int64_t ticksCount)
+{
+	return ticksCount * NANOSECONDS_PER_SECOND / Simulation::TICKS_PER_SECOND;
+}
+
+// a simulation held up longer than this (a debugger, a suspended process)
+// drops the missed ticks instead of running them all at once
+const unsigned MAX_LATE_TICKS_COUNT = 8;
+
+}
+
+Simulation::Simulation(Game& game, const Clock& clock)
+	: m_Game(game)
+	, m_Clock(clock)
+	, m_TicksCount(0)
+	, m_IsRunning(false)
+	, m_IsSuspended(false)
+	, m_PendingKey(GAME_KEY_NONE)
+{
+}
+
+Simulation::~Simulation()
+{
+	Stop();
+}
+
+void Simulation::Start()
+{
+	assert(!m_IsRunning);
+
+	m_Game.Publish(m_Snapshots.GetWriteBuffer());
+	m_Snapshots.GetWriteBuffer().Tick = m_TicksCount;
+	m_Snapshots.Publish();
+
+	m_IsRunning = true;
+	m_Thread = thread(&Simulation::Run, this);
+}
+
+void Simulation::Stop()
+{
+	m_IsRunning = false;
+
+	if (m_Thread.joinable())
+	{
+		m_Thread.join();
+	}
+}
+
+void Simulation::PostKey(GameKey key)
+{
+	m_PendingKey = key;
+}
+
+void Simulation::SetSuspended(bool isSuspended)
+{
+	m_IsSuspended = isSuspended;
+}
+
+const GameSnapshot& Simulation::GetLatestSnapshot()
+{
+	// the thread sets the error before it clears m_IsRunning
+	if (!m_IsRunning && m_Error)
+	{
+		Stop();
+		rethrow_exception(m_Error);
+	}
+
+	m_Snapshots.Update();
+	return m_Snapshots.GetReadBuffer();
+}
+
+void Simulation::Run()
+{
+	FrameProfiler::SetThreadName("simulation");
+
+	// deadlines are counted from a start in whole ticks, so they don't drift
+	int64_t start = m_Clock.GetNanoseconds();
+	int64_t ticksSinceStart = 0;
+
+	try
+	{
+		while (m_IsRunning)
+		{
+			++ticksSinceStart;
+			const int64_t nextTick = start + GetTicksTime(ticksSinceStart);
+
+			// virtual time may stand still, Stop must still get through
+			while (m_IsRunning && m_Clock.GetNanoseconds() < nextTick)
+			{
+				m_Clock.WaitUntil(nextTick);
+			}
+
+			if (!m_IsRunning)
+			{
+				break;
+			}
+
+			if (!m_IsSuspended)
+			{
+				Tick();
+			}
+
+			const int64_t now = m_Clock.GetNanoseconds();
+
+			if (now - nextTick > GetTicksTime(MAX_LATE_TICKS_COUNT))
+			{
+				start = now;
+				ticksSinceStart = 0;
+			}
+		}
+	}
+	catch (...)
+	{
+		m_Error = current_exception();
+		m_IsRunning = false;
+	}
+}
+
+void Simulation::Tick()
+{
+	ScopedPhaseTimer timer(PHASE_SIMULATION_TICK);
+
+	GameKey key = GameKey(m_PendingKey.exchange(GAME_KEY_NONE));
+
+	if (key != GAME_KEY_NONE)
+	{
+		m_Game.OnKeyPressed(key);
+	}
+
+	m_Game.Update(GetTicksTime(int64_t(m_TicksCount) + 1) - GetTicksTime(int64_t(m_TicksCount)));
+	++m_TicksCount;
+
+	GameSnapshot& snapshot = m_Snapshots.GetWriteBuffer();
+	m_Game.Publish(snapshot);
+	snapshot.Tick = m_TicksCount;
+
+	m_Snapshots.Publish();
+}
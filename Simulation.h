@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Game.h"
+#include "GameSnapshot.h"
+#include "TripleBuffer.h"
+#include "Clock.h"
+
+// Runs the game on a thread of its own at a fixed tick rate, so input and
+// gravity keep their pace whatever the frame rate is. Every tick ends with
+// a snapshot published through a triple buffer; the render thread draws
+// the latest one and never waits for the simulation, nor it for rendering.
+class Simulation
+{
+public:
+	static const unsigned TICKS_PER_SECOND = 120;
+
+	// the game must not be used by anyone else until Stop; ticks are paced
+	// by the clock, a ManualClock runs the game on virtual time
+	explicit Simulation(Game& game, const Clock& clock = Clock::GetSteadyClock());
+	~Simulation();
+
+	// publishes the first snapshot before the thread starts
+	void Start();
+	void Stop();
+
+	// any thread, the key reaches the game at the start of the next tick
+	void PostKey(GameKey key);
+
+	// a suspended simulation doesn't advance, e.g. while the window is inactive
+	void SetSuspended(bool isSuspended);
+
+	// render thread only; rethrows an exception that ended the simulation
+	const GameSnapshot& GetLatestSnapshot();
+
+private:
+	Simulation(const Simulation&);
+	Simulation& operator = (const Simulation&);
+
+	void Run();
+	void Tick();
+
+	Game& m_Game;
+	const Clock& m_Clock;
+	TripleBuffer<GameSnapshot> m_Snapshots;
+	uint64_t m_TicksCount;
+
+	std::thread m_Thread;
+	std::atomic<bool> m_IsRunning;
+	std::atomic<bool> m_IsSuspended;
+
+	// the last key posted since the previous tick, like Game keeps it
+	std::atomic<int> m_PendingKey;
+
+	std::exception_ptr m_Error;
+};
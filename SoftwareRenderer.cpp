@@ -0,0 +1,855 @@
+#include "pch.h"
+#include "SoftwareRenderer.h"
+#include "StackInstances.h"
+
+using namespace std;
+
+namespace
+{
+
+typedef vector<char> SoftwareBuffer;
+
+SoftwareBuffer* ToSoftwareBuffer(RenderBuffer* pBuffer)
+{
+	return reinterpret_cast<SoftwareBuffer*>(pBuffer);
+}
+
+// tiles are squares of TILE_SIZE pixels, the last row and column may be cut
+const unsigned TILE_SIZE = 64;
+
+// vertices are snapped to 1/16 of a pixel, so edges shared by two triangles
+// are walked exactly the same way and no pixel is drawn twice or missed
+const int SUBPIXEL_BITS = 4;
+const int SUBPIXEL_SCALE = 1 << SUBPIXEL_BITS;
+const int SUBPIXEL_HALF = SUBPIXEL_SCALE / 2;
+
+// at most 3 vertices plus one for each of the 6 clip planes
+const size_t MAX_CLIPPED_VERTICES_COUNT = 9;
+
+const size_t CLIP_PLANES_COUNT = 6;
+
+// signed distance to a clip plane of D3D, inside when not negative
+template <typename Vertex>
+float GetPlaneDistance(const Vertex& v, size_t plane)
+{
+	switch (plane)
+	{
+	case 0: return v.w + v.x;
+	case 1: return v.w - v.x;
+	case 2: return v.w + v.y;
+	case 3: return v.w - v.y;
+	case 4: return v.z;
+	default: return v.w - v.z;
+	}
+}
+
+template <typename Vertex>
+Vertex Lerp(const Vertex& v0, const Vertex& v1, float t)
+{
+	Vertex v;
+	v.x = v0.x + (v1.x - v0.x) * t;
+	v.y = v0.y + (v1.y - v0.y) * t;
+	v.z = v0.z + (v1.z - v0.z) * t;
+	v.w = v0.w + (v1.w - v0.w) * t;
+	v.u = v0.u + (v1.u - v0.u) * t;
+	v.v = v0.v + (v1.v - v0.v) * t;
+	return v;
+}
+
+float Saturate(float value)
+{
+	return min(max(value, 0.0f), 1.0f);
+}
+
+// source of D3D10_BLEND_SRC_ALPHA, D3D10_BLEND_INV_SRC_ALPHA for the colors
+// and D3D10_BLEND_ONE, D3D10_BLEND_ZERO for the alpha
+struct BlendSource
+{
+	explicit BlendSource(const Color& color)
+	{
+		float alpha = Saturate(color.a);
+
+		r = Saturate(color.r) * alpha * 255.0f + 0.5f;
+		g = Saturate(color.g) * alpha * 255.0f + 0.5f;
+		b = Saturate(color.b) * alpha * 255.0f + 0.5f;
+		a = uint32_t(alpha * 255.0f + 0.5f) << 24;
+		InverseAlpha = 1.0f - alpha;
+	}
+
+	uint32_t Blend(uint32_t destination) const
+	{
+		uint32_t blendedR = uint32_t(r + float(destination & 0xff) * InverseAlpha);
+		uint32_t blendedG = uint32_t(g + float((destination >> 8) & 0xff) * InverseAlpha);
+		uint32_t blendedB = uint32_t(b + float((destination >> 16) & 0xff) * InverseAlpha);
+
+		return min(blendedR, 255u) | (min(blendedG, 255u) << 8) | (min(blendedB, 255u) << 16) | a;
+	}
+
+	float r, g, b;
+	uint32_t a;
+	float InverseAlpha;
+};
+
+// edge function of a triangle in subpixel units, not negative inside
+struct Edge
+{
+	Edge(int x0, int y0, int x1, int y1, int startX, int startY)
+		: StepX(-int64_t(y1 - y0) * SUBPIXEL_SCALE)
+		, StepY(int64_t(x1 - x0) * SUBPIXEL_SCALE)
+	{
+		// pixels on an edge belong to the triangle on its right or below it,
+		// the top-left rule of D3D
+		bool isTopLeft = y1 < y0 || (y1 == y0 && x1 > x0);
+
+		Value = int64_t(x1 - x0) * (startY - y0) - int64_t(y1 - y0) * (startX - x0) - (isTopLeft ? 0 : 1);
+	}
+
+	int64_t Value;
+	int64_t StepX;
+	int64_t StepY;
+};
+
+}
+
+SoftwareRenderer::SoftwareRenderer(unsigned width, unsigned height, unsigned threadsCount /*= 0*/)
+	: m_Width(0)
+	, m_Height(0)
+	, m_ThreadsCount(threadsCount != 0 ? threadsCount : max(thread::hardware_concurrency(), 1u))
+	, m_TilesCountX(0)
+	, m_TilesCountY(0)
+	, m_ClearColor(BLACK)
+	, m_VertexFormat(VERTEX_FORMAT_POSITION)
+	, m_pVertexBuffer(nullptr)
+	, m_pInstanceBuffer(nullptr)
+	, m_InstanceSize(0)
+	, m_pIndexBuffer(nullptr)
+	, m_Topology(TOPOLOGY_TRIANGLE_LIST)
+	, m_pTexture(nullptr)
+	, m_Pass(RENDER_PASS_SOLID)
+	, m_Color(BLACK)
+{
+	MatrixIdentity(&m_World);
+	MatrixIdentity(&m_ViewProjection);
+
+	Resize(width, height);
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+}
+
+// buffers
+
+RenderBuffer* SoftwareRenderer::CreateVertexBuffer(const void* pVertices, size_t size)
+{
+	assert(size > 0);
+
+	SoftwareBuffer* pBuffer = new SoftwareBuffer(size);
+	memcpy(&pBuffer->front(), pVertices, size);
+
+	return reinterpret_cast<RenderBuffer*>(pBuffer);
+}
+
+RenderBuffer* SoftwareRenderer::CreateIndexBuffer(const unsigned* pIndices, size_t count)
+{
+	return CreateVertexBuffer(pIndices, count * sizeof(unsigned));
+}
+
+RenderBuffer* SoftwareRenderer::CreateDynamicVertexBuffer(size_t size)
+{
+	assert(size > 0);
+	return reinterpret_cast<RenderBuffer*>(new SoftwareBuffer(size));
+}
+
+RenderBuffer* SoftwareRenderer::CreateDynamicIndexBuffer(size_t count)
+{
+	return CreateDynamicVertexBuffer(count * sizeof(unsigned));
+}
+
+void SoftwareRenderer::UpdateDynamicBuffer(RenderBuffer* pBuffer, const void* pData, size_t size)
+{
+	SoftwareBuffer* pSoftwareBuffer = ToSoftwareBuffer(pBuffer);
+	assert(size <= pSoftwareBuffer->size());
+
+	memcpy(&pSoftwareBuffer->front(), pData, size);
+}
+
+void SoftwareRenderer::ReleaseBuffer(RenderBuffer* pBuffer)
+{
+	delete ToSoftwareBuffer(pBuffer);
+}
+
+// textures
+
+RenderTexture* SoftwareRenderer::CreateTexture(size_t width, size_t height, const uint8_t* pCoverage)
+{
+	assert(width > 0 && height > 0 && pCoverage);
+
+	Texture* pTexture = new Texture;
+	pTexture->Width = width;
+	pTexture->Height = height;
+	pTexture->Coverage.assign(pCoverage, pCoverage + width * height);
+
+	return reinterpret_cast<RenderTexture*>(pTexture);
+}
+
+void SoftwareRenderer::ReleaseTexture(RenderTexture* pTexture)
+{
+	delete reinterpret_cast<Texture*>(pTexture);
+}
+
+// draw submission
+
+void SoftwareRenderer::BeginFrame()
+{
+}
+
+void SoftwareRenderer::SetVertexBuffers(VertexFormat format, RenderBuffer* pVertexBuffer, RenderBuffer* pInstanceBuffer, size_t instanceSize)
+{
+	m_VertexFormat = format;
+	m_pVertexBuffer = ToSoftwareBuffer(pVertexBuffer);
+	m_pInstanceBuffer = ToSoftwareBuffer(pInstanceBuffer);
+	m_InstanceSize = instanceSize;
+}
+
+void SoftwareRenderer::SetIndexBuffer(RenderBuffer* pIndexBuffer)
+{
+	m_pIndexBuffer = ToSoftwareBuffer(pIndexBuffer);
+}
+
+void SoftwareRenderer::SetTopology(PrimitiveTopology topology)
+{
+	m_Topology = topology;
+}
+
+void SoftwareRenderer::SetTexture(RenderTexture* pTexture)
+{
+	m_pTexture = reinterpret_cast<const Texture*>(pTexture);
+}
+
+void SoftwareRenderer::ApplyPass(RenderPass pass)
+{
+	m_Pass = pass;
+}
+
+void SoftwareRenderer::DrawIndexed(size_t indicesCount, size_t startIndex, int baseVertex)
+{
+	DrawIndexedInstanced(indicesCount, 1, startIndex, baseVertex);
+}
+
+void SoftwareRenderer::DrawIndexedInstanced(size_t indicesCount, size_t instancesCount, size_t startIndex, int baseVertex)
+{
+	assert(m_pVertexBuffer && m_pIndexBuffer);
+	assert((m_VertexFormat == VERTEX_FORMAT_INSTANCED) == (m_pInstanceBuffer != nullptr));
+
+	if (indicesCount == 0)
+	{
+		return;
+	}
+
+	const unsigned* pIndices = reinterpret_cast<const unsigned*>(&m_pIndexBuffer->front()) + startIndex;
+	assert((startIndex + indicesCount) * sizeof(unsigned) <= m_pIndexBuffer->size());
+
+	// only the vertices the indices reach are transformed
+	unsigned minIndex = UINT_MAX;
+	unsigned maxIndex = 0;
+
+	for (size_t i = 0; i < indicesCount; ++i)
+	{
+		minIndex = min(minIndex, pIndices[i]);
+		maxIndex = max(maxIndex, pIndices[i]);
+	}
+
+	assert(m_Pass != RENDER_PASS_TEXT || m_pTexture);
+
+	const size_t stride = GetVertexSize(m_VertexFormat);
+	const size_t firstVertex = minIndex + baseVertex;
+	const size_t verticesCount = maxIndex - minIndex + 1;
+	assert((firstVertex + verticesCount) * stride <= m_pVertexBuffer->size());
+
+	m_ClipVertices.resize(verticesCount);
+	m_VertexColors.resize(verticesCount);
+
+	const Matrix worldViewProjection = m_Pass == RENDER_PASS_TEXT ? m_World : m_World * m_ViewProjection;
+
+	for (size_t instance = 0; instance < instancesCount; ++instance)
+	{
+		// the instance cell goes through the world matrix like in InstancedVS
+		Vector3 cell(0.0f, 0.0f, 0.0f);
+		Color instanceColor = m_Color;
+
+		if (m_pInstanceBuffer)
+		{
+			assert((instance + 1) * m_InstanceSize <= m_pInstanceBuffer->size());
+			const StackInstance& stackInstance = *reinterpret_cast<const StackInstance*>(&m_pInstanceBuffer->front() + instance * m_InstanceSize);
+
+			cell = stackInstance.Cell;
+
+			if (m_Pass == RENDER_PASS_INSTANCED_FACES)
+			{
+				instanceColor = stackInstance.LevelColor;
+			}
+		}
+
+		for (size_t i = 0; i < verticesCount; ++i)
+		{
+			const char* pVertex = &m_pVertexBuffer->front() + (firstVertex + i) * stride;
+			const Vector3 position = reinterpret_cast<const Vertex*>(pVertex)->Position + cell;
+			const Matrix& m = worldViewProjection;
+
+			ClipVertex& clipVertex = m_ClipVertices[i];
+			clipVertex.x = position.x * m._11 + position.y * m._21 + position.z * m._31 + m._41;
+			clipVertex.y = position.x * m._12 + position.y * m._22 + position.z * m._32 + m._42;
+			clipVertex.z = position.x * m._13 + position.y * m._23 + position.z * m._33 + m._43;
+			clipVertex.w = position.x * m._14 + position.y * m._24 + position.z * m._34 + m._44;
+			clipVertex.u = 0.0f;
+			clipVertex.v = 0.0f;
+
+			switch (m_Pass)
+			{
+			case RENDER_PASS_COLORED_FACES:
+				m_VertexColors[i] = reinterpret_cast<const ColoredVertex*>(pVertex)->VertexColor;
+				break;
+
+			case RENDER_PASS_TEXT:
+				clipVertex.u = reinterpret_cast<const TextVertex*>(pVertex)->U;
+				clipVertex.v = reinterpret_cast<const TextVertex*>(pVertex)->V;
+				m_VertexColors[i] = reinterpret_cast<const TextVertex*>(pVertex)->VertexColor;
+				break;
+
+			default:
+				m_VertexColors[i] = instanceColor;
+				break;
+			}
+		}
+
+		// faces of the colored meshes and glyph quads have a single color,
+		// the one of their first vertex is taken
+		switch (m_Topology)
+		{
+		case TOPOLOGY_TRIANGLE_LIST:
+			for (size_t i = 0; i + 2 < indicesCount; i += 3)
+			{
+				unsigned v0 = pIndices[i] - minIndex;
+				unsigned v1 = pIndices[i + 1] - minIndex;
+				unsigned v2 = pIndices[i + 2] - minIndex;
+				AssembleTriangle(m_ClipVertices[v0], m_ClipVertices[v1], m_ClipVertices[v2], m_VertexColors[v0]);
+			}
+			break;
+
+		case TOPOLOGY_TRIANGLE_STRIP:
+			// odd triangles are flipped to keep the winding of the strip
+			for (size_t i = 0; i + 2 < indicesCount; ++i)
+			{
+				unsigned v0 = pIndices[i] - minIndex;
+				unsigned v1 = pIndices[i + 1 + (i & 1)] - minIndex;
+				unsigned v2 = pIndices[i + 2 - (i & 1)] - minIndex;
+				AssembleTriangle(m_ClipVertices[v0], m_ClipVertices[v1], m_ClipVertices[v2], m_VertexColors[v0]);
+			}
+			break;
+
+		case TOPOLOGY_LINE_LIST:
+			for (size_t i = 0; i + 1 < indicesCount; i += 2)
+			{
+				unsigned v0 = pIndices[i] - minIndex;
+				unsigned v1 = pIndices[i + 1] - minIndex;
+				AssembleLine(m_ClipVertices[v0], m_ClipVertices[v1], m_VertexColors[v0]);
+			}
+			break;
+		}
+	}
+}
+
+// constants
+
+void SoftwareRenderer::SetColor(const Color& color)
+{
+	m_Color = color;
+}
+
+void SoftwareRenderer::SetWorld(const Matrix& world)
+{
+	m_World = world;
+}
+
+void SoftwareRenderer::SetViewProjection(const Matrix& viewProjection)
+{
+	m_ViewProjection = viewProjection;
+}
+
+// frame
+
+void SoftwareRenderer::Resize(unsigned width, unsigned height)
+{
+	assert(width > 0 && height > 0);
+
+	m_Width = width;
+	m_Height = height;
+
+	m_TilesCountX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	m_TilesCountY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+	m_ColorBuffer.assign(width * height, 0);
+	m_DepthBuffer.assign(width * height, 1.0f);
+
+	m_Primitives.clear();
+	m_Bins.assign(m_TilesCountX * m_TilesCountY, vector<unsigned>());
+}
+
+void SoftwareRenderer::SetClearColor(const Color& color)
+{
+	m_ClearColor = color;
+}
+
+void SoftwareRenderer::Rasterize()
+{
+	const unsigned tilesCount = m_TilesCountX * m_TilesCountY;
+	const unsigned threadsCount = min(m_ThreadsCount, tilesCount);
+
+	// tiles are handed out one by one, so threads stuck on crowded tiles
+	// don't hold the others back
+	atomic<unsigned> nextTile(0);
+
+	auto job = [&]()
+	{
+		for (unsigned tile = nextTile++; tile < tilesCount; tile = nextTile++)
+		{
+			RasterizeTile(tile);
+		}
+	};
+
+	vector<thread> threads;
+
+	for (unsigned worker = 1; worker < threadsCount; ++worker)
+	{
+		threads.push_back(thread(job));
+	}
+
+	job();
+
+	for (size_t i = 0; i < threads.size(); ++i)
+	{
+		threads[i].join();
+	}
+
+	m_Primitives.clear();
+
+	for (size_t tile = 0; tile < m_Bins.size(); ++tile)
+	{
+		m_Bins[tile].clear();
+	}
+}
+
+unsigned SoftwareRenderer::GetWidth() const
+{
+	return m_Width;
+}
+
+unsigned SoftwareRenderer::GetHeight() const
+{
+	return m_Height;
+}
+
+const uint32_t* SoftwareRenderer::GetPixels() const
+{
+	return &m_ColorBuffer.front();
+}
+
+bool SoftwareRenderer::WriteTga(const string& fileName) const
+{
+	ofstream file(fileName, ios::binary);
+
+	// true color image, 8 bits of alpha, rows from the top
+	const unsigned char header[18] =
+	{
+		0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		(unsigned char)(m_Width & 0xff), (unsigned char)(m_Width >> 8),
+		(unsigned char)(m_Height & 0xff), (unsigned char)(m_Height >> 8),
+		32, 0x28
+	};
+
+	file.write((const char*)header, sizeof(header));
+
+	// TGA keeps BGRA
+	vector<uint32_t> row(m_Width);
+
+	for (unsigned y = 0; y < m_Height; ++y)
+	{
+		const uint32_t* pPixels = &m_ColorBuffer[y * m_Width];
+
+		for (unsigned x = 0; x < m_Width; ++x)
+		{
+			uint32_t pixel = pPixels[x];
+			row[x] = (pixel & 0xff00ff00) | ((pixel & 0xff) << 16) | ((pixel >> 16) & 0xff);
+		}
+
+		file.write((const char*)&row.front(), m_Width * sizeof(uint32_t));
+	}
+
+	return file.good();
+}
+
+// primitives
+
+void SoftwareRenderer::AssembleTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, const Color& color)
+{
+	ClipVertex polygon[MAX_CLIPPED_VERTICES_COUNT] = { v0, v1, v2 };
+	size_t verticesCount = 3;
+
+	// Sutherland-Hodgman against the planes the triangle crosses, most
+	// triangles are inside all of them
+	for (size_t plane = 0; plane < CLIP_PLANES_COUNT; ++plane)
+	{
+		float distances[MAX_CLIPPED_VERTICES_COUNT];
+		size_t outsideCount = 0;
+
+		for (size_t i = 0; i < verticesCount; ++i)
+		{
+			distances[i] = GetPlaneDistance(polygon[i], plane);
+			outsideCount += distances[i] < 0.0f ? 1 : 0;
+		}
+
+		if (outsideCount == verticesCount)
+		{
+			return;
+		}
+
+		if (outsideCount == 0)
+		{
+			continue;
+		}
+
+		ClipVertex clipped[MAX_CLIPPED_VERTICES_COUNT];
+		size_t clippedCount = 0;
+
+		for (size_t i = 0; i < verticesCount; ++i)
+		{
+			size_t next = (i + 1) % verticesCount;
+
+			if (distances[i] >= 0.0f)
+			{
+				clipped[clippedCount++] = polygon[i];
+			}
+
+			if ((distances[i] < 0.0f) != (distances[next] < 0.0f))
+			{
+				clipped[clippedCount++] = Lerp(polygon[i], polygon[next], distances[i] / (distances[i] - distances[next]));
+			}
+		}
+
+		copy(clipped, clipped + clippedCount, polygon);
+		verticesCount = clippedCount;
+	}
+
+	Primitive primitive;
+	primitive.PrimitiveColor = color;
+	primitive.pTexture = m_Pass == RENDER_PASS_TEXT ? m_pTexture : nullptr;
+	primitive.IsLine = false;
+	primitive.Vertices[0] = ToScreen(polygon[0]);
+
+	// the clipped polygon is convex, a fan keeps its winding
+	for (size_t i = 1; i + 1 < verticesCount; ++i)
+	{
+		primitive.Vertices[1] = ToScreen(polygon[i]);
+		primitive.Vertices[2] = ToScreen(polygon[i + 1]);
+
+		const ScreenVertex* v = primitive.Vertices;
+		float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+
+		// clockwise on the screen is the front, like D3D10_CULL_BACK with
+		// FrontCounterClockwise off
+		if (area > 0.0f)
+		{
+			AddPrimitive(primitive);
+		}
+	}
+}
+
+void SoftwareRenderer::AssembleLine(const ClipVertex& v0, const ClipVertex& v1, const Color& color)
+{
+	float t0 = 0.0f;
+	float t1 = 1.0f;
+
+	for (size_t plane = 0; plane < CLIP_PLANES_COUNT; ++plane)
+	{
+		float d0 = GetPlaneDistance(v0, plane);
+		float d1 = GetPlaneDistance(v1, plane);
+
+		if (d0 < 0.0f && d1 < 0.0f)
+		{
+			return;
+		}
+
+		if (d0 < 0.0f)
+		{
+			t0 = max(t0, d0 / (d0 - d1));
+		}
+		else if (d1 < 0.0f)
+		{
+			t1 = min(t1, d0 / (d0 - d1));
+		}
+	}
+
+	if (t0 >= t1)
+	{
+		return;
+	}
+
+	Primitive primitive;
+	primitive.PrimitiveColor = color;
+	primitive.pTexture = nullptr;
+	primitive.IsLine = true;
+	primitive.Vertices[0] = ToScreen(Lerp(v0, v1, t0));
+	primitive.Vertices[1] = ToScreen(Lerp(v0, v1, t1));
+	primitive.Vertices[2] = primitive.Vertices[1];
+
+	AddPrimitive(primitive);
+}
+
+void SoftwareRenderer::AddPrimitive(const Primitive& primitive)
+{
+	const ScreenVertex* v = primitive.Vertices;
+
+	float minX = min(min(v[0].x, v[1].x), v[2].x);
+	float maxX = max(max(v[0].x, v[1].x), v[2].x);
+	float minY = min(min(v[0].y, v[1].y), v[2].y);
+	float maxY = max(max(v[0].y, v[1].y), v[2].y);
+
+	int left = max(int(floor(minX)), 0);
+	int right = min(int(floor(maxX)), int(m_Width) - 1);
+	int top = max(int(floor(minY)), 0);
+	int bottom = min(int(floor(maxY)), int(m_Height) - 1);
+
+	if (left > right || top > bottom)
+	{
+		return;
+	}
+
+	const unsigned index = unsigned(m_Primitives.size());
+	m_Primitives.push_back(primitive);
+
+	for (int tileY = top / TILE_SIZE; tileY <= bottom / int(TILE_SIZE); ++tileY)
+	{
+		for (int tileX = left / TILE_SIZE; tileX <= right / int(TILE_SIZE); ++tileX)
+		{
+			m_Bins[tileY * m_TilesCountX + tileX].push_back(index);
+		}
+	}
+}
+
+SoftwareRenderer::ScreenVertex SoftwareRenderer::ToScreen(const ClipVertex& vertex) const
+{
+	float inverseW = 1.0f / vertex.w;
+
+	ScreenVertex screenVertex;
+	screenVertex.x = (vertex.x * inverseW + 1.0f) * 0.5f * m_Width;
+	screenVertex.y = (1.0f - vertex.y * inverseW) * 0.5f * m_Height;
+	screenVertex.z = vertex.z * inverseW;
+	screenVertex.u = vertex.u;
+	screenVertex.v = vertex.v;
+	return screenVertex;
+}
+
+// rasterization
+
+void SoftwareRenderer::RasterizeTile(unsigned tile)
+{
+	const int left = (tile % m_TilesCountX) * TILE_SIZE;
+	const int top = (tile / m_TilesCountX) * TILE_SIZE;
+	const int right = min(left + int(TILE_SIZE), int(m_Width));
+	const int bottom = min(top + int(TILE_SIZE), int(m_Height));
+
+	const uint32_t clearColor = BlendSource(Color(m_ClearColor.r, m_ClearColor.g, m_ClearColor.b, 1.0f)).Blend(0);
+
+	for (int y = top; y < bottom; ++y)
+	{
+		fill(&m_ColorBuffer[y * m_Width + left], &m_ColorBuffer[y * m_Width + right], clearColor);
+		fill(&m_DepthBuffer[y * m_Width + left], &m_DepthBuffer[y * m_Width + right], 1.0f);
+	}
+
+	const vector<unsigned>& bin = m_Bins[tile];
+
+	for (size_t i = 0; i < bin.size(); ++i)
+	{
+		const Primitive& primitive = m_Primitives[bin[i]];
+
+		if (primitive.IsLine)
+		{
+			RasterizeLine(primitive, left, top, right, bottom);
+		}
+		else
+		{
+			RasterizeTriangle(primitive, left, top, right, bottom);
+		}
+	}
+}
+
+void SoftwareRenderer::RasterizeTriangle(const Primitive& primitive, int left, int top, int right, int bottom)
+{
+	const ScreenVertex* v = primitive.Vertices;
+
+	int x[3];
+	int y[3];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		x[i] = int(floor(v[i].x * SUBPIXEL_SCALE + 0.5f));
+		y[i] = int(floor(v[i].y * SUBPIXEL_SCALE + 0.5f));
+	}
+
+	const int64_t area = int64_t(x[1] - x[0]) * (y[2] - y[0]) - int64_t(x[2] - x[0]) * (y[1] - y[0]);
+
+	if (area <= 0)
+	{
+		return;
+	}
+
+	// pixels whose centers may be covered, within the tile
+	int minX = max(left, (min(min(x[0], x[1]), x[2]) - SUBPIXEL_HALF) >> SUBPIXEL_BITS);
+	int maxX = min(right - 1, (max(max(x[0], x[1]), x[2]) - SUBPIXEL_HALF) >> SUBPIXEL_BITS);
+	int minY = max(top, (min(min(y[0], y[1]), y[2]) - SUBPIXEL_HALF) >> SUBPIXEL_BITS);
+	int maxY = min(bottom - 1, (max(max(y[0], y[1]), y[2]) - SUBPIXEL_HALF) >> SUBPIXEL_BITS);
+
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	const int startX = minX * SUBPIXEL_SCALE + SUBPIXEL_HALF;
+	const int startY = minY * SUBPIXEL_SCALE + SUBPIXEL_HALF;
+
+	// e0 weights the first vertex, e1 the second and e2 the third
+	Edge e0(x[1], y[1], x[2], y[2], startX, startY);
+	Edge e1(x[2], y[2], x[0], y[0], startX, startY);
+	Edge e2(x[0], y[0], x[1], y[1], startX, startY);
+
+	// depth is affine on the screen
+	const float inverseArea = 1.0f / float(area);
+	const float depthStepX = (float(e1.StepX) * (v[1].z - v[0].z) + float(e2.StepX) * (v[2].z - v[0].z)) * inverseArea;
+	const float depthStepY = (float(e1.StepY) * (v[1].z - v[0].z) + float(e2.StepY) * (v[2].z - v[0].z)) * inverseArea;
+	float depthRow = v[0].z + (float(e1.Value) * (v[1].z - v[0].z) + float(e2.Value) * (v[2].z - v[0].z)) * inverseArea;
+
+	// and so are the texture coordinates of the text
+	const Texture* pTexture = primitive.pTexture;
+	float uStepX = 0.0f, uStepY = 0.0f, uRow = 0.0f;
+	float vStepX = 0.0f, vStepY = 0.0f, vRow = 0.0f;
+
+	if (pTexture)
+	{
+		uStepX = (float(e1.StepX) * (v[1].u - v[0].u) + float(e2.StepX) * (v[2].u - v[0].u)) * inverseArea;
+		uStepY = (float(e1.StepY) * (v[1].u - v[0].u) + float(e2.StepY) * (v[2].u - v[0].u)) * inverseArea;
+		uRow = v[0].u + (float(e1.Value) * (v[1].u - v[0].u) + float(e2.Value) * (v[2].u - v[0].u)) * inverseArea;
+
+		vStepX = (float(e1.StepX) * (v[1].v - v[0].v) + float(e2.StepX) * (v[2].v - v[0].v)) * inverseArea;
+		vStepY = (float(e1.StepY) * (v[1].v - v[0].v) + float(e2.StepY) * (v[2].v - v[0].v)) * inverseArea;
+		vRow = v[0].v + (float(e1.Value) * (v[1].v - v[0].v) + float(e2.Value) * (v[2].v - v[0].v)) * inverseArea;
+	}
+
+	const BlendSource source(primitive.PrimitiveColor);
+
+	for (int py = minY; py <= maxY; ++py)
+	{
+		int64_t w0 = e0.Value;
+		int64_t w1 = e1.Value;
+		int64_t w2 = e2.Value;
+		float depth = depthRow;
+		float textureU = uRow;
+		float textureV = vRow;
+
+		uint32_t* pColor = &m_ColorBuffer[py * m_Width];
+		float* pDepth = &m_DepthBuffer[py * m_Width];
+
+		for (int px = minX; px <= maxX; ++px)
+		{
+			if ((w0 | w1 | w2) >= 0 && depth <= pDepth[px])
+			{
+				pDepth[px] = depth;
+
+				if (pTexture)
+				{
+					// TextPS with a clamped point sampler
+					size_t texelX = size_t(min(max(textureU * pTexture->Width, 0.0f), float(pTexture->Width - 1)));
+					size_t texelY = size_t(min(max(textureV * pTexture->Height, 0.0f), float(pTexture->Height - 1)));
+
+					Color color = primitive.PrimitiveColor;
+					color.a *= pTexture->Coverage[texelY * pTexture->Width + texelX] / 255.0f;
+					pColor[px] = BlendSource(color).Blend(pColor[px]);
+				}
+				else
+				{
+					pColor[px] = source.Blend(pColor[px]);
+				}
+			}
+
+			w0 += e0.StepX;
+			w1 += e1.StepX;
+			w2 += e2.StepX;
+			depth += depthStepX;
+			textureU += uStepX;
+			textureV += vStepX;
+		}
+
+		e0.Value += e0.StepY;
+		e1.Value += e1.StepY;
+		e2.Value += e2.StepY;
+		depthRow += depthStepY;
+		uRow += uStepY;
+		vRow += vStepY;
+	}
+}
+
+void SoftwareRenderer::RasterizeLine(const Primitive& primitive, int left, int top, int right, int bottom)
+{
+	ScreenVertex v0 = primitive.Vertices[0];
+	ScreenVertex v1 = primitive.Vertices[1];
+
+	const bool isXMajor = fabs(v1.x - v0.x) >= fabs(v1.y - v0.y);
+
+	// walks the major axis, one pixel for every pixel center in [start, end)
+	if (isXMajor ? v0.x > v1.x : v0.y > v1.y)
+	{
+		swap(v0, v1);
+	}
+
+	const float start = isXMajor ? v0.x : v0.y;
+	const float length = isXMajor ? v1.x - v0.x : v1.y - v0.y;
+
+	if (length <= 0.0f)
+	{
+		return;
+	}
+
+	const float minorStart = isXMajor ? v0.y : v0.x;
+	const float minorLength = isXMajor ? v1.y - v0.y : v1.x - v0.x;
+
+	int first = int(ceil(start - 0.5f));
+	int last = int(ceil(start + length - 0.5f)) - 1;
+
+	first = max(first, isXMajor ? left : top);
+	last = min(last, (isXMajor ? right : bottom) - 1);
+
+	const int minorMin = isXMajor ? top : left;
+	const int minorMax = isXMajor ? bottom : right;
+
+	const BlendSource source(primitive.PrimitiveColor);
+
+	for (int major = first; major <= last; ++major)
+	{
+		float t = (float(major) + 0.5f - start) / length;
+		int minor = int(floor(minorStart + t * minorLength));
+
+		if (minor < minorMin || minor >= minorMax)
+		{
+			continue;
+		}
+
+		size_t pixel = isXMajor ? minor * m_Width + major : major * m_Width + minor;
+		float depth = v0.z + t * (v1.z - v0.z);
+
+		if (depth <= m_DepthBuffer[pixel])
+		{
+			m_DepthBuffer[pixel] = depth;
+			m_ColorBuffer[pixel] = source.Blend(m_ColorBuffer[pixel]);
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Renderer.h"
+
+// Draws on the CPU what BlockOut.fx draws on the GPU: flat colors, text
+// sampled from its atlas with the nearest texel, blending
+// with the source alpha like BlockOut::BuildBlendStates, depth test
+// LESS_EQUAL with depth writes like BlockOut::BuildDepthStencilState, and
+// back faces culled like the default rasterizer state. Draws are transformed,
+// clipped and binned into tiles as they come; Rasterize then fills the tiles
+// in parallel, each one in submission order, so the image doesn't depend on
+// the threads count. Needs no graphics API and runs on any platform.
+class SoftwareRenderer : public Renderer
+{
+public:
+	// 0 uses all hardware threads
+	SoftwareRenderer(unsigned width, unsigned height, unsigned threadsCount = 0);
+	virtual ~SoftwareRenderer();
+
+	virtual RenderBuffer* CreateVertexBuffer(const void* pVertices, size_t size);
+	virtual RenderBuffer* CreateIndexBuffer(const unsigned* pIndices, size_t count);
+	virtual RenderBuffer* CreateDynamicVertexBuffer(size_t size);
+	virtual RenderBuffer* CreateDynamicIndexBuffer(size_t count);
+	virtual void UpdateDynamicBuffer(RenderBuffer* pBuffer, const void* pData, size_t size);
+	virtual void ReleaseBuffer(RenderBuffer* pBuffer);
+
+	virtual RenderTexture* CreateTexture(size_t width, size_t height, const uint8_t* pCoverage);
+	virtual void ReleaseTexture(RenderTexture* pTexture);
+
+	// keeps the primitives of the earlier flushes, so the HUD lands on the
+	// scene of the same frame
+	virtual void BeginFrame();
+
+	virtual void SetVertexBuffers(VertexFormat format, RenderBuffer* pVertexBuffer, RenderBuffer* pInstanceBuffer, size_t instanceSize);
+	virtual void SetIndexBuffer(RenderBuffer* pIndexBuffer);
+	virtual void SetTopology(PrimitiveTopology topology);
+	virtual void SetTexture(RenderTexture* pTexture);
+	virtual void ApplyPass(RenderPass pass);
+
+	virtual void DrawIndexed(size_t indicesCount, size_t startIndex, int baseVertex);
+	virtual void DrawIndexedInstanced(size_t indicesCount, size_t instancesCount, size_t startIndex, int baseVertex);
+
+	virtual void SetColor(const Color& color);
+	virtual void SetWorld(const Matrix& world);
+	// ignored by the text pass, whose world maps pixels to clip space like
+	// TextVS
+	virtual void SetViewProjection(const Matrix& viewProjection);
+
+	// drops the primitives of the current frame
+	void Resize(unsigned width, unsigned height);
+
+	void SetClearColor(const Color& color);
+
+	// clears the frame, draws everything submitted since the last Rasterize
+	// and drops it
+	void Rasterize();
+
+	unsigned GetWidth() const;
+	unsigned GetHeight() const;
+
+	// RGBA with 8 bits per channel, rows from the top
+	const uint32_t* GetPixels() const;
+
+	// uncompressed 32 bit TGA, returns false when the file can't be written
+	bool WriteTga(const std::string& fileName) const;
+
+private:
+	// coverage rows from the top
+	struct Texture
+	{
+		size_t Width;
+		size_t Height;
+		std::vector<uint8_t> Coverage;
+	};
+
+	// position after the viewport transformation, z is the depth, u and v
+	// are interpolated on the screen like it, the text has no perspective
+	struct ScreenVertex
+	{
+		float x, y, z;
+		float u, v;
+	};
+
+	struct Primitive
+	{
+		ScreenVertex Vertices[3];
+		Color PrimitiveColor;
+		const Texture* pTexture;	// text triangles only
+		bool IsLine;
+	};
+
+	// homogeneous clip space position and texture coordinates
+	struct ClipVertex
+	{
+		float x, y, z, w;
+		float u, v;
+	};
+
+	// clips and bins the primitives of the current draw
+	void AssembleTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, const Color& color);
+	void AssembleLine(const ClipVertex& v0, const ClipVertex& v1, const Color& color);
+	void AddPrimitive(const Primitive& primitive);
+
+	void RasterizeTile(unsigned tile);
+	void RasterizeTriangle(const Primitive& primitive, int left, int top, int right, int bottom);
+	void RasterizeLine(const Primitive& primitive, int left, int top, int right, int bottom);
+
+	ScreenVertex ToScreen(const ClipVertex& vertex) const;
+
+	unsigned m_Width;
+	unsigned m_Height;
+	unsigned m_ThreadsCount;
+
+	unsigned m_TilesCountX;
+	unsigned m_TilesCountY;
+
+	Color m_ClearColor;
+	std::vector<uint32_t> m_ColorBuffer;
+	std::vector<float> m_DepthBuffer;
+
+	// primitives of the frame and, per tile, the indices of the ones over it
+	std::vector<Primitive> m_Primitives;
+	std::vector<std::vector<unsigned> > m_Bins;
+
+	// bound state
+	VertexFormat m_VertexFormat;
+	const std::vector<char>* m_pVertexBuffer;
+	const std::vector<char>* m_pInstanceBuffer;
+	size_t m_InstanceSize;
+	const std::vector<char>* m_pIndexBuffer;
+	PrimitiveTopology m_Topology;
+	const Texture* m_pTexture;
+	RenderPass m_Pass;
+
+	Color m_Color;
+	Matrix m_World;
+	Matrix m_ViewProjection;
+
+	// vertices of the current draw in clip space and their colors
+	std::vector<ClipVertex> m_ClipVertices;
+	std::vector<Color> m_VertexColors;
+};
@@ -0,0 +1,85 @@
+#include "pch.h"
+#include "StackFaceMasks.h"
+
+StackFaceMasks::StackFaceMasks()
+{
+	Clear();
+}
+
+void StackFaceMasks::Clear()
+{
+	memset(m_Masks, 0, sizeof(m_Masks));
+}
+
+StackFaceMasks::Mask StackFaceMasks::GetMask(size_t x, size_t y, size_t z) const
+{
+	assert(x < PIT_X_SIZE && y < PIT_Y_SIZE && z < PIT_Z_SIZE);
+	return m_Masks[z][y][x];
+}
+
+void StackFaceMasks::OnCellOccupied(const Pit& pit, size_t x, size_t y, size_t z)
+{
+	int cellX = int(x), cellY = int(y), cellZ = int(z);
+
+	// the new cube and the neighbours it may cover
+	UpdateCell(pit, cellX, cellY, cellZ);
+	UpdateCell(pit, cellX - 1, cellY, cellZ);
+	UpdateCell(pit, cellX + 1, cellY, cellZ);
+	UpdateCell(pit, cellX, cellY - 1, cellZ);
+	UpdateCell(pit, cellX, cellY + 1, cellZ);
+	UpdateCell(pit, cellX, cellY, cellZ + 1);
+}
+
+void StackFaceMasks::OnLevelRemoved(const Pit& pit, size_t z)
+{
+	assert(z < PIT_Z_SIZE);
+
+	// levels above move down unchanged, their neighbours moved with them
+	memmove(m_Masks[1], m_Masks[0], z * sizeof(m_Masks[0]));
+	memset(m_Masks[0], 0, sizeof(m_Masks[0]));
+
+	// only the tops of the level below the removed one see something new
+	for (int y = 0; y < int(PIT_Y_SIZE); ++y)
+	{
+		for (int x = 0; x < int(PIT_X_SIZE); ++x)
+		{
+			UpdateCell(pit, x, y, int(z) + 1);
+		}
+	}
+}
+
+void StackFaceMasks::Rebuild(const Pit& pit)
+{
+	for (int z = 0; z < int(PIT_Z_SIZE); ++z)
+	{
+		for (int y = 0; y < int(PIT_Y_SIZE); ++y)
+		{
+			for (int x = 0; x < int(PIT_X_SIZE); ++x)
+			{
+				UpdateCell(pit, x, y, z);
+			}
+		}
+	}
+}
+
+void StackFaceMasks::UpdateCell(const Pit& pit, int x, int y, int z)
+{
+	if (x < 0 || x >= int(PIT_X_SIZE) || y < 0 || y >= int(PIT_Y_SIZE) || z < 0 || z >= int(PIT_Z_SIZE))
+	{
+		return;
+	}
+
+	Mask mask = 0;
+
+	if (pit.IsOccupied(x, y, z))
+	{
+		// only sides facing the middle of the pit can be seen
+		if (!pit.IsOccupied(x, y, z - 1)) mask |= FACE_TOP;
+		if (x > int(PIT_X_SIZE / 2) && !pit.IsOccupied(x - 1, y, z)) mask |= FACE_LEFT;
+		if (x < int(PIT_X_SIZE / 2) && !pit.IsOccupied(x + 1, y, z)) mask |= FACE_RIGHT;
+		if (y > int(PIT_Y_SIZE / 2) && !pit.IsOccupied(x, y - 1, z)) mask |= FACE_FRONT;
+		if (y < int(PIT_Y_SIZE / 2) && !pit.IsOccupied(x, y + 1, z)) mask |= FACE_BACK;
+	}
+
+	m_Masks[z][y][x] = mask;
+}
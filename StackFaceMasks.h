@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Pit.h"
+
+// Faces of every settled cube the camera can see, kept up to date around
+// the changed cells only, so drawing the stack does no neighbour lookups.
+// A face is exposed when the neighbouring cell is free and the face looks
+// towards the middle of the pit, where the camera is; the bottom face is
+// never seen. Free cells and fully hidden cubes have an empty mask.
+class StackFaceMasks
+{
+public:
+	typedef uint8_t Mask;
+
+	enum Face
+	{
+		FACE_TOP	= 1 << 0,	// -z, towards the camera
+		FACE_LEFT	= 1 << 1,	// -x
+		FACE_RIGHT	= 1 << 2,	// +x
+		FACE_FRONT	= 1 << 3,	// -y
+		FACE_BACK	= 1 << 4,	// +y
+	};
+
+	StackFaceMasks();
+
+	void Clear();
+
+	Mask GetMask(size_t x, size_t y, size_t z) const;
+
+	// call after the pit changed in the same way
+	void OnCellOccupied(const Pit& pit, size_t x, size_t y, size_t z);
+	void OnLevelRemoved(const Pit& pit, size_t z);
+
+	// recomputes every cell
+	void Rebuild(const Pit& pit);
+
+private:
+	void UpdateCell(const Pit& pit, int x, int y, int z);
+
+	Mask m_Masks[PIT_Z_SIZE][PIT_Y_SIZE][PIT_X_SIZE];
+};
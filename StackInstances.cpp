@@ -0,0 +1,37 @@
+#include "pch.h"
+#include "StackInstances.h"
+#include "StackFaceMasks.h"
+
+using namespace std;
+
+size_t StackInstanceBuilder::Build(
+	const Pit& pit,
+	const StackFaceMasks& faceMasks,
+	const Color* pLevelColors,
+	size_t levelColorsCount,
+	vector<StackInstance>& instances)
+{
+	assert(levelColorsCount > 0);
+
+	instances.clear();
+
+	// from the bottom, in the order the boxes were drawn one by one
+	for (int z = int(PIT_Z_SIZE) - 1; z >= int(pit.GetHighestOccupiedLevel()); --z)
+	{
+		for (size_t y = 0; y < PIT_Y_SIZE; ++y)
+		{
+			for (size_t x = 0; x < PIT_X_SIZE; ++x)
+			{
+				if (faceMasks.GetMask(x, y, z) != 0)
+				{
+					StackInstance instance;
+					instance.Cell = Vector3(float(x), float(y), float(z));
+					instance.LevelColor = pLevelColors[z % levelColorsCount];
+					instances.push_back(instance);
+				}
+			}
+		}
+	}
+
+	return instances.size();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+class Pit;
+class StackFaceMasks;
+
+// per instance data of a settled cube, the cell offset is in grid units
+// and goes through the world matrix of the grid
+struct StackInstance
+{
+	Vector3	Cell;
+	Color	LevelColor;
+};
+
+// Collects the visible cubes of the stack for instanced drawing, the cubes
+// with at least one exposed face. Needs no device, so the result can be
+// checked on the CPU alone.
+class StackInstanceBuilder
+{
+public:
+	// levels are colored cyclically with pLevelColors, returns the count
+	static size_t Build(
+		const Pit& pit,
+		const StackFaceMasks& faceMasks,
+		const Color* pLevelColors,
+		size_t levelColorsCount,
+		std::vector<StackInstance>& instances);
+};
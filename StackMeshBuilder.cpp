@@ -0,0 +1,359 @@
+#include "pch.h"
+#include "StackMeshBuilder.h"
+#include "StackFaceMasks.h"
+
+using namespace std;
+
+namespace
+{
+
+// faces of a cell that can be seen, the bottom one never is
+enum FaceDirection
+{
+	FACE_TOP,		// -z, towards the camera
+	FACE_LEFT,		// -x
+	FACE_RIGHT,		// +x
+	FACE_FRONT,		// -y
+	FACE_BACK,		// +y
+
+	FACE_DIRECTIONS_COUNT
+};
+
+struct FaceAxes
+{
+	StackFaceMasks::Mask Face;
+	int Normal;		// axis of the face normal
+	int Sign;		// direction of the normal along it
+	int U, V;		// axes spanning the face
+};
+
+const FaceAxes FACE_AXES[FACE_DIRECTIONS_COUNT] =
+{
+	{ StackFaceMasks::FACE_TOP,		2, -1, 0, 1 },
+	{ StackFaceMasks::FACE_LEFT,	0, -1, 1, 2 },
+	{ StackFaceMasks::FACE_RIGHT,	0,  1, 1, 2 },
+	{ StackFaceMasks::FACE_FRONT,	1, -1, 0, 2 },
+	{ StackFaceMasks::FACE_BACK,	1,  1, 0, 2 },
+};
+
+const int PIT_SIZE[3] = { int(PIT_X_SIZE), int(PIT_Y_SIZE), int(PIT_Z_SIZE) };
+
+// Every unit square of the cell lattice holds one visible face at most, the
+// cells on its two sides can't both show it, and a merged rectangle covers
+// one or more of them. Lines are merged from the unit edges of the lattice.
+const size_t MAX_FACES_COUNT =
+	(PIT_X_SIZE + 1) * PIT_Y_SIZE * PIT_Z_SIZE +
+	PIT_X_SIZE * (PIT_Y_SIZE + 1) * PIT_Z_SIZE +
+	PIT_X_SIZE * PIT_Y_SIZE * (PIT_Z_SIZE + 1);
+const size_t MAX_LINES_COUNT =
+	PIT_X_SIZE * (PIT_Y_SIZE + 1) * (PIT_Z_SIZE + 1) +
+	(PIT_X_SIZE + 1) * PIT_Y_SIZE * (PIT_Z_SIZE + 1) +
+	(PIT_X_SIZE + 1) * (PIT_Y_SIZE + 1) * PIT_Z_SIZE;
+
+// unit edge from Start along Axis, in cell corner coordinates
+struct Edge
+{
+	int Axis;
+	int Start[3];
+
+	bool operator < (const Edge& other) const
+	{
+		// edges of one line end up next to each other, ordered along it
+		int a = (Axis + 1) % 3, b = (Axis + 2) % 3;
+
+		if (Axis != other.Axis) return Axis < other.Axis;
+		if (Start[a] != other.Start[a]) return Start[a] < other.Start[a];
+		if (Start[b] != other.Start[b]) return Start[b] < other.Start[b];
+		return Start[Axis] < other.Start[Axis];
+	}
+
+	bool operator == (const Edge& other) const
+	{
+		return Axis == other.Axis
+			&& Start[0] == other.Start[0] && Start[1] == other.Start[1] && Start[2] == other.Start[2];
+	}
+};
+
+class StackMesher
+{
+public:
+	StackMesher(
+		const StackFaceMasks& faceMasks,
+		const Color* pLevelColors,
+		size_t levelColorsCount,
+		vector<ColoredVertex>& vertices,
+		vector<unsigned>& triangleIndices,
+		vector<unsigned>& lineIndices,
+		vector<Edge>& edges)
+		: m_FaceMasks(faceMasks)
+		, m_pLevelColors(pLevelColors)
+		, m_LevelColorsCount(levelColorsCount)
+		, m_Vertices(vertices)
+		, m_TriangleIndices(triangleIndices)
+		, m_LineIndices(lineIndices)
+		, m_Edges(edges)
+	{
+	}
+
+	void Build()
+	{
+		m_Vertices.clear();
+		m_TriangleIndices.clear();
+		m_LineIndices.clear();
+		m_Edges.clear();
+
+		for (int direction = 0; direction < FACE_DIRECTIONS_COUNT; ++direction)
+		{
+			const FaceAxes& axes = FACE_AXES[direction];
+
+			for (int slice = 0; slice < PIT_SIZE[axes.Normal]; ++slice)
+			{
+				MergeSlice(FaceDirection(direction), slice);
+			}
+		}
+
+		BuildOutline();
+	}
+
+private:
+	// greedy rectangles of equally colored visible faces in one slice
+	void MergeSlice(FaceDirection direction, int slice)
+	{
+		const FaceAxes& axes = FACE_AXES[direction];
+		int uSize = PIT_SIZE[axes.U], vSize = PIT_SIZE[axes.V];
+
+		// level color index + 1 per face, 0 for no face
+		int faces[PIT_Z_SIZE][PIT_Z_SIZE] = {};
+		static_assert(PIT_Z_SIZE >= PIT_X_SIZE && PIT_Z_SIZE >= PIT_Y_SIZE, "slice does not fit");
+
+		bool hasFace = false;
+
+		for (int v = 0; v < vSize; ++v)
+		{
+			for (int u = 0; u < uSize; ++u)
+			{
+				int cell[3];
+				cell[axes.Normal] = slice;
+				cell[axes.U] = u;
+				cell[axes.V] = v;
+
+				if (m_FaceMasks.GetMask(cell[0], cell[1], cell[2]) & axes.Face)
+				{
+					faces[v][u] = int(cell[2] % m_LevelColorsCount) + 1;
+					hasFace = true;
+
+					AddFaceEdges(axes, cell);
+				}
+			}
+		}
+
+		if (!hasFace)
+		{
+			return;
+		}
+
+		for (int v = 0; v < vSize; ++v)
+		{
+			for (int u = 0; u < uSize; )
+			{
+				int face = faces[v][u];
+
+				if (face == 0)
+				{
+					++u;
+					continue;
+				}
+
+				int width = 1;
+				while (u + width < uSize && faces[v][u + width] == face)
+				{
+					++width;
+				}
+
+				int height = 1;
+				while (v + height < vSize && HasRow(faces[v + height], u, width, face))
+				{
+					++height;
+				}
+
+				for (int row = v; row < v + height; ++row)
+				{
+					for (int column = u; column < u + width; ++column)
+					{
+						faces[row][column] = 0;
+					}
+				}
+
+				AddQuad(axes, slice, u, v, width, height, m_pLevelColors[face - 1]);
+
+				u += width;
+			}
+		}
+	}
+
+	static bool HasRow(const int* pRow, int u, int width, int face)
+	{
+		for (int column = u; column < u + width; ++column)
+		{
+			if (pRow[column] != face)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void AddQuad(const FaceAxes& axes, int slice, int u, int v, int width, int height, const Color& color)
+	{
+		// the face lies on the near or the far plane of its cells
+		float plane = float(axes.Sign > 0 ? slice + 1 : slice);
+
+		int cornersUV[4][2] = { { u, v }, { u + width, v }, { u + width, v + height }, { u, v + height } };
+
+		unsigned first = unsigned(m_Vertices.size());
+
+		for (int corner = 0; corner < 4; ++corner)
+		{
+			float position[3];
+			position[axes.Normal] = plane;
+			position[axes.U] = float(cornersUV[corner][0]);
+			position[axes.V] = float(cornersUV[corner][1]);
+
+			m_Vertices.push_back(ColoredVertex(Vector3(position[0], position[1], position[2]), color));
+		}
+
+		// front faces are clockwise seen from outside, their normal
+		// (c1 - c0) x (c2 - c0) points out of the cell
+		Vector3 edge1 = m_Vertices[first + 1].Position - m_Vertices[first].Position;
+		Vector3 edge2 = m_Vertices[first + 2].Position - m_Vertices[first].Position;
+		Vector3 normal;
+		Vec3Cross(&normal, &edge1, &edge2);
+
+		float outwards = (&normal.x)[axes.Normal] * axes.Sign;
+
+		unsigned second = outwards > 0.0f ? first + 1 : first + 3;
+		unsigned fourth = outwards > 0.0f ? first + 3 : first + 1;
+
+		unsigned indices[] = { first, second, first + 2, first, first + 2, fourth };
+		m_TriangleIndices.insert(m_TriangleIndices.end(), indices, indices + 6);
+	}
+
+	void AddFaceEdges(const FaceAxes& axes, const int cell[3])
+	{
+		int corner[3] = { cell[0], cell[1], cell[2] };
+
+		if (axes.Sign > 0)
+		{
+			++corner[axes.Normal];
+		}
+
+		Edge edge;
+
+		// the two edges along U, then the two along V
+		for (int i = 0; i < 2; ++i)
+		{
+			edge.Axis = axes.U;
+			memcpy(edge.Start, corner, sizeof(corner));
+			edge.Start[axes.V] += i;
+			m_Edges.push_back(edge);
+
+			edge.Axis = axes.V;
+			memcpy(edge.Start, corner, sizeof(corner));
+			edge.Start[axes.U] += i;
+			m_Edges.push_back(edge);
+		}
+	}
+
+	void BuildOutline()
+	{
+		sort(m_Edges.begin(), m_Edges.end());
+		m_Edges.erase(unique(m_Edges.begin(), m_Edges.end()), m_Edges.end());
+
+		for (size_t first = 0; first < m_Edges.size(); )
+		{
+			const Edge& start = m_Edges[first];
+			size_t last = first;
+
+			// collinear unit edges following each other form one line
+			while (last + 1 < m_Edges.size() && IsContinuation(m_Edges[last], m_Edges[last + 1]))
+			{
+				++last;
+			}
+
+			int end[3] = { start.Start[0], start.Start[1], start.Start[2] };
+			end[start.Axis] = m_Edges[last].Start[start.Axis] + 1;
+
+			AddLineVertex(start.Start);
+			AddLineVertex(end);
+
+			first = last + 1;
+		}
+	}
+
+	static bool IsContinuation(const Edge& edge, const Edge& next)
+	{
+		int a = (edge.Axis + 1) % 3, b = (edge.Axis + 2) % 3;
+
+		return next.Axis == edge.Axis
+			&& next.Start[a] == edge.Start[a]
+			&& next.Start[b] == edge.Start[b]
+			&& next.Start[edge.Axis] == edge.Start[edge.Axis] + 1;
+	}
+
+	void AddLineVertex(const int position[3])
+	{
+		m_LineIndices.push_back(unsigned(m_Vertices.size()));
+		m_Vertices.push_back(ColoredVertex(Vector3(float(position[0]), float(position[1]), float(position[2])), BLACK));
+	}
+
+	const StackFaceMasks& m_FaceMasks;
+	const Color* m_pLevelColors;
+	size_t m_LevelColorsCount;
+
+	vector<ColoredVertex>& m_Vertices;
+	vector<unsigned>& m_TriangleIndices;
+	vector<unsigned>& m_LineIndices;
+
+	vector<Edge>& m_Edges;
+};
+
+}
+
+void StackMeshBuilder::Build(
+	const StackFaceMasks& faceMasks,
+	const Color* pLevelColors,
+	size_t levelColorsCount,
+	vector<ColoredVertex>& vertices,
+	vector<unsigned>& triangleIndices,
+	vector<unsigned>& lineIndices)
+{
+	assert(levelColorsCount > 0);
+
+	// kept between builds like the output vectors, so a rebuild allocates
+	// only the first time on a thread
+	static thread_local vector<Edge> edges;
+	edges.reserve(4 * MAX_FACES_COUNT);
+
+	StackMesher mesher(faceMasks, pLevelColors, levelColorsCount, vertices, triangleIndices, lineIndices, edges);
+	mesher.Build();
+
+	assert(vertices.size() <= GetMaxVerticesCount());
+	assert(triangleIndices.size() <= GetMaxTriangleIndicesCount());
+	assert(lineIndices.size() <= GetMaxLineIndicesCount());
+}
+
+size_t StackMeshBuilder::GetMaxVerticesCount()
+{
+	return 4 * MAX_FACES_COUNT + 2 * MAX_LINES_COUNT;
+}
+
+size_t StackMeshBuilder::GetMaxTriangleIndicesCount()
+{
+	return 6 * MAX_FACES_COUNT;
+}
+
+size_t StackMeshBuilder::GetMaxLineIndicesCount()
+{
+	return 2 * MAX_LINES_COUNT;
+}
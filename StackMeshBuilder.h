@@ -0,0 +1,27 @@
+#pragma once
+
+class StackFaceMasks;
+
+// Turns the settled stack into one mesh. Only the exposed faces of
+// StackFaceMasks are kept and coplanar faces of the same level color are
+// merged greedily into rectangles. The outline has the edges of every
+// visible cell face, merged into the longest straight lines. Plain C++
+// without a device, so the counts can be checked on any platform, see
+// BlockOutBench -stack-meshes.
+class StackMeshBuilder
+{
+public:
+	// levels are colored cyclically with pLevelColors
+	static void Build(
+		const StackFaceMasks& faceMasks,
+		const Color* pLevelColors,
+		size_t levelColorsCount,
+		std::vector<ColoredVertex>& vertices,
+		std::vector<unsigned>& triangleIndices,
+		std::vector<unsigned>& lineIndices);
+
+	// the most any stack of the pit needs, for buffers made once
+	static size_t GetMaxVerticesCount();
+	static size_t GetMaxTriangleIndicesCount();
+	static size_t GetMaxLineIndicesCount();
+};
@@ -0,0 +1,421 @@
+#include "pch.h"
+#include "Tracer.h"
+#include "Clock.h"
+
+using namespace std;
+
+namespace
+{
+
+enum TraceEventType
+{
+	TRACE_COMPLETE,
+	TRACE_INSTANT,
+};
+
+struct TraceEvent
+{
+	const char* Category;
+	const char* Name;
+	const char* ArgName;
+	int64_t ArgValue;
+	int64_t StartTime;
+	int64_t Duration;
+	TraceEventType Type;
+};
+
+// single producer, the owning thread, and single consumer, the flusher
+struct TraceRing
+{
+	TraceRing()
+		: Head(0)
+		, Tail(0)
+		, DroppedCount(0)
+		, IsNameWritten(false)
+	{
+	}
+
+	static const uint32_t CAPACITY = 8192;
+
+	TraceEvent Events[CAPACITY];
+	atomic<uint32_t> Head;
+	atomic<uint32_t> Tail;
+	atomic<uint64_t> DroppedCount;
+
+	// guarded by the registry mutex
+	string Name;
+	bool IsNameWritten;
+};
+
+const unsigned MAX_THREADS_COUNT = 64;
+
+// flush often enough that the rings of a busy frame never fill up
+const chrono::milliseconds FLUSH_INTERVAL(20);
+
+// rings outlive their threads, the ring of a thread that ended goes to the
+// next new thread, so short lived workers share a few tracks
+struct TraceRings
+{
+	TraceRings()
+		: ClaimedCount(0)
+	{
+		for (unsigned i = 0; i < MAX_THREADS_COUNT; ++i)
+		{
+			Rings[i].store(nullptr, memory_order_relaxed);
+		}
+	}
+
+	~TraceRings()
+	{
+		for (unsigned i = 0; i < MAX_THREADS_COUNT; ++i)
+		{
+			delete Rings[i].load();
+		}
+	}
+
+	atomic<TraceRing*> Rings[MAX_THREADS_COUNT];
+	atomic<unsigned> ClaimedCount;
+
+	// guards the names and the free rings, never taken while recording
+	mutex Mutex;
+	vector<TraceRing*> FreeRings;
+};
+
+TraceRings s_TraceRings;
+
+struct ThreadRing
+{
+	ThreadRing()
+		: pRing(nullptr)
+		, IsOverLimit(false)
+	{
+	}
+
+	~ThreadRing()
+	{
+		if (pRing)
+		{
+			lock_guard<mutex> lock(s_TraceRings.Mutex);
+			pRing->Name.clear();
+			s_TraceRings.FreeRings.push_back(pRing);
+		}
+	}
+
+	TraceRing* pRing;
+	bool IsOverLimit;
+};
+
+thread_local ThreadRing s_ThreadRing;
+
+// everything below belongs to the flusher, or to Start and Stop while it isn't running
+ofstream s_File;
+bool s_IsFirstEvent = true;
+int64_t s_TraceStartTime = 0;
+
+thread s_Flusher;
+mutex s_FlusherMutex;
+condition_variable s_FlusherCondition;
+bool s_IsFlusherRunning = false;
+
+TraceRing* GetThreadRing()
+{
+	if (s_ThreadRing.pRing || s_ThreadRing.IsOverLimit)
+	{
+		return s_ThreadRing.pRing;
+	}
+
+	{
+		lock_guard<mutex> lock(s_TraceRings.Mutex);
+
+		if (!s_TraceRings.FreeRings.empty())
+		{
+			s_ThreadRing.pRing = s_TraceRings.FreeRings.back();
+			s_TraceRings.FreeRings.pop_back();
+			return s_ThreadRing.pRing;
+		}
+	}
+
+	const unsigned index = s_TraceRings.ClaimedCount.fetch_add(1);
+
+	// threads past the limit are not traced
+	if (index < MAX_THREADS_COUNT)
+	{
+		s_ThreadRing.pRing = new TraceRing;
+		s_TraceRings.Rings[index].store(s_ThreadRing.pRing, memory_order_release);
+	}
+	else
+	{
+		s_ThreadRing.IsOverLimit = true;
+	}
+
+	return s_ThreadRing.pRing;
+}
+
+void Push(const TraceEvent& event)
+{
+	TraceRing* pRing = GetThreadRing();
+
+	if (!pRing)
+	{
+		return;
+	}
+
+	const uint32_t head = pRing->Head.load(memory_order_relaxed);
+
+	if (head - pRing->Tail.load(memory_order_acquire) == TraceRing::CAPACITY)
+	{
+		pRing->DroppedCount.store(pRing->DroppedCount.load(memory_order_relaxed) + 1, memory_order_relaxed);
+		return;
+	}
+
+	pRing->Events[head % TraceRing::CAPACITY] = event;
+	pRing->Head.store(head + 1, memory_order_release);
+}
+
+string EscapeJson(const string& text)
+{
+	string escaped;
+
+	for (size_t i = 0; i < text.size(); ++i)
+	{
+		if (text[i] == '"' || text[i] == '\\')
+		{
+			escaped += '\\';
+		}
+
+		escaped += text[i];
+	}
+
+	return escaped;
+}
+
+// the part of an event every type shares, up to the timestamp
+void BeginEvent(const char* type, unsigned tid)
+{
+	s_File << (s_IsFirstEvent ? "\n" : ",\n") << "{\"ph\":\"" << type << "\",\"pid\":1,\"tid\":" << tid + 1;
+	s_IsFirstEvent = false;
+}
+
+// microseconds with nanoseconds as decimals, nanoseconds must not be negative
+void WriteTimestamp(const char* key, int64_t nanoseconds)
+{
+	s_File << ",\"" << key << "\":" << nanoseconds / 1000 << '.' << setfill('0') << setw(3) << nanoseconds % 1000;
+}
+
+void WriteEvent(const TraceEvent& event, unsigned tid)
+{
+	BeginEvent(event.Type == TRACE_COMPLETE ? "X" : "i", tid);
+	// spans begun just before the trace started are moved to its start
+	WriteTimestamp("ts", max<int64_t>(event.StartTime - s_TraceStartTime, 0));
+
+	if (event.Type == TRACE_COMPLETE)
+	{
+		WriteTimestamp("dur", event.Duration);
+	}
+	else
+	{
+		// instants mark their own thread only
+		s_File << ",\"s\":\"t\"";
+	}
+
+	s_File << ",\"cat\":\"" << event.Category << "\",\"name\":\"" << event.Name << '"';
+
+	if (event.ArgName)
+	{
+		s_File << ",\"args\":{\"" << event.ArgName << "\":" << event.ArgValue << '}';
+	}
+
+	s_File << '}';
+}
+
+void WriteThreadName(const string& name, unsigned tid)
+{
+	BeginEvent("M", tid);
+	s_File << ",\"name\":\"thread_name\",\"args\":{\"name\":\"" << EscapeJson(name) << "\"}}";
+}
+
+}
+
+atomic<bool> Tracer::m_IsEnabled(false);
+
+bool Tracer::Start(const string& fileName)
+{
+	assert(!s_IsFlusherRunning);
+
+	s_File.open(fileName.c_str());
+
+	if (!s_File)
+	{
+		s_File.clear();
+		return false;
+	}
+
+	s_File << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	s_IsFirstEvent = true;
+	s_TraceStartTime = Clock::GetSteadyClock().GetNanoseconds();
+
+	// names already written belong to an earlier trace
+	{
+		lock_guard<mutex> lock(s_TraceRings.Mutex);
+
+		for (unsigned i = 0; i < MAX_THREADS_COUNT; ++i)
+		{
+			if (TraceRing* pRing = s_TraceRings.Rings[i].load(memory_order_acquire))
+			{
+				pRing->IsNameWritten = false;
+			}
+		}
+	}
+
+	s_IsFlusherRunning = true;
+	s_Flusher = thread(&Tracer::RunFlusher);
+
+	m_IsEnabled = true;
+	return true;
+}
+
+void Tracer::Stop()
+{
+	if (!m_IsEnabled)
+	{
+		return;
+	}
+
+	m_IsEnabled = false;
+
+	{
+		lock_guard<mutex> lock(s_FlusherMutex);
+		s_IsFlusherRunning = false;
+	}
+
+	s_FlusherCondition.notify_one();
+	s_Flusher.join();
+
+	// events recorded after the flusher's last pass
+	Flush();
+
+	for (unsigned i = 0; i < MAX_THREADS_COUNT; ++i)
+	{
+		TraceRing* pRing = s_TraceRings.Rings[i].load(memory_order_acquire);
+
+		if (pRing && pRing->DroppedCount.load(memory_order_relaxed) > 0)
+		{
+			TraceEvent event = { "trace", "dropped events", "count", int64_t(pRing->DroppedCount.load(memory_order_relaxed)),
+				Clock::GetSteadyClock().GetNanoseconds(), 0, TRACE_INSTANT };
+			WriteEvent(event, i);
+			pRing->DroppedCount.store(0, memory_order_relaxed);
+		}
+	}
+
+	s_File << "\n]}\n";
+	s_File.close();
+}
+
+void Tracer::SetThreadName(const string& name)
+{
+	// the ring is claimed even while tracing is off, so a later trace has the name
+	if (TraceRing* pRing = GetThreadRing())
+	{
+		lock_guard<mutex> lock(s_TraceRings.Mutex);
+		pRing->Name = name;
+		pRing->IsNameWritten = false;
+	}
+}
+
+void Tracer::Complete(const char* category, const char* name, int64_t startTime, int64_t duration,
+	const char* argName, int64_t argValue)
+{
+	if (IsEnabled())
+	{
+		TraceEvent event = { category, name, argName, argValue, startTime, duration, TRACE_COMPLETE };
+		Push(event);
+	}
+}
+
+void Tracer::Instant(const char* category, const char* name, const char* argName, int64_t argValue)
+{
+	if (IsEnabled())
+	{
+		TraceEvent event = { category, name, argName, argValue, Clock::GetSteadyClock().GetNanoseconds(), 0, TRACE_INSTANT };
+		Push(event);
+	}
+}
+
+void Tracer::Flush()
+{
+	const unsigned threadsCount = min(s_TraceRings.ClaimedCount.load(), MAX_THREADS_COUNT);
+
+	for (unsigned i = 0; i < threadsCount; ++i)
+	{
+		// claimed but maybe not stored yet
+		TraceRing* pRing = s_TraceRings.Rings[i].load(memory_order_acquire);
+
+		if (!pRing)
+		{
+			continue;
+		}
+
+		{
+			lock_guard<mutex> lock(s_TraceRings.Mutex);
+
+			if (!pRing->IsNameWritten && !pRing->Name.empty())
+			{
+				WriteThreadName(pRing->Name, i);
+				pRing->IsNameWritten = true;
+			}
+		}
+
+		const uint32_t head = pRing->Head.load(memory_order_acquire);
+		uint32_t tail = pRing->Tail.load(memory_order_relaxed);
+
+		for (; tail != head; ++tail)
+		{
+			WriteEvent(pRing->Events[tail % TraceRing::CAPACITY], i);
+		}
+
+		pRing->Tail.store(tail, memory_order_release);
+	}
+
+	s_File.flush();
+}
+
+void Tracer::RunFlusher()
+{
+	SetThreadName("trace flusher");
+
+	unique_lock<mutex> lock(s_FlusherMutex);
+
+	while (s_IsFlusherRunning)
+	{
+		s_FlusherCondition.wait_for(lock, FLUSH_INTERVAL);
+
+		lock.unlock();
+		Flush();
+		lock.lock();
+	}
+}
+
+ScopedTrace::ScopedTrace(const char* category, const char* name)
+	: m_Category(category)
+	, m_Name(name)
+	, m_ArgName(nullptr)
+	, m_ArgValue(0)
+	, m_StartTime(Tracer::IsEnabled() ? Clock::GetSteadyClock().GetNanoseconds() : 0)
+{
+}
+
+ScopedTrace::~ScopedTrace()
+{
+	// a span begun before the trace started is not recorded
+	if (m_StartTime != 0 && Tracer::IsEnabled())
+	{
+		const int64_t duration = Clock::GetSteadyClock().GetNanoseconds() - m_StartTime;
+		Tracer::Complete(m_Category, m_Name, m_StartTime, duration, m_ArgName, m_ArgValue);
+	}
+}
+
+void ScopedTrace::SetArgument(const char* argName, int64_t argValue)
+{
+	m_ArgName = argName;
+	m_ArgValue = argValue;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// Optional timeline of frame phases and game events written as Chrome
+// trace_event JSON, for Perfetto or about:tracing. Each thread records into
+// a ring buffer of its own without locks; a background thread drains the
+// rings into the file while the game runs. Events recorded while tracing is
+// off cost one relaxed load, events that find their ring full are dropped
+// and counted.
+//
+// Names, categories and argument names must be string literals or live as
+// long as the program. Times are nanoseconds of the steady clock.
+class Tracer
+{
+public:
+	// starts the flusher thread, returns false when the file can't be written
+	static bool Start(const std::string& fileName);
+
+	// writes out everything recorded so far and closes the file
+	static void Stop();
+
+	static bool IsEnabled()
+	{
+		return m_IsEnabled.load(std::memory_order_relaxed);
+	}
+
+	// shown as the track name of the calling thread
+	static void SetThreadName(const std::string& name);
+
+	// a span already finished, argName may be null
+	static void Complete(const char* category, const char* name, int64_t startTime, int64_t duration,
+		const char* argName = nullptr, int64_t argValue = 0);
+
+	// a point in time, argName may be null
+	static void Instant(const char* category, const char* name, const char* argName = nullptr, int64_t argValue = 0);
+
+private:
+	static void Flush();
+	static void RunFlusher();
+
+	static std::atomic<bool> m_IsEnabled;
+};
+
+// Traces the lifetime of the scope as a span.
+class ScopedTrace
+{
+public:
+	ScopedTrace(const char* category, const char* name);
+	~ScopedTrace();
+
+	// e.g. the number of nodes a search visited, known at the end
+	void SetArgument(const char* argName, int64_t argValue);
+
+private:
+	ScopedTrace(const ScopedTrace&);
+	ScopedTrace& operator = (const ScopedTrace&);
+
+	const char* m_Category;
+	const char* m_Name;
+	const char* m_ArgName;
+	int64_t m_ArgValue;
+	int64_t m_StartTime;
+};
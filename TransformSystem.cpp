@@ -0,0 +1,267 @@
+#include "pch.h"
+#include "TransformSystem.h"
+
+using namespace std;
+
+
+TransformSystem::Handle TransformSystem::Allocate()
+{
+	if (m_FreeSlots.empty())
+	{
+		size_t slotsCount = m_World.size();
+		size_t newSlotsCount = slotsCount + GROUP_SIZE;
+
+		m_ScaleX.resize(newSlotsCount);
+		m_ScaleY.resize(newSlotsCount);
+		m_ScaleZ.resize(newSlotsCount);
+		m_RotationX.resize(newSlotsCount);
+		m_RotationY.resize(newSlotsCount);
+		m_RotationZ.resize(newSlotsCount);
+		m_RotationW.resize(newSlotsCount);
+		m_PositionX.resize(newSlotsCount);
+		m_PositionY.resize(newSlotsCount);
+		m_PositionZ.resize(newSlotsCount);
+		m_World.resize(newSlotsCount);
+		m_IsDirty.resize(newSlotsCount);
+
+		// lowest slots are used first
+		for (size_t slot = newSlotsCount; slot > slotsCount; --slot)
+		{
+			Reset(Handle(slot - 1));
+			m_FreeSlots.push_back(Handle(slot - 1));
+		}
+	}
+
+	Handle handle = m_FreeSlots.back();
+	m_FreeSlots.pop_back();
+
+	return handle;
+}
+
+void TransformSystem::Free(Handle handle)
+{
+	assert(handle < m_World.size());
+
+	if (m_IsDirty[handle])
+	{
+		--m_DirtyCount;
+	}
+
+	Reset(handle);
+	m_FreeSlots.push_back(handle);
+}
+
+Vector3 TransformSystem::GetScale(Handle handle)
+{
+	return Vector3(m_ScaleX[handle], m_ScaleY[handle], m_ScaleZ[handle]);
+}
+
+Quaternion TransformSystem::GetRotation(Handle handle)
+{
+	return Quaternion(m_RotationX[handle], m_RotationY[handle], m_RotationZ[handle], m_RotationW[handle]);
+}
+
+Vector3 TransformSystem::GetPosition(Handle handle)
+{
+	return Vector3(m_PositionX[handle], m_PositionY[handle], m_PositionZ[handle]);
+}
+
+void TransformSystem::SetScale(Handle handle, const Vector3& scale)
+{
+	m_ScaleX[handle] = scale.x;
+	m_ScaleY[handle] = scale.y;
+	m_ScaleZ[handle] = scale.z;
+
+	if (!m_IsDirty[handle])
+	{
+		m_IsDirty[handle] = 1;
+		++m_DirtyCount;
+	}
+}
+
+void TransformSystem::SetRotation(Handle handle, const Quaternion& rotation)
+{
+	m_RotationX[handle] = rotation.x;
+	m_RotationY[handle] = rotation.y;
+	m_RotationZ[handle] = rotation.z;
+	m_RotationW[handle] = rotation.w;
+
+	if (!m_IsDirty[handle])
+	{
+		m_IsDirty[handle] = 1;
+		++m_DirtyCount;
+	}
+}
+
+void TransformSystem::SetPosition(Handle handle, const Vector3& position)
+{
+	m_PositionX[handle] = position.x;
+	m_PositionY[handle] = position.y;
+	m_PositionZ[handle] = position.z;
+
+	if (!m_IsDirty[handle])
+	{
+		m_IsDirty[handle] = 1;
+		++m_DirtyCount;
+	}
+}
+
+void TransformSystem::UpdateWorldMatrices()
+{
+	if (m_DirtyCount == 0)
+	{
+		return;
+	}
+
+	for (size_t first = 0; first < m_World.size(); first += GROUP_SIZE)
+	{
+		// the flags of a group are tested with one load
+		uint32_t groupDirtyFlags;
+		memcpy(&groupDirtyFlags, &m_IsDirty[first], sizeof(groupDirtyFlags));
+
+		// clean slots of a dirty group are recomputed to the same values
+		if (groupDirtyFlags != 0)
+		{
+			UpdateWorldMatricesGroup(Handle(first));
+			memset(&m_IsDirty[first], 0, GROUP_SIZE);
+		}
+	}
+
+	m_DirtyCount = 0;
+}
+
+const Matrix& TransformSystem::GetWorldMatrix(Handle handle)
+{
+	assert(handle < m_World.size());
+
+	if (m_IsDirty[handle])
+	{
+		UpdateWorldMatrix(handle);
+
+		m_IsDirty[handle] = 0;
+		--m_DirtyCount;
+	}
+
+	return m_World[handle];
+}
+
+const Matrix* TransformSystem::GetWorldMatrices()
+{
+	return m_World.empty() ? nullptr : &m_World.front();
+}
+
+size_t TransformSystem::GetSlotsCount()
+{
+	return m_World.size();
+}
+
+// world = scale * rotation * translation, written out so that the scalar
+// and the SIMD paths give the same values as the matrix products
+void TransformSystem::UpdateWorldMatrix(Handle handle)
+{
+	float x = m_RotationX[handle], y = m_RotationY[handle], z = m_RotationZ[handle], w = m_RotationW[handle];
+	float sx = m_ScaleX[handle], sy = m_ScaleY[handle], sz = m_ScaleZ[handle];
+
+	m_World[handle] = Matrix(
+		sx * (1.0f - 2.0f * (y * y + z * z)),	sx * (2.0f * (x * y + z * w)),			sx * (2.0f * (x * z - y * w)),			0.0f,
+		sy * (2.0f * (x * y - z * w)),			sy * (1.0f - 2.0f * (x * x + z * z)),	sy * (2.0f * (y * z + x * w)),			0.0f,
+		sz * (2.0f * (x * z + y * w)),			sz * (2.0f * (y * z - x * w)),			sz * (1.0f - 2.0f * (x * x + y * y)),	0.0f,
+		m_PositionX[handle],					m_PositionY[handle],					m_PositionZ[handle],					1.0f);
+}
+
+void TransformSystem::UpdateWorldMatricesGroup(Handle first)
+{
+#ifdef MATH_USE_SSE
+	__m128 x = _mm_loadu_ps(&m_RotationX[first]);
+	__m128 y = _mm_loadu_ps(&m_RotationY[first]);
+	__m128 z = _mm_loadu_ps(&m_RotationZ[first]);
+	__m128 w = _mm_loadu_ps(&m_RotationW[first]);
+
+	__m128 sx = _mm_loadu_ps(&m_ScaleX[first]);
+	__m128 sy = _mm_loadu_ps(&m_ScaleY[first]);
+	__m128 sz = _mm_loadu_ps(&m_ScaleZ[first]);
+
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 two = _mm_set1_ps(2.0f);
+	__m128 zero = _mm_setzero_ps();
+
+	__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+	__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+	__m128 xw = _mm_mul_ps(x, w), yw = _mm_mul_ps(y, w), zw = _mm_mul_ps(z, w);
+
+	// one register per matrix element, one lane per slot
+	__m128 rows[4][4] =
+	{
+		{
+			_mm_mul_ps(sx, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)))),
+			_mm_mul_ps(sx, _mm_mul_ps(two, _mm_add_ps(xy, zw))),
+			_mm_mul_ps(sx, _mm_mul_ps(two, _mm_sub_ps(xz, yw))),
+			zero,
+		},
+		{
+			_mm_mul_ps(sy, _mm_mul_ps(two, _mm_sub_ps(xy, zw))),
+			_mm_mul_ps(sy, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)))),
+			_mm_mul_ps(sy, _mm_mul_ps(two, _mm_add_ps(yz, xw))),
+			zero,
+		},
+		{
+			_mm_mul_ps(sz, _mm_mul_ps(two, _mm_add_ps(xz, yw))),
+			_mm_mul_ps(sz, _mm_mul_ps(two, _mm_sub_ps(yz, xw))),
+			_mm_mul_ps(sz, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)))),
+			zero,
+		},
+		{
+			_mm_loadu_ps(&m_PositionX[first]),
+			_mm_loadu_ps(&m_PositionY[first]),
+			_mm_loadu_ps(&m_PositionZ[first]),
+			one,
+		},
+	};
+
+	for (int row = 0; row < 4; ++row)
+	{
+		// element registers become the rows of the four matrices
+		_MM_TRANSPOSE4_PS(rows[row][0], rows[row][1], rows[row][2], rows[row][3]);
+
+		for (size_t slot = 0; slot < GROUP_SIZE; ++slot)
+		{
+			_mm_storeu_ps(m_World[first + slot].m[row], rows[row][slot]);
+		}
+	}
+#else
+	for (size_t slot = 0; slot < GROUP_SIZE; ++slot)
+	{
+		UpdateWorldMatrix(Handle(first + slot));
+	}
+#endif
+}
+
+void TransformSystem::Reset(Handle handle)
+{
+	m_ScaleX[handle] = m_ScaleY[handle] = m_ScaleZ[handle] = 1.0f;
+	m_RotationX[handle] = m_RotationY[handle] = m_RotationZ[handle] = 0.0f;
+	m_RotationW[handle] = 1.0f;
+	m_PositionX[handle] = m_PositionY[handle] = m_PositionZ[handle] = 0.0f;
+
+	MatrixIdentity(&m_World[handle]);
+	m_IsDirty[handle] = 0;
+}
+
+// static members initialization
+
+TransformSystem::ComponentContainer TransformSystem::m_ScaleX;
+TransformSystem::ComponentContainer TransformSystem::m_ScaleY;
+TransformSystem::ComponentContainer TransformSystem::m_ScaleZ;
+TransformSystem::ComponentContainer TransformSystem::m_RotationX;
+TransformSystem::ComponentContainer TransformSystem::m_RotationY;
+TransformSystem::ComponentContainer TransformSystem::m_RotationZ;
+TransformSystem::ComponentContainer TransformSystem::m_RotationW;
+TransformSystem::ComponentContainer TransformSystem::m_PositionX;
+TransformSystem::ComponentContainer TransformSystem::m_PositionY;
+TransformSystem::ComponentContainer TransformSystem::m_PositionZ;
+
+vector<Matrix> TransformSystem::m_World;
+vector<uint8_t> TransformSystem::m_IsDirty;
+size_t TransformSystem::m_DirtyCount = 0;
+
+vector<TransformSystem::Handle> TransformSystem::m_FreeSlots;
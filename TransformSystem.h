@@ -0,0 +1,58 @@
+#pragma once
+
+// Scale, rotation and position of every GameObject kept in structure of
+// arrays form. Setters only mark the slot dirty; UpdateWorldMatrices
+// recomputes all dirty world matrices in one pass, four slots at a time,
+// and the results are kept in one contiguous array for the renderer.
+class TransformSystem
+{
+public:
+	typedef unsigned Handle;
+
+	// new transforms are identities
+	static Handle Allocate();
+	static void Free(Handle handle);
+
+	static Vector3 GetScale(Handle handle);
+	static Quaternion GetRotation(Handle handle);
+	static Vector3 GetPosition(Handle handle);
+
+	static void SetScale(Handle handle, const Vector3& scale);
+	static void SetRotation(Handle handle, const Quaternion& rotation);
+	static void SetPosition(Handle handle, const Vector3& position);
+
+	// once per frame, before drawing
+	static void UpdateWorldMatrices();
+
+	// up to date even when the slot changed after the last update
+	static const Matrix& GetWorldMatrix(Handle handle);
+
+	// every slot, valid until the next Allocate; free slots hold identities
+	static const Matrix* GetWorldMatrices();
+	static size_t GetSlotsCount();
+
+private:
+	static void UpdateWorldMatrix(Handle handle);
+	static void UpdateWorldMatricesGroup(Handle first);
+
+	static void Reset(Handle handle);
+
+	typedef std::vector<float> ComponentContainer;
+
+	static ComponentContainer m_ScaleX, m_ScaleY, m_ScaleZ;
+	static ComponentContainer m_RotationX, m_RotationY, m_RotationZ, m_RotationW;
+	static ComponentContainer m_PositionX, m_PositionY, m_PositionZ;
+
+	static std::vector<Matrix> m_World;
+
+	// one byte per slot so four slots are tested with one load
+	static std::vector<uint8_t> m_IsDirty;
+	static size_t m_DirtyCount;
+
+	static std::vector<Handle> m_FreeSlots;
+
+	// slots are added in groups of the SIMD width
+	static const size_t GROUP_SIZE = 4;
+
+	static_assert(GROUP_SIZE == sizeof(uint32_t), "dirty flags of a group must fit one load");
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+// Hands the latest value from one writer thread to one reader thread
+// without locks. The writer fills GetWriteBuffer and publishes it, the
+// reader switches to the latest published value with Update. Neither side
+// ever waits, and the value the reader holds is not written until it
+// switches again; values the reader had no time for are skipped.
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+		: m_Write(0)
+		, m_Middle(1)
+		, m_Read(2)
+	{
+	}
+
+	// writer side
+
+	T& GetWriteBuffer()
+	{
+		return m_Buffers[m_Write];
+	}
+
+	void Publish()
+	{
+		m_Write = m_Middle.exchange(m_Write | FRESH_FLAG, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// reader side
+
+	// returns false when nothing was published since the last switch
+	bool Update()
+	{
+		if (!(m_Middle.load(std::memory_order_relaxed) & FRESH_FLAG))
+		{
+			return false;
+		}
+
+		m_Read = m_Middle.exchange(m_Read, std::memory_order_acq_rel) & INDEX_MASK;
+		return true;
+	}
+
+	const T& GetReadBuffer() const
+	{
+		return m_Buffers[m_Read];
+	}
+
+private:
+	TripleBuffer(const TripleBuffer&);
+	TripleBuffer& operator = (const TripleBuffer&);
+
+	// the middle index carries whether it was published after the last switch
+	static const unsigned INDEX_MASK = 3;
+	static const unsigned FRESH_FLAG = 4;
+
+	T m_Buffers[3];
+
+	unsigned m_Write;
+	std::atomic<unsigned> m_Middle;
+	unsigned m_Read;
+};
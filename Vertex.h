@@ -14,3 +14,38 @@ struct Vertex
 	
 	Vector3	Position;
 };
+
+// vertex of meshes colored per vertex, like the merged stack
+struct ColoredVertex
+{
+	ColoredVertex(const Vector3& pos, const Color& color)
+		: Position(pos)
+		, VertexColor(color)
+	{
+	}
+
+	Vector3	Position;
+	Color	VertexColor;
+};
+
+// vertex of the HUD text, the position is in pixels from the top left corner
+// of the screen and the texture coordinates are in the glyph atlas
+struct TextVertex
+{
+	TextVertex()
+	{
+	}
+
+	TextVertex(float x, float y, float u, float v, const Color& color)
+		: Position(Vector3(x, y, 0.0f))
+		, U(u)
+		, V(v)
+		, VertexColor(color)
+	{
+	}
+
+	Vector3	Position;
+	float	U;
+	float	V;
+	Color	VertexColor;
+};
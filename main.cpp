@@ -1,6 +1,235 @@
 #include "pch.h"
 #include "BlockOut.h"
+#include "Game.h"
+#include "GameSnapshot.h"
+#include "HudLayer.h"
+#include "PositionNotation.h"
+#include "SoftwareRenderer.h"
+#include "ShapeSetImage.h"
+#include "ShapeSetParser.h"
+#include "PolycubeEnumerator.h"
+#include "Grid.h"
+#include "Tracer.h"
 
+using namespace std;
+
+// of -render, the size the window opens with
+const unsigned RENDER_WIDTH = 800;
+const unsigned RENDER_HEIGHT = 600;
+
+// BlockOut.exe -generate <max cubes> <text shape set> [-min <cubes>] [-reflect] [-planar] [-fit] [-threads <count>]
+int GenerateShapeSet(istream& arguments)
+{
+	PolycubeEnumerator::Options options;
+	string fileName;
+
+	arguments >> options.MaxCubesCount >> fileName;
+
+	string option;
+
+	while (arguments >> option)
+	{
+		if (option == "-min")
+		{
+			arguments >> options.MinCubesCount;
+		}
+		else if (option == "-reflect")
+		{
+			options.IsReflectionIdentified = true;
+		}
+		else if (option == "-planar")
+		{
+			options.IsPlanarOnly = true;
+		}
+		else if (option == "-fit")
+		{
+			// every piece must fit in the pit when laid flat
+			options.MaxExtent = (Grid::X_SIZE < Grid::Y_SIZE) ? Grid::X_SIZE : Grid::Y_SIZE;
+		}
+		else if (option == "-threads")
+		{
+			arguments >> options.ThreadsCount;
+		}
+	}
+
+	if (arguments.bad() || fileName.empty() ||
+		options.MinCubesCount < 1 || options.MinCubesCount > options.MaxCubesCount ||
+		options.MaxCubesCount > PolycubeEnumerator::MAX_CUBES_COUNT)
+	{
+		::MessageBox(0, "Usage: -generate <max cubes> <file> [-min <cubes>] [-reflect] [-planar] [-fit] [-threads <count>]", "Error", MB_ICONERROR);
+		return 1;
+	}
+
+	ofstream file(fileName.c_str());
+	PolycubeEnumerator::WriteShapeSet(file, PolycubeEnumerator::Enumerate(options));
+
+	if (file.fail())
+	{
+		::MessageBox(0, ("Cannot write file " + fileName).c_str(), "Error", MB_ICONERROR);
+		return 1;
+	}
+
+	return 0;
+}
+
+// BlockOut.exe -render <position> <TGA file>
+// Draws a frame of the position, see PositionNotation, with the HUD at the
+// size of the window, on the CPU, so it needs no graphics device.
+int RenderPosition(istream& arguments)
+{
+	// the position has spaces, the file name is the last word
+	vector<string> words;
+	string word;
+
+	while (arguments >> word)
+	{
+		words.push_back(word);
+	}
+
+	if (words.size() < 2)
+	{
+		::MessageBox(0, "Usage: -render <position> <file>", "Error", MB_ICONERROR);
+		return 1;
+	}
+
+	const string fileName = words.back();
+	string notation = words.front();
+
+	for (size_t i = 1; i + 1 < words.size(); ++i)
+	{
+		notation += ' ' + words[i];
+	}
+
+	GamePosition position;
+
+	try
+	{
+		position = PositionNotation::Parse(notation);
+	}
+	catch (const NotationError& error)
+	{
+		::MessageBox(0, error.what(), "Error", MB_ICONERROR);
+		return 1;
+	}
+
+	SoftwareRenderer renderer(RENDER_WIDTH, RENDER_HEIGHT);
+	Game game(renderer);
+	game.SetAspectRatio(float(RENDER_WIDTH) / RENDER_HEIGHT);
+
+	if (!game.SetPosition(position))
+	{
+		::MessageBox(0, "The position doesn't fit the default shape set", "Error", MB_ICONERROR);
+		return 1;
+	}
+
+	GameSnapshot snapshot;
+	game.Publish(snapshot);
+
+	HudLayer hudLayer(renderer, BlockOut::BuildGlyphAtlas());
+	hudLayer.Update(snapshot, RENDER_WIDTH, RENDER_HEIGHT);
+
+	game.Draw(snapshot);
+	hudLayer.Draw();
+	renderer.Rasterize();
+
+	if (!renderer.WriteTga(fileName))
+	{
+		::MessageBox(0, ("Cannot write file " + fileName).c_str(), "Error", MB_ICONERROR);
+		return 1;
+	}
+
+	return 0;
+}
+
+// BlockOut.exe -convert <text shape set> <binary shape set>
+// BlockOut.exe -generate ..., see GenerateShapeSet
+// BlockOut.exe -render ..., see RenderPosition
+bool RunCommandLineTool(const string& commandLine, int& exitCode)
+{
+	istringstream arguments(commandLine);
+
+	string command;
+	arguments >> command;
+
+	if (command == "-convert")
+	{
+		string textFileName, binaryFileName;
+		arguments >> textFileName >> binaryFileName;
+
+		try
+		{
+			ShapeSetImage::ConvertTextFile(textFileName, binaryFileName);
+			exitCode = 0;
+		}
+		catch (const ShapeSetError& error)
+		{
+			::MessageBox(0, error.what(), "Error", MB_ICONERROR);
+			exitCode = 1;
+		}
+
+		return true;
+	}
+
+	if (command == "-generate")
+	{
+		exitCode = GenerateShapeSet(arguments);
+		return true;
+	}
+
+	if (command == "-render")
+	{
+		exitCode = RenderPosition(arguments);
+		return true;
+	}
+
+	return false;
+}
+
+// the word after the option, empty when the option isn't given
+string GetOptionArgument(const string& commandLine, const string& name)
+{
+	istringstream arguments(commandLine);
+
+	string option, argument;
+
+	while (arguments >> option)
+	{
+		if (option == name)
+		{
+			arguments >> argument;
+		}
+	}
+
+	return argument;
+}
+
+// BlockOut.exe -shapes <shape set> plays with a custom shape set
+int Run(HINSTANCE hInstance, const string& commandLine)
+{
+	int exitCode;
+
+	if (RunCommandLineTool(commandLine, exitCode))
+	{
+		return exitCode;
+	}
+
+	BlockOut theApp(hInstance, GetOptionArgument(commandLine, "-shapes"));
+	
+	theApp.InitApplication();
+
+	try
+	{
+		return theApp.Run();
+	}
+	catch (const ShapeSetError& error)
+	{
+		// a shape of the set turned out corrupted when it was first played
+		::MessageBox(0, error.what(), "Error", MB_ICONERROR);
+		return 1;
+	}
+}
+
+// BlockOut.exe ... -trace <file> writes a Chrome trace of the run, see Tracer
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR commandLine, int showCommand)
 {
 	// Enable run-time memory check for debug builds.
@@ -8,9 +237,15 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR commandLine
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
-	BlockOut theApp(hInstance);
-	
-	theApp.InitApplication();
+	const string traceFileName = GetOptionArgument(commandLine, "-trace");
+
+	if (!traceFileName.empty() && !Tracer::Start(traceFileName))
+	{
+		::MessageBox(0, ("Cannot write file " + traceFileName).c_str(), "Error", MB_ICONERROR);
+	}
+
+	const int exitCode = Run(hInstance, commandLine);
 
-	return theApp.Run();
+	Tracer::Stop();
+	return exitCode;
 }
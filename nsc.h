@@ -11,9 +11,18 @@ class InvalidNumberException : public std::bad_cast
 {
 public:
 	InvalidNumberException(const std::string& invalidNumber)
-		: std::bad_cast((invalidNumber + " is inavlid number !").c_str())
+		: m_Message(invalidNumber + " is inavlid number !")
 	{
 	}
+
+	// std::bad_cast takes a message only with MSVC
+	virtual const char* what() const throw()
+	{
+		return m_Message.c_str();
+	}
+
+private:
+	std::string m_Message;
 };
 
 template <typename NumberType>
@@ -35,7 +44,7 @@ NumberType StringToNumber(const std::string& str)
 template <typename NumberType>
 std::string NumberToString(NumberType number)
 {
-	ostringstream oss;
+	std::ostringstream oss;
 	oss << number;
 	return oss.str();
 }
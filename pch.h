@@ -4,23 +4,50 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
 #include <vector>
+#include <algorithm>
+#include <map>
+#include <functional>
+#include <set>
+#include <unordered_set>
 #include <string>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <iomanip>
 #include <limits>
+#include <climits>
 #include <cassert>
 #include <ctime>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <exception>
 
+// the game itself is portable, only the application and its renderer
+// need Windows and Direct3D
+#ifdef _WIN32
+#define NOMINMAX
 #include <windows.h>
 
 #include <d3dx10.h>
 #include <dxerr.h>
+#endif
 
+#include "SimdMath.h"
 #include "Colors.h"
 #include "SaveDisposal.h"
+#ifdef _WIN32
 #include "D3DDebug.h"
+#endif
 #include "Globals.h"
 #include "Vertex.h"
 #include "nsc.h"